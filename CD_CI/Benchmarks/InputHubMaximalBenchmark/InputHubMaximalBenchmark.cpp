@@ -0,0 +1,147 @@
+/**
+ * @file InputHubMaximalBenchmark.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Input hub throughput with every feature in use
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "cd_ci_assertions.hpp"
+#include "cd_ci_benchmark.hpp"
+#include <iostream>
+
+//------------------------------------------------------------------
+// Globals
+//------------------------------------------------------------------
+
+#define EVENT_COUNT 2000000ULL
+
+#define LCLUTCH 1
+#define RCLUTCH 2
+#define ALT_IN 3
+#define CMD 4
+#define CYCLE_CLUTCH 5
+#define CYCLE_ALT 6
+#define UP 7
+#define DOWN 8
+#define LEFT 9
+#define RIGHT 10
+#define CYCLE_DPAD 11
+#define SW_BIT1 12
+#define SW_BIT2 13
+#define SW_BIT4 14
+#define LSHIFT 23
+#define RSHIFT 24
+#define NEUTRAL 25
+#define FIRST_BUTTON 32
+
+//------------------------------------------------------------------
+// MOCKS
+//------------------------------------------------------------------
+
+uint64_t reportCount = 0ULL;
+
+void internals::hid::reset()
+{
+}
+
+void internals::hid::reportInput(
+    uint64_t inputsLow,
+    uint64_t inputsHigh,
+    uint8_t POVstate,
+    uint8_t leftAxis,
+    uint8_t rightAxis,
+    uint8_t clutchAxis,
+    bool keepAlive)
+{
+    reportCount++;
+}
+
+void internals::inputMap::map(
+    bool isAltModeEngaged,
+    const InputBitmap &firmware_bitmap,
+    uint64_t &low,
+    uint64_t &high)
+{
+    if (isAltModeEngaged)
+    {
+        low = 0ULL;
+        high = firmware_bitmap;
+    }
+    else
+    {
+        low = firmware_bitmap;
+        high = 0ULL;
+    }
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    InputNumber::bookAll();
+    DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_BUTTON);
+    DeviceCapabilities::setFlag(DeviceCapability::DPAD);
+    DeviceCapabilities::setFlag(DeviceCapability::ALT);
+    inputHub::altButtons::inputs({ALT_IN});
+    inputHub::altButtons::cycleWorkingModeInputs({CMD, CYCLE_ALT});
+    inputHub::dpad::inputs(UP, DOWN, LEFT, RIGHT);
+    inputHub::dpad::cycleWorkingModeInputs({CMD, CYCLE_DPAD});
+    inputHub::clutch::inputs(LCLUTCH, RCLUTCH);
+    inputHub::clutch::cycleWorkingModeInputs({CMD, CYCLE_CLUTCH});
+    inputHub::clutch::bitePointInputs(UP, DOWN);
+    inputHub::securityLock::cycleWorkingModeInputs({CMD, UP, DOWN});
+    inputHub::neutralGear::set(NEUTRAL, {LSHIFT, RSHIFT});
+    inputHub::codedSwitch::add(
+        SW_BIT1,
+        SW_BIT2,
+        SW_BIT4,
+        {40, 41, 42, 43, 44, 45, 46, 47});
+    internals::inputHub::getReady();
+    OnStart::notify();
+    InputHubService::call::setClutchWorkingMode(ClutchWorkingMode::CLUTCH, false);
+    InputHubService::call::setAltButtonsWorkingMode(AltButtonsWorkingMode::ALT, false);
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation, false);
+
+    // Every event goes through all the filters,
+    // but no command is issued
+    uint64_t state = 0ULL;
+    benchmark(
+        "input hub (maximal configuration)",
+        EVENT_COUNT,
+        [&state](uint64_t i)
+        {
+            DecouplingEvent event;
+            uint64_t previous = state;
+            state = ((i & 0xFFULL) << FIRST_BUTTON) |
+                    ((i & 0x7ULL) << SW_BIT1) |
+                    ((i & 0x3ULL) << LSHIFT) |
+                    ((i & 0x3ULL) << LCLUTCH);
+            if (i & 0x100ULL)
+                state |= (1ULL << ALT_IN);
+            if (i & 0x200ULL)
+                state |= (1ULL << UP);
+            event.rawInputBitmap = state;
+            event.rawInputChanges = state ^ previous;
+            event.leftAxisValue = CLUTCH_NONE_VALUE;
+            event.rightAxisValue = CLUTCH_NONE_VALUE;
+            internals::inputHub::onRawInput(event);
+        });
+
+    assert<uint64_t>::equals("Report count", EVENT_COUNT, reportCount);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file InputHubMinimalBenchmark.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Input hub throughput with a minimal configuration
+ *        (buttons only)
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "cd_ci_assertions.hpp"
+#include "cd_ci_benchmark.hpp"
+#include <iostream>
+
+//------------------------------------------------------------------
+// Globals
+//------------------------------------------------------------------
+
+#define EVENT_COUNT 2000000ULL
+
+//------------------------------------------------------------------
+// MOCKS
+//------------------------------------------------------------------
+
+uint64_t reportCount = 0ULL;
+uint64_t currentLow = 0ULL;
+
+void internals::hid::reset()
+{
+}
+
+void internals::hid::reportInput(
+    uint64_t inputsLow,
+    uint64_t inputsHigh,
+    uint8_t POVstate,
+    uint8_t leftAxis,
+    uint8_t rightAxis,
+    uint8_t clutchAxis,
+    bool keepAlive)
+{
+    currentLow = inputsLow;
+    reportCount++;
+}
+
+void internals::inputMap::map(
+    bool isAltModeEngaged,
+    const InputBitmap &firmware_bitmap,
+    uint64_t &low,
+    uint64_t &high)
+{
+    low = firmware_bitmap;
+    high = 0ULL;
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    InputNumber::bookAll();
+    internals::inputHub::getReady();
+    OnStart::notify();
+
+    uint64_t state = 0ULL;
+    benchmark(
+        "input hub (minimal configuration)",
+        EVENT_COUNT,
+        [&state](uint64_t i)
+        {
+            DecouplingEvent event;
+            uint64_t previous = state;
+            state = (i & 0xFFFFULL) << 4;
+            event.rawInputBitmap = state;
+            event.rawInputChanges = state ^ previous;
+            event.leftAxisValue = CLUTCH_NONE_VALUE;
+            event.rightAxisValue = CLUTCH_NONE_VALUE;
+            internals::inputHub::onRawInput(event);
+        });
+
+    assert<uint64_t>::equals("Report count", EVENT_COUNT, reportCount);
+    assert<uint64_t>::equals("Last report", state, currentLow);
+    return 0;
+}
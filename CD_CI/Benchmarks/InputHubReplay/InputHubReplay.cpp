@@ -0,0 +1,357 @@
+/**
+ * @file InputHubReplay.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Replay recorded input streams through the input hub
+ *        and the input map, checking the resulting reports
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "cd_ci_assertions.hpp"
+#include "cd_ci_replay.hpp"
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <algorithm>
+
+/*
+Usage:
+
+- No arguments:
+  replay the bundled recordings, which must match bit by bit.
+- record [folder]:
+  generate the bundled recordings again from the current firmware.
+  Do this only after an intended change in behavior.
+- replay <prefix>:
+  replay <prefix>.events and compare to <prefix>.reports, if any.
+- import <trace dump> <prefix>:
+  convert a dump of the on-device input event trace
+  into <prefix>.events and <prefix>.reports.
+  Note that the device configuration may differ from this one.
+*/
+
+//------------------------------------------------------------------
+// Globals
+//------------------------------------------------------------------
+
+#define LCLUTCH 1
+#define RCLUTCH 2
+#define ALT_IN 3
+#define CMD 4
+#define CYCLE_CLUTCH 5
+#define CYCLE_ALT 6
+#define UP 7
+#define DOWN 8
+#define LEFT 9
+#define RIGHT 10
+#define CYCLE_DPAD 11
+#define SW_BIT1 12
+#define SW_BIT2 13
+#define SW_BIT4 14
+#define LSHIFT 23
+#define RSHIFT 24
+#define NEUTRAL 25
+#define FIRST_BUTTON 32
+
+#define EVENT_COUNT 5000
+
+struct Recording
+{
+    std::string name;
+    uint32_t seed;
+    InputBitmap inputs;
+    bool axes;
+};
+
+const InputBitmap buttons =
+    inputBitmapOf(FIRST_BUTTON) | inputBitmapOf(FIRST_BUTTON + 1) |
+    inputBitmapOf(FIRST_BUTTON + 2) | inputBitmapOf(FIRST_BUTTON + 3) |
+    inputBitmapOf(LSHIFT) | inputBitmapOf(RSHIFT);
+
+const InputBitmap commands =
+    buttons | inputBitmapOf(ALT_IN) | inputBitmapOf(CMD) |
+    inputBitmapOf(CYCLE_CLUTCH) | inputBitmapOf(CYCLE_ALT) |
+    inputBitmapOf(UP) | inputBitmapOf(DOWN) | inputBitmapOf(LEFT) |
+    inputBitmapOf(RIGHT) | inputBitmapOf(CYCLE_DPAD) |
+    inputBitmapOf(SW_BIT1) | inputBitmapOf(SW_BIT2) | inputBitmapOf(SW_BIT4);
+
+const Recording recordings[] = {
+    {"buttons", 0x5EED0001, buttons, false},
+    {"commands", 0x5EED0002, commands, false},
+    {"axes", 0x5EED0003, buttons | inputBitmapOf(ALT_IN), true},
+};
+
+std::filesystem::path recordingsFolder()
+{
+    return std::filesystem::path(__FILE__).parent_path() / "recordings";
+}
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+void configure()
+{
+    InputNumber::bookAll();
+    DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_ANALOG);
+    DeviceCapabilities::setFlag(DeviceCapability::DPAD);
+    DeviceCapabilities::setFlag(DeviceCapability::ALT);
+    inputHub::altButtons::inputs({ALT_IN});
+    inputHub::altButtons::cycleWorkingModeInputs({CMD, CYCLE_ALT});
+    inputHub::dpad::inputs(UP, DOWN, LEFT, RIGHT);
+    inputHub::dpad::cycleWorkingModeInputs({CMD, CYCLE_DPAD});
+    inputHub::clutch::inputs(LCLUTCH, RCLUTCH);
+    inputHub::clutch::cycleWorkingModeInputs({CMD, CYCLE_CLUTCH});
+    inputHub::clutch::bitePointInputs(UP, DOWN);
+    inputHub::securityLock::cycleWorkingModeInputs({CMD, UP, DOWN});
+    inputHub::neutralGear::set(NEUTRAL, {LSHIFT, RSHIFT});
+    inputHub::codedSwitch::add(
+        SW_BIT1,
+        SW_BIT2,
+        SW_BIT4,
+        {40, 41, 42, 43, 44, 45, 46, 47});
+    internals::inputMap::getReady();
+    internals::inputHub::getReady();
+    OnStart::notify();
+}
+
+void resetWorkingModes()
+{
+    InputHubService::call::setSecurityLock(false, false);
+    InputHubService::call::setClutchWorkingMode(ClutchWorkingMode::CLUTCH, false);
+    InputHubService::call::setAltButtonsWorkingMode(AltButtonsWorkingMode::ALT, false);
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation, false);
+    InputHubService::call::setBitePoint(CLUTCH_DEFAULT_VALUE, false);
+}
+
+bool loadEvents(const std::string &prefix, InputStream &events)
+{
+    std::vector<uint8_t> data;
+    if (!replay::load(prefix + ".events", data))
+    {
+        std::cout << "[replay] Unable to read " << prefix << ".events" << std::endl;
+        return false;
+    }
+    if (!replay::decode(data, events))
+    {
+        std::cout << "[replay] Malformed or incompatible " << prefix << ".events" << std::endl;
+        return false;
+    }
+
+    // The encoding must be canonical
+    // (the header may differ in the width of the input bitmap)
+    std::vector<uint8_t> encoded;
+    replay::encode(events, encoded);
+    if (!std::equal(
+            encoded.begin() + replay::HEADER_SIZE,
+            encoded.end(),
+            data.begin() + replay::HEADER_SIZE,
+            data.end()))
+    {
+        std::cout << "[replay] Non-canonical encoding at " << prefix << ".events" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool save(const std::string &prefix, const InputStream &events, const ReportStream &reports)
+{
+    std::vector<uint8_t> data;
+    replay::encode(events, data);
+    bool ok = replay::save(prefix + ".events", data);
+    replay::encode(reports, data);
+    ok = ok && replay::save(prefix + ".reports", data);
+    if (!ok)
+        std::cout << "[replay] Unable to write " << prefix << std::endl;
+    return ok;
+}
+
+/**
+ * @brief Replay a recording and compare the reports
+ *
+ * @param prefix File name without extension
+ * @param required True if the reports file must exist
+ * @return true If the reports match
+ */
+bool check(const std::string &prefix, bool required)
+{
+    InputStream events;
+    ReportStream expected, actual;
+    std::vector<uint8_t> data;
+    if (!loadEvents(prefix, events))
+        return false;
+    bool hasReports = replay::load(prefix + ".reports", data);
+    if (hasReports && !replay::decode(data, expected))
+    {
+        std::cout << "[replay] Malformed " << prefix << ".reports" << std::endl;
+        return false;
+    }
+    if (!hasReports && required)
+    {
+        std::cout << "[replay] Unable to read " << prefix << ".reports" << std::endl;
+        return false;
+    }
+    resetWorkingModes();
+    replay::run("replay " + std::filesystem::path(prefix).filename().string(), events, actual);
+    if (!hasReports)
+        return true;
+    size_t differences = replay::diff(expected, actual);
+    if (differences)
+        std::cout << "[replay] " << differences << " differences at " << prefix << std::endl;
+    return (differences == 0);
+}
+
+// Same layout as report ID 8
+void dumpTraceEntry(const InputTraceEntry &entry, std::vector<uint8_t> &dump)
+{
+    uint8_t payload[EVENT_TRACE_REPORT_SIZE] = {};
+    payload[8] = entry.reported ? 0x07 : 0x03;
+    payload[9] = replay::BITMAP_BYTES;
+    payload[10] = entry.input.leftAxisValue;
+    payload[11] = entry.input.rightAxisValue;
+    if (entry.reported)
+    {
+        memcpy(payload + 16, &entry.inputsLow, 8);
+        memcpy(payload + 24, &entry.inputsHigh, 8);
+        payload[32] = entry.POVstate;
+        payload[33] = entry.leftAxis;
+        payload[34] = entry.rightAxis;
+        payload[35] = entry.clutchAxis;
+    }
+    for (uint8_t i = 0; i < replay::BITMAP_BYTES; i++)
+    {
+        payload[36 + i] = replay::bitmapByte(entry.input.rawInputBitmap, i);
+        payload[36 + replay::BITMAP_BYTES + i] = replay::bitmapByte(entry.input.rawInputChanges, i);
+    }
+    dump.insert(dump.end(), payload, payload + EVENT_TRACE_REPORT_SIZE);
+}
+
+//------------------------------------------------------------------
+// Commands
+//------------------------------------------------------------------
+
+int record(std::filesystem::path folder)
+{
+    std::filesystem::create_directories(folder);
+    for (const Recording &recording : recordings)
+    {
+        InputStream events;
+        ReportStream reports;
+        replay::generate(events, EVENT_COUNT, recording.seed, recording.inputs, recording.axes);
+        resetWorkingModes();
+        replay::run("record " + recording.name, events, reports);
+        if (!save((folder / recording.name).string(), events, reports))
+            return 1;
+    }
+    return 0;
+}
+
+int import(const std::string &dumpFile, const std::string &prefix)
+{
+    std::vector<uint8_t> dump;
+    InputStream events;
+    ReportStream reports;
+    if (!replay::load(dumpFile, dump) || !replay::fromTrace(dump, events, reports))
+    {
+        std::cout << "[replay] Unable to import " << dumpFile << std::endl;
+        return 1;
+    }
+    std::cout << "[replay] " << events.size() << " events, "
+              << reports.size() << " reports" << std::endl;
+    return save(prefix, events, reports) ? 0 : 1;
+}
+
+void selfCheck()
+{
+    std::cout << "- bundled recordings -" << std::endl;
+    for (const Recording &recording : recordings)
+    {
+        std::string prefix = (recordingsFolder() / recording.name).string();
+        assert(check(prefix, true) && "Recording does not match");
+    }
+
+    std::cout << "- deterministic replay -" << std::endl;
+    InputStream events;
+    ReportStream first, second;
+    replay::generate(events, EVENT_COUNT, 0x5EED0004, commands, true);
+    resetWorkingModes();
+    replay::run("first run", events, first);
+    resetWorkingModes();
+    replay::run("second run", events, second);
+    assert<size_t>::equals("Replay is not deterministic", 0, replay::diff(first, second));
+
+    std::cout << "- binary format -" << std::endl;
+    std::vector<uint8_t> data;
+    InputStream decodedEvents;
+    ReportStream decodedReports;
+    replay::encode(events, data);
+    assert(replay::decode(data, decodedEvents) && "Events not decoded");
+    assert<size_t>::equals("Decoded event count", events.size(), decodedEvents.size());
+    for (size_t i = 0; i < events.size(); i++)
+        assert((events[i].rawInputBitmap == decodedEvents[i].rawInputBitmap) &&
+               (events[i].rawInputChanges == decodedEvents[i].rawInputChanges) &&
+               (events[i].leftAxisValue == decodedEvents[i].leftAxisValue) &&
+               (events[i].rightAxisValue == decodedEvents[i].rightAxisValue) &&
+               "Decoded event differs");
+    std::cout << "  (" << (data.size() / (double)events.size()) << " bytes per event)" << std::endl;
+    data.pop_back();
+    assert(!replay::decode(data, decodedEvents) && "Truncated events decoded");
+    replay::encode(first, data);
+    assert(replay::decode(data, decodedReports) && "Reports not decoded");
+    assert<size_t>::equals("Decoded reports differ", 0, replay::diff(first, decodedReports));
+
+    std::cout << "- on-device trace -" << std::endl;
+    InputTraceEntry entry;
+    std::vector<uint8_t> dump;
+    replay::generate(events, EVENT_TRACE_DEPTH - 1, 0x5EED0005, commands, true);
+    resetWorkingModes();
+    InputHubService::call::setEventTrace(true);
+    // Skip the "release all" event
+    uint32_t sequence = InputHubService::call::getEventTraceCount() + 1;
+    replay::run("traced run", events, first);
+    InputHubService::call::setEventTrace(false);
+    while (InputHubService::call::getEventTraceEntry(sequence++, entry))
+        dumpTraceEntry(entry, dump);
+    assert(replay::fromTrace(dump, decodedEvents, decodedReports) && "Trace not imported");
+    assert<size_t>::equals("Traced event count", events.size(), decodedEvents.size());
+    for (size_t i = 0; i < events.size(); i++)
+        assert((events[i].rawInputBitmap == decodedEvents[i].rawInputBitmap) &&
+               (events[i].rawInputChanges == decodedEvents[i].rawInputChanges) &&
+               "Traced event differs");
+    assert<size_t>::equals("Traced reports differ", 0, replay::diff(first, decodedReports));
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    configure();
+    std::string command = (argc > 1) ? argv[1] : "";
+    if (command.empty())
+    {
+        selfCheck();
+        return 0;
+    }
+    if (command == "record")
+        return record((argc > 2) ? std::filesystem::path(argv[2]) : recordingsFolder());
+    if ((command == "replay") && (argc > 2))
+        return check(argv[2], false) ? 0 : 1;
+    if ((command == "import") && (argc > 3))
+        return import(argv[2], argv[3]);
+    std::cout << "Usage: " << argv[0] << " [record [folder] | replay <prefix> | import <trace dump> <prefix>]" << std::endl;
+    return 2;
+}
@@ -87,7 +87,7 @@ uint64_t mapBitmapWitness = 0ULL;
 
 void internals::inputMap::map(
     bool isAltModeEngaged,
-    uint64_t firmware_bitmap,
+    const InputBitmap &firmware_bitmap,
     uint64_t &low,
     uint64_t &high)
 {
@@ -120,7 +120,8 @@ void internals::hid::reportInput(
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
     reportWitness++;
 }
@@ -0,0 +1,242 @@
+/**
+ * @file Report10Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "SettingsImage.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <cstring>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint8_t page;
+    uint8_t command; // page count at read
+    uint16_t size;
+    uint8_t data[SETTINGS_IMAGE_PAGE_SIZE];
+} Report10;
+
+#define REPORT10BYTES(s) ((uint8_t *)&s)
+#define IMAGE_SIZE 150
+#define PAGE_COUNT 3
+
+//-------------------------------------------------------------------
+// Mocks
+//-------------------------------------------------------------------
+
+class StorageMock : public StorageService
+{
+public:
+    inline static int exportCount = 0;
+    inline static int importCount = 0;
+    inline static uint8_t imported[SETTINGS_IMAGE_MAX_SIZE];
+    inline static uint16_t importedSize = 0;
+    inline static uint8_t seed = 0;
+
+    virtual uint16_t exportSettings(uint8_t *image) override
+    {
+        exportCount++;
+        for (uint16_t i = 0; i < IMAGE_SIZE; i++)
+            image[i] = i + seed;
+        return IMAGE_SIZE;
+    }
+
+    virtual bool importSettings(const uint8_t *image, uint16_t size) override
+    {
+        importCount++;
+        importedSize = size;
+        memcpy(imported, image, size);
+        return true;
+    }
+} storageMock;
+
+//-------------------------------------------------------------------
+
+void selectPage(uint8_t page)
+{
+    Report10 r10{};
+    r10.page = page;
+    r10.command = 0;
+    internals::hid::common::onSetFeature(RID_FEATURE_SETTINGS_IMAGE, REPORT10BYTES(r10), sizeof(Report10));
+}
+
+Report10 readPage()
+{
+    Report10 r10;
+    uint16_t size = internals::hid::common::onGetFeature(RID_FEATURE_SETTINGS_IMAGE, REPORT10BYTES(r10), sizeof(Report10));
+    assert<uint16_t>::equals("Report size", SETTINGS_IMAGE_REPORT_SIZE, size);
+    return r10;
+}
+
+void writePage(uint8_t page, uint16_t size)
+{
+    Report10 r10{};
+    r10.page = page;
+    r10.command = 1;
+    r10.size = size;
+    for (uint8_t i = 0; i < SETTINGS_IMAGE_PAGE_SIZE; i++)
+        if (((page * SETTINGS_IMAGE_PAGE_SIZE) + i) < size)
+            r10.data[i] = 200 - i;
+    internals::hid::common::onSetFeature(RID_FEATURE_SETTINGS_IMAGE, REPORT10BYTES(r10), sizeof(Report10));
+}
+
+//-------------------------------------------------------------------
+// Test groups
+//-------------------------------------------------------------------
+
+void TG_read()
+{
+    std::cout << "- read -" << std::endl;
+
+    // No snapshot yet
+    Report10 r10 = readPage();
+    assert<int>::equals("Empty image", 0, r10.size);
+    assert<int>::equals("No snapshot", 0, StorageMock::exportCount);
+
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        selectPage(page);
+        r10 = readPage();
+        assert<int>::equals("Page", page, r10.page);
+        assert<int>::equals("Page count", PAGE_COUNT, r10.command);
+        assert<int>::equals("Image size", IMAGE_SIZE, r10.size);
+        for (uint8_t i = 0; i < SETTINGS_IMAGE_PAGE_SIZE; i++)
+        {
+            uint16_t offset = (page * SETTINGS_IMAGE_PAGE_SIZE) + i;
+            uint8_t expected = (offset < IMAGE_SIZE) ? (uint8_t)offset : 0;
+            assert<int>::equals("Image data", expected, r10.data[i]);
+        }
+    }
+    assert<int>::equals("Snapshots", 1, StorageMock::exportCount);
+
+    // Reading does not change the selection
+    r10 = readPage();
+    assert<int>::equals("Same page", PAGE_COUNT - 1, r10.page);
+    assert<int>::equals("Snapshots (read again)", 1, StorageMock::exportCount);
+
+    // A new snapshot is taken when selecting page 0 again
+    StorageMock::seed = 1;
+    selectPage(0);
+    r10 = readPage();
+    assert<int>::equals("Page 0", 0, r10.page);
+    assert<int>::equals("Snapshots (2)", 2, StorageMock::exportCount);
+    assert<int>::equals("New snapshot", 1, r10.data[0]);
+
+    // The snapshot does not change while reading other pages
+    StorageMock::seed = 2;
+    selectPage(1);
+    r10 = readPage();
+    assert<int>::equals("Page 1", 1, r10.page);
+    assert<int>::equals("Snapshot kept", SETTINGS_IMAGE_PAGE_SIZE + 1, r10.data[0]);
+    assert<int>::equals("Snapshots (3)", 2, StorageMock::exportCount);
+}
+
+void TG_write()
+{
+    std::cout << "- write -" << std::endl;
+
+    // Not applied until all pages are received
+    writePage(0, IMAGE_SIZE);
+    writePage(1, IMAGE_SIZE);
+    assert<int>::equals("Partial image", 0, StorageMock::importCount);
+    writePage(2, IMAGE_SIZE);
+    assert<int>::equals("Imported", 1, StorageMock::importCount);
+    assert<int>::equals("Imported size", IMAGE_SIZE, StorageMock::importedSize);
+    assert<int>::equals("Imported data (1)", 200, StorageMock::imported[0]);
+    assert<int>::equals("Imported data (2)", 200 - 21, StorageMock::imported[(2 * SETTINGS_IMAGE_PAGE_SIZE) + 21]);
+
+    // Out of order
+    writePage(0, IMAGE_SIZE);
+    writePage(2, IMAGE_SIZE);
+    writePage(1, IMAGE_SIZE);
+    assert<int>::equals("Out of order", 1, StorageMock::importCount);
+
+    // Size mismatch
+    writePage(0, IMAGE_SIZE);
+    writePage(1, IMAGE_SIZE + 1);
+    writePage(2, IMAGE_SIZE);
+    assert<int>::equals("Size mismatch", 1, StorageMock::importCount);
+
+    // Too big
+    for (uint8_t page = 0; page < 255; page++)
+        writePage(page, SETTINGS_IMAGE_MAX_SIZE + 1);
+    assert<int>::equals("Too big", 1, StorageMock::importCount);
+
+    // Restart at page 0
+    writePage(0, IMAGE_SIZE);
+    writePage(1, IMAGE_SIZE);
+    writePage(0, IMAGE_SIZE);
+    writePage(1, IMAGE_SIZE);
+    writePage(2, IMAGE_SIZE);
+    assert<int>::equals("Restarted", 2, StorageMock::importCount);
+
+    // Single page
+    writePage(0, SETTINGS_IMAGE_HEADER_SIZE);
+    assert<int>::equals("Single page", 3, StorageMock::importCount);
+    assert<int>::equals("Single page size", SETTINGS_IMAGE_HEADER_SIZE, StorageMock::importedSize);
+}
+
+void TG_writeAndRead()
+{
+    std::cout << "- write and read -" << std::endl;
+    // The Bluetooth stack reads this report after each write
+    int imports = StorageMock::importCount;
+    int exports = StorageMock::exportCount;
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        writePage(page, IMAGE_SIZE);
+        readPage();
+    }
+    assert<int>::equals("Imported", imports + 1, StorageMock::importCount);
+    assert<int>::equals("Imported size", IMAGE_SIZE, StorageMock::importedSize);
+    assert<int>::equals("Imported data (1)", 200, StorageMock::imported[0]);
+    assert<int>::equals("Imported data (2)", 200 - 21, StorageMock::imported[(2 * SETTINGS_IMAGE_PAGE_SIZE) + 21]);
+    assert<int>::equals("No snapshot on read", exports, StorageMock::exportCount);
+
+    // Taking a snapshot while writing does not discard the image
+    StorageMock::seed = 3;
+    writePage(0, IMAGE_SIZE);
+    selectPage(0);
+    writePage(1, IMAGE_SIZE);
+    readPage();
+    writePage(2, IMAGE_SIZE);
+    assert<int>::equals("Imported (2)", imports + 2, StorageMock::importCount);
+    assert<int>::equals("Imported data (3)", 200 - 5, StorageMock::imported[SETTINGS_IMAGE_PAGE_SIZE + 5]);
+    Report10 r10 = readPage();
+    assert<int>::equals("Snapshot intact", 3, r10.data[0]);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report10) == SETTINGS_IMAGE_REPORT_SIZE) && "Test is outdated");
+    StorageService::inject(&storageMock);
+    TG_read();
+    TG_write();
+    TG_writeAndRead();
+    return 0;
+}
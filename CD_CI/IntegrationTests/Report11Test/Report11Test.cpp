@@ -0,0 +1,87 @@
+/**
+ * @file Report11Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint8_t profile;
+    uint8_t state;
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+    uint8_t attempts;
+} Report11;
+
+#define REPORT11BYTES(s) ((uint8_t *)&s)
+
+void writeProfile(uint8_t profile)
+{
+    Report11 r11{};
+    r11.profile = profile;
+    r11.interval = 0xFFFF;
+    internals::hid::common::onSetFeature(RID_FEATURE_BLE_CONNECTION, REPORT11BYTES(r11), sizeof(Report11));
+}
+
+Report11 readReport()
+{
+    Report11 r11{};
+    uint16_t size = internals::hid::common::onGetFeature(
+        RID_FEATURE_BLE_CONNECTION,
+        REPORT11BYTES(r11),
+        sizeof(Report11));
+    assert<uint16_t>::equals("Report size", BLE_CONNECTION_REPORT_SIZE, size);
+    return r11;
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert<size_t>::equals("Test is outdated", BLE_CONNECTION_REPORT_SIZE, sizeof(Report11));
+    internals::hid::common::getReady();
+
+    Report11 r11 = readReport();
+    assert<uint8_t>::equals("Default profile", (uint8_t)BleConnectionProfile::BALANCED, r11.profile);
+    assert<uint8_t>::equals("Not connected", (uint8_t)BleConnectionState::DISCONNECTED, r11.state);
+
+    writeProfile((uint8_t)BleConnectionProfile::COMPETITIVE);
+    r11 = readReport();
+    assert<uint8_t>::equals("Competitive", (uint8_t)BleConnectionProfile::COMPETITIVE, r11.profile);
+    assert<uint16_t>::equals("Read-only interval", 0, r11.interval);
+
+    writeProfile((uint8_t)BleConnectionProfile::_MAX_VALUE + 1);
+    r11 = readReport();
+    assert<uint8_t>::equals("Invalid profile", (uint8_t)BleConnectionProfile::COMPETITIVE, r11.profile);
+
+    writeProfile((uint8_t)BleConnectionProfile::BATTERY);
+    r11 = readReport();
+    assert<uint8_t>::equals("Battery", (uint8_t)BleConnectionProfile::BATTERY, r11.profile);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file Report1Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include <cinttypes>
+#include <cassert>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+uint8_t report1[GAMEPAD_REPORT_SIZE];
+bool notifyConfigChanges = false;
+
+bool sendInput(
+    uint64_t inputsLow,
+    uint64_t inputsHigh = 0ULL,
+    uint8_t POVstate = 0,
+    uint8_t leftAxis = CLUTCH_NONE_VALUE,
+    uint8_t rightAxis = CLUTCH_NONE_VALUE,
+    uint8_t clutchAxis = CLUTCH_NONE_VALUE,
+    bool keepAlive = false)
+{
+    return internals::hid::common::onReportInput(
+        report1,
+        notifyConfigChanges,
+        inputsLow,
+        inputsHigh,
+        POVstate,
+        leftAxis,
+        rightAxis,
+        clutchAxis,
+        keepAlive);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    internals::hid::common::getReady();
+
+    // Layout
+    assert(sendInput(0x0807060504030201ULL, 0x100F0E0D0C0B0A09ULL, 5, 18, 19, 17) && "First report not sent");
+    for (uint8_t i = 0; i < 19; i++)
+        assert((report1[i] == i + 1) && "Bad report layout");
+    assert((report1[19] == 5) && "Bad POV");
+    assert((internals::hid::common::getSuppressedReportCount() == 0) && "Bad count at start");
+
+    // Identical reports are suppressed
+    assert(!sendInput(0x0807060504030201ULL, 0x100F0E0D0C0B0A09ULL, 5, 18, 19, 17) && "Identical report sent");
+    assert((internals::hid::common::getSuppressedReportCount() == 1) && "Bad count (1)");
+
+    // Any change is reported
+    assert(sendInput(0ULL, 0x100F0E0D0C0B0A09ULL, 5, 18, 19, 17) && "Buttons not sent");
+    assert(sendInput(0ULL, 0ULL, 5, 18, 19, 17) && "High buttons not sent");
+    assert(sendInput(0ULL, 0ULL, 0, 18, 19, 17) && "POV not sent");
+    assert(sendInput(0ULL, 0ULL, 0, 0, 19, 17) && "Left axis not sent");
+    assert(sendInput(0ULL, 0ULL, 0, 0, 0, 17) && "Right axis not sent");
+    assert(sendInput(0ULL, 0ULL, 0, 0, 0, 0) && "Clutch axis not sent");
+    assert(!sendInput(0ULL, 0ULL, 0, 0, 0, 0) && "Identical report sent (2)");
+    assert((internals::hid::common::getSuppressedReportCount() == 2) && "Bad count (2)");
+
+    // Changes in the device configuration are always reported
+    notifyConfigChanges = true;
+    assert(sendInput(0ULL) && "Config changes not sent");
+    assert((report1[19] == (RID_FEATURE_CONFIG << 4)) && "Config flag not set");
+    assert(!notifyConfigChanges && "Config flag not cleared");
+    assert(sendInput(0ULL) && "Config flag not removed");
+    assert((report1[19] == 0) && "Config flag not removed from report");
+    assert(!sendInput(0ULL) && "Identical report sent (3)");
+
+    // Reset
+    sendInput(0xFFULL);
+    internals::hid::common::onReset(report1);
+    assert(!sendInput(0ULL) && "Identical report sent after reset");
+
+    // Reconnection
+    OnConnected::notify();
+    assert(sendInput(0ULL) && "Report not sent after reconnection");
+
+    // Keep alive
+    assert(!sendInput(0ULL) && "Identical report sent (4)");
+    assert(sendInput(0ULL, 0ULL, 0, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, true) &&
+           "Keep-alive report not sent");
+    assert(!sendInput(0ULL) && "Identical report sent (5)");
+    assert((internals::hid::common::getSuppressedReportCount() == 6) && "Bad count (3)");
+
+    // A reset does not delay the next keep-alive report
+    internals::hid::common::onReset(report1);
+    assert(sendInput(0ULL, 0ULL, 0, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, true) &&
+           "Keep-alive report not sent after reset");
+
+    // Compact layout: 24 buttons and a hat switch
+    internals::hid::common::setInputLayout(HidInputLayout::fit(23, false, false, true));
+    assert((internals::hid::common::getInputReportSize() == 4) && "Bad compact size");
+    uint16_t descriptorSize;
+    assert((internals::hid::common::getDescriptor(descriptorSize) != nullptr) && "No descriptor");
+    assert((descriptorSize < sizeof(HidDescriptor::data)) && "Descriptor not compact");
+    assert(sendInput(0x0807060504030201ULL, 0x100F0E0D0C0B0A09ULL, 5, 18, 19, 17) && "Compact report not sent");
+    for (uint8_t i = 0; i < 3; i++)
+        assert((report1[i] == i + 1) && "Bad compact layout");
+    assert((report1[3] == 5) && "Bad compact POV");
+    assert(!sendInput(0x0807060504030201ULL, 0ULL, 5, 18, 19, 17) && "Unused inputs reported");
+    notifyConfigChanges = true;
+    assert(sendInput(0x0807060504030201ULL, 0ULL, 5) && "Compact config changes not sent");
+    assert((report1[3] == ((RID_FEATURE_CONFIG << 4) | 5)) && "Compact config flag not set");
+
+    // Compact layout: 8 buttons, clutch paddles, no hat switch
+    internals::hid::common::setInputLayout(HidInputLayout::fit(7, true, true, false));
+    assert((internals::hid::common::getInputReportSize() == 5) && "Bad compact size (2)");
+    assert(sendInput(0x0807060504030201ULL, 0ULL, 5, 18, 19, 17) && "Compact report not sent (2)");
+    assert((report1[0] == 1) && (report1[1] == 17) && (report1[2] == 18) && (report1[3] == 19) && "Bad compact layout (2)");
+    assert((report1[4] == 0) && "POV reported without hat switch");
+
+    // Back to the default layout
+    internals::hid::common::setInputLayout(HidInputLayout{});
+    assert((internals::hid::common::getInputReportSize() == GAMEPAD_REPORT_SIZE) && "Bad default size");
+    assert(sendInput(0ULL) && "Report not sent after layout change");
+}
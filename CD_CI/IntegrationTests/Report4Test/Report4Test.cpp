@@ -18,6 +18,7 @@
 #include "InternalServices.hpp"
 #include "HID_definitions.hpp"
 #include <cinttypes>
+#include <atomic>
 #include <cassert>
 
 //-------------------------------------------------------------------
@@ -37,7 +38,7 @@ typedef struct __attribute__((packed))
 // Mocks
 //-------------------------------------------------------------------
 
-extern uint8_t selectedInput;
+extern std::atomic<uint8_t> selectedInput;
 
 static Report4 received;
 
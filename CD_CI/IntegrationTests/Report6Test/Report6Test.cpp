@@ -0,0 +1,141 @@
+/**
+ * @file Report6Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <atomic>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint8_t index = 0xFF;
+    uint8_t count = 0xFF;
+    uint8_t flags = 0xFF;
+    uint8_t firstInputNumber = 0xFF;
+    uint8_t inputCount = 0xFF;
+    uint8_t reserved[3] = {0xFF, 0xFF, 0xFF};
+    uint32_t minNs = 0xFFFFFFFF;
+    uint32_t avgNs = 0xFFFFFFFF;
+    uint32_t maxNs = 0xFFFFFFFF;
+    uint32_t readCount = 0xFFFFFFFF;
+} Report6;
+
+#define REPORT6BYTES(s) ((uint8_t *)&s)
+
+//-------------------------------------------------------------------
+// Mocks
+//-------------------------------------------------------------------
+
+extern std::atomic<uint8_t> selectedProfile;
+
+class InputMock : public InputService
+{
+public:
+    bool profiling = false;
+
+    virtual void setReadProfiling(bool enable) override
+    {
+        profiling = enable;
+    }
+
+    virtual bool getReadProfiling() override
+    {
+        return profiling;
+    }
+
+    virtual uint8_t getReadCostCount() override
+    {
+        return 2;
+    }
+
+    virtual bool getReadCost(uint8_t index, InputReadCost &cost) override
+    {
+        if (index > 1)
+            return false;
+        cost.firstInputNumber = 10 * index;
+        cost.inputCount = 8;
+        cost.busInput = (index == 1);
+        cost.minNs = 1000 + index;
+        cost.avgNs = 2000 + index;
+        cost.maxNs = 3000 + index;
+        cost.readCount = 50 + index;
+        return true;
+    }
+} inputMock;
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report6) == INPUT_PROFILE_REPORT_SIZE) && "Test is outdated");
+    InputService::inject(&inputMock);
+
+    Report6 r6;
+
+    // Enable profiling and select the second input
+    r6.index = 1;
+    r6.flags = 0x01;
+    internals::hid::common::onSetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert<int>::equals("Selected (1)", 1, selectedProfile);
+    assert(inputMock.profiling && "Profiling not enabled");
+
+    internals::hid::common::onGetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert<int>::equals("Index (1)", 1, r6.index);
+    assert<int>::equals("Count (1)", 2, r6.count);
+    assert<int>::equals("Flags (1)", 0x03, r6.flags);
+    assert<int>::equals("First input number (1)", 10, r6.firstInputNumber);
+    assert<int>::equals("Input count (1)", 8, r6.inputCount);
+    assert<uint32_t>::equals("Min (1)", 1001, r6.minNs);
+    assert<uint32_t>::equals("Avg (1)", 2001, r6.avgNs);
+    assert<uint32_t>::equals("Max (1)", 3001, r6.maxNs);
+    assert<uint32_t>::equals("Read count (1)", 51, r6.readCount);
+
+    // Select the first input without changing the profiling state
+    r6.index = 0;
+    r6.flags = 0xFF;
+    internals::hid::common::onSetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert(inputMock.profiling && "Profiling disabled");
+    internals::hid::common::onGetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert<int>::equals("Index (2)", 0, r6.index);
+    assert<int>::equals("Flags (2)", 0x01, r6.flags);
+    assert<int>::equals("First input number (2)", 0, r6.firstInputNumber);
+    assert<uint32_t>::equals("Avg (2)", 2000, r6.avgNs);
+
+    // Select an invalid input and disable profiling
+    r6.index = 7;
+    r6.flags = 0x00;
+    internals::hid::common::onSetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert(!inputMock.profiling && "Profiling not disabled");
+    internals::hid::common::onGetFeature(RID_FEATURE_INPUT_PROFILE, REPORT6BYTES(r6), sizeof(Report6));
+    assert<int>::equals("Index (3)", 7, r6.index);
+    assert<int>::equals("Flags (3)", 0x00, r6.flags);
+    assert<int>::equals("First input number (3)", 0xFF, r6.firstInputNumber);
+    assert<int>::equals("Input count (3)", 0, r6.inputCount);
+    assert<uint32_t>::equals("Max (3)", 0, r6.maxNs);
+    assert<uint32_t>::equals("Read count (3)", 0, r6.readCount);
+    return 0;
+}
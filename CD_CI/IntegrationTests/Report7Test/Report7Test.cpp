@@ -0,0 +1,128 @@
+/**
+ * @file Report7Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint32_t scanCount;
+    uint32_t scanOverruns;
+    uint32_t hubEvents;
+    uint32_t queueDrops;
+    uint32_t reportsSent;
+    uint32_t reportsSuppressed;
+    uint32_t i2cErrors[2];
+    uint32_t bitQueueOverflows;
+    uint32_t freeHeap;
+    uint16_t queueHighWaterMark;
+    uint16_t stackHighWaterMark[4];
+    uint16_t telemetryDeltasLost;
+    uint32_t hidReportDrops;
+    uint16_t hidWorkerStackHighWaterMark;
+} Report7;
+
+#define REPORT7BYTES(s) ((uint8_t *)&s)
+
+uint8_t report1[GAMEPAD_REPORT_SIZE];
+
+bool sendInput(uint64_t inputsLow)
+{
+    bool notifyConfigChanges = false;
+    uint64_t inputsHigh = 0ULL;
+    uint8_t POVstate = 0;
+    uint8_t axis = CLUTCH_NONE_VALUE;
+    return internals::hid::common::onReportInput(
+        report1,
+        notifyConfigChanges,
+        inputsLow,
+        inputsHigh,
+        POVstate,
+        axis,
+        axis,
+        axis);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report7) == HEALTH_REPORT_SIZE) && "Test is outdated");
+    internals::hid::common::getReady();
+    FirmwareCounters::reset();
+
+    // Counters
+    COUNT_EVENTS(scanCount, 100);
+    COUNT_EVENT(scanOverruns);
+    COUNT_EVENTS(hubEvents, 50);
+    COUNT_EVENTS(queueDrops, 3);
+    COUNT_EVENTS(i2cErrors[1], 7);
+    COUNT_EVENTS(bitQueueOverflows, 2);
+    COUNT_EVENTS(telemetryDeltasLost, 4);
+    COUNT_EVENTS(hidReportDrops, 6);
+    COUNT_MAX(queueHighWaterMark, 12);
+    COUNT_MAX(queueHighWaterMark, 5);
+    assert(sendInput(1ULL) && "Report not sent (1)");
+    assert(!sendInput(1ULL) && "Report not suppressed");
+    assert(sendInput(2ULL) && "Report not sent (2)");
+
+    // Stack usage (fake handles carry the high-water mark)
+    COUNT_TASK(FirmwareTask::INPUT_POLLING, 800);
+    COUNT_TASK(FirmwareTask::INPUT_HUB, 1200);
+    COUNT_TASK(FirmwareTask::UI, 900);
+    COUNT_TASK(FirmwareTask::UI, 600);
+    COUNT_TASK(FirmwareTask::HID_WORKER, 1500);
+
+    Report7 r7;
+    uint16_t size = internals::hid::common::onGetFeature(RID_FEATURE_HEALTH, REPORT7BYTES(r7), sizeof(Report7));
+    assert<uint16_t>::equals("Report size", HEALTH_REPORT_SIZE, size);
+    assert<uint32_t>::equals("Scan count", 100, r7.scanCount);
+    assert<uint32_t>::equals("Scan overruns", 1, r7.scanOverruns);
+    assert<uint32_t>::equals("Hub events", 50, r7.hubEvents);
+    assert<uint32_t>::equals("Queue drops", 3, r7.queueDrops);
+    assert<uint32_t>::equals("Reports sent", 2, r7.reportsSent);
+    assert<uint32_t>::equals("Reports suppressed", 1, r7.reportsSuppressed);
+    assert<uint32_t>::equals("I2C errors (primary)", 0, r7.i2cErrors[0]);
+    assert<uint32_t>::equals("I2C errors (secondary)", 7, r7.i2cErrors[1]);
+    assert<uint32_t>::equals("BitQueue overflows", 2, r7.bitQueueOverflows);
+    assert<uint16_t>::equals("Queue high-water mark", 12, r7.queueHighWaterMark);
+    assert<uint16_t>::equals("Stack (polling)", 800, r7.stackHighWaterMark[0]);
+    assert<uint16_t>::equals("Stack (hub)", 1200, r7.stackHighWaterMark[1]);
+    assert<uint16_t>::equals("Stack (UI)", 600, r7.stackHighWaterMark[2]);
+    assert<uint16_t>::equals("Stack (battery)", 0xFFFF, r7.stackHighWaterMark[3]);
+    assert<uint16_t>::equals("Telemetry deltas lost", 4, r7.telemetryDeltasLost);
+    assert<uint32_t>::equals("HID report drops", 6, r7.hidReportDrops);
+    assert<uint16_t>::equals("Stack (HID worker)", 1500, r7.hidWorkerStackHighWaterMark);
+
+    // Read-only
+    Report7 zero = {};
+    internals::hid::common::onSetFeature(RID_FEATURE_HEALTH, REPORT7BYTES(zero), sizeof(Report7));
+    internals::hid::common::onGetFeature(RID_FEATURE_HEALTH, REPORT7BYTES(r7), sizeof(Report7));
+    assert<uint32_t>::equals("Scan count after write", 100, r7.scanCount);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file Report8Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <atomic>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint32_t sequence = 0xFFFFFFFF;
+    uint32_t count = 0xFFFFFFFF;
+    uint8_t flags = 0xFF;
+    uint8_t bitmapBytes = 0xFF;
+    uint8_t rawLeftAxis = 0xFF;
+    uint8_t rawRightAxis = 0xFF;
+    uint32_t timestampUs = 0xFFFFFFFF;
+    uint64_t inputsLow = 0xFFFFFFFFFFFFFFFFULL;
+    uint64_t inputsHigh = 0xFFFFFFFFFFFFFFFFULL;
+    uint8_t POVstate = 0xFF;
+    uint8_t leftAxis = 0xFF;
+    uint8_t rightAxis = 0xFF;
+    uint8_t clutchAxis = 0xFF;
+    uint64_t rawInputBitmap[INPUT_BITMAP_WORD_COUNT];
+    uint64_t rawInputChanges[INPUT_BITMAP_WORD_COUNT];
+} Report8;
+
+#define REPORT8BYTES(s) ((uint8_t *)&s)
+
+//-------------------------------------------------------------------
+// Mocks
+//-------------------------------------------------------------------
+
+extern std::atomic<uint32_t> selectedTrace;
+
+class InputHubMock : public InputHubService
+{
+public:
+    bool tracing = false;
+    // The two oldest entries were overwritten
+    uint32_t count = EVENT_TRACE_DEPTH + 2;
+
+    virtual void setEventTrace(bool enable) override
+    {
+        tracing = enable;
+    }
+
+    virtual bool getEventTrace() override
+    {
+        return tracing;
+    }
+
+    virtual uint32_t getEventTraceCount() override
+    {
+        return count;
+    }
+
+    virtual bool getEventTraceEntry(uint32_t sequence, InputTraceEntry &entry) override
+    {
+        if ((sequence >= count) || ((count - sequence) > EVENT_TRACE_DEPTH))
+            return false;
+        entry.timestampUs = 1000 * sequence;
+        entry.input.rawInputBitmap = 1ULL << sequence;
+        entry.input.rawInputChanges = 1ULL << sequence;
+        entry.input.leftAxisValue = 10 + sequence;
+        entry.input.rightAxisValue = 20 + sequence;
+        entry.reported = (sequence != 3);
+        entry.inputsLow = 1ULL << sequence;
+        entry.inputsHigh = 0ULL;
+        entry.POVstate = sequence;
+        entry.leftAxis = 30 + sequence;
+        entry.rightAxis = 40 + sequence;
+        entry.clutchAxis = 50 + sequence;
+        return true;
+    }
+} inputHubMock;
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report8) == EVENT_TRACE_REPORT_SIZE) && "Test is outdated");
+    InputHubService::inject(&inputHubMock);
+    internals::hid::common::getReady();
+
+    Report8 r8;
+
+    // Enable recording and select the oldest entry
+    r8.sequence = 0;
+    r8.flags = 0x01;
+    internals::hid::common::onSetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert(inputHubMock.tracing && "Recording not enabled");
+    assert<uint32_t>::equals("Selected (1)", 0, selectedTrace);
+
+    // Overwritten entries are skipped
+    uint16_t size = internals::hid::common::onGetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert<uint16_t>::equals("Report size", EVENT_TRACE_REPORT_SIZE, size);
+    assert<uint32_t>::equals("Sequence (1)", 2, r8.sequence);
+    assert<uint32_t>::equals("Count (1)", EVENT_TRACE_DEPTH + 2, r8.count);
+    assert<int>::equals("Flags (1)", 0x07, r8.flags);
+    assert<int>::equals("Bitmap bytes", INPUT_BITMAP_WIDTH / 8, r8.bitmapBytes);
+    assert<int>::equals("Raw left axis (1)", 12, r8.rawLeftAxis);
+    assert<int>::equals("Raw right axis (1)", 22, r8.rawRightAxis);
+    assert<uint32_t>::equals("Timestamp (1)", 2000, r8.timestampUs);
+    assert<uint64_t>::equals("Inputs low (1)", 1ULL << 2, r8.inputsLow);
+    assert<uint64_t>::equals("Inputs high (1)", 0ULL, r8.inputsHigh);
+    assert<int>::equals("POV (1)", 2, r8.POVstate);
+    assert<int>::equals("Left axis (1)", 32, r8.leftAxis);
+    assert<int>::equals("Right axis (1)", 42, r8.rightAxis);
+    assert<int>::equals("Clutch axis (1)", 52, r8.clutchAxis);
+    assert<uint64_t>::equals("Raw bitmap (1)", 1ULL << 2, r8.rawInputBitmap[0]);
+    assert<uint64_t>::equals("Raw changes (1)", 1ULL << 2, r8.rawInputChanges[0]);
+
+    // Reading does not change the selection
+    assert<uint32_t>::equals("Selected (2)", 0, selectedTrace);
+    internals::hid::common::onGetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert<uint32_t>::equals("Sequence (read again)", 2, r8.sequence);
+
+    // Select the next entry, which was not reported
+    r8.sequence = 3;
+    r8.flags = 0xFF;
+    internals::hid::common::onSetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    internals::hid::common::onGetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert<uint32_t>::equals("Sequence (2)", 3, r8.sequence);
+    assert<int>::equals("Flags (2)", 0x03, r8.flags);
+    assert<int>::equals("Raw left axis (2)", 13, r8.rawLeftAxis);
+    assert<uint64_t>::equals("Inputs low (2)", 0ULL, r8.inputsLow);
+    assert<int>::equals("Clutch axis (2)", 0, r8.clutchAxis);
+
+    // Not recorded yet
+    r8.sequence = EVENT_TRACE_DEPTH + 2;
+    r8.flags = 0xFF;
+    internals::hid::common::onSetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert(inputHubMock.tracing && "Recording disabled");
+    internals::hid::common::onGetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert<uint32_t>::equals("Sequence (3)", EVENT_TRACE_DEPTH + 2, r8.sequence);
+    assert<int>::equals("Flags (3)", 0x01, r8.flags);
+    assert<uint32_t>::equals("Timestamp (3)", 0, r8.timestampUs);
+    internals::hid::common::onGetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert<uint32_t>::equals("Sequence (4)", EVENT_TRACE_DEPTH + 2, r8.sequence);
+
+    // Keep the selection and disable recording
+    r8.sequence = 0xFFFFFFFF;
+    r8.flags = 0x00;
+    internals::hid::common::onSetFeature(RID_FEATURE_EVENT_TRACE, REPORT8BYTES(r8), sizeof(Report8));
+    assert(!inputHubMock.tracing && "Recording not disabled");
+    assert<uint32_t>::equals("Selected (5)", EVENT_TRACE_DEPTH + 2, selectedTrace);
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file Report9Test.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Integration test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "Checksum.hpp"
+#include "cd_ci_assertions.hpp"
+#include <cinttypes>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+typedef struct __attribute__((packed))
+{
+    uint8_t page;
+    uint8_t command; // page count at read
+    uint16_t checksum;
+    uint8_t map[BUTTONS_MAP_PAGE_SIZE][2];
+} Report9;
+
+#define REPORT9BYTES(s) ((uint8_t *)&s)
+#define BOOKED_INPUTS 40
+
+uint16_t checksum(const Report9 &r9)
+{
+    uint16_t crc = crc16(REPORT9BYTES(r9), 2);
+    return crc16(REPORT9BYTES(r9) + 4, sizeof(r9.map), crc);
+}
+
+void selectPage(uint8_t page)
+{
+    Report9 r9{};
+    r9.page = page;
+    r9.command = 0;
+    internals::hid::common::onSetFeature(RID_FEATURE_BUTTONS_MAP_BULK, REPORT9BYTES(r9), sizeof(Report9));
+}
+
+Report9 readPage()
+{
+    Report9 r9;
+    uint16_t size = internals::hid::common::onGetFeature(RID_FEATURE_BUTTONS_MAP_BULK, REPORT9BYTES(r9), sizeof(Report9));
+    assert<uint16_t>::equals("Report size", BUTTONS_MAP_BULK_REPORT_SIZE, size);
+    assert<uint16_t>::equals("Checksum at read", checksum(r9), r9.checksum);
+    return r9;
+}
+
+void writePage(uint8_t page, uint8_t offset, bool corrupt = false)
+{
+    Report9 r9;
+    r9.page = page;
+    r9.command = 1;
+    for (uint8_t i = 0; i < BUTTONS_MAP_PAGE_SIZE; i++)
+    {
+        r9.map[i][0] = (i + offset) % 128;
+        r9.map[i][1] = (i + offset + 1) % 128;
+    }
+    r9.checksum = checksum(r9);
+    if (corrupt)
+        r9.map[3][1] ^= 0x04;
+    internals::hid::common::onSetFeature(RID_FEATURE_BUTTONS_MAP_BULK, REPORT9BYTES(r9), sizeof(Report9));
+}
+
+void assertMap(std::string name, uint8_t firmware_defined, uint8_t noAlt, uint8_t alt)
+{
+    uint8_t actualNoAlt, actualAlt;
+    InputMapService::call::getMap(firmware_defined, actualNoAlt, actualAlt);
+    assert<int>::equals(name + " (no ALT)", noAlt, actualNoAlt);
+    assert<int>::equals(name + " (ALT)", alt, actualAlt);
+}
+
+//-------------------------------------------------------------------
+// Test groups
+//-------------------------------------------------------------------
+
+void TG_read()
+{
+    std::cout << "- read -" << std::endl;
+    selectPage(0);
+    Report9 r9 = readPage();
+    assert<int>::equals("Page", 0, r9.page);
+    assert<int>::equals("Page count", BUTTONS_MAP_PAGE_COUNT, r9.command);
+    for (uint8_t i = 0; i < BUTTONS_MAP_PAGE_SIZE; i++)
+    {
+        assert<int>::equals("Default map (no ALT)", i, r9.map[i][0]);
+        assert<int>::equals("Default map (ALT)", i + 64, r9.map[i][1]);
+    }
+
+    // Reading does not change the selection
+    r9 = readPage();
+    assert<int>::equals("Same page", 0, r9.page);
+
+    selectPage(1);
+    r9 = readPage();
+    assert<int>::equals("Next page", 1, r9.page);
+    for (uint8_t i = 0; i < BUTTONS_MAP_PAGE_SIZE; i++)
+    {
+        uint8_t expected = ((i + BUTTONS_MAP_PAGE_SIZE) < BOOKED_INPUTS) ? (i + BUTTONS_MAP_PAGE_SIZE) : 0xFF;
+        assert<int>::equals("Map at page 1", expected, r9.map[i][0]);
+    }
+
+    // Last page
+    selectPage(BUTTONS_MAP_PAGE_COUNT - 1);
+    r9 = readPage();
+    assert<int>::equals("Last page", BUTTONS_MAP_PAGE_COUNT - 1, r9.page);
+
+    // Invalid page
+    selectPage(BUTTONS_MAP_PAGE_COUNT);
+    r9 = readPage();
+    assert<int>::equals("Page after invalid selection", BUTTONS_MAP_PAGE_COUNT - 1, r9.page);
+}
+
+void TG_write()
+{
+    std::cout << "- write -" << std::endl;
+
+    // Not applied until all pages are received
+    for (uint8_t page = 0; page < BUTTONS_MAP_PAGE_COUNT - 1; page++)
+        writePage(page, 10);
+    assertMap("Partial map", 0, 0, 64);
+    writePage(BUTTONS_MAP_PAGE_COUNT - 1, 10);
+    assertMap("Bulk map (1)", 0, 10, 11);
+    assertMap("Bulk map (2)", BUTTONS_MAP_PAGE_SIZE + 1, 11, 12);
+
+    // Read back
+    selectPage(0);
+    Report9 r9 = readPage();
+    assert<int>::equals("Read back", 15, r9.map[5][0]);
+
+    // Corrupted pages discard the whole map
+    writePage(0, 20);
+    writePage(1, 20, true);
+    for (uint8_t page = 2; page < BUTTONS_MAP_PAGE_COUNT; page++)
+        writePage(page, 20);
+    assertMap("Corrupted map", 0, 10, 11);
+    writePage(1, 20);
+    assertMap("Corrupted map, page written again", 0, 10, 11);
+
+    // Any map starts at page 0
+    for (uint8_t page = 1; page < BUTTONS_MAP_PAGE_COUNT; page++)
+        writePage(page, 30);
+    writePage(0, 30);
+    assertMap("Map not started at page 0", 0, 10, 11);
+    for (uint8_t page = 1; page < BUTTONS_MAP_PAGE_COUNT; page++)
+        writePage(page, 30);
+    assertMap("Bulk map (3)", 0, 30, 31);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report9) == BUTTONS_MAP_BULK_REPORT_SIZE) && "Test is outdated");
+    InputNumber::clearBook();
+    for (uint8_t i = 0; i < BOOKED_INPUTS; i++)
+    {
+        InputNumber n = i;
+        n.book();
+    }
+    internals::inputMap::getReady();
+    OnStart::notify();
+
+    TG_read();
+    TG_write();
+    return 0;
+}
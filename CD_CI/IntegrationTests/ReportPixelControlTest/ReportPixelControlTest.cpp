@@ -22,6 +22,7 @@
 #include <cinttypes>
 #include <cassert>
 #include <iostream>
+#include <chrono>
 
 //-------------------------------------------------------------------
 // Auxiliary
@@ -31,6 +32,9 @@ extern uint32_t lastPixelColor;
 extern PixelGroup lastPixelGroup;
 extern bool shown;
 extern uint8_t lastPixelIndex;
+extern uint32_t pixelColor[3][16];
+extern uint32_t pixelCallCount;
+extern uint32_t pixelShowCount;
 
 typedef struct __attribute__((packed))
 {
@@ -44,6 +48,41 @@ typedef struct __attribute__((packed))
 
 #define REPORT30BYTES(s) ((uint8_t *)&s)
 
+typedef struct __attribute__((packed))
+{
+    uint8_t group = 0;
+    uint8_t flags = 0;
+    uint8_t firstIndex = 0;
+    uint8_t count = 0;
+    uint8_t items[3 * PIXEL_FRAME_MAX_PIXELS]{};
+} Report31;
+
+#define REPORT31BYTES(s) ((uint8_t *)&s)
+
+void setItem(Report31 &r31, uint8_t index, uint32_t color)
+{
+    r31.items[index * 3] = (uint8_t)color;
+    r31.items[index * 3 + 1] = (uint8_t)(color >> 8);
+    r31.items[index * 3 + 2] = (uint8_t)(color >> 16);
+}
+
+void setRun(Report31 &r31, uint8_t index, uint8_t length, uint32_t color)
+{
+    r31.items[index * 4] = length;
+    r31.items[index * 4 + 1] = (uint8_t)color;
+    r31.items[index * 4 + 2] = (uint8_t)(color >> 8);
+    r31.items[index * 4 + 3] = (uint8_t)(color >> 16);
+}
+
+void assertColors(std::string msg, PixelGroup grp, uint8_t from, uint8_t to, uint32_t color)
+{
+    for (uint8_t i = from; i <= to; i++)
+        assert<uint32_t>::equals(
+            msg + ": pixel " + std::to_string(i),
+            color,
+            pixelColor[(uint8_t)grp][i]);
+}
+
 void assertPixel(std::string msg, PixelGroup grp, uint8_t index, uint32_t color, bool isShown = false)
 {
     assert<uint8_t>::equals(msg + ": pixel group", (uint8_t)grp, (uint8_t)lastPixelGroup);
@@ -53,16 +92,14 @@ void assertPixel(std::string msg, PixelGroup grp, uint8_t index, uint32_t color,
 }
 
 //-------------------------------------------------------------------
-//-------------------------------------------------------------------
-// Entry point
-//-------------------------------------------------------------------
+// Test groups
 //-------------------------------------------------------------------
 
 using namespace telemetry;
 
-int main()
+void TG_singlePixel()
 {
-    assert((sizeof(Report30) == PIXEL_REPORT_SIZE) && "Test is outdated");
+    std::cout << "- single pixel -" << std::endl;
 
     Report30 r30;
     r30.group = 0;
@@ -97,3 +134,183 @@ int main()
     internals::hid::common::onOutput(RID_OUTPUT_PIXEL, REPORT30BYTES(r30), sizeof(r30));
     assertPixel("Reset", PixelGroup::GRP_TELEMETRY, 0, 0, false);
 }
+
+void TG_range()
+{
+    std::cout << "- range -" << std::endl;
+    internals::pixels::reset();
+
+    Report31 r31;
+    r31.group = 1;
+    r31.firstIndex = 2;
+    r31.count = 3;
+    setItem(r31, 0, 0x010203);
+    setItem(r31, 1, 0x040506);
+    setItem(r31, 2, 0x070809);
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assertColors("Range (before)", PixelGroup::GRP_BUTTONS, 0, 1, 0);
+    assertColors("Range (1)", PixelGroup::GRP_BUTTONS, 2, 2, 0x010203);
+    assertColors("Range (2)", PixelGroup::GRP_BUTTONS, 3, 3, 0x040506);
+    assertColors("Range (3)", PixelGroup::GRP_BUTTONS, 4, 4, 0x070809);
+    assertColors("Range (after)", PixelGroup::GRP_BUTTONS, 5, 15, 0);
+    assertColors("Range (other group)", PixelGroup::GRP_TELEMETRY, 0, 15, 0);
+    assert<bool>::equals("Range: not shown", false, shown);
+
+    r31.flags = PIXEL_FRAME_FLAG_SHOW;
+    r31.count = 0;
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assert<bool>::equals("Implicit show", true, shown);
+    assertColors("Show only", PixelGroup::GRP_BUTTONS, 2, 2, 0x010203);
+
+    internals::pixels::reset();
+    r31.group = 3;
+    r31.flags = PIXEL_FRAME_FLAG_SHOW;
+    r31.count = 1;
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assert<bool>::equals("Invalid group", false, shown);
+
+    r31.group = 0;
+    r31.count = PIXEL_FRAME_MAX_PIXELS + 1;
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assert<bool>::equals("Invalid count", false, shown);
+    assertColors("Invalid count", PixelGroup::GRP_TELEMETRY, 0, 15, 0);
+
+    r31.count = 1;
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), PIXEL_FRAME_REPORT_SIZE - 1);
+    assert<bool>::equals("Short report", false, shown);
+}
+
+void TG_rle()
+{
+    std::cout << "- RLE -" << std::endl;
+    internals::pixels::reset();
+
+    Report31 r31;
+    r31.group = 0;
+    r31.flags = PIXEL_FRAME_FLAG_RLE | PIXEL_FRAME_FLAG_SHOW;
+    r31.firstIndex = 1;
+    r31.count = 4;
+    setRun(r31, 0, 5, 0x00FF00);
+    setRun(r31, 1, 0, 0x123456);
+    setRun(r31, 2, 4, 0xFFFF00);
+    setRun(r31, 3, 3, 0xFF0000);
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assertColors("RLE (before)", PixelGroup::GRP_TELEMETRY, 0, 0, 0);
+    assertColors("RLE (green)", PixelGroup::GRP_TELEMETRY, 1, 5, 0x00FF00);
+    assertColors("RLE (yellow)", PixelGroup::GRP_TELEMETRY, 6, 9, 0xFFFF00);
+    assertColors("RLE (red)", PixelGroup::GRP_TELEMETRY, 10, 12, 0xFF0000);
+    assertColors("RLE (after)", PixelGroup::GRP_TELEMETRY, 13, 15, 0);
+    assert<bool>::equals("RLE: shown", true, shown);
+
+    internals::pixels::reset();
+    r31.firstIndex = 250;
+    r31.count = 1;
+    setRun(r31, 0, 255, 0x0000FF);
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assert<uint8_t>::equals("RLE overflow", 250, lastPixelIndex);
+
+    internals::pixels::reset();
+    r31.count = PIXEL_FRAME_MAX_RUNS + 1;
+    internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+    assert<bool>::equals("RLE: invalid count", false, shown);
+}
+
+void TG_throughput()
+{
+    std::cout << "- throughput -" << std::endl;
+
+    // A 16-LED rev strip plus 16 button backlights
+    constexpr int frames = 10000;
+    uint32_t revColor[16];
+    for (int i = 0; i < 16; i++)
+        revColor[i] = (i < 5) ? 0x00FF00 : ((i < 10) ? 0xFFFF00 : 0xFF0000);
+
+    // Single pixel reports
+    internals::pixels::reset();
+    pixelCallCount = 0;
+    pixelShowCount = 0;
+    uint32_t singleReports = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        Report30 r30;
+        for (uint8_t grp = 0; grp < 2; grp++)
+            for (uint8_t i = 0; i < 16; i++)
+            {
+                r30.group = grp;
+                r30.index = i;
+                r30.blue = (uint8_t)revColor[i];
+                r30.green = (uint8_t)(revColor[i] >> 8);
+                r30.red = (uint8_t)(revColor[i] >> 16);
+                internals::hid::common::onOutput(RID_OUTPUT_PIXEL, REPORT30BYTES(r30), sizeof(r30));
+                singleReports++;
+            }
+        r30.group = 0xFF;
+        internals::hid::common::onOutput(RID_OUTPUT_PIXEL, REPORT30BYTES(r30), sizeof(r30));
+        singleReports++;
+    }
+    auto singleTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    assert<uint32_t>::equals("Single: shown frames", frames, pixelShowCount);
+    assertColors("Single: rev strip", PixelGroup::GRP_TELEMETRY, 0, 4, 0x00FF00);
+    assertColors("Single: backlights", PixelGroup::GRP_BUTTONS, 10, 15, 0xFF0000);
+
+    // Range report for the backlights, RLE report for the rev strip
+    internals::pixels::reset();
+    pixelCallCount = 0;
+    pixelShowCount = 0;
+    uint32_t frameReports = 0;
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        Report31 r31;
+        r31.group = 1;
+        r31.count = 16;
+        for (uint8_t i = 0; i < 16; i++)
+            setItem(r31, i, revColor[i]);
+        internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+        frameReports++;
+
+        r31.group = 0;
+        r31.flags = PIXEL_FRAME_FLAG_RLE | PIXEL_FRAME_FLAG_SHOW;
+        r31.count = 3;
+        setRun(r31, 0, 5, 0x00FF00);
+        setRun(r31, 1, 5, 0xFFFF00);
+        setRun(r31, 2, 6, 0xFF0000);
+        internals::hid::common::onOutput(RID_OUTPUT_PIXEL_FRAME, REPORT31BYTES(r31), sizeof(r31));
+        frameReports++;
+    }
+    auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    assert<uint32_t>::equals("Frame: shown frames", frames, pixelShowCount);
+    assertColors("Frame: rev strip (green)", PixelGroup::GRP_TELEMETRY, 0, 4, 0x00FF00);
+    assertColors("Frame: rev strip (yellow)", PixelGroup::GRP_TELEMETRY, 5, 9, 0xFFFF00);
+    assertColors("Frame: rev strip (red)", PixelGroup::GRP_TELEMETRY, 10, 15, 0xFF0000);
+    assertColors("Frame: backlights", PixelGroup::GRP_BUTTONS, 10, 15, 0xFF0000);
+    assert<uint32_t>::equals("Frame: pixel calls per frame", 16 + 3, pixelCallCount / frames);
+
+    std::cout << "Reports per frame: "
+              << (singleReports / frames) << " (single pixel), "
+              << (frameReports / frames) << " (pixel frame)" << std::endl;
+    std::cout << "Time per frame (ns): "
+              << (singleTime.count() * 1000 / frames) << " (single pixel), "
+              << (frameTime.count() * 1000 / frames) << " (pixel frame)" << std::endl;
+    assert<uint32_t>::equals("Single: reports per frame", 33, singleReports / frames);
+    assert<uint32_t>::equals("Frame: reports per frame", 2, frameReports / frames);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    assert((sizeof(Report30) == PIXEL_REPORT_SIZE) && "Test is outdated");
+    assert((sizeof(Report31) == PIXEL_FRAME_REPORT_SIZE) && "Test is outdated");
+    TG_singlePixel();
+    TG_range();
+    TG_rle();
+    TG_throughput();
+}
@@ -22,6 +22,7 @@
 #include <cinttypes>
 #include <cassert>
 #include <iostream>
+#include <cstring>
 
 //-------------------------------------------------------------------
 // Auxiliary
@@ -35,6 +36,31 @@ uint8_t report23[] = {0x56, 0x71, 0x00, 0xb0, 0x04, 0x5e, 0x27, 0xbf, 0x04, 0x01
 #define BYTES(s) ((uint8_t *)&s)
 #define AS_UINT16(s) *((uint16_t *)(s))
 
+uint8_t report24[TELEMETRY_DELTA_REPORT_SIZE];
+uint8_t report24Index = 0;
+
+void beginDelta(uint8_t sequence, uint8_t flags = 0)
+{
+    memset(report24, 0, sizeof(report24));
+    report24[0] = sequence;
+    report24[1] = flags;
+    report24Index = 2;
+}
+
+void addDelta(uint8_t tag, uint8_t length, uint16_t value)
+{
+    report24[report24Index++] = tag;
+    report24[report24Index++] = length;
+    report24[report24Index++] = (uint8_t)value;
+    if (length > 1)
+        report24[report24Index++] = (uint8_t)(value >> 8);
+}
+
+void sendDelta()
+{
+    internals::hid::common::onOutput(RID_OUTPUT_TELEMETRY_DELTA, report24, sizeof(report24));
+}
+
 //-------------------------------------------------------------------
 // Mocks
 //-------------------------------------------------------------------
@@ -102,4 +128,75 @@ int main()
     assert(data.gauges.oilTemperature == 1215);
     assert(data.gauges.relativeRemainingFuel == 1);
     assert(data.gauges.absoluteRemainingFuel == 116);
+
+    // Report 24
+    std::cout << "- Report 24 (telemetry delta) -" << std::endl;
+    FirmwareCounters::reset();
+    uint32_t frameID = data.frameID;
+    beginDelta(10, TELEMETRY_DELTA_FLAG_RESYNC);
+    addDelta(0x11, 2, 7000);
+    sendDelta();
+    assert<uint32_t>::equals("Delta: frame ID", frameID + 1, data.frameID);
+    assert<uint16_t>::equals("Delta: rpm", 7000, data.powertrain.rpm);
+    assert<char>::equals("Delta: gear unchanged", 0x4B, data.powertrain.gear);
+    assert<uint16_t>::equals("Delta: speed unchanged", 320, data.powertrain.speed);
+    assert<uint8_t>::equals("Delta: rpm percent unchanged", 99, data.powertrain.rpmPercent);
+
+    beginDelta(11);
+    addDelta(0x36, 1, 0);
+    addDelta(0x28, 1, 0xFF);
+    addDelta(0x51, 2, 0xFFFF);
+    addDelta(0x19, 2, 0xFFFF);
+    addDelta(0x41, 2, 250);
+    addDelta(0x10, 1, 'N');
+    sendDelta();
+    assert<bool>::equals("Delta: yellow flag", false, data.raceControl.yellowFlag);
+    assert<bool>::equals("Delta: black flag unchanged", true, data.raceControl.blackFlag);
+    assert<uint16_t>::equals("Delta: remaining laps unchanged", 2530, data.raceControl.remainingLaps);
+    assert<uint8_t>::equals("Delta: brake bias", 100, data.ecu.brakeBias);
+    assert<uint8_t>::equals("Delta: TC level unchanged", 7, data.ecu.tcLevel);
+    assert<float>::almostEquals("Delta: turbo pressure", 2.5, data.gauges.absoluteTurboPressure, 0.01);
+    assert<uint16_t>::equals("Delta: water temperature unchanged", 1200, data.gauges.waterTemperature);
+    assert<uint16_t>::equals("Delta: speed (out of range entry)", 320, data.powertrain.speed);
+    assert<char>::equals("Delta: gear", 'N', data.powertrain.gear);
+    assert<uint16_t>::equals("Delta: rpm kept", 7000, data.powertrain.rpm);
+
+    // A full report overrides previous deltas
+    internals::hid::common::onOutput(RID_OUTPUT_POWERTRAIN, report20, sizeof(report20));
+    assert<uint16_t>::equals("Full: rpm", 1630, data.powertrain.rpm);
+    beginDelta(12);
+    addDelta(0x13, 1, 50);
+    sendDelta();
+    assert<uint16_t>::equals("Delta after full: rpm", 1630, data.powertrain.rpm);
+    assert<uint8_t>::equals("Delta after full: rpm percent", 50, data.powertrain.rpmPercent);
+
+    // Entries past the end of the report are ignored
+    beginDelta(13);
+    report24[2] = 0x11;
+    report24[3] = TELEMETRY_DELTA_REPORT_SIZE;
+    sendDelta();
+    assert<uint16_t>::equals("Truncated entry", 1630, data.powertrain.rpm);
+
+    // Sequence numbers
+    assert<uint32_t>::equals("No deltas lost", 0, FirmwareCounters::telemetryDeltasLost);
+    beginDelta(16);
+    sendDelta();
+    assert<uint32_t>::equals("Deltas lost", 2, FirmwareCounters::telemetryDeltasLost);
+    beginDelta(12);
+    sendDelta();
+    assert<uint32_t>::equals("Host started over", 2, FirmwareCounters::telemetryDeltasLost);
+    beginDelta(0, TELEMETRY_DELTA_FLAG_RESYNC);
+    sendDelta();
+    assert<uint32_t>::equals("Resync", 2, FirmwareCounters::telemetryDeltasLost);
+    beginDelta(1);
+    sendDelta();
+    beginDelta(2);
+    sendDelta();
+    assert<uint32_t>::equals("In sequence", 2, FirmwareCounters::telemetryDeltasLost);
+
+    // Reports posted by the transport layer (processed at once in CD_CI)
+    beginDelta(3);
+    addDelta(0x11, 2, 8000);
+    internals::hid::common::postOutput(RID_OUTPUT_TELEMETRY_DELTA, report24, sizeof(report24));
+    assert<uint16_t>::equals("Posted delta: rpm", 8000, data.powertrain.rpm);
 }
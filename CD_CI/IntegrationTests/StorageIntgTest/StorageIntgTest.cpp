@@ -16,8 +16,12 @@
 #include "SimWheel.hpp"
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
+#include "SettingsImage.hpp"
+#include "Checksum.hpp"
+#include "cd_ci_assertions.hpp"
 
 #include <iostream>
+#include <cstring>
 
 //-------------------------------------------------------------------
 // Mocks
@@ -149,10 +153,21 @@ public:
         uint8_t &user_defined_alt)
     {
         _saved = true;
-        user_defined = 0;
-        user_defined_alt = 0;
+        user_defined = firmware_defined;
+        user_defined_alt = firmware_defined + 64;
     }
     virtual void resetMap() MOCK;
+
+    inline static bool _bulkLoaded = false;
+    inline static uint8_t _lastAlt = 0;
+
+    virtual void setMaps(
+        const uint8_t *user_defined,
+        const uint8_t *user_defined_alt) override
+    {
+        _bulkLoaded = true;
+        _lastAlt = user_defined_alt[INPUT_BITMAP_WIDTH - 1];
+    }
 } inputMapMock;
 
 //-------------------------------------------------------------------
@@ -203,6 +218,7 @@ public:
         uint16_t &customPID) override
     {
         _saved = true;
+        _getCount++;
         customVID = 100;
         customPID = 100;
     }
@@ -210,9 +226,51 @@ public:
     virtual void setCustomHardwareID(
         uint16_t customVID,
         uint16_t customPID,
-        bool save) override { _loaded = !save; }
+        bool save) override
+    {
+        _loaded = !save;
+        _loadedVID = customVID;
+        _loadedPID = customPID;
+    }
+
+    inline static int _getCount = 0;
+    inline static uint16_t _loadedVID = 0;
+    inline static uint16_t _loadedPID = 0;
 } hidMock;
 
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+void clearLoadedFlags()
+{
+    InputServiceMock::_pulseLoaded = false;
+    InputServiceMock::_axisCalLoaded = false;
+    InputServiceMock::_polarityLoaded = false;
+    InputHubMock::_secLockLoaded = false;
+    InputHubMock::_bpLoaded = false;
+    InputHubMock::_clutchWMLoaded = false;
+    InputHubMock::_altWMLoaded = false;
+    InputHubMock::_dpadWMLoaded = false;
+    InputMapMock::_bulkLoaded = false;
+    BattCalMock::_calDataLoaded = false;
+    BattCalMock::_autoParamLoaded = false;
+    HidMock::_loaded = false;
+    HidMock::_loadedVID = 0;
+    HidMock::_loadedPID = 0;
+}
+
+// Compute the size and CRC of a hand-made image again
+void seal(uint8_t *image, uint16_t size)
+{
+    image[6] = size & 0xFF;
+    image[7] = size >> 8;
+    uint16_t crc = crc16(image, SETTINGS_IMAGE_CRC_INDEX);
+    crc = crc16(image + SETTINGS_IMAGE_HEADER_SIZE, size - SETTINGS_IMAGE_HEADER_SIZE, crc);
+    image[SETTINGS_IMAGE_CRC_INDEX] = crc & 0xFF;
+    image[SETTINGS_IMAGE_CRC_INDEX + 1] = crc >> 8;
+}
+
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 // Test groups
@@ -304,6 +362,106 @@ void TG_Hid()
     assert((HidMock::_loaded) && "Hardware id not loaded");
 }
 
+//-------------------------------------------------------------------
+
+void TG_SettingsImage()
+{
+    std::cout << "- Settings image -" << std::endl;
+    uint8_t image[SETTINGS_IMAGE_MAX_SIZE];
+    uint8_t copy[SETTINGS_IMAGE_MAX_SIZE];
+
+    // Export
+    uint16_t size = StorageService::call::exportSettings(image);
+    assert((memcmp(image, SETTINGS_IMAGE_MAGIC, 4) == 0) && "Bad magic number");
+    assert<int>::equals("Version", SETTINGS_IMAGE_VERSION, image[4]);
+    // Note: the security lock and the custom hardware ID are not exported
+    assert<int>::equals("Record count", (int)UserSetting::_MAX_VALUE - 2, image[5]);
+    assert<int>::equals("Size field", size, image[6] | (image[7] << 8));
+    assert<int>::equals(
+        "Image size",
+        SETTINGS_IMAGE_HEADER_SIZE +
+            ((int)UserSetting::_MAX_VALUE - 2) * SETTINGS_IMAGE_RECORD_HEADER_SIZE +
+            16 + 2 + 5 * 1 + 2 * INPUT_BITMAP_WIDTH + 4 + 2,
+        size);
+    for (uint16_t index = SETTINGS_IMAGE_HEADER_SIZE; index < size;)
+    {
+        assert((image[index] != (uint8_t)UserSetting::SECURITY_LOCK) && "Sec lock exported");
+        assert((image[index] != (uint8_t)UserSetting::CUSTOM_HARDWARE_ID) && "Hardware ID exported");
+        index += SETTINGS_IMAGE_RECORD_HEADER_SIZE + (image[index + 1] | (image[index + 2] << 8));
+    }
+
+    // Import
+    // Note: each save calls getCustomHardwareID() once
+    clearLoadedFlags();
+    HidMock::_getCount = 0;
+    assert(StorageService::call::importSettings(image, size) && "Valid image rejected");
+    assert((InputServiceMock::_pulseLoaded) && "Pulse width not imported");
+    assert((InputServiceMock::_axisCalLoaded) && "Axis calibration not imported");
+    assert((InputServiceMock::_polarityLoaded) && "Axis polarity not imported");
+    assert((!InputHubMock::_secLockLoaded) && "Sec lock imported");
+    assert((InputHubMock::_bpLoaded) && "Bite point not imported");
+    assert((InputHubMock::_clutchWMLoaded) && "Clutch wm not imported");
+    assert((InputHubMock::_altWMLoaded) && "Alt wm not imported");
+    assert((InputHubMock::_dpadWMLoaded) && "DPAD wm not imported");
+    assert((InputMapMock::_bulkLoaded) && "Map not imported");
+    assert<int>::equals("Imported map", (INPUT_BITMAP_WIDTH - 1 + 64) % 256, InputMapMock::_lastAlt);
+    assert((BattCalMock::_calDataLoaded) && "Batt data not imported");
+    assert((BattCalMock::_autoParamLoaded) && "Batt autocal not imported");
+    assert((!HidMock::_loaded) && "Hardware ID imported");
+    assert<int>::equals("Saved once", 1, HidMock::_getCount);
+
+    // Corrupted images are not applied at all
+    memcpy(copy, image, size);
+    copy[size - 1] ^= 0x01;
+    clearLoadedFlags();
+    HidMock::_getCount = 0;
+    assert(!StorageService::call::importSettings(copy, size) && "Corrupted image accepted");
+    assert(!StorageService::call::importSettings(image, size - 1) && "Truncated image accepted");
+    memcpy(copy, image, size);
+    copy[4] = SETTINGS_IMAGE_VERSION + 1;
+    seal(copy, size);
+    assert(!StorageService::call::importSettings(copy, size) && "Unknown version accepted");
+    memcpy(copy, image, size);
+    copy[SETTINGS_IMAGE_HEADER_SIZE + 1] = 15; // Wrong payload size of the first record
+    seal(copy, size);
+    assert(!StorageService::call::importSettings(copy, size) && "Bad record accepted");
+    assert(!InputHubMock::_bpLoaded && !InputMapMock::_bulkLoaded && "Partially applied");
+    assert<int>::equals("Saved after rejection", 0, HidMock::_getCount);
+
+    // Unknown records are ignored
+    memcpy(copy, image, size);
+    copy[size] = 0xF0;
+    copy[size + 1] = 1;
+    copy[size + 2] = 0;
+    copy[size + 3] = 0xAA;
+    copy[5]++;
+    seal(copy, size + 4);
+    assert(StorageService::call::importSettings(copy, size + 4) && "Unknown record not ignored");
+    assert((InputHubMock::_bpLoaded) && "Not applied with unknown record");
+
+    // An image can not change the security lock nor the custom hardware ID
+    memcpy(copy, image, size);
+    uint16_t forged = size;
+    copy[forged++] = (uint8_t)UserSetting::SECURITY_LOCK;
+    copy[forged++] = 1;
+    copy[forged++] = 0;
+    copy[forged++] = 1;
+    copy[forged++] = (uint8_t)UserSetting::CUSTOM_HARDWARE_ID;
+    copy[forged++] = 4;
+    copy[forged++] = 0;
+    copy[forged++] = 0x34;
+    copy[forged++] = 0x12;
+    copy[forged++] = 0x78;
+    copy[forged++] = 0x56;
+    copy[5] += 2;
+    seal(copy, forged);
+    clearLoadedFlags();
+    assert(StorageService::call::importSettings(copy, forged) && "Forged image rejected");
+    assert((InputHubMock::_bpLoaded) && "Forged image not applied");
+    assert((!InputHubMock::_secLockLoaded) && "Sec lock changed by an image");
+    assert((!HidMock::_loaded) && "Hardware ID changed by an image");
+}
+
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 // Entry point
@@ -326,6 +484,7 @@ int main()
     TG_InputMap();
     TG_BattCal();
     TG_Hid();
+    TG_SettingsImage();
 
     return 0;
 }
@@ -118,9 +118,23 @@ void test2()
     assert(result && "Seq1+seq1 is not equal to the poped sequence (2)");
 }
 
+void test3()
+{
+    std::cout << "- Test 3-" << std::endl;
+    FirmwareCounters::reset();
+    BitQueue q;
+    for (int i = 0; i < 63; i++)
+        q.enqueue(true);
+    assert((FirmwareCounters::bitQueueOverflows == 0) && "Overflow counted while not full");
+    q.enqueue(true);
+    q.enqueue(false);
+    assert((FirmwareCounters::bitQueueOverflows == 2) && "Overflow not counted");
+}
+
 int main()
 {
     test0();
     test1();
     test2();
+    test3();
 }
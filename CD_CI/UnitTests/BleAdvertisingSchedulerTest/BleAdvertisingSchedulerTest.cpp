@@ -0,0 +1,145 @@
+/**
+ * @file BleAdvertisingSchedulerTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "BleAdvertisingScheduler.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+
+//------------------------------------------------------------------
+// Mocks
+//------------------------------------------------------------------
+
+class MockAdvertiser : public BleAdvertiser
+{
+public:
+    bool bonded = true;
+    uint32_t startCount = 0;
+    BleAdvertisingParameters current{false, 0, 0};
+
+    virtual bool startAdvertising(const BleAdvertisingParameters &params) override
+    {
+        if (params.bondedOnly && !bonded)
+            return false;
+        startCount++;
+        current = params;
+        return true;
+    }
+};
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+void assertPhase(std::string text, BleAdvertisingPhase expected, BleAdvertisingScheduler &scheduler)
+{
+    assert<int>::equals(text, (int)expected, (int)scheduler.getPhase());
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_phases()
+{
+    std::cout << "- phases -" << std::endl;
+    MockAdvertiser advertiser;
+    BleAdvertisingScheduler scheduler(advertiser, 1000, 5000);
+    assertPhase("Initial", BleAdvertisingPhase::IDLE, scheduler);
+
+    assert<uint32_t>::equals("Bonded duration", 1000, scheduler.start(100, true));
+    assertPhase("Bonded", BleAdvertisingPhase::BONDED, scheduler);
+    assert<bool>::equals("White list", true, advertiser.current.bondedOnly);
+
+    assert<uint32_t>::equals("Fast duration", 5000, scheduler.onPhaseTimeout());
+    assertPhase("Fast", BleAdvertisingPhase::FAST, scheduler);
+    assert<bool>::equals("No white list", false, advertiser.current.bondedOnly);
+    uint16_t fastInterval = advertiser.current.maxInterval;
+
+    assert<uint32_t>::equals("Slow duration", 0, scheduler.onPhaseTimeout());
+    assertPhase("Slow", BleAdvertisingPhase::SLOW, scheduler);
+    assert((advertiser.current.minInterval > fastInterval) && "Slow phase is not slower");
+
+    // Slow advertising lasts forever
+    assert<uint32_t>::equals("Still slow", 0, scheduler.onPhaseTimeout());
+    assert<uint32_t>::equals("Advertising restarts", 3, advertiser.startCount);
+}
+
+void TG_connection()
+{
+    std::cout << "- connection -" << std::endl;
+    MockAdvertiser advertiser;
+    BleAdvertisingScheduler scheduler(advertiser, 1000, 5000);
+
+    scheduler.start(2000, true);
+    assert<uint32_t>::equals("Time to connect", 350, scheduler.onConnected(2350));
+    assertPhase("Idle", BleAdvertisingPhase::IDLE, scheduler);
+    assert<int>::equals(
+        "Phase at connection",
+        (int)BleAdvertisingPhase::BONDED,
+        (int)scheduler.lastConnectionPhase);
+
+    // A late timeout does not restart advertising
+    assert<uint32_t>::equals("Late timeout", 0, scheduler.onPhaseTimeout());
+    assert<uint32_t>::equals("No restart", 1, advertiser.startCount);
+
+    scheduler.start(10000, true);
+    scheduler.onPhaseTimeout();
+    scheduler.onPhaseTimeout();
+    assert<uint32_t>::equals("Time to connect (slow)", 7500, scheduler.onConnected(17500));
+    assert<int>::equals(
+        "Phase at connection (slow)",
+        (int)BleAdvertisingPhase::SLOW,
+        (int)scheduler.lastConnectionPhase);
+
+    // Connection while not advertising keeps the last figures
+    assert<uint32_t>::equals("Not advertising", 7500, scheduler.onConnected(20000));
+}
+
+void TG_skipped()
+{
+    std::cout << "- skipped phases -" << std::endl;
+    MockAdvertiser advertiser;
+    BleAdvertisingScheduler scheduler(advertiser, 1000, 5000);
+
+    // No bonded host
+    assert<uint32_t>::equals("Fast first", 5000, scheduler.start(0, false));
+    assertPhase("Fast", BleAdvertisingPhase::FAST, scheduler);
+
+    // The bond is gone
+    advertiser.bonded = false;
+    assert<uint32_t>::equals("Bonded failed", 5000, scheduler.start(0, true));
+    assertPhase("Fast (2)", BleAdvertisingPhase::FAST, scheduler);
+
+    // Disabled phases
+    MockAdvertiser advertiser2;
+    BleAdvertisingScheduler slowOnly(advertiser2, 0, 0);
+    assert<uint32_t>::equals("Slow only", 0, slowOnly.start(0, true));
+    assertPhase("Slow", BleAdvertisingPhase::SLOW, slowOnly);
+    assert<uint32_t>::equals("Single start", 1, advertiser2.startCount);
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_phases();
+    TG_connection();
+    TG_skipped();
+    return 0;
+}
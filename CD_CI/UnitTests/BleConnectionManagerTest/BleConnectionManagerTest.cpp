@@ -0,0 +1,199 @@
+/**
+ * @file BleConnectionManagerTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "BleConnectionManager.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+
+//------------------------------------------------------------------
+// Mocks
+//------------------------------------------------------------------
+
+class MockConnection : public BleConnection
+{
+public:
+    bool refuse = false;
+    uint32_t requestCount = 0;
+    BleConnectionParameters lastRequest{0, 0, 0, 0};
+
+    virtual bool requestParameters(const BleConnectionParameters &params) override
+    {
+        requestCount++;
+        lastRequest = params;
+        return !refuse;
+    }
+} connection;
+
+BleConnectionManager manager(connection);
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+void assertState(std::string text, BleConnectionState expected)
+{
+    assert<int>::equals(text, (int)expected, (int)manager.getStatus().state);
+}
+
+void assertRequest(std::string text, uint16_t minInterval, uint16_t maxInterval, uint16_t latency)
+{
+    assert<uint16_t>::equals(text + " (min interval)", minInterval, connection.lastRequest.minInterval);
+    assert<uint16_t>::equals(text + " (max interval)", maxInterval, connection.lastRequest.maxInterval);
+    assert<uint16_t>::equals(text + " (latency)", latency, connection.lastRequest.latency);
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_profiles()
+{
+    std::cout << "- profiles -" << std::endl;
+    BleConnectionParameters params;
+    params = BleConnectionManager::parametersFor(BleConnectionProfile::COMPETITIVE);
+    assert<uint16_t>::equals("Competitive interval", 6, params.maxInterval);
+    assert<uint16_t>::equals("Competitive latency", 0, params.latency);
+    params = BleConnectionManager::parametersFor(BleConnectionProfile::BATTERY);
+    assert<uint16_t>::equals("Battery latency", 4, params.latency);
+    params = BleConnectionManager::parametersFor(BleConnectionProfile::COMPETITIVE, 2);
+    assert<uint16_t>::equals("Relaxed interval", 24, params.maxInterval);
+    params = BleConnectionManager::parametersFor(BleConnectionProfile::BATTERY, 10);
+    assert<uint16_t>::equals("Interval limit", BLE_CONN_MAX_INTERVAL, params.maxInterval);
+
+    // Supervision timeout must exceed (1 + latency) * max interval * 2
+    for (uint8_t p = 0; p <= (uint8_t)BleConnectionProfile::_MAX_VALUE; p++)
+        for (uint8_t attempt = 0; attempt < BLE_CONN_MAX_ATTEMPTS; attempt++)
+        {
+            params = BleConnectionManager::parametersFor((BleConnectionProfile)p, attempt);
+            uint32_t limit = (1 + params.latency) * params.maxInterval * 125 * 2 / 1000;
+            assert((params.timeout > limit) && "Supervision timeout too short");
+        }
+}
+
+void TG_accepted()
+{
+    std::cout << "- accepted -" << std::endl;
+    assertState("Initial state", BleConnectionState::DISCONNECTED);
+    assert<int>::equals(
+        "Default profile",
+        (int)BleConnectionProfile::BALANCED,
+        (int)manager.getStatus().profile);
+
+    // No request while disconnected
+    manager.setProfile(BleConnectionProfile::COMPETITIVE);
+    assert<uint32_t>::equals("Request while disconnected", 0, connection.requestCount);
+
+    manager.onConnected(24, 0, 500);
+    assertState("Connected", BleConnectionState::PENDING);
+    assert<uint32_t>::equals("Request at connection", 1, connection.requestCount);
+    assertRequest("Competitive", 6, 6, 0);
+    assert<uint16_t>::equals("Initial interval", 24, manager.getStatus().interval);
+
+    manager.onParametersUpdated(6, 0, 200);
+    assertState("Accepted", BleConnectionState::ACCEPTED);
+    assert<uint16_t>::equals("Negotiated interval", 6, manager.getStatus().interval);
+    assert<uint16_t>::equals("Negotiated timeout", 200, manager.getStatus().timeout);
+    assert<uint8_t>::equals("Attempts", 1, manager.getStatus().attempts);
+
+    // Updates within the requested range are fine
+    manager.onParametersUpdated(6, 0, 300);
+    assertState("Still accepted", BleConnectionState::ACCEPTED);
+    assert<uint32_t>::equals("No more requests", 1, connection.requestCount);
+}
+
+void TG_rejected()
+{
+    std::cout << "- rejected -" << std::endl;
+    manager.onDisconnected();
+    assertState("Disconnected", BleConnectionState::DISCONNECTED);
+    assert<uint16_t>::equals("Interval cleared", 0, manager.getStatus().interval);
+    connection.requestCount = 0;
+
+    manager.onConnected(24, 0, 500);
+    // The host answers with its own parameters
+    manager.onParametersUpdated(24, 0, 500);
+    assertState("Re-requested", BleConnectionState::PENDING);
+    assert<uint32_t>::equals("Second request", 2, connection.requestCount);
+    assertRequest("Relaxed (1)", 6, 12, 0);
+
+    // The host does not answer
+    manager.onRequestTimeout();
+    assert<uint32_t>::equals("Third request", 3, connection.requestCount);
+    assertRequest("Relaxed (2)", 6, 24, 0);
+
+    // Out of attempts: host parameters are used
+    manager.onRequestTimeout();
+    assertState("Settled", BleConnectionState::SETTLED);
+    assert<uint32_t>::equals("No more requests", 3, connection.requestCount);
+    manager.onParametersUpdated(16, 0, 500);
+    assertState("Still settled", BleConnectionState::SETTLED);
+    assert<uint16_t>::equals("Host interval", 16, manager.getStatus().interval);
+    manager.onRequestTimeout();
+    assert<uint32_t>::equals("Timeout ignored", 3, connection.requestCount);
+}
+
+void TG_relaxedAccepted()
+{
+    std::cout << "- relaxed request accepted -" << std::endl;
+    connection.requestCount = 0;
+    manager.setProfile(BleConnectionProfile::BALANCED);
+    assertState("New profile", BleConnectionState::PENDING);
+    assertRequest("Balanced", 9, 12, 0);
+    manager.onParametersUpdated(24, 0, 500);
+    assertRequest("Relaxed balanced", 9, 24, 0);
+    manager.onParametersUpdated(24, 0, 500);
+    assertState("Relaxed accepted", BleConnectionState::ACCEPTED);
+    assert<uint8_t>::equals("Attempts", 2, manager.getStatus().attempts);
+
+    // The host changes the parameters on its own
+    manager.onParametersUpdated(40, 0, 500);
+    assertState("Renegotiation", BleConnectionState::PENDING);
+    assertRequest("Balanced again", 9, 12, 0);
+    assert<uint8_t>::equals("Attempts restarted", 1, manager.getStatus().attempts);
+}
+
+void TG_refused()
+{
+    std::cout << "- refused by the stack -" << std::endl;
+    connection.refuse = true;
+    connection.requestCount = 0;
+    manager.setProfile(BleConnectionProfile::BATTERY);
+    assertState("Settled", BleConnectionState::SETTLED);
+    assert<uint32_t>::equals("Attempts exhausted", BLE_CONN_MAX_ATTEMPTS, connection.requestCount);
+    connection.refuse = false;
+
+    // Invalid profiles are ignored
+    manager.setProfile((BleConnectionProfile)0xFF);
+    assert<int>::equals(
+        "Invalid profile",
+        (int)BleConnectionProfile::BATTERY,
+        (int)manager.getStatus().profile);
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_profiles();
+    TG_accepted();
+    TG_rejected();
+    TG_relaxedAccepted();
+    TG_refused();
+    return 0;
+}
@@ -50,7 +50,8 @@ void internals::hid::reportInput(
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
     currentLow = inputsLow;
 }
@@ -59,7 +60,7 @@ void internals::hid::reportInput(
 
 void internals::inputMap::map(
     bool isAltModeEngaged,
-    uint64_t firmware_bitmap,
+    const InputBitmap &firmware_bitmap,
     uint64_t &low,
     uint64_t &high)
 {
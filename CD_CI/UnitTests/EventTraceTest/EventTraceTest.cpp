@@ -0,0 +1,120 @@
+/**
+ * @file EventTraceTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "EventTrace.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+#include <thread>
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+struct Item
+{
+    uint32_t a;
+    uint32_t b;
+};
+
+TraceRing<Item, 4> ring;
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_empty()
+{
+    std::cout << "- empty -" << std::endl;
+    Item item;
+    assert<uint32_t>::equals("Count", 0, ring.count());
+    assert<uint32_t>::equals("Oldest", 0, ring.oldest());
+    assert(!ring.get(0, item) && "Item not pushed");
+}
+
+void TG_pushAndGet()
+{
+    std::cout << "- push and get -" << std::endl;
+    Item item;
+    for (uint32_t i = 0; i < 3; i++)
+        ring.push({i, i * 10});
+    assert<uint32_t>::equals("Count", 3, ring.count());
+    assert<uint32_t>::equals("Oldest", 0, ring.oldest());
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        assert(ring.get(i, item) && "Item not available");
+        assert<uint32_t>::equals("Item", i * 10, item.b);
+    }
+    assert(!ring.get(3, item) && "Item not pushed");
+}
+
+void TG_overwrite()
+{
+    std::cout << "- overwrite -" << std::endl;
+    Item item;
+    for (uint32_t i = 3; i < 10; i++)
+        ring.push({i, i * 10});
+    assert<uint32_t>::equals("Count", 10, ring.count());
+    assert<uint32_t>::equals("Oldest", 6, ring.oldest());
+    assert(!ring.get(5, item) && "Item not overwritten");
+    for (uint32_t i = 6; i < 10; i++)
+    {
+        assert(ring.get(i, item) && "Item not available");
+        assert<uint32_t>::equals("Item", i * 10, item.b);
+    }
+}
+
+void TG_concurrent()
+{
+    std::cout << "- concurrent reader -" << std::endl;
+    // Items are consistent or rejected, never torn
+    TraceRing<Item, 8> concurrentRing;
+    std::atomic<bool> done = false;
+    std::thread writer(
+        [&concurrentRing, &done]()
+        {
+            for (uint32_t i = 0; i < 200000; i++)
+                concurrentRing.push({i, ~i});
+            done = true;
+        });
+    uint32_t accepted = 0;
+    while (!done)
+    {
+        Item item;
+        uint32_t sequence = concurrentRing.oldest();
+        if (concurrentRing.get(sequence, item))
+        {
+            assert<uint32_t>::equals("Sequence", sequence, item.a);
+            assert<uint32_t>::equals("Torn item", ~item.a, item.b);
+            accepted++;
+        }
+    }
+    writer.join();
+    std::cout << "  (" << accepted << " items read)" << std::endl;
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_empty();
+    TG_pushAndGet();
+    TG_overwrite();
+    TG_concurrent();
+    return 0;
+}
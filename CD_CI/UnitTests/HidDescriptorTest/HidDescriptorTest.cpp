@@ -0,0 +1,248 @@
+/**
+ * @file HidDescriptorTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "HID_definitions.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+#include <string>
+#include <map>
+#include <utility>
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+// Input report of firmware versions prior to HidInputLayout
+const uint8_t legacyInputDescriptor[] = {
+    0x05, 0x01, 0x09, CONTROLLER_TYPE_GAMEPAD, 0xA1, 0x01,
+    0x85, RID_INPUT_GAMEPAD,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x80, 0x15, 0x00, 0x25, 0x01, 0x95, 0x80, 0x75, 0x01, 0x81, 0x02,
+    0x05, 0x01, 0x09, 0x35, 0x26, 0xFE, 0x00, 0x95, 0x01, 0x75, 0x08, 0x81, 0x02,
+    0x09, 0x34, 0x81, 0x02,
+    0x09, 0x33, 0x81, 0x02,
+    0x09, 0x39, 0x46, 0x40, 0x01, 0x65, 0x14, 0x15, 0x01, 0x25, 0x08, 0x75, 0x04, 0x81, 0x02,
+    0x09, 0x47, 0x45, 0x00, 0x65, 0x00, 0x81, 0x02};
+
+// The descriptor is built at compile time
+static_assert(
+    buildHidDescriptor(HidInputLayout{}).size == sizeof(legacyInputDescriptor) + sizeof(hid_descriptor_tail),
+    "Default descriptor size does not match");
+
+// Report sizes in bits, per main item kind and report ID
+typedef std::map<std::pair<uint8_t, uint8_t>, uint32_t> ReportBits;
+
+#define MAIN_INPUT 8
+#define MAIN_OUTPUT 9
+#define MAIN_FEATURE 11
+
+int32_t itemValue(const uint8_t *data, uint8_t size, bool isSigned)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; i++)
+        value |= ((uint32_t)data[i]) << (8 * i);
+    if (isSigned && (size > 0) && (size < 4) && (value & (1u << (8 * size - 1))))
+        value |= ~((1u << (8 * size)) - 1);
+    return (int32_t)value;
+}
+
+/**
+ * @brief Check a report descriptor against the HID 1.11 specification
+ *        (short items only, which is all this firmware uses)
+ *
+ * @param data Descriptor
+ * @param size Descriptor size
+ * @param[out] bits Report sizes in bits
+ */
+void validate(const uint8_t *data, uint16_t size, ReportBits &bits, std::string name)
+{
+    uint16_t index = 0;
+    int depth = 0;
+    uint32_t reportSize = 0, reportCount = 0;
+    uint8_t reportID = 0;
+    int32_t logicalMin = 0, logicalMax = 0;
+    bool hasUsageMin = false, hasUsageMax = false;
+    int32_t usageMin = 0, usageMax = 0;
+    bits.clear();
+    while (index < size)
+    {
+        uint8_t prefix = data[index++];
+        assert((prefix != 0xFE) && "Long item");
+        uint8_t itemSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag = prefix >> 4;
+        assert(((index + itemSize) <= size) && "Truncated item");
+        const uint8_t *payload = data + index;
+        index += itemSize;
+        if (type == 1)
+        {
+            // Global items
+            if (tag == 1)
+                logicalMin = itemValue(payload, itemSize, true);
+            else if (tag == 2)
+                logicalMax = itemValue(payload, itemSize, true);
+            else if (tag == 7)
+                reportSize = itemValue(payload, itemSize, false);
+            else if (tag == 8)
+            {
+                reportID = itemValue(payload, itemSize, false);
+                assert((reportID != 0) && "Report ID zero");
+            }
+            else if (tag == 9)
+                reportCount = itemValue(payload, itemSize, false);
+            assert((tag != 10) && (tag != 11) && "Push/Pop not expected");
+        }
+        else if (type == 2)
+        {
+            // Local items
+            if (tag == 1)
+            {
+                hasUsageMin = true;
+                usageMin = itemValue(payload, itemSize, false);
+            }
+            else if (tag == 2)
+            {
+                hasUsageMax = true;
+                usageMax = itemValue(payload, itemSize, false);
+            }
+        }
+        else if (type == 0)
+        {
+            // Main items
+            if (tag == 10)
+                depth++;
+            else if (tag == 12)
+            {
+                depth--;
+                assert((depth >= 0) && "Unbalanced end of collection");
+            }
+            else
+            {
+                assert(((tag == MAIN_INPUT) || (tag == MAIN_OUTPUT) || (tag == MAIN_FEATURE)) && "Unknown main item");
+                assert((depth > 0) && "Report outside a collection");
+                assert((reportID != 0) && "Missing report ID");
+                assert((reportSize > 0) && (reportCount > 0) && "Missing report size or count");
+                bool constant = (itemSize > 0) && (payload[0] & 0x01);
+                if ((tag == MAIN_INPUT) && !constant)
+                    assert((logicalMin <= logicalMax) && "Bad logical range");
+                assert((hasUsageMin == hasUsageMax) && "Incomplete usage range");
+                if (hasUsageMin)
+                {
+                    assert((usageMin <= usageMax) && "Bad usage range");
+                    assert<uint32_t>::equals(name + ": usage range vs report count", usageMax - usageMin + 1, reportCount);
+                }
+                bits[{tag, reportID}] += reportSize * reportCount;
+            }
+            // Local items apply to the next main item only
+            hasUsageMin = false;
+            hasUsageMax = false;
+        }
+        else
+            assert(false && "Reserved item type");
+    }
+    assert<int>::equals(name + ": unbalanced collections", 0, depth);
+    for (auto report : bits)
+        assert<uint32_t>::equals(name + ": report not byte-aligned", 0, report.second % 8);
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_legacy()
+{
+    std::cout << "- legacy layout -" << std::endl;
+    HidDescriptor descriptor = buildHidDescriptor(HidInputLayout{});
+    for (uint16_t i = 0; i < sizeof(legacyInputDescriptor); i++)
+        assert<int>::equals("Input descriptor byte " + std::to_string(i), legacyInputDescriptor[i], descriptor.data[i]);
+    for (uint16_t i = 0; i < sizeof(hid_descriptor_tail); i++)
+        assert<int>::equals("Tail byte " + std::to_string(i), hid_descriptor_tail[i], descriptor.data[sizeof(legacyInputDescriptor) + i]);
+    assert<int>::equals("Default report size", GAMEPAD_REPORT_SIZE, HidInputLayout{}.reportSize());
+    assert<int>::equals("Maximum size", HID_INPUT_DESCRIPTOR_MAX_SIZE, sizeof(legacyInputDescriptor));
+}
+
+void TG_reportSizes()
+{
+    std::cout << "- report sizes -" << std::endl;
+    ReportBits bits;
+    HidDescriptor descriptor = buildHidDescriptor(HidInputLayout{});
+    validate(descriptor.data, descriptor.size, bits, "default");
+    assert<uint32_t>::equals("Input", GAMEPAD_REPORT_SIZE * 8, bits[{MAIN_INPUT, RID_INPUT_GAMEPAD}]);
+    assert<uint32_t>::equals("Capabilities", CAPABILITIES_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_CAPABILITIES}]);
+    assert<uint32_t>::equals("Config", CONFIG_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_CONFIG}]);
+    assert<uint32_t>::equals("Buttons map", BUTTONS_MAP_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_BUTTONS_MAP}]);
+    assert<uint32_t>::equals("Hardware ID", HARDWARE_ID_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_HARDWARE_ID}]);
+    assert<uint32_t>::equals("Input profile", INPUT_PROFILE_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_INPUT_PROFILE}]);
+    assert<uint32_t>::equals("Health", HEALTH_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_HEALTH}]);
+    assert<uint32_t>::equals("Event trace", EVENT_TRACE_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_EVENT_TRACE}]);
+    assert<uint32_t>::equals("Bulk map", BUTTONS_MAP_BULK_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_BUTTONS_MAP_BULK}]);
+    assert<uint32_t>::equals("Settings image", SETTINGS_IMAGE_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_SETTINGS_IMAGE}]);
+    assert<uint32_t>::equals("BLE connection", BLE_CONNECTION_REPORT_SIZE * 8, bits[{MAIN_FEATURE, RID_FEATURE_BLE_CONNECTION}]);
+    assert<uint32_t>::equals("Powertrain", POWERTRAIN_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_POWERTRAIN}]);
+    assert<uint32_t>::equals("ECU", ECU_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_ECU}]);
+    assert<uint32_t>::equals("Race control", RACE_CONTROL_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_RACE_CONTROL}]);
+    assert<uint32_t>::equals("Gauges", GAUGES_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_GAUGES}]);
+    assert<uint32_t>::equals("Telemetry delta", TELEMETRY_DELTA_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_TELEMETRY_DELTA}]);
+    assert<uint32_t>::equals("Pixel", PIXEL_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_PIXEL}]);
+    assert<uint32_t>::equals("Pixel frame", PIXEL_FRAME_REPORT_SIZE * 8, bits[{MAIN_OUTPUT, RID_OUTPUT_PIXEL_FRAME}]);
+}
+
+void TG_allLayouts()
+{
+    std::cout << "- all layouts -" << std::endl;
+    ReportBits bits;
+    for (uint8_t buttons = 8; buttons <= BUTTON_COUNT; buttons += 8)
+        for (uint8_t flags = 0; flags < 8; flags++)
+        {
+            HidInputLayout layout = HidInputLayout::fit(buttons - 1, flags & 1, flags & 2, flags & 4);
+            std::string name = "layout " + std::to_string(buttons) + "/" + std::to_string(flags);
+            assert<int>::equals(name + ": button count", buttons, layout.buttonCount);
+            HidDescriptor descriptor = buildHidDescriptor(layout);
+            assert((descriptor.size <= HID_DESCRIPTOR_MAX_SIZE) && "Descriptor too big");
+            validate(descriptor.data, descriptor.size, bits, name);
+            assert<uint32_t>::equals(name + ": input size", layout.reportSize() * 8, bits[{MAIN_INPUT, RID_INPUT_GAMEPAD}]);
+            assert((layout.reportSize() <= GAMEPAD_REPORT_SIZE) && "Report too big");
+        }
+}
+
+void TG_fit()
+{
+    std::cout << "- fit -" << std::endl;
+    assert<int>::equals("Fit 0", 8, HidInputLayout::fit(0, false, false, false).buttonCount);
+    assert<int>::equals("Fit 7", 8, HidInputLayout::fit(7, false, false, false).buttonCount);
+    assert<int>::equals("Fit 23", 24, HidInputLayout::fit(23, false, false, false).buttonCount);
+    assert<int>::equals("Fit 24", 32, HidInputLayout::fit(24, false, false, false).buttonCount);
+    assert<int>::equals("Fit 127", 128, HidInputLayout::fit(127, false, false, false).buttonCount);
+    assert<int>::equals("Fit 200", 128, HidInputLayout::fit(200, false, false, false).buttonCount);
+
+    // A small wheel: 24 buttons, no clutch paddles
+    assert<int>::equals("Small wheel", 4, HidInputLayout::fit(23, false, false, true).reportSize());
+    assert<int>::equals("Small wheel with clutch", 5, HidInputLayout::fit(23, true, false, true).reportSize());
+    assert<int>::equals("Small wheel with analog clutch", 7, HidInputLayout::fit(23, true, true, true).reportSize());
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_legacy();
+    TG_reportSizes();
+    TG_allLayouts();
+    TG_fit();
+    return 0;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file HidRouterTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HidRouter.hpp"
+#include "cd_ci_assertions.hpp"
+
+#include <cinttypes>
+#include <cassert>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Mocks
+//-------------------------------------------------------------------
+
+/**
+ * @brief Dummy transport
+ *
+ */
+struct FakeTransport
+{
+    bool started = false;
+    bool connected = false;
+    bool configChanged = false;
+    int batteryLevel = -1;
+    uint32_t inputReports = 0;
+    uint32_t resets = 0;
+    uint64_t inputsLow = 0ULL;
+    uint8_t leftAxis = 0;
+    BleConnectionStatus connection;
+
+    void clear()
+    {
+        inputReports = 0;
+        resets = 0;
+        configChanged = false;
+        inputsLow = 0ULL;
+        leftAxis = 0;
+    }
+};
+
+FakeTransport usbTransport;
+FakeTransport bleTransport;
+uint32_t forgetCount = 0;
+uint32_t connectedCount = 0;
+uint32_t disconnectedCount = 0;
+
+void onConnected()
+{
+    connectedCount++;
+}
+
+void onDisconnected()
+{
+    disconnectedCount++;
+}
+
+void internals::hid::common::forgetLastInputReport()
+{
+    forgetCount++;
+}
+
+#define FAKE_TRANSPORT(ns, transport, customID)                          \
+    void internals::hid::ns::begin(                                      \
+        std::string deviceName,                                          \
+        std::string deviceManufacturer,                                  \
+        bool enableAutoPowerOff,                                         \
+        uint16_t VID,                                                    \
+        uint16_t PID) { transport.started = true; }                      \
+    bool internals::hid::ns::supportsCustomHardwareID() { return customID; } \
+    bool internals::hid::ns::isConnected() { return transport.connected; } \
+    void internals::hid::ns::reportChangeInConfig() { transport.configChanged = true; } \
+    void internals::hid::ns::reportBatteryLevel(int batteryLevel) { transport.batteryLevel = batteryLevel; } \
+    void internals::hid::ns::reportInput(                                \
+        uint64_t inputsLow,                                              \
+        uint64_t inputsHigh,                                             \
+        uint8_t POVstate,                                                \
+        uint8_t leftAxis,                                                \
+        uint8_t rightAxis,                                               \
+        uint8_t clutchAxis,                                              \
+        bool keepAlive)                                                  \
+    {                                                                    \
+        transport.inputReports++;                                        \
+        transport.inputsLow = inputsLow;                                 \
+        transport.leftAxis = leftAxis;                                   \
+    }                                                                    \
+    void internals::hid::ns::reset() { transport.resets++; }          \
+    void internals::hid::ns::setConnectionProfile(BleConnectionProfile profile) \
+    {                                                                    \
+        transport.connection.profile = profile;                          \
+    }                                                                    \
+    BleConnectionStatus internals::hid::ns::getConnectionStatus()        \
+    {                                                                    \
+        return transport.connection;                                     \
+    }
+
+FAKE_TRANSPORT(usb, usbTransport, false)
+FAKE_TRANSPORT(ble, bleTransport, true)
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+void clearAll()
+{
+    usbTransport.clear();
+    bleTransport.clear();
+    forgetCount = 0;
+    connectedCount = 0;
+    disconnectedCount = 0;
+}
+
+void sendInput(uint64_t inputsLow, uint8_t leftAxis = 0)
+{
+    internals::hid::reportInput(inputsLow, 0ULL, 0, leftAxis, 0, 0);
+}
+
+//-------------------------------------------------------------------
+// Test groups
+//-------------------------------------------------------------------
+
+void TG_begin()
+{
+    std::cout << "- begin -" << std::endl;
+    OnConnected::subscribe(onConnected);
+    OnDisconnected::subscribe(onDisconnected);
+    internals::hid::begin("name", "manufacturer", true, 0, 0);
+    assert<uint32_t>::equals("Initial status", 1, disconnectedCount);
+    assert<uint32_t>::equals("Initial status (connected)", 0, connectedCount);
+    assert<bool>::equals("USB started", true, usbTransport.started);
+    assert<bool>::equals("BLE started", true, bleTransport.started);
+    assert<bool>::equals("Not connected", false, internals::hid::isConnected());
+    assert<uint8_t>::equals("No route", internals::hid::router::NO_ROUTE, internals::hid::router::getRoute());
+    assert<bool>::equals("Custom hardware ID", true, internals::hid::supportsCustomHardwareID());
+
+    clearAll();
+    sendInput(1ULL);
+    assert<uint32_t>::equals("No route: USB", 0, usbTransport.inputReports);
+    assert<uint32_t>::equals("No route: BLE", 0, bleTransport.inputReports);
+}
+
+void TG_routing()
+{
+    std::cout << "- routing -" << std::endl;
+
+    // BLE host connects: the current state goes there
+    clearAll();
+    bleTransport.connected = true;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("BLE route", internals::hid::router::BLE_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("BLE connect: forget", 1, forgetCount);
+    assert<uint32_t>::equals("BLE connect: reports", 1, bleTransport.inputReports);
+    assert<uint64_t>::equals("BLE connect: state", 1ULL, bleTransport.inputsLow);
+    assert<bool>::equals("BLE connect: config", true, bleTransport.configChanged);
+    assert<uint32_t>::equals("BLE connect: event", 1, connectedCount);
+
+    clearAll();
+    sendInput(2ULL, 10);
+    assert<uint32_t>::equals("BLE: BLE reports", 1, bleTransport.inputReports);
+    assert<uint32_t>::equals("BLE: USB reports", 0, usbTransport.inputReports);
+    assert<uint64_t>::equals("BLE: state", 2ULL, bleTransport.inputsLow);
+
+    // Cable plugged in: USB has lower latency
+    clearAll();
+    usbTransport.connected = true;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("USB route", internals::hid::router::USB_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("USB connect: reports", 1, usbTransport.inputReports);
+    assert<uint64_t>::equals("USB connect: state", 2ULL, usbTransport.inputsLow);
+    assert<uint8_t>::equals("USB connect: axis", 10, usbTransport.leftAxis);
+    assert<bool>::equals("USB connect: config", true, usbTransport.configChanged);
+    assert<bool>::equals("USB connect: BLE config", false, bleTransport.configChanged);
+    assert<uint32_t>::equals("USB connect: event", 1, connectedCount);
+
+    clearAll();
+    sendInput(3ULL);
+    assert<uint32_t>::equals("USB: USB reports", 1, usbTransport.inputReports);
+    assert<uint32_t>::equals("USB: BLE reports", 0, bleTransport.inputReports);
+
+    // Cable unplugged (no event): fail over at the next report
+    clearAll();
+    usbTransport.connected = false;
+    sendInput(4ULL);
+    assert<uint8_t>::equals("Unplug: route", internals::hid::router::BLE_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("Unplug: forget", 1, forgetCount);
+    assert<uint32_t>::equals("Unplug: BLE reports", 1, bleTransport.inputReports);
+    assert<uint64_t>::equals("Unplug: state", 4ULL, bleTransport.inputsLow);
+    assert<uint32_t>::equals("Unplug: USB reports", 0, usbTransport.inputReports);
+    assert<bool>::equals("Unplug: config", true, bleTransport.configChanged);
+    assert<uint32_t>::equals("Unplug: connected event", 1, connectedCount);
+    assert<uint32_t>::equals("Unplug: disconnected event", 0, disconnectedCount);
+
+    // USB suspended and resumed: no report is needed to switch routes
+    clearAll();
+    usbTransport.connected = true;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("Resume: route", internals::hid::router::USB_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("Resume: USB reports", 1, usbTransport.inputReports);
+    clearAll();
+    usbTransport.connected = false;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("Suspend: route", internals::hid::router::BLE_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("Suspend: BLE reports", 1, bleTransport.inputReports);
+
+    // BLE status changes while USB is in use are not notified
+    usbTransport.connected = true;
+    internals::hid::router::update();
+    clearAll();
+    bleTransport.connected = false;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("BLE gone: route", internals::hid::router::USB_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("BLE gone: disconnected event", 0, disconnectedCount);
+    bleTransport.connected = true;
+    internals::hid::router::update();
+    assert<uint32_t>::equals("BLE back: connected event", 0, connectedCount);
+    usbTransport.connected = false;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("BLE back: route", internals::hid::router::BLE_ROUTE, internals::hid::router::getRoute());
+
+    // BLE disconnected
+    clearAll();
+    bleTransport.connected = false;
+    internals::hid::router::update();
+    assert<uint8_t>::equals("Disconnected: route", internals::hid::router::NO_ROUTE, internals::hid::router::getRoute());
+    assert<uint32_t>::equals("Disconnected: event", 1, disconnectedCount);
+    assert<uint32_t>::equals("Disconnected: connected event", 0, connectedCount);
+    sendInput(5ULL);
+    assert<uint32_t>::equals("Disconnected: USB reports", 0, usbTransport.inputReports);
+    assert<uint32_t>::equals("Disconnected: BLE reports", 0, bleTransport.inputReports);
+}
+
+void TG_reset()
+{
+    std::cout << "- reset -" << std::endl;
+    clearAll();
+    internals::hid::reset();
+    assert<uint32_t>::equals("No route", 0, usbTransport.resets + bleTransport.resets);
+
+    usbTransport.connected = true;
+    internals::hid::router::update();
+    assert<uint64_t>::equals("Reset state", 0ULL, usbTransport.inputsLow);
+    clearAll();
+    internals::hid::reset();
+    assert<uint32_t>::equals("USB reset", 1, usbTransport.resets);
+    assert<uint32_t>::equals("BLE reset", 0, bleTransport.resets);
+}
+
+void TG_broadcast()
+{
+    std::cout << "- broadcast -" << std::endl;
+    internals::hid::reportChangeInConfig();
+    assert<bool>::equals("USB config", true, usbTransport.configChanged);
+    assert<bool>::equals("BLE config", true, bleTransport.configChanged);
+    internals::hid::reportBatteryLevel(66);
+    assert<int>::equals("USB battery", 66, usbTransport.batteryLevel);
+    assert<int>::equals("BLE battery", 66, bleTransport.batteryLevel);
+    assert<bool>::equals("Connected", true, internals::hid::isConnected());
+}
+
+void TG_connectionProfile()
+{
+    std::cout << "- connection profile -" << std::endl;
+    internals::hid::setConnectionProfile(BleConnectionProfile::COMPETITIVE);
+    assert<uint8_t>::equals(
+        "BLE profile",
+        (uint8_t)BleConnectionProfile::COMPETITIVE,
+        (uint8_t)bleTransport.connection.profile);
+    assert<uint8_t>::equals(
+        "USB profile untouched",
+        (uint8_t)BleConnectionProfile::_DEFAULT_VALUE,
+        (uint8_t)usbTransport.connection.profile);
+    bleTransport.connection.interval = 6;
+    assert<uint16_t>::equals("Interval", 6, internals::hid::getConnectionStatus().interval);
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    TG_begin();
+    TG_routing();
+    TG_reset();
+    TG_broadcast();
+    TG_connectionProfile();
+    return 0;
+}
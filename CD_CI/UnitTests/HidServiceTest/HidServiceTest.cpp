@@ -40,5 +40,9 @@ int main()
     assert(vid == 0);
     assert(pid == 0);
 
+    assert(internals::hid::common::getUSBReportRate() == 1000);
+    hid::configure("none", "none", false, FACTORY_VID, FACTORY_PID, USBReportRate::HZ_250);
+    assert(internals::hid::common::getUSBReportRate() == 250);
+
     return 0;
 }
\ No newline at end of file
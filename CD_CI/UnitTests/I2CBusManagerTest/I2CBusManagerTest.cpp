@@ -0,0 +1,318 @@
+/**
+ * @file I2CBusManagerTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "HAL.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+//------------------------------------------------------------------
+// Mocks
+//------------------------------------------------------------------
+
+std::vector<size_t> groupSizes;
+std::vector<uint8_t> groupAddresses;
+uint8_t failingAddress = 0xFF;
+
+bool recordingExecutor(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    groupSizes.push_back(count);
+    groupAddresses.push_back(transactions[0].address7bits);
+    for (size_t i = 0; i < count; i++)
+        if (transactions[i].readBuffer)
+            for (size_t j = 0; j < transactions[i].readSize; j++)
+                transactions[i].readBuffer[j] = transactions[i].address7bits;
+    return (transactions[0].address7bits != failingAddress);
+}
+
+std::atomic<bool> holdBus{false};
+std::atomic<bool> busHeld{false};
+
+bool blockingExecutor(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    groupAddresses.push_back(transactions[0].address7bits);
+    busHeld = true;
+    while (holdBus)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return true;
+}
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+void executeOne(I2CBusManager *manager, I2CClient client, uint8_t address)
+{
+    I2CTransaction transaction;
+    transaction.address7bits = address;
+    manager->execute(client, &transaction, 1);
+}
+
+void waitForWaitingClients(I2CBusManager &manager, uint32_t count)
+{
+    for (int retry = 0; retry < 1000; retry++)
+    {
+        uint32_t waiting = 0;
+        {
+            std::lock_guard<std::mutex> lock(manager._mutex);
+            for (uint8_t i = 0; i < I2C_CLIENT_COUNT; i++)
+                waiting += manager._waiting[i];
+        }
+        if (waiting >= count)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(false && "Clients are not waiting for the bus");
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_coalescing()
+{
+    std::cout << "- coalescing -" << std::endl;
+    I2CBusManager manager(I2CBus::PRIMARY, recordingExecutor);
+    groupSizes.clear();
+    groupAddresses.clear();
+    uint8_t buffer[4][2] = {};
+    I2CTransaction transactions[4];
+    uint8_t addresses[4] = {0x20, 0x20, 0x21, 0x20};
+    for (int i = 0; i < 4; i++)
+    {
+        transactions[i].address7bits = addresses[i];
+        transactions[i].readBuffer = buffer[i];
+        transactions[i].readSize = 2;
+    }
+    assert(manager.execute(I2CClient::INPUTS, transactions, 4) && "Execution failed");
+    assert<size_t>::equals("Bus operations", 3, groupSizes.size());
+    assert<size_t>::equals("1st group size", 2, groupSizes[0]);
+    assert<size_t>::equals("2nd group size", 1, groupSizes[1]);
+    assert<size_t>::equals("3rd group size", 1, groupSizes[2]);
+    assert<int>::equals("Read buffer", 0x21, buffer[2][1]);
+    for (int i = 0; i < 4; i++)
+        assert(transactions[i].success && "Transaction not successful");
+
+    I2CClientStatistics stats = manager.getStatistics(I2CClient::INPUTS);
+    assert<uint32_t>::equals("Transaction count", 4, stats.transactionCount);
+    assert<uint32_t>::equals("Batch count", 3, stats.batchCount);
+    assert<uint32_t>::equals("Error count", 0, stats.errorCount);
+    stats = manager.getStatistics(I2CClient::UI);
+    assert<uint32_t>::equals("Transaction count (other client)", 0, stats.transactionCount);
+}
+
+void TG_errors()
+{
+    std::cout << "- errors -" << std::endl;
+    I2CBusManager manager(I2CBus::PRIMARY, recordingExecutor);
+    failingAddress = 0x21;
+    I2CTransaction transactions[3];
+    transactions[0].address7bits = 0x20;
+    transactions[1].address7bits = 0x21;
+    transactions[2].address7bits = 0x21;
+    assert(!manager.execute(I2CClient::UI, transactions, 3) && "Failure not reported");
+    assert(transactions[0].success && "Bad success flag (0)");
+    assert(!transactions[1].success && "Bad success flag (1)");
+    assert(!transactions[2].success && "Bad success flag (2)");
+    I2CClientStatistics stats = manager.getStatistics(I2CClient::UI);
+    assert<uint32_t>::equals("Error count", 2, stats.errorCount);
+    manager.resetStatistics();
+    stats = manager.getStatistics(I2CClient::UI);
+    assert<uint32_t>::equals("Error count after reset", 0, stats.errorCount);
+    failingAddress = 0xFF;
+}
+
+void TG_devices()
+{
+    std::cout << "- devices -" << std::endl;
+    I2CBusManager manager(I2CBus::PRIMARY, recordingExecutor);
+    manager.setDeviceSpeed(0x20, I2C_FAST_MODE_PLUS);
+    manager.setDeviceSpeed(0x21, I2C_FAST_MODE);
+    manager.setDeviceSpeed(0x21, I2C_STANDARD_MODE);
+    manager.setDeviceSpeed(0x21, I2C_FAST_MODE);
+    assert<int>::equals("Speed (0x20)", I2C_FAST_MODE_PLUS, manager.getDeviceSpeed(0x20));
+    assert<int>::equals("Lowest speed kept (0x21)", I2C_STANDARD_MODE, manager.getDeviceSpeed(0x21));
+    assert<int>::equals("Unknown speed", 0, manager.getDeviceSpeed(0x22));
+
+    I2CTransaction transactions[4];
+    uint8_t addresses[4] = {0x20, 0x20, 0x21, 0x22};
+    for (int i = 0; i < 4; i++)
+        transactions[i].address7bits = addresses[i];
+    manager.execute(I2CClient::INPUTS, transactions, 4);
+    manager.execute(I2CClient::UI, transactions + 2, 1);
+
+    std::vector<I2CDeviceStatistics> stats;
+    manager.getDeviceStatistics(stats);
+    assert<size_t>::equals("Device count", 3, stats.size());
+    assert<int>::equals("1st device", 0x20, stats[0].address7bits);
+    assert<int>::equals("1st device speed", I2C_FAST_MODE_PLUS, stats[0].speedMultiplier);
+    assert<uint32_t>::equals("1st device batches", 1, stats[0].batchCount);
+    assert<int>::equals("2nd device", 0x21, stats[1].address7bits);
+    assert<uint32_t>::equals("2nd device batches", 2, stats[1].batchCount);
+    assert<int>::equals("3rd device speed", 0, stats[2].speedMultiplier);
+
+    manager.resetStatistics();
+    manager.getDeviceStatistics(stats);
+    assert<size_t>::equals("Device count after reset", 0, stats.size());
+    assert<int>::equals("Speed after reset", I2C_FAST_MODE_PLUS, manager.getDeviceSpeed(0x20));
+}
+
+void TG_priority()
+{
+    std::cout << "- priority -" << std::endl;
+    I2CBusManager manager(I2CBus::PRIMARY, blockingExecutor);
+    groupAddresses.clear();
+
+    // A low priority client holds the bus
+    holdBus = true;
+    busHeld = false;
+    std::thread owner(executeOne, &manager, I2CClient::BATTERY_MONITOR, 1);
+    while (!busHeld)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Other clients are queued in reverse priority order
+    std::thread battery(executeOne, &manager, I2CClient::BATTERY_MONITOR, 2);
+    waitForWaitingClients(manager, 1);
+    std::thread ui(executeOne, &manager, I2CClient::UI, 3);
+    waitForWaitingClients(manager, 2);
+    std::thread inputs(executeOne, &manager, I2CClient::INPUTS, 4);
+    waitForWaitingClients(manager, 3);
+    holdBus = false;
+    owner.join();
+    battery.join();
+    ui.join();
+    inputs.join();
+
+    assert<size_t>::equals("Bus operations", 4, groupAddresses.size());
+    assert<int>::equals("1st served", 1, groupAddresses[0]);
+    assert<int>::equals("2nd served (inputs)", 4, groupAddresses[1]);
+    assert<int>::equals("3rd served (ui)", 3, groupAddresses[2]);
+    assert<int>::equals("4th served (battery)", 2, groupAddresses[3]);
+    assert((manager.getStatistics(I2CClient::INPUTS).maxWaitUs > 0) && "Wait time not recorded");
+}
+
+void TG_async()
+{
+    std::cout << "- async -" << std::endl;
+    I2CBusManager manager(I2CBus::PRIMARY, blockingExecutor);
+    groupAddresses.clear();
+
+    // A client holds the bus
+    holdBus = true;
+    busHeld = false;
+    std::thread owner(executeOne, &manager, I2CClient::UI, 1);
+    while (!busHeld)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Requests are queued without blocking
+    I2CTransaction transactions[2];
+    transactions[0].address7bits = 2;
+    transactions[1].address7bits = 3;
+    I2CRequest battery, inputs;
+    battery.client = I2CClient::BATTERY_MONITOR;
+    battery.transactions = &transactions[0];
+    battery.count = 1;
+    inputs.client = I2CClient::INPUTS;
+    inputs.transactions = &transactions[1];
+    inputs.count = 1;
+    assert(manager.submit(battery) && "Request not queued (battery)");
+    assert(manager.submit(inputs) && "Request not queued (inputs)");
+    assert(battery.pending && "Not pending (battery)");
+    assert(inputs.pending && "Not pending (inputs)");
+    assert(!manager.submit(inputs) && "Pending request queued twice");
+
+    // Release the bus
+    holdBus = false;
+    owner.join();
+    for (int retry = 0; (retry < 1000) && (battery.pending || inputs.pending); retry++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(!battery.pending && "Still pending (battery)");
+    assert(!inputs.pending && "Still pending (inputs)");
+    assert(battery.result && "Bad result (battery)");
+    assert(inputs.result && "Bad result (inputs)");
+    assert<size_t>::equals("Bus operations", 3, groupAddresses.size());
+    assert<int>::equals("2nd served (inputs)", 3, groupAddresses[1]);
+    assert<int>::equals("3rd served (battery)", 2, groupAddresses[2]);
+
+    // Completed requests may be submitted again
+    assert(manager.submit(inputs) && "Completed request not queued");
+    for (int retry = 0; (retry < 1000) && inputs.pending; retry++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(!inputs.pending && "Still pending (again)");
+    assert<size_t>::equals("Bus operations (again)", 4, groupAddresses.size());
+}
+
+void TG_hal()
+{
+    std::cout << "- HAL -" << std::endl;
+    internals::hal::i2c::setFakeExecutor(recordingExecutor);
+    groupSizes.clear();
+    uint8_t data = 0;
+    I2CTransaction transaction;
+    transaction.address7bits = 0x32;
+    transaction.readBuffer = &data;
+    transaction.readSize = 1;
+    assert(internals::hal::i2c::execute(I2CBus::SECONDARY, I2CClient::INPUTS, &transaction) && "HAL execution failed");
+    assert<int>::equals("HAL read", 0x32, data);
+    assert<uint32_t>::equals(
+        "HAL statistics",
+        1,
+        internals::hal::i2c::getStatistics(I2CBus::SECONDARY, I2CClient::INPUTS).transactionCount);
+    assert<uint32_t>::equals(
+        "HAL statistics (other bus)",
+        0,
+        internals::hal::i2c::getStatistics(I2CBus::PRIMARY, I2CClient::INPUTS).transactionCount);
+
+    // Asynchronous execution
+    data = 0;
+    transaction.address7bits = 0x33;
+    I2CRequest request;
+    request.transactions = &transaction;
+    request.count = 1;
+    assert(internals::hal::i2c::submit(I2CBus::SECONDARY, request) && "HAL submit failed");
+    for (int retry = 0; (retry < 1000) && request.pending; retry++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(!request.pending && "HAL request still pending");
+    assert(request.result && "HAL request failed");
+    assert<int>::equals("HAL asynchronous read", 0x33, data);
+
+    // Per-device clock speed
+    internals::hal::i2c::require(I2C_STANDARD_MODE, I2CBus::SECONDARY, 0x32);
+    std::vector<I2CDeviceStatistics> devices;
+    internals::hal::i2c::getDeviceStatistics(devices, I2CBus::SECONDARY);
+    assert<size_t>::equals("HAL device count", 2, devices.size());
+    assert<int>::equals("HAL device speed", I2C_STANDARD_MODE, devices[0].speedMultiplier);
+    internals::hal::i2c::setFakeExecutor(nullptr);
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_coalescing();
+    TG_errors();
+    TG_devices();
+    TG_priority();
+    TG_async();
+    TG_hal();
+    return 0;
+}
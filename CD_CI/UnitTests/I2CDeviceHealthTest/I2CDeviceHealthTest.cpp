@@ -0,0 +1,289 @@
+/**
+ * @file I2CDeviceHealthTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "HAL.hpp"
+#include "I2CDeviceHealth.hpp"
+#include "InputHardware.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+#include <string>
+#include <cstring>
+
+//------------------------------------------------------------------
+// Mocks
+//------------------------------------------------------------------
+
+#define DEVICE_ADDRESS 0x20
+
+bool deviceIsDead = false;
+uint32_t busOperations = 0;
+
+bool faultyExecutor(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    busOperations++;
+    if (deviceIsDead)
+        return false;
+    for (size_t i = 0; i < count; i++)
+        if (transactions[i].readBuffer)
+            transactions[i].readBuffer[0] = 0xA5;
+    return true;
+}
+
+#define EXPANDER_ADDRESS 0x21
+
+/**
+ * @brief Fake MCP23017 GPIO expander (BANK=0, sequential operation)
+ *
+ */
+struct FakeMCP23017
+{
+    bool dead = false;
+    uint8_t reg[0x16];
+    uint8_t pointer = 0;
+    // Pressed switches (GPB in the high byte)
+    uint16_t pressed = 0;
+    uint32_t accesses = 0;
+
+    FakeMCP23017() { powerOn(); }
+
+    void powerOn()
+    {
+        memset(reg, 0, sizeof(reg));
+        // IODIRA/B
+        reg[0] = 0xFF;
+        reg[1] = 0xFF;
+    }
+
+    uint8_t readRegister(uint8_t index)
+    {
+        if ((index == 0x12) || (index == 0x13))
+        {
+            // Switches pulled up, IPOLA/B applied
+            uint8_t level = ~(uint8_t)(pressed >> (8 * (index - 0x12)));
+            return level ^ reg[index - 0x10];
+        }
+        return reg[index];
+    }
+} expander;
+
+bool fakeExpanderExecutor(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    expander.accesses++;
+    if (expander.dead)
+        return false;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (transactions[i].address7bits != EXPANDER_ADDRESS)
+            return false;
+        if (transactions[i].writeSize > 0)
+        {
+            expander.pointer = transactions[i].writeBuffer[0];
+            for (size_t j = 1; j < transactions[i].writeSize; j++)
+                expander.reg[expander.pointer++] = transactions[i].writeBuffer[j];
+        }
+        for (size_t j = 0; j < transactions[i].readSize; j++)
+            transactions[i].readBuffer[j] = expander.readRegister(expander.pointer++);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+I2CDeviceHealth health;
+uint8_t data;
+
+bool scan()
+{
+    return health.attempt(
+        []()
+        {
+            I2CTransaction transaction;
+            transaction.address7bits = DEVICE_ADDRESS;
+            transaction.readBuffer = &data;
+            transaction.readSize = 1;
+            return internals::hal::i2c::execute(I2CBus::PRIMARY, I2CClient::INPUTS, &transaction);
+        },
+        []()
+        {
+            return internals::hal::i2c::recover(I2CBus::PRIMARY, I2CClient::INPUTS) &&
+                   internals::hal::i2c::probe(DEVICE_ADDRESS, I2CBus::PRIMARY);
+        });
+}
+
+void expectSkipped(uint32_t periods, std::string text)
+{
+    uint32_t before = busOperations;
+    for (uint32_t i = 0; i < periods; i++)
+        assert(!scan() && "Device not skipped");
+    assert<uint32_t>::equals(text, before, busOperations);
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_healthy()
+{
+    std::cout << "- healthy -" << std::endl;
+    data = 0;
+    assert(scan() && "Healthy device not read");
+    assert<int>::equals("Data", 0xA5, data);
+    assert(health.isHealthy() && "Not healthy");
+    assert<uint32_t>::equals("Error count", 0, health.errorCount);
+}
+
+void TG_backoff()
+{
+    std::cout << "- backoff -" << std::endl;
+    deviceIsDead = true;
+
+    // First failure: skip 1 period
+    assert(!scan() && "Failure not reported");
+    assert(!health.isHealthy() && "Still healthy");
+    expectSkipped(1, "Bus accessed while skipped (1)");
+
+    // Failed recovery: skip 2 periods, then 4, then 8
+    for (uint32_t backoff = 2; backoff <= 8; backoff *= 2)
+    {
+        uint32_t before = busOperations;
+        assert(!scan() && "Failed recovery not reported");
+        assert<uint32_t>::equals("Probe at recovery", before + 1, busOperations);
+        expectSkipped(backoff, "Bus accessed while skipped (" + std::to_string(backoff) + ")");
+    }
+    assert<uint32_t>::equals("Error count", 4, health.errorCount);
+    assert<uint32_t>::equals("Recovery count", 3, health.recoveryCount);
+    assert<uint32_t>::equals("Skipped count", 15, health.skippedCount);
+
+    // Backoff is limited
+    for (int attempt = 0; attempt < 10; attempt++)
+    {
+        uint32_t before = busOperations;
+        while (before == busOperations)
+            scan();
+    }
+    expectSkipped(I2C_HEALTH_MAX_BACKOFF, "Bus accessed while skipped (max)");
+    uint32_t before = busOperations;
+    scan();
+    assert<uint32_t>::equals("Recovery after max backoff", before + 1, busOperations);
+}
+
+void TG_rejoin()
+{
+    std::cout << "- rejoin -" << std::endl;
+    deviceIsDead = false;
+
+    // Wait for the next recovery
+    int periods = 0;
+    data = 0;
+    while (!scan() && (periods < 2 * I2C_HEALTH_MAX_BACKOFF))
+        periods++;
+    assert((periods <= I2C_HEALTH_MAX_BACKOFF) && "Device did not rejoin");
+    assert(health.isHealthy() && "Not healthy after rejoin");
+    assert<int>::equals("Data after rejoin", 0xA5, data);
+
+    // No more backoff
+    assert(scan() && "Skipped after rejoin");
+
+    // A new failure starts the backoff again
+    deviceIsDead = true;
+    assert(!scan() && "Failure not reported (2)");
+    expectSkipped(1, "Bus accessed while skipped (again)");
+    deviceIsDead = false;
+    assert(scan() && "Not recovered in the first attempt");
+}
+
+void TG_counters()
+{
+    std::cout << "- counters -" << std::endl;
+    std::vector<I2CDeviceStatistics> devices;
+    internals::hal::i2c::getDeviceStatistics(devices, I2CBus::PRIMARY);
+    assert<size_t>::equals("Device count", 1, devices.size());
+    assert<int>::equals("Device address", DEVICE_ADDRESS, devices[0].address7bits);
+    assert((devices[0].errorCount > 0) && "Device errors not counted");
+    assert<uint32_t>::equals(
+        "Bus recoveries",
+        health.recoveryCount,
+        internals::hal::i2c::getStatistics(I2CBus::PRIMARY, I2CClient::INPUTS).recoveryCount);
+}
+
+void TG_expander()
+{
+    std::cout << "- expander through the HAL -" << std::endl;
+    internals::hal::i2c::setFakeExecutor(fakeExpanderExecutor);
+    MCP23017Expander spec;
+    spec[MCP23017Pin::GPA0] = 40;
+    spec[MCP23017Pin::GPB7] = 41;
+    MCP23017ButtonsInput chip(spec, EXPANDER_ADDRESS, I2CBus::SECONDARY);
+    InputBitmap gpa0 = (InputBitmap)spec[MCP23017Pin::GPA0];
+    InputBitmap gpb7 = (InputBitmap)spec[MCP23017Pin::GPB7];
+    InputBitmap other = (InputBitmap)InputNumber(5);
+
+    expander.pressed = 0x0001;
+    assert<uint64_t>::equals("Healthy read", gpa0, chip.read(NO_INPUTS));
+
+    // The chip fails: its last known state is kept, bus not accessed
+    expander.dead = true;
+    assert<uint64_t>::equals("Failed read", gpa0, chip.read(gpa0 | other));
+    uint32_t before = expander.accesses;
+    assert<uint64_t>::equals("Skipped read", gpa0, chip.read(gpa0 | other));
+    assert<uint32_t>::equals("Bus accessed while skipped", before, expander.accesses);
+
+    // Failed recovery: probed twice (before and after releasing the bus)
+    before = expander.accesses;
+    chip.read(gpa0 | other);
+    assert<uint32_t>::equals("Probes at failed recovery", before + 2, expander.accesses);
+
+    // Power cycled: the configuration is lost
+    expander.powerOn();
+    expander.pressed = 0x8000;
+    expander.dead = false;
+    InputBitmap result;
+    int periods = 0;
+    do
+    {
+        result = chip.read(gpa0 | other);
+        // An unconfigured chip would read every switch as pressed
+        assert(((result == gpa0) || (result == gpb7)) && "Read from an unconfigured chip");
+        periods++;
+    } while ((result != gpb7) && (periods <= I2C_HEALTH_MAX_BACKOFF));
+    assert<uint64_t>::equals("Read after recovery", gpb7, result);
+    assert<int>::equals("IOCON after recovery", 0b01000000, expander.reg[0x0A]);
+    assert<int>::equals("IPOLA after recovery", 0xFF, expander.reg[0x02]);
+    assert<int>::equals("GPPUB after recovery", 0xFF, expander.reg[0x0D]);
+
+    // Back to normal
+    expander.pressed = 0x0001;
+    assert<uint64_t>::equals("Healthy read after recovery", gpa0, chip.read(NO_INPUTS));
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    internals::hal::i2c::setFakeExecutor(faultyExecutor);
+    TG_healthy();
+    TG_backoff();
+    TG_rejoin();
+    TG_counters();
+    TG_expander();
+    internals::hal::i2c::setFakeExecutor(nullptr);
+    return 0;
+}
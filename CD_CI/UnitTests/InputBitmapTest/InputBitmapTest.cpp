@@ -0,0 +1,81 @@
+/**
+ * @file InputBitmapTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#include "InputBitmap.hpp"
+#include <cassert>
+#include <iostream>
+
+//-------------------------------------------------------------------
+// Auxiliary
+//-------------------------------------------------------------------
+
+template <size_t WIDTH>
+void testWideBitmap()
+{
+    typedef WideBitmap<WIDTH> Bitmap;
+
+    // Construction
+    Bitmap none;
+    assert(!none && "Default bitmap is not empty");
+    Bitmap low(0x81ULL);
+    assert(low && "Bitmap from 64-bit value is empty");
+    assert((low.word[0] == 0x81ULL) && "Bad low word");
+    for (size_t i = 1; i < Bitmap::WORD_COUNT; i++)
+        assert((low.word[i] == 0ULL) && "High words not cleared");
+
+    // Single bits
+    for (size_t n = 0; n < WIDTH; n++)
+    {
+        Bitmap b = Bitmap::bit(n);
+        assert(b && "Single bit not set");
+        assert((b.word[n / 64] == (1ULL << (n % 64))) && "Single bit in wrong place");
+        assert(((b & ~b) == none) && "Bad complement");
+    }
+    assert((Bitmap::bit(WIDTH) == none) && "Out of range bit set");
+
+    // Bitwise operations across word boundaries
+    Bitmap a = Bitmap::bit(0) | Bitmap::bit(63) | Bitmap::bit(WIDTH - 1);
+    Bitmap b = Bitmap::bit(63) | Bitmap::bit(64);
+    assert(((a & b) == Bitmap::bit(63)) && "Bad AND");
+    assert(((a | b) == (Bitmap::bit(0) | Bitmap::bit(63) | Bitmap::bit(64) | Bitmap::bit(WIDTH - 1))) && "Bad OR");
+    assert(((a ^ b) == (Bitmap::bit(0) | Bitmap::bit(64) | Bitmap::bit(WIDTH - 1))) && "Bad XOR");
+    assert(((a ^ a) == none) && "XOR not cleared");
+    assert((a != b) && "Bad inequality");
+    Bitmap all = ~none;
+    for (size_t i = 0; i < Bitmap::WORD_COUNT; i++)
+        assert((all.word[i] == ~0ULL) && "Bad complement of empty bitmap");
+    Bitmap c = all;
+    c &= ~Bitmap::bit(WIDTH - 1);
+    assert(((c ^ all) == Bitmap::bit(WIDTH - 1)) && "Bad AND assignment");
+    c |= Bitmap::bit(WIDTH - 1);
+    assert((c == all) && "Bad OR assignment");
+    c ^= all;
+    assert(!c && "Bad XOR assignment");
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+int main()
+{
+    testWideBitmap<128>();
+    testWideBitmap<192>();
+
+    // Input bitmaps
+    assert((NO_INPUTS == InputBitmap{}) && "Bad empty input bitmap");
+    assert(((ALL_INPUTS & inputBitmapOf(MAX_INPUT_NUMBER)) == inputBitmapOf(MAX_INPUT_NUMBER)) && "Bad full input bitmap");
+    assert((inputBitmapOf(MAX_INPUT_NUMBER + 1) == NO_INPUTS) && "Out of range input number");
+    assert((inputBitmapWord(inputBitmapOf(5), 0) == (1ULL << 5)) && "Bad input bitmap word");
+    return 0;
+}
@@ -19,6 +19,8 @@
 #include "cd_ci_assertions.hpp"
 #include <iostream>
 #include <functional>
+#include <thread>
+#include <atomic>
 
 //------------------------------------------------------------------
 // Globals
@@ -79,6 +81,7 @@ uint64_t currentHigh = 0ULL;
 uint8_t currentClutch = CLUTCH_NONE_VALUE;
 uint8_t currentLeftAxis = CLUTCH_NONE_VALUE;
 uint8_t currentRightAxis = CLUTCH_NONE_VALUE;
+bool currentKeepAlive = false;
 
 void internals::hid::reset()
 {
@@ -93,7 +96,8 @@ void internals::hid::reportInput(
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
     currentLow = inputsLow;
     currentHigh = inputsHigh;
@@ -101,6 +105,7 @@ void internals::hid::reportInput(
     currentClutch = clutchAxis;
     currentLeftAxis = leftAxis;
     currentRightAxis = rightAxis;
+    currentKeepAlive = keepAlive;
     currentALTEnabled = (inputsLow == 0ULL) && (inputsHigh != 0ULL);
     currentState = currentALTEnabled ? inputsHigh : inputsLow;
 }
@@ -109,7 +114,7 @@ void internals::hid::reportInput(
 
 void internals::inputMap::map(
     bool isAltModeEngaged,
-    uint64_t firmware_bitmap,
+    const InputBitmap &firmware_bitmap,
     uint64_t &low,
     uint64_t &high)
 {
@@ -197,16 +202,20 @@ void InputSimulator::axis(uint8_t left, uint8_t right)
 
 //------------------------------------------------------------------
 
+extern void inputHubBuildPipeline();
+
 void noClutchPaddles()
 {
     DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_BUTTON, false);
     DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_ANALOG, false);
+    inputHubBuildPipeline();
 }
 
 void clutchPaddleType(bool analog)
 {
     DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_ANALOG, analog);
     DeviceCapabilities::setFlag(DeviceCapability::CLUTCH_BUTTON, !analog);
+    inputHubBuildPipeline();
 }
 
 //------------------------------------------------------------------
@@ -759,6 +768,18 @@ void TG_repeatedCommand()
     input.release();
 }
 
+void TG_keepAlive()
+{
+    input.release();
+    assert<bool>::equals("Not a keep-alive event", false, currentKeepAlive);
+    input.event.keepAlive = true;
+    input.repeat();
+    input.event.keepAlive = false;
+    assert<bool>::equals("Keep-alive event", true, currentKeepAlive);
+    input.repeat();
+    assert<bool>::equals("Keep-alive flag cleared", false, currentKeepAlive);
+}
+
 void TG_securityLock()
 {
     // initialize
@@ -813,6 +834,109 @@ void TG_neutralGear()
     assert<uint64_t>::equals("Lshift off + RShift off", 0ULL, currentLow);
 }
 
+void TG_concurrentSettings()
+{
+    // Working modes are changed by another thread
+    // while inputs are processed. Every HID report must be consistent
+    // with one working mode or the other.
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation);
+    input.release();
+    std::atomic<bool> done = false;
+    std::thread writer(
+        [&done]()
+        {
+            for (int i = 0; i < 20000; i++)
+                InputHubService::call::setDPadWorkingMode(
+                    (i % 2) ? DPadWorkingMode::Navigation : DPadWorkingMode::Regular);
+            done = true;
+        });
+    while (!done)
+    {
+        input.push(UP);
+        bool asPOV = (currentPOV == 1) && (currentState == 0ULL);
+        bool asButton = (currentPOV == 0) && (currentState == UP_B);
+        assert((asPOV || asButton) && "Inconsistent working mode");
+        input.release();
+    }
+    writer.join();
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation);
+}
+
+void TG_concurrentCommands()
+{
+    // Command combos are issued while another thread changes
+    // the settings. No command is lost.
+    InputHubService::call::setClutchWorkingMode(ClutchWorkingMode::CLUTCH);
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation);
+    input.release();
+    std::atomic<bool> done = false;
+    std::thread writer(
+        [&done]()
+        {
+            int i = 0;
+            while (!done)
+                InputHubService::call::setDPadWorkingMode(
+                    (i++ % 2) ? DPadWorkingMode::Navigation : DPadWorkingMode::Regular);
+        });
+    uint8_t modeCount = (uint8_t)ClutchWorkingMode::_MAX_VALUE + 1;
+    for (int i = 0; i < 1000; i++)
+    {
+        input.pushSeveral(BMP_CYCLE_CLUTCH);
+        input.release();
+    }
+    done = true;
+    writer.join();
+    assert<int>::equals(
+        "Clutch working mode after concurrent cycles",
+        (int)((uint8_t)ClutchWorkingMode::CLUTCH + 1000) % modeCount,
+        (int)InputHubService::call::getClutchWorkingMode());
+    InputHubService::call::setClutchWorkingMode(ClutchWorkingMode::CLUTCH);
+    InputHubService::call::setDPadWorkingMode(DPadWorkingMode::Navigation);
+}
+
+void TG_eventTrace()
+{
+    InputTraceEntry entry;
+    input.release();
+    uint32_t first = InputHubService::call::getEventTraceCount();
+
+    // Nothing recorded while disabled
+    InputHubService::call::setEventTrace(false);
+    input.push(LSHIFT);
+    assert<uint32_t>::equals("Recorded while disabled", first, InputHubService::call::getEventTraceCount());
+    input.release();
+
+    // Reported events
+    InputHubService::call::setEventTrace(true);
+    assert<bool>::equals("Trace enabled", true, InputHubService::call::getEventTrace());
+    input.push(LSHIFT);
+    input.release(LSHIFT);
+    assert<uint32_t>::equals("Recorded count", first + 2, InputHubService::call::getEventTraceCount());
+    assert(InputHubService::call::getEventTraceEntry(first, entry) && "Entry not available (1)");
+    assert<bool>::equals("Reported (1)", true, entry.reported);
+    assert<uint64_t>::equals("Raw bitmap (1)", BITMAP(LSHIFT), inputBitmapWord(entry.input.rawInputBitmap, 0));
+    assert<uint64_t>::equals("Raw changes (1)", BITMAP(LSHIFT), inputBitmapWord(entry.input.rawInputChanges, 0));
+    assert<uint64_t>::equals("HID inputs (1)", BITMAP(LSHIFT), entry.inputsLow);
+    assert(InputHubService::call::getEventTraceEntry(first + 1, entry) && "Entry not available (2)");
+    assert<uint64_t>::equals("Raw bitmap (2)", 0ULL, inputBitmapWord(entry.input.rawInputBitmap, 0));
+    assert<uint64_t>::equals("HID inputs (2)", 0ULL, entry.inputsLow);
+    assert(!InputHubService::call::getEventTraceEntry(first + 2, entry) && "Entry not recorded yet");
+
+    // Events consumed by a command
+    InputHubService::call::setAltButtonsWorkingMode(AltButtonsWorkingMode::ALT);
+    input.pushSeveral(BMP_CYCLE_ALT);
+    assert(InputHubService::call::getEventTraceEntry(first + 2, entry) && "Entry not available (3)");
+    assert<bool>::equals("Reported (3)", false, entry.reported);
+    input.release();
+
+    // The oldest entries are overwritten
+    for (int i = 0; i < EVENT_TRACE_DEPTH; i++)
+        input.repeat();
+    assert(!InputHubService::call::getEventTraceEntry(first, entry) && "Entry not overwritten");
+    InputHubService::call::setEventTrace(false);
+    InputHubService::call::setAltButtonsWorkingMode(AltButtonsWorkingMode::Regular);
+}
+
 //------------------------------------------------------------------
 //------------------------------------------------------------------
 // Entry point
@@ -897,9 +1021,20 @@ int main()
     std::cout << ("- simulate repeated input without real change in inputs state -") << std::endl;
     TG_repeatedCommand();
 
+    std::cout << ("- forward keep-alive events -") << std::endl;
+    TG_keepAlive();
+
     std::cout << ("- simulate security lock -") << std::endl;
     TG_securityLock();
 
     std::cout << ("- simulate neutral gear input -") << std::endl;
     TG_neutralGear();
+
+    std::cout << ("- simulate concurrent changes in working modes -") << std::endl;
+    TG_concurrentSettings();
+    std::cout << ("- simulate command combos during concurrent changes -") << std::endl;
+    TG_concurrentCommands();
+
+    std::cout << ("- trace input events -") << std::endl;
+    TG_eventTrace();
 }
\ No newline at end of file
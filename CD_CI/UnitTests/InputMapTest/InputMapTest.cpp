@@ -13,6 +13,8 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include <iostream>
+#include <thread>
+#include <atomic>
 
 bool loaded = false;
 
@@ -215,6 +217,159 @@ void test6()
     InputNumber::bookAll();
 }
 
+void test7()
+{
+    std::cout << "- Test 7 -" << std::endl;
+    uint8_t alt, noAlt;
+    uint64_t rawBitmap, low, high;
+
+    reset();
+    internals::inputMap::getReady();
+    OnStart::notify();
+    InputMapService::call::setMap(5, 50, 51);
+
+    // Bulk map
+    uint8_t newNoAlt[INPUT_BITMAP_WIDTH];
+    uint8_t newAlt[INPUT_BITMAP_WIDTH];
+    for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
+    {
+        newNoAlt[i] = 0xFF;
+        newAlt[i] = 0xFF;
+    }
+    newNoAlt[0] = 10;
+    newAlt[0] = 11;
+    newNoAlt[1] = 12;
+    newAlt[1] = 0xFF; // Incomplete: not changed
+    newNoAlt[63] = 0;
+    newAlt[63] = 127;
+    InputMapService::call::setMaps(newNoAlt, newAlt);
+
+    InputMapService::call::getMap(0, noAlt, alt);
+    assert((noAlt == 10) && (alt == 11) && "setMaps failed (1)");
+    InputMapService::call::getMap(1, noAlt, alt);
+    assert((noAlt == 1) && (alt == 65) && "setMaps failed (2)");
+    InputMapService::call::getMap(5, noAlt, alt);
+    assert((noAlt == 50) && (alt == 51) && "setMaps did not keep the previous map");
+    InputMapService::call::getMap(63, noAlt, alt);
+    assert((noAlt == 0) && (alt == 127) && "setMaps failed (3)");
+
+    rawBitmap = 0b100001;
+    internals::inputMap::map(false, rawBitmap, low, high);
+    assert(((low == (BMPL(10) | BMPL(50))) && (high == 0ULL)) && "map() failed after setMaps (1)");
+    internals::inputMap::map(true, rawBitmap, low, high);
+    assert(((low == (BMPL(11) | BMPL(51))) && (high == 0ULL)) && "map() failed after setMaps (2)");
+
+    // Single changes after a bulk map
+    InputMapService::call::setMap(0, 20, 21);
+    InputMapService::call::getMap(0, noAlt, alt);
+    assert((noAlt == 20) && (alt == 21) && "setMap failed after setMaps");
+    InputMapService::call::setMaps(newNoAlt, newAlt);
+    InputMapService::call::getMap(0, noAlt, alt);
+    assert((noAlt == 10) && (alt == 11) && "setMaps failed (4)");
+    InputMapService::call::getMap(5, noAlt, alt);
+    assert((noAlt == 50) && (alt == 51) && "setMaps lost a previous change");
+}
+
+void test8()
+{
+    std::cout << "- Test 8 -" << std::endl;
+    reset();
+    internals::inputMap::getReady();
+    OnStart::notify();
+
+    // Bulk maps are replaced by another thread
+    // while inputs are mapped. Every result must be consistent
+    // with one map or the other.
+    uint8_t identity[INPUT_BITMAP_WIDTH];
+    uint8_t shifted[INPUT_BITMAP_WIDTH];
+    for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
+    {
+        identity[i] = i % 64;
+        shifted[i] = (i + 1) % 64;
+    }
+    std::atomic<bool> done = false;
+    std::thread writer(
+        [&]()
+        {
+            for (int i = 0; i < 20000; i++)
+                InputMapService::call::setMaps(
+                    (i % 2) ? shifted : identity,
+                    (i % 2) ? shifted : identity);
+            done = true;
+        });
+    InputBitmap rawBitmap = BMPL(0) | BMPL(1) | BMPL(2);
+    uint64_t low, high;
+    while (!done)
+    {
+        internals::inputMap::map(false, rawBitmap, low, high);
+        bool asIdentity = (low == (BMPL(0) | BMPL(1) | BMPL(2)));
+        bool asShifted = (low == (BMPL(1) | BMPL(2) | BMPL(3)));
+        assert((asIdentity || asShifted) && "Inconsistent map");
+    }
+    writer.join();
+}
+
+void test9()
+{
+    std::cout << "- Test 9 -" << std::endl;
+    uint8_t alt, noAlt;
+
+    reset();
+    inputMap::set(0, 1, 2);
+    internals::inputMap::getReady();
+    OnStart::notify();
+
+    // The factory map is not affected by the user-defined map
+    InputMapService::call::setMap(0, 40, 41);
+    InputMapService::call::setMap(7, 42, 43);
+    internals::inputMap::getFactoryMap(0, noAlt, alt);
+    assert((noAlt == 1) && (alt == 2) && "getFactoryMap failed (1)");
+    internals::inputMap::getFactoryMap(7, noAlt, alt);
+    assert((noAlt == 7) && (alt == 7 + 64) && "getFactoryMap failed (2)");
+}
+
+void test10()
+{
+    std::cout << "- Test 10 -" << std::endl;
+    reset();
+    internals::inputMap::getReady();
+    OnStart::notify();
+
+    // Same as test 8, but the map is also reset and changed
+    // one input at a time by another thread
+    uint8_t shifted[INPUT_BITMAP_WIDTH];
+    for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
+        shifted[i] = (i + 1) % 64;
+    std::atomic<bool> done = false;
+    std::thread writer(
+        [&]()
+        {
+            // Note: the last iteration resets the map
+            for (int i = 0; i <= 20000; i++)
+                if (i % 2)
+                    InputMapService::call::setMaps(shifted, shifted);
+                else
+                {
+                    InputMapService::call::resetMap();
+                    InputMapService::call::setMap(10, 11, 12);
+                }
+            done = true;
+        });
+    InputBitmap rawBitmap = BMPL(0) | BMPL(1) | BMPL(2);
+    uint64_t low, high;
+    while (!done)
+    {
+        internals::inputMap::map(false, rawBitmap, low, high);
+        bool asDefault = (low == (BMPL(0) | BMPL(1) | BMPL(2)));
+        bool asShifted = (low == (BMPL(1) | BMPL(2) | BMPL(3)));
+        assert((asDefault || asShifted) && "Inconsistent map");
+    }
+    writer.join();
+    uint8_t alt, noAlt;
+    InputMapService::call::getMap(10, noAlt, alt);
+    assert((noAlt == 11) && (alt == 12) && "setMap failed after resetMap");
+}
+
 int main()
 {
     LoadSetting::subscribe(loadSettingsCallback);
@@ -255,4 +410,8 @@ int main()
     test4();
     test5();
     test6();
+    test7();
+    test8();
+    test9();
+    test10();
 }
\ No newline at end of file
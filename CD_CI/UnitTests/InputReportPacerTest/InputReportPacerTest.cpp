@@ -0,0 +1,137 @@
+/**
+ * @file InputReportPacerTest.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-19
+ * @brief Unit test
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "InputReportPacer.hpp"
+#include "cd_ci_assertions.hpp"
+#include <iostream>
+
+//------------------------------------------------------------------
+// Mocks
+//------------------------------------------------------------------
+
+class MockEndpoint : public InputReportEndpoint
+{
+public:
+    bool busy = false;
+    uint32_t sendCount = 0;
+    uint8_t last[GAMEPAD_REPORT_SIZE];
+    uint8_t lastSize = 0;
+
+    virtual bool sendInputReport(const uint8_t *report, uint8_t size) override
+    {
+        if (busy)
+            return false;
+        sendCount++;
+        memcpy(last, report, size);
+        lastSize = size;
+        return true;
+    }
+};
+
+//------------------------------------------------------------------
+// Auxiliary
+//------------------------------------------------------------------
+
+#define CONFIG_NOTIFICATION (RID_FEATURE_CONFIG << 4)
+
+void makeReport(uint8_t *report, uint8_t buttons, uint8_t lastByte)
+{
+    report[0] = buttons;
+    report[1] = 0;
+    report[2] = lastByte;
+}
+
+//------------------------------------------------------------------
+// Test groups
+//------------------------------------------------------------------
+
+void TG_pacing()
+{
+    std::cout << "- pacing -" << std::endl;
+    MockEndpoint endpoint;
+    InputReportPacer pacer(endpoint, 1000);
+    uint8_t report[3];
+
+    assert<int64_t>::equals("Nothing pending", 0, pacer.flush(5000));
+    makeReport(report, 1, 0);
+    pacer.post(report, 3);
+    assert<int64_t>::equals("Sent at once", 0, pacer.flush(5000));
+    assert<uint32_t>::equals("Send count", 1, endpoint.sendCount);
+    assert<bool>::equals("Not pending", false, pacer.isPending());
+
+    // Too early
+    makeReport(report, 2, 0);
+    pacer.post(report, 3);
+    assert<int64_t>::equals("Wait", 600, pacer.flush(5400));
+    assert<uint32_t>::equals("Not sent", 1, endpoint.sendCount);
+    assert<int64_t>::equals("Sent later", 0, pacer.flush(6000));
+    assert<uint8_t>::equals("Latest report", 2, endpoint.last[0]);
+
+    // Busy endpoint
+    endpoint.busy = true;
+    makeReport(report, 3, 0);
+    pacer.post(report, 3);
+    assert<int64_t>::equals("Busy", INPUT_REPORT_BUSY_RETRY_US, pacer.flush(8000));
+    assert<bool>::equals("Still pending", true, pacer.isPending());
+    endpoint.busy = false;
+    assert<int64_t>::equals("No longer busy", 0, pacer.flush(8250));
+    assert<uint8_t>::equals("Latest report (2)", 3, endpoint.last[0]);
+}
+
+void TG_overwrite()
+{
+    std::cout << "- two reports inside one period -" << std::endl;
+    MockEndpoint endpoint;
+    InputReportPacer pacer(endpoint, 1000);
+    uint8_t report[3];
+    makeReport(report, 1, 0);
+    pacer.post(report, 3);
+    pacer.flush(5000);
+
+    // A configuration change is notified, then overwritten
+    makeReport(report, 2, CONFIG_NOTIFICATION | 0x01);
+    pacer.post(report, 3);
+    pacer.flush(5100);
+    makeReport(report, 4, 0x02);
+    pacer.post(report, 3);
+    pacer.flush(5200);
+    assert<uint32_t>::equals("Not sent yet", 1, endpoint.sendCount);
+    pacer.flush(6000);
+    assert<uint32_t>::equals("Sent", 2, endpoint.sendCount);
+    assert<uint8_t>::equals("Latest buttons", 4, endpoint.last[0]);
+    assert<uint8_t>::equals(
+        "Notification carried over",
+        CONFIG_NOTIFICATION | 0x02,
+        endpoint.last[2]);
+
+    // Sent once
+    makeReport(report, 8, 0x03);
+    pacer.post(report, 3);
+    pacer.flush(7000);
+    assert<uint8_t>::equals("Notification sent once", 0x03, endpoint.last[2]);
+}
+
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+// Entry point
+//------------------------------------------------------------------
+//------------------------------------------------------------------
+
+int main()
+{
+    TG_pacing();
+    TG_overwrite();
+    return 0;
+}
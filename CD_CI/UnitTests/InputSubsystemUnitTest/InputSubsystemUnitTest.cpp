@@ -17,24 +17,42 @@
 #include "SimWheelInternals.hpp"
 #include "InternalTypes.hpp"
 #include "InternalServices.hpp"
+#include "HAL.hpp"
 #include "cd_ci_assertions.hpp"
 #include <iostream>
 #include <semaphore>
 #include <chrono>
+#include <thread>
+#include <algorithm>
 
 //------------------------------------------------------------------
 // Globals
 //------------------------------------------------------------------
 
-FakeInput *primary, *secondary;
+FakeInput *primary, *secondary, *busInput;
 
 DecouplingEvent receivedEvent;
 std::counting_semaphore<1> received{1};
 
+std::vector<uint8_t> fakeI2CDevices;
+uint32_t fakeI2CProbeCount = 0;
+
 //------------------------------------------------------------------
 // Auxiliary
 //------------------------------------------------------------------
 
+uint8_t getI2CFullAddress(uint8_t I2CAddress, bool isFullAddress, I2CBus bus);
+
+bool fakeI2CBus(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    fakeI2CProbeCount++;
+    return (bus == I2CBus::PRIMARY) &&
+           (std::find(
+                fakeI2CDevices.begin(),
+                fakeI2CDevices.end(),
+                transactions[0].address7bits) != fakeI2CDevices.end());
+}
+
 void waitFor(std::string message = "")
 {
     if (!received.try_acquire_for(std::chrono::milliseconds(300)))
@@ -50,6 +68,7 @@ void reset()
     primary->leftAxis = 0;
     primary->rightAxis = 0;
     secondary->state = 0ULL;
+    busInput->state = 0ULL;
     if ((receivedEvent.leftAxisValue != 0) ||
         (receivedEvent.rightAxisValue != 0) ||
         (receivedEvent.rawInputBitmap != 0ULL))
@@ -208,6 +227,131 @@ void test7()
     assert<size_t>::equals("recalibration", 2, primary->recalibrationRequestCount);
 }
 
+/**
+ * @brief Check inputs scanned in the bus task
+ *
+ */
+void test8()
+{
+    std::cout << "- test 8 -" << std::endl;
+    InputService::call::setAxisPolarity(false, false, false);
+    reset();
+    busInput->state = 0b110000;
+    waitFor("1");
+    binEquals("bus input (bitmap)", 0b110000, receivedEvent.rawInputBitmap);
+    binEquals("bus input (changes)", 0b110000, receivedEvent.rawInputChanges);
+    primary->press(0);
+    waitFor("2");
+    binEquals("merged input (bitmap)", 0b110001, receivedEvent.rawInputBitmap);
+    binEquals("merged input (changes)", 0b000001, receivedEvent.rawInputChanges);
+    busInput->release(5);
+    waitFor("3");
+    binEquals("bus release (bitmap)", 0b010001, receivedEvent.rawInputBitmap);
+    binEquals("bus release (changes)", 0b100000, receivedEvent.rawInputChanges);
+    primary->release(0);
+    waitFor("4");
+}
+
+void test9()
+{
+    std::cout << "- test 9 -" << std::endl;
+    internals::hal::i2c::setFakeExecutor(fakeI2CBus);
+    fakeI2CDevices = {0x20, 0x3A};
+
+    // First boot: the bus is probed
+    fakeI2CProbeCount = 0;
+    assert<int>::equals("Full address (1)", 0x20, getI2CFullAddress(0x20, true, I2CBus::PRIMARY));
+    assert((fakeI2CProbeCount >= 112) && "Bus not probed");
+    assert((fakeI2CProbeCount <= 224) && "Reserved addresses probed");
+
+    // Probed once
+    fakeI2CProbeCount = 0;
+    assert<int>::equals("Full address (2)", 0x3A, getI2CFullAddress(0x02, false, I2CBus::PRIMARY));
+    assert<uint32_t>::equals("Probes after discovery", 0, fakeI2CProbeCount);
+
+    // Next boot: cached addresses are verified with a single probe
+    internals::inputs::forgetI2CDevices();
+    fakeI2CProbeCount = 0;
+    assert<int>::equals("Full address (3)", 0x3A, getI2CFullAddress(0x02, false, I2CBus::PRIMARY));
+    assert<uint32_t>::equals("Probes from cache", 1, fakeI2CProbeCount);
+
+    // Next boot: a device was moved, so the bus is probed again
+    fakeI2CDevices = {0x20, 0x32};
+    internals::inputs::forgetI2CDevices();
+    fakeI2CProbeCount = 0;
+    assert<int>::equals("Full address (4)", 0x32, getI2CFullAddress(0x02, false, I2CBus::PRIMARY));
+    assert((fakeI2CProbeCount > 1) && "Stale cache not detected");
+
+    // Next boot: the new map was cached
+    internals::inputs::forgetI2CDevices();
+    fakeI2CProbeCount = 0;
+    assert<int>::equals("Full address (5)", 0x32, getI2CFullAddress(0x02, false, I2CBus::PRIMARY));
+    assert<uint32_t>::equals("Probes from updated cache", 1, fakeI2CProbeCount);
+
+    // Missing devices
+    try
+    {
+        getI2CFullAddress(0x50, true, I2CBus::PRIMARY);
+        assert(false && "Missing device found");
+    }
+    catch (i2c_device_not_found &e)
+    {
+    }
+    internals::hal::i2c::setFakeExecutor(nullptr);
+}
+
+/**
+ * @brief Check read cost profiling
+ *
+ */
+void test10()
+{
+    std::cout << "- test 10 -" << std::endl;
+    std::vector<InputReadCost> costs;
+    inputs::getReadCosts(costs);
+    assert<size_t>::equals("Profiled inputs", 3, costs.size());
+    assert<int>::equals("Service count", 3, InputService::call::getReadCostCount());
+    for (InputReadCost &cost : costs)
+        assert<uint32_t>::equals("Reads before profiling", 0, cost.readCount);
+    InputReadCost cost;
+    assert(!InputService::call::getReadCost(3, cost) && "Index out of range");
+
+    inputs::profileReads();
+    assert(InputService::call::getReadProfiling() && "Profiling not enabled");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    inputs::getReadCosts(costs);
+    uint8_t busCount = 0;
+    for (InputReadCost &cost : costs)
+    {
+        assert((cost.readCount > 0) && "Reads not profiled");
+        assert((cost.minNs <= cost.avgNs) && "Minimum above average");
+        assert((cost.avgNs <= cost.maxNs) && "Average above maximum");
+        assert<int>::equals("Input count", 2, cost.inputCount);
+        if (cost.busInput)
+        {
+            busCount++;
+            assert<int>::equals("Bus input number", 4, cost.firstInputNumber);
+        }
+        else
+            assert(((cost.firstInputNumber == 0) || (cost.firstInputNumber == 2)) &&
+                   "Wrong input number");
+    }
+    assert<int>::equals("Bus inputs", 1, busCount);
+
+    inputs::profileReads(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    InputService::call::getReadCost(0, cost);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    inputs::getReadCosts(costs);
+    assert<uint32_t>::equals("Reads after profiling", cost.readCount, costs[0].readCount);
+
+    // Statistics are cleared when enabled again
+    InputService::call::setReadProfiling(true);
+    InputService::call::getReadCost(0, cost);
+    assert((cost.readCount <= 1) && "Statistics not cleared");
+    InputService::call::setReadProfiling(false);
+}
+
 //------------------------------------------------------------------
 //------------------------------------------------------------------
 // Entry point
@@ -222,6 +366,10 @@ int main()
     secondary->mask = ~(0b1100);
     internals::inputs::addFakeInput(primary);
     internals::inputs::addFakeInput(secondary);
+    busInput = new FakeInput();
+    busInput->mask = ~(0b110000);
+    busInput->isBusInput = true;
+    internals::inputs::addFakeInput(busInput);
     internals::inputs::getReady();
     OnStart::notify();
     waitFor();
@@ -233,4 +381,7 @@ int main()
     test5();
     test6();
     test7();
+    test8();
+    test9();
+    test10();
 }
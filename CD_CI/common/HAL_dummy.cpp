@@ -23,6 +23,18 @@
 
 std::vector<int> fakeADCreadings;
 size_t fakeADCIndex = 0;
+I2CExecutor fakeI2CExecutor = nullptr;
+
+bool executeFakeI2CTransactions(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    if (fakeI2CExecutor)
+        return fakeI2CExecutor(bus, transactions, count);
+    return true;
+}
+
+I2CBusManager fakeBusManager[] = {
+    {static_cast<I2CBus>(0), executeFakeI2CTransactions},
+    {static_cast<I2CBus>(1), executeFakeI2CTransactions}};
 
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
@@ -34,9 +46,12 @@ size_t fakeADCIndex = 0;
 // I2C: Probe
 //-------------------------------------------------------------------
 
-bool internals::hal::i2c::probe(uint8_t address7bits, I2CBus bus)
+bool internals::hal::i2c::probe(uint8_t address7bits, I2CBus bus, I2CClient client)
 {
-    return true;
+    // An empty transaction to the given address
+    I2CTransaction transaction;
+    transaction.address7bits = address7bits;
+    return executeFakeI2CTransactions(bus, &transaction, 1);
 }
 
 // ----------------------------------------------------------------------------
@@ -46,10 +61,21 @@ void internals::hal::i2c::probe(std::vector<uint8_t> &result, I2CBus bus)
     result.clear();
     for (uint8_t address = 0; address < 128; address++)
     {
-        result.push_back(address);
+        if (!isReservedAddress(address) && probe(address, bus))
+            result.push_back(address);
     }
 }
 
+// ----------------------------------------------------------------------------
+
+void internals::hal::i2c::probe(
+    std::vector<uint8_t> &primary,
+    std::vector<uint8_t> &secondary)
+{
+    probe(primary, I2CBus::PRIMARY);
+    probe(secondary, I2CBus::SECONDARY);
+}
+
 // ----------------------------------------------------------------------------
 // I2C: _bus initialization
 // ----------------------------------------------------------------------------
@@ -58,8 +84,13 @@ void internals::hal::i2c::initialize(GPIO sda, GPIO scl, I2CBus bus, bool enable
 {
 }
 
-void internals::hal::i2c::require(uint8_t max_speed_multiplier, I2CBus bus)
+void internals::hal::i2c::require(
+    uint8_t max_speed_multiplier,
+    I2CBus bus,
+    uint8_t address7bits)
 {
+    if (address7bits < 128)
+        fakeBusManager[static_cast<int>(bus)].setDeviceSpeed(address7bits, max_speed_multiplier);
 }
 
 // ----------------------------------------------------------------------------
@@ -82,7 +113,55 @@ uint8_t internals::hal::i2c::findFullAddress(
     uint8_t hardwareAddress,
     uint8_t hardwareAddressMask)
 {
-    return hardwareAddress;
+    uint8_t fullAddress = 0xFF;
+    int count = 0;
+    for (uint8_t candidate : fullAddressList)
+        if ((candidate & hardwareAddressMask) == hardwareAddress)
+        {
+            count++;
+            fullAddress = candidate;
+        }
+    return (count > 1) ? 0xFE : fullAddress;
+}
+
+// ----------------------------------------------------------------------------
+// Transactions
+// ----------------------------------------------------------------------------
+
+bool internals::hal::i2c::execute(
+    I2CBus bus,
+    I2CClient client,
+    I2CTransaction *transactions,
+    size_t count)
+{
+    return fakeBusManager[static_cast<int>(bus)].execute(client, transactions, count);
+}
+
+bool internals::hal::i2c::recover(I2CBus bus, I2CClient client)
+{
+    return fakeBusManager[static_cast<int>(bus)].recover(client);
+}
+
+bool internals::hal::i2c::submit(I2CBus bus, I2CRequest &request)
+{
+    return fakeBusManager[static_cast<int>(bus)].submit(request);
+}
+
+I2CClientStatistics internals::hal::i2c::getStatistics(I2CBus bus, I2CClient client)
+{
+    return fakeBusManager[static_cast<int>(bus)].getStatistics(client);
+}
+
+void internals::hal::i2c::getDeviceStatistics(
+    std::vector<I2CDeviceStatistics> &result,
+    I2CBus bus)
+{
+    fakeBusManager[static_cast<int>(bus)].getDeviceStatistics(result);
+}
+
+void internals::hal::i2c::setFakeExecutor(I2CExecutor executor)
+{
+    fakeI2CExecutor = executor;
 }
 
 // ----------------------------------------------------------------------------
@@ -119,4 +198,20 @@ void internals::hal::gpio::forInput(
     bool enablePullDown,
     bool enablePullUp)
 {
-}
\ No newline at end of file
+}
+
+void internals::hal::gpio::enableISR(InputGPIO pin, ISRHandler handler, void *param)
+{
+}
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Task monitoring
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+uint32_t internals::hal::task::getStackHighWaterMark(void *handle)
+{
+    // Fake handles carry the high-water mark
+    return (uint32_t)(uintptr_t)handle;
+}
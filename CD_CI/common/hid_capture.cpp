@@ -0,0 +1,28 @@
+/**
+ * @file hid_capture.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Fake HID implementation capturing input reports
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "cd_ci_replay.hpp"
+
+void internals::hid::reset() {}
+
+void internals::hid::reportInput(
+    uint64_t inputsLow,
+    uint64_t inputsHigh,
+    uint8_t POVstate,
+    uint8_t leftAxis,
+    uint8_t rightAxis,
+    uint8_t clutchAxis,
+    bool keepAlive)
+{
+    capturedReports.push_back({inputsLow, inputsHigh, POVstate, leftAxis, rightAxis, clutchAxis});
+}
@@ -16,6 +16,9 @@ uint32_t lastPixelColor = 0;
 PixelGroup lastPixelGroup = PixelGroup::GRP_TELEMETRY;
 bool shown = false;
 uint8_t lastPixelIndex = 0;
+uint32_t pixelColor[3][16]{};
+uint32_t pixelCallCount = 0;
+uint32_t pixelShowCount = 0;
 
 void internals::pixels::getReady() {}
 void internals::pixels::set(PixelGroup group,
@@ -27,6 +30,9 @@ void internals::pixels::set(PixelGroup group,
     lastPixelGroup = group;
     lastPixelColor = blue | (green << 8) | (red << 16);
     lastPixelIndex = pixelIndex;
+    if (((uint8_t)group < 3) && (pixelIndex < 16))
+        pixelColor[(uint8_t)group][pixelIndex] = lastPixelColor;
+    pixelCallCount++;
 }
 
 void internals::pixels::setAll(PixelGroup group,
@@ -34,7 +40,23 @@ void internals::pixels::setAll(PixelGroup group,
                                uint8_t green,
                                uint8_t blue)
 {
-    internals::pixels::set(group, 0, red, green, blue);
+    internals::pixels::setRange(group, 0, 255, red, green, blue);
+}
+
+void internals::pixels::setRange(PixelGroup group,
+                                 uint8_t fromPixelIndex,
+                                 uint8_t toPixelIndex,
+                                 uint8_t red,
+                                 uint8_t green,
+                                 uint8_t blue)
+{
+    lastPixelGroup = group;
+    lastPixelColor = blue | (green << 8) | (red << 16);
+    lastPixelIndex = fromPixelIndex;
+    if ((uint8_t)group < 3)
+        for (uint16_t i = fromPixelIndex; (i <= toPixelIndex) && (i < 16); i++)
+            pixelColor[(uint8_t)group][i] = lastPixelColor;
+    pixelCallCount++;
 }
 
 void internals::pixels::shiftToNext(PixelGroup group) {}
@@ -42,6 +64,7 @@ void internals::pixels::shiftToPrevious(PixelGroup group) {}
 void internals::pixels::show()
 {
     shown = true;
+    pixelShowCount++;
 }
 
 void internals::pixels::reset()
@@ -50,6 +73,9 @@ void internals::pixels::reset()
     lastPixelGroup = PixelGroup::GRP_TELEMETRY;
     shown = false;
     lastPixelIndex = 0;
+    for (int g = 0; g < 3; g++)
+        for (int i = 0; i < 16; i++)
+            pixelColor[g][i] = 0;
 }
 
 uint8_t internals::pixels::getCount(PixelGroup group) { return 16; }
@@ -0,0 +1,51 @@
+/**
+ * @file cd_ci_benchmark.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Utility for throughput measurements
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+//------------------------------------------------------------------
+// Benchmark
+//------------------------------------------------------------------
+
+/**
+ * @brief Run a function many times and print its throughput
+ *
+ * @param name Name of this benchmark
+ * @param iterations Number of calls to @p work
+ * @param work Function to measure. Receives the iteration number.
+ * @return double Calls per second
+ */
+inline double benchmark(
+    std::string name,
+    uint64_t iterations,
+    std::function<void(uint64_t)> work)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+        work(i);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double throughput = (seconds > 0.0) ? (iterations / seconds) : 0.0;
+    std::cout << "[benchmark] " << name << ": "
+              << iterations << " calls in "
+              << (seconds * 1000.0) << " ms ("
+              << (uint64_t)throughput << " calls/s)" << std::endl;
+    return throughput;
+}
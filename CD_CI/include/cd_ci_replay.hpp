@@ -0,0 +1,593 @@
+/**
+ * @file cd_ci_replay.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Record and replay of input streams through the input hub
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Imports
+//------------------------------------------------------------------
+
+#include "SimWheelInternals.hpp"
+#include "HID_definitions.hpp"
+#include "cd_ci_benchmark.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+
+//------------------------------------------------------------------
+// Streams
+//------------------------------------------------------------------
+
+/**
+ * @brief An input report as sent to the host computer
+ *
+ */
+struct CapturedReport
+{
+    uint64_t inputsLow;
+    uint64_t inputsHigh;
+    uint8_t POVstate;
+    uint8_t leftAxis;
+    uint8_t rightAxis;
+    uint8_t clutchAxis;
+
+    bool operator==(const CapturedReport &other) const = default;
+};
+
+/// @brief A sequence of input events
+typedef std::vector<DecouplingEvent> InputStream;
+
+/// @brief A sequence of input reports
+typedef std::vector<CapturedReport> ReportStream;
+
+/// @brief Input reports captured by the fake HID implementation
+///        (see hid_capture.cpp)
+inline ReportStream capturedReports;
+
+//------------------------------------------------------------------
+// Binary format
+//------------------------------------------------------------------
+
+/*
+Both files start with a 12-byte header:
+- 4 bytes: signature ("SWIS" for input events, "SWRS" for reports)
+- 1 byte: format version
+- 1 byte: width of the input bitmap in bytes (zero for reports)
+- 2 bytes: reserved
+- 4 bytes: count of items (little endian)
+
+Each item is encoded as a difference from the previous one,
+starting from all inputs released and the axes in the
+CLUTCH_NONE_VALUE position. Each item starts with a byte
+of flags telling which fields follow.
+
+Bitmaps and button states are encoded as a count of non-zero
+bytes followed by (byte index, value) pairs, where the values are
+XORed with the previous item, so a single button press or
+release takes three bytes.
+*/
+
+namespace replay
+{
+    /// @brief Version of the binary format
+    constexpr uint8_t FORMAT_VERSION = 1;
+    /// @brief Size of the file header
+    constexpr size_t HEADER_SIZE = 12;
+    /// @brief Width of the input bitmap in bytes
+    constexpr uint8_t BITMAP_BYTES = INPUT_BITMAP_WIDTH / 8;
+
+    // Flags of input events
+    constexpr uint8_t EVENT_BITMAP = 0x01;
+    constexpr uint8_t EVENT_CHANGES = 0x02;
+    constexpr uint8_t EVENT_LEFT_AXIS = 0x04;
+    constexpr uint8_t EVENT_RIGHT_AXIS = 0x08;
+
+    // Flags of reports
+    constexpr uint8_t REPORT_LOW = 0x01;
+    constexpr uint8_t REPORT_HIGH = 0x02;
+    constexpr uint8_t REPORT_POV = 0x04;
+    constexpr uint8_t REPORT_LEFT_AXIS = 0x08;
+    constexpr uint8_t REPORT_RIGHT_AXIS = 0x10;
+    constexpr uint8_t REPORT_CLUTCH_AXIS = 0x20;
+
+    //--------------------------------------------------------------
+    // Auxiliary
+    //--------------------------------------------------------------
+
+    inline uint8_t bitmapByte(const InputBitmap &bitmap, uint8_t index)
+    {
+        return (inputBitmapWord(bitmap, index / 8) >> ((index % 8) * 8)) & 0xFF;
+    }
+
+    inline void setBitmapByte(InputBitmap &bitmap, uint8_t index, uint8_t value)
+    {
+        uint8_t shift = (index % 8) * 8;
+        uint64_t word = inputBitmapWord(bitmap, index / 8);
+        word = (word & ~(0xFFULL << shift)) | ((uint64_t)value << shift);
+        setInputBitmapWord(bitmap, index / 8, word);
+    }
+
+    inline void putHeader(std::vector<uint8_t> &data, const char *signature, uint8_t width, uint32_t count)
+    {
+        data.insert(data.end(), signature, signature + 4);
+        data.push_back(FORMAT_VERSION);
+        data.push_back(width);
+        data.push_back(0);
+        data.push_back(0);
+        for (int i = 0; i < 4; i++)
+            data.push_back((count >> (i * 8)) & 0xFF);
+    }
+
+    inline bool getHeader(const std::vector<uint8_t> &data, const char *signature, uint8_t maxWidth, uint32_t &count)
+    {
+        if ((data.size() < HEADER_SIZE) ||
+            (memcmp(data.data(), signature, 4) != 0) ||
+            (data[4] != FORMAT_VERSION) ||
+            (data[5] > maxWidth))
+            return false;
+        count = 0;
+        for (int i = 0; i < 4; i++)
+            count |= ((uint32_t)data[8 + i]) << (i * 8);
+        return true;
+    }
+
+    inline void putBitmap(std::vector<uint8_t> &data, const InputBitmap &bitmap)
+    {
+        size_t countIndex = data.size();
+        data.push_back(0);
+        for (uint8_t i = 0; i < BITMAP_BYTES; i++)
+        {
+            uint8_t value = bitmapByte(bitmap, i);
+            if (value)
+            {
+                data.push_back(i);
+                data.push_back(value);
+                data[countIndex]++;
+            }
+        }
+    }
+
+    inline bool getBitmap(const std::vector<uint8_t> &data, size_t &index, InputBitmap &bitmap)
+    {
+        bitmap = NO_INPUTS;
+        if (index >= data.size())
+            return false;
+        uint8_t count = data[index++];
+        if ((count > BITMAP_BYTES) || ((index + 2 * count) > data.size()))
+            return false;
+        for (uint8_t i = 0; i < count; i++, index += 2)
+        {
+            if (data[index] >= BITMAP_BYTES)
+                return false;
+            setBitmapByte(bitmap, data[index], data[index + 1]);
+        }
+        return true;
+    }
+
+    inline void putWord(std::vector<uint8_t> &data, uint64_t word)
+    {
+        size_t countIndex = data.size();
+        data.push_back(0);
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            uint8_t value = (word >> (i * 8)) & 0xFF;
+            if (value)
+            {
+                data.push_back(i);
+                data.push_back(value);
+                data[countIndex]++;
+            }
+        }
+    }
+
+    inline bool getWord(const std::vector<uint8_t> &data, size_t &index, uint64_t &word)
+    {
+        word = 0ULL;
+        if (index >= data.size())
+            return false;
+        uint8_t count = data[index++];
+        if ((count > 8) || ((index + 2 * count) > data.size()))
+            return false;
+        for (uint8_t i = 0; i < count; i++, index += 2)
+        {
+            if (data[index] >= 8)
+                return false;
+            word |= ((uint64_t)data[index + 1]) << (data[index] * 8);
+        }
+        return true;
+    }
+
+    inline bool getByte(const std::vector<uint8_t> &data, size_t &index, uint8_t &value)
+    {
+        if (index >= data.size())
+            return false;
+        value = data[index++];
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    // Encoding
+    //--------------------------------------------------------------
+
+    /**
+     * @brief Encode a stream of input events
+     *
+     * @param stream Input events
+     * @param[out] data Binary data
+     */
+    inline void encode(const InputStream &stream, std::vector<uint8_t> &data)
+    {
+        data.clear();
+        putHeader(data, "SWIS", BITMAP_BYTES, stream.size());
+        InputBitmap bitmap = NO_INPUTS;
+        uint8_t left = CLUTCH_NONE_VALUE;
+        uint8_t right = CLUTCH_NONE_VALUE;
+        for (const DecouplingEvent &event : stream)
+        {
+            InputBitmap delta = event.rawInputBitmap ^ bitmap;
+            uint8_t flags = 0;
+            if (delta != NO_INPUTS)
+                flags |= EVENT_BITMAP;
+            if (event.rawInputChanges != delta)
+                flags |= EVENT_CHANGES;
+            if (event.leftAxisValue != left)
+                flags |= EVENT_LEFT_AXIS;
+            if (event.rightAxisValue != right)
+                flags |= EVENT_RIGHT_AXIS;
+            data.push_back(flags);
+            if (flags & EVENT_BITMAP)
+                putBitmap(data, delta);
+            if (flags & EVENT_CHANGES)
+                putBitmap(data, event.rawInputChanges);
+            if (flags & EVENT_LEFT_AXIS)
+                data.push_back(event.leftAxisValue);
+            if (flags & EVENT_RIGHT_AXIS)
+                data.push_back(event.rightAxisValue);
+            bitmap = event.rawInputBitmap;
+            left = event.leftAxisValue;
+            right = event.rightAxisValue;
+        }
+    }
+
+    /**
+     * @brief Decode a stream of input events
+     *
+     * @param data Binary data
+     * @param[out] stream Input events
+     * @return true On success
+     * @return false If @p data is malformed or it was recorded
+     *               with a wider input bitmap
+     */
+    inline bool decode(const std::vector<uint8_t> &data, InputStream &stream)
+    {
+        uint32_t count;
+        stream.clear();
+        if (!getHeader(data, "SWIS", BITMAP_BYTES, count))
+            return false;
+        stream.reserve(count);
+        size_t index = HEADER_SIZE;
+        DecouplingEvent event;
+        event.rawInputBitmap = NO_INPUTS;
+        event.leftAxisValue = CLUTCH_NONE_VALUE;
+        event.rightAxisValue = CLUTCH_NONE_VALUE;
+        for (uint32_t n = 0; n < count; n++)
+        {
+            uint8_t flags;
+            InputBitmap delta = NO_INPUTS;
+            if (!getByte(data, index, flags) ||
+                ((flags & EVENT_BITMAP) && !getBitmap(data, index, delta)))
+                return false;
+            event.rawInputBitmap ^= delta;
+            event.rawInputChanges = delta;
+            if (((flags & EVENT_CHANGES) && !getBitmap(data, index, event.rawInputChanges)) ||
+                ((flags & EVENT_LEFT_AXIS) && !getByte(data, index, event.leftAxisValue)) ||
+                ((flags & EVENT_RIGHT_AXIS) && !getByte(data, index, event.rightAxisValue)))
+                return false;
+            stream.push_back(event);
+        }
+        return (index == data.size());
+    }
+
+    /**
+     * @brief Encode a stream of input reports
+     *
+     * @param stream Input reports
+     * @param[out] data Binary data
+     */
+    inline void encode(const ReportStream &stream, std::vector<uint8_t> &data)
+    {
+        data.clear();
+        putHeader(data, "SWRS", 0, stream.size());
+        CapturedReport previous{0ULL, 0ULL, 0, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE};
+        for (const CapturedReport &report : stream)
+        {
+            uint8_t flags = 0;
+            flags |= (report.inputsLow != previous.inputsLow) ? REPORT_LOW : 0;
+            flags |= (report.inputsHigh != previous.inputsHigh) ? REPORT_HIGH : 0;
+            flags |= (report.POVstate != previous.POVstate) ? REPORT_POV : 0;
+            flags |= (report.leftAxis != previous.leftAxis) ? REPORT_LEFT_AXIS : 0;
+            flags |= (report.rightAxis != previous.rightAxis) ? REPORT_RIGHT_AXIS : 0;
+            flags |= (report.clutchAxis != previous.clutchAxis) ? REPORT_CLUTCH_AXIS : 0;
+            data.push_back(flags);
+            if (flags & REPORT_LOW)
+                putWord(data, report.inputsLow ^ previous.inputsLow);
+            if (flags & REPORT_HIGH)
+                putWord(data, report.inputsHigh ^ previous.inputsHigh);
+            if (flags & REPORT_POV)
+                data.push_back(report.POVstate);
+            if (flags & REPORT_LEFT_AXIS)
+                data.push_back(report.leftAxis);
+            if (flags & REPORT_RIGHT_AXIS)
+                data.push_back(report.rightAxis);
+            if (flags & REPORT_CLUTCH_AXIS)
+                data.push_back(report.clutchAxis);
+            previous = report;
+        }
+    }
+
+    /**
+     * @brief Decode a stream of input reports
+     *
+     * @param data Binary data
+     * @param[out] stream Input reports
+     * @return true On success
+     * @return false If @p data is malformed
+     */
+    inline bool decode(const std::vector<uint8_t> &data, ReportStream &stream)
+    {
+        uint32_t count;
+        stream.clear();
+        if (!getHeader(data, "SWRS", 0, count))
+            return false;
+        stream.reserve(count);
+        size_t index = HEADER_SIZE;
+        CapturedReport report{0ULL, 0ULL, 0, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE, CLUTCH_NONE_VALUE};
+        for (uint32_t n = 0; n < count; n++)
+        {
+            uint8_t flags;
+            uint64_t deltaLow = 0ULL;
+            uint64_t deltaHigh = 0ULL;
+            if (!getByte(data, index, flags) ||
+                ((flags & REPORT_LOW) && !getWord(data, index, deltaLow)) ||
+                ((flags & REPORT_HIGH) && !getWord(data, index, deltaHigh)))
+                return false;
+            report.inputsLow ^= deltaLow;
+            report.inputsHigh ^= deltaHigh;
+            if (((flags & REPORT_POV) && !getByte(data, index, report.POVstate)) ||
+                ((flags & REPORT_LEFT_AXIS) && !getByte(data, index, report.leftAxis)) ||
+                ((flags & REPORT_RIGHT_AXIS) && !getByte(data, index, report.rightAxis)) ||
+                ((flags & REPORT_CLUTCH_AXIS) && !getByte(data, index, report.clutchAxis)))
+                return false;
+            stream.push_back(report);
+        }
+        return (index == data.size());
+    }
+
+    //--------------------------------------------------------------
+    // Files
+    //--------------------------------------------------------------
+
+    /**
+     * @brief Write binary data to a file
+     *
+     * @param path File name
+     * @param data Binary data
+     * @return true On success
+     */
+    inline bool save(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write((const char *)data.data(), data.size());
+        return file.good();
+    }
+
+    /**
+     * @brief Read binary data from a file
+     *
+     * @param path File name
+     * @param[out] data Binary data
+     * @return true On success
+     */
+    inline bool load(const std::string &path, std::vector<uint8_t> &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    // Sources of input events
+    //--------------------------------------------------------------
+
+    /**
+     * @brief Generate a deterministic pseudo-random stream
+     *
+     * @note Each event toggles one of the inputs in @p inputs.
+     *       The same seed always generates the same stream.
+     *
+     * @param[out] stream Input events
+     * @param count Count of events
+     * @param seed Non-zero seed
+     * @param inputs Inputs to toggle
+     * @param axes True to move the axes, too
+     */
+    inline void generate(
+        InputStream &stream,
+        uint32_t count,
+        uint32_t seed,
+        InputBitmap inputs,
+        bool axes = false)
+    {
+        std::vector<uint8_t> candidates;
+        for (uint8_t n = 0; n < INPUT_BITMAP_WIDTH; n++)
+            if ((inputs & inputBitmapOf(n)) != NO_INPUTS)
+                candidates.push_back(n);
+        stream.clear();
+        stream.reserve(count);
+        uint32_t random = (seed != 0) ? seed : 1;
+        DecouplingEvent event;
+        event.rawInputBitmap = NO_INPUTS;
+        event.leftAxisValue = CLUTCH_NONE_VALUE;
+        event.rightAxisValue = CLUTCH_NONE_VALUE;
+        for (uint32_t i = 0; (i < count) && (candidates.size() > 0); i++)
+        {
+            // xorshift32
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            event.rawInputChanges = inputBitmapOf(candidates[random % candidates.size()]);
+            event.rawInputBitmap ^= event.rawInputChanges;
+            if (axes && (random & 0x100))
+            {
+                event.leftAxisValue = (random >> 9) & 0xFF;
+                event.rightAxisValue = (random >> 17) & 0xFF;
+            }
+            stream.push_back(event);
+        }
+    }
+
+    /**
+     * @brief Extract input events and reports from an on-device trace
+     *
+     * @note The trace is dumped as a sequence of raw report ID 8
+     *       payloads (see HID_notes.md). Entries not available
+     *       are ignored. Consumed events have no report.
+     *
+     * @param dump Report ID 8 payloads, one after another
+     * @param[out] events Input events
+     * @param[out] reports Input reports sent by the device
+     * @return true On success
+     * @return false If @p dump is malformed or it was recorded
+     *               with a different width of the input bitmap
+     */
+    inline bool fromTrace(
+        const std::vector<uint8_t> &dump,
+        InputStream &events,
+        ReportStream &reports)
+    {
+        events.clear();
+        reports.clear();
+        if ((dump.size() % EVENT_TRACE_REPORT_SIZE) != 0)
+            return false;
+        for (size_t offset = 0; offset < dump.size(); offset += EVENT_TRACE_REPORT_SIZE)
+        {
+            const uint8_t *entry = dump.data() + offset;
+            if (entry[9] != BITMAP_BYTES)
+                return false;
+            if (!(entry[8] & 0x02))
+                continue;
+            DecouplingEvent event;
+            event.rawInputBitmap = NO_INPUTS;
+            event.rawInputChanges = NO_INPUTS;
+            for (uint8_t i = 0; i < BITMAP_BYTES; i++)
+            {
+                setBitmapByte(event.rawInputBitmap, i, entry[36 + i]);
+                setBitmapByte(event.rawInputChanges, i, entry[36 + BITMAP_BYTES + i]);
+            }
+            event.leftAxisValue = entry[10];
+            event.rightAxisValue = entry[11];
+            events.push_back(event);
+            if (entry[8] & 0x04)
+            {
+                CapturedReport report;
+                memcpy(&report.inputsLow, entry + 16, 8);
+                memcpy(&report.inputsHigh, entry + 24, 8);
+                report.POVstate = entry[32];
+                report.leftAxis = entry[33];
+                report.rightAxis = entry[34];
+                report.clutchAxis = entry[35];
+                reports.push_back(report);
+            }
+        }
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    // Replay
+    //--------------------------------------------------------------
+
+    /**
+     * @brief Replay input events through the input hub
+     *
+     * @note Requires the fake HID implementation at hid_capture.cpp.
+     *       A "release all" event is processed first (not captured),
+     *       so the input hub does not depend on the previous replay.
+     *       Working modes are not reset.
+     *
+     * @param name Name of this replay
+     * @param stream Input events
+     * @param[out] reports Captured input reports
+     * @return double Events per second
+     */
+    inline double run(const std::string &name, const InputStream &stream, ReportStream &reports)
+    {
+        DecouplingEvent releaseAll;
+        releaseAll.rawInputBitmap = NO_INPUTS;
+        releaseAll.rawInputChanges = ALL_INPUTS;
+        releaseAll.leftAxisValue = CLUTCH_NONE_VALUE;
+        releaseAll.rightAxisValue = CLUTCH_NONE_VALUE;
+        internals::inputHub::onRawInput(releaseAll);
+        capturedReports.clear();
+        capturedReports.reserve(stream.size());
+        double throughput = benchmark(
+            name,
+            stream.size(),
+            [&stream](uint64_t i)
+            {
+                // Filters modify the event
+                DecouplingEvent event = stream[i];
+                internals::inputHub::onRawInput(event);
+            });
+        reports = capturedReports;
+        return throughput;
+    }
+
+    /**
+     * @brief Compare two streams of input reports
+     *
+     * @param expected Expected reports
+     * @param actual Actual reports
+     * @param maxShown Maximum count of differences to print
+     * @return size_t Count of differences
+     */
+    inline size_t diff(const ReportStream &expected, const ReportStream &actual, size_t maxShown = 10)
+    {
+        size_t differences = 0;
+        if (expected.size() != actual.size())
+        {
+            std::cout << "[replay] Expected " << expected.size()
+                      << " reports, found " << actual.size() << std::endl;
+            differences++;
+        }
+        size_t count = (expected.size() < actual.size()) ? expected.size() : actual.size();
+        for (size_t i = 0; i < count; i++)
+            if (!(expected[i] == actual[i]))
+            {
+                if (differences < maxShown)
+                    std::cout << "[replay] Report " << i << " differs:" << std::hex
+                              << " low " << expected[i].inputsLow << "/" << actual[i].inputsLow
+                              << " high " << expected[i].inputsHigh << "/" << actual[i].inputsHigh
+                              << " POV " << (int)expected[i].POVstate << "/" << (int)actual[i].POVstate
+                              << " left " << (int)expected[i].leftAxis << "/" << (int)actual[i].leftAxis
+                              << " right " << (int)expected[i].rightAxis << "/" << (int)actual[i].rightAxis
+                              << " clutch " << (int)expected[i].clutchAxis << "/" << (int)actual[i].clutchAxis
+                              << std::dec << std::endl;
+                differences++;
+            }
+        return differences;
+    }
+} // namespace replay
@@ -0,0 +1,21 @@
+/**
+ * @file gpio.h
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-19
+ * @brief Fake ESP-IDF's GPIO driver for testing
+ *
+ * @note All pins read LOW. Writes are ignored.
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+#include <cinttypes>
+
+typedef int gpio_num_t;
+
+inline int gpio_set_level(gpio_num_t pin, uint32_t level) { return 0; }
+inline int gpio_get_level(gpio_num_t pin) { return 0; }
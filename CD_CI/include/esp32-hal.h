@@ -0,0 +1,21 @@
+/**
+ * @file esp32-hal.h
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-19
+ * @brief Fake Arduino's ESP32 HAL for testing
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+#include <cinttypes>
+
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 240
+
+typedef unsigned int UBaseType_t;
+
+#define portSET_INTERRUPT_MASK_FROM_ISR() ((UBaseType_t)0)
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(mask) ((void)(mask))
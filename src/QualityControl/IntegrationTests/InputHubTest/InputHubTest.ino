@@ -93,7 +93,8 @@ void internals::hid::reportInput(
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
     _inputsLow = inputsLow;
     _inputsHigh = inputsHigh;
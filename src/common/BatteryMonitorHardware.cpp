@@ -14,16 +14,10 @@
 #include "SimWheel.hpp"
 #include "HAL.hpp"
 
-#if !CD_CI
-#include "driver/i2c.h" // For I2C operation
-#endif
-
 //-------------------------------------------------------------------
 // MAX1704x hardware
 //-------------------------------------------------------------------
 
-#define I2C_WAIT_TICKS pdMS_TO_TICKS(150)
-
 #define MAX1704x_I2C_ADDRESS_SHIFTED 0x6c
 #define MAX1704x_REG_SoC 0x04
 #define MAX1704x_REG_MODE 0x06
@@ -32,41 +26,31 @@
 
 bool MAX1704x::read(uint8_t regAddress, uint16_t &value)
 {
-#if !CD_CI
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, fg_i2c_address | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, regAddress, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, fg_i2c_address | I2C_MASTER_READ, true);
-    i2c_master_read_byte(cmd, ((uint8_t *)&value) + 1, I2C_MASTER_ACK);
-    i2c_master_read_byte(cmd, ((uint8_t *)&value), I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    bool result = (i2c_master_cmd_begin(I2C_NUM_0, cmd, I2C_WAIT_TICKS) == ESP_OK);
-    i2c_cmd_link_delete(cmd);
-    return result;
-#else
+    uint8_t data[2] = {0, 0};
+    I2CTransaction transaction;
+    transaction.address7bits = (fg_i2c_address >> 1);
+    transaction.writeBuffer = &regAddress;
+    transaction.writeSize = 1;
+    transaction.readBuffer = data;
+    transaction.readSize = 2;
+    if (internals::hal::i2c::execute(_bus, I2CClient::BATTERY_MONITOR, &transaction))
+    {
+        // Big endian
+        value = (data[0] << 8) | data[1];
+        return true;
+    }
     return false;
-#endif
 }
 
 bool MAX1704x::write(uint8_t regAddress, uint16_t value)
 {
-#if !CD_CI
-    uint8_t *data = (uint8_t *)&value;
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, fg_i2c_address | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, regAddress, true);
-    i2c_master_write_byte(cmd, data[1], true);
-    i2c_master_write_byte(cmd, data[0], true);
-    i2c_master_stop(cmd);
-    bool result = (i2c_master_cmd_begin(I2C_NUM_0, cmd, I2C_WAIT_TICKS) == ESP_OK);
-    i2c_cmd_link_delete(cmd);
-    return result;
-#else
-    return false;
-#endif
+    // Big endian
+    uint8_t data[3] = {regAddress, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    I2CTransaction transaction;
+    transaction.address7bits = (fg_i2c_address >> 1);
+    transaction.writeBuffer = data;
+    transaction.writeSize = 3;
+    return internals::hal::i2c::execute(_bus, I2CClient::BATTERY_MONITOR, &transaction);
 }
 
 bool MAX1704x::quickStart()
@@ -97,7 +81,8 @@ MAX1704x::MAX1704x(I2CBus bus, uint8_t i2c_address)
     }
     else
         fg_i2c_address = MAX1704x_I2C_ADDRESS_SHIFTED;
-    internals::hal::i2c::require(4, bus);
+    _bus = bus;
+    internals::hal::i2c::require(I2C_FAST_MODE, bus, fg_i2c_address >> 1);
 }
 
 void MAX1704x::getStatus(BatteryStatus &currentStatus)
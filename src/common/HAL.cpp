@@ -19,6 +19,8 @@
 
 #include "HAL.hpp"
 #include <array>
+#include <thread>
+#include <functional> // For std::ref()
 #include "driver/i2c.h"          // For I2C operation
 #include "esp32-hal-log.h"       // For log_e()
 #include "esp_adc/adc_oneshot.h" // For ADC operation
@@ -26,6 +28,7 @@
 #include "driver/gpio.h"         // For gpio_set_level/gpio_get_level()
 #include "esp_intr_alloc.h"      // For gpio_isr_handler_add()
 #include "esp32-hal-cpu.h"       // For getCpuFrequencyMhz()
+#include "freertos/FreeRTOS.h"   // For uxTaskGetStackHighWaterMark()
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
@@ -35,11 +38,25 @@
 
 // I2C
 #define STANDARD_CLOCK_SPEED 100000
+#if defined(CONFIG_IDF_TARGET_ESP32)
+// The original ESP32 is not rated above Fast-mode
+#define MAX_SPEED_MULTIPLIER I2C_FAST_MODE
+#else
+#define MAX_SPEED_MULTIPLIER I2C_FAST_MODE_PLUS
+#endif
 static gpio_num_t sdaPin[] = {(gpio_num_t)SDA, GPIO_NUM_NC};
 static gpio_num_t sclPin[] = {(gpio_num_t)SCL, GPIO_NUM_NC};
 static bool internalPullup[] = {true, true};
 static bool isInitialized[] = {false, false};
-static uint8_t max_speed_x[] = {4, 4};
+static uint8_t max_speed_x[] = {I2C_FAST_MODE, I2C_FAST_MODE};
+static uint8_t current_speed_x[] = {0, 0};
+#define I2C_TIMEOUT_TICKS pdMS_TO_TICKS(30)
+#define I2C_PROBE_TIMEOUT_TICKS pdMS_TO_TICKS(10)
+bool executeI2CTransactions(I2CBus bus, I2CTransaction *transactions, size_t count);
+bool recoverI2CBus(I2CBus bus);
+static I2CBusManager busManager[] = {
+    {static_cast<I2CBus>(0), executeI2CTransactions, recoverI2CBus},
+    {static_cast<I2CBus>(1), executeI2CTransactions, recoverI2CBus}};
 
 // ADC
 static std::array<adc_oneshot_unit_handle_t, SOC_ADC_PERIPH_NUM> adc_handler{nullptr};
@@ -71,7 +88,10 @@ bool doInitializeI2C(
     conf.master.clk_speed = STANDARD_CLOCK_SPEED * clock_multiplier;
     if (i2c_param_config(_bus, &conf) == ESP_OK)
         if (i2c_driver_install(_bus, I2C_MODE_MASTER, 0, 0, 0) == ESP_OK)
+        {
+            current_speed_x[_bus] = clock_multiplier;
             return true;
+        }
     return false;
 }
 
@@ -79,10 +99,39 @@ bool doInitializeI2C(
 
 void checkSpeedMultiplier(uint8_t &max_speed_multiplier)
 {
-    if (max_speed_multiplier < 1)
-        max_speed_multiplier = 1;
-    if (max_speed_multiplier > 4)
-        max_speed_multiplier = 4;
+    if (max_speed_multiplier < I2C_STANDARD_MODE)
+        max_speed_multiplier = I2C_STANDARD_MODE;
+    if (max_speed_multiplier > MAX_SPEED_MULTIPLIER)
+        max_speed_multiplier = MAX_SPEED_MULTIPLIER;
+}
+
+// ----------------------------------------------------------------------------
+
+void setClock(uint8_t speed, i2c_port_t _bus)
+{
+    if (speed == current_speed_x[_bus])
+        return;
+    // The driver is already installed, so just the clock is changed
+    i2c_config_t conf = {};
+    conf.mode = I2C_MODE_MASTER;
+    conf.sda_io_num = sdaPin[_bus];
+    conf.scl_io_num = sclPin[_bus];
+    conf.sda_pullup_en = internalPullup[_bus];
+    conf.scl_pullup_en = internalPullup[_bus];
+    conf.master.clk_speed = STANDARD_CLOCK_SPEED * speed;
+    if (i2c_param_config(_bus, &conf) == ESP_OK)
+        current_speed_x[_bus] = speed;
+}
+
+// ----------------------------------------------------------------------------
+
+void selectClock(uint8_t address7bits, i2c_port_t _bus)
+{
+    // Note: the bus is owned by the caller
+    uint8_t speed = busManager[_bus].getDeviceSpeed(address7bits);
+    if (speed == 0)
+        speed = max_speed_x[_bus];
+    setClock(speed, _bus);
 }
 
 // ----------------------------------------------------------------------------
@@ -100,47 +149,84 @@ void i2cError(
 // I2C: Probe
 //-------------------------------------------------------------------
 
-bool internals::hal::i2c::probe(uint8_t address7bits, I2CBus bus)
+bool doProbe(uint8_t address7bits, i2c_port_t _bus, TickType_t timeout)
 {
-    internals::hal::i2c::abortOnInvalidAddress(address7bits);
-    auto _bus = static_cast<i2c_port_t>(bus);
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, (address7bits << 1) | I2C_MASTER_WRITE, true);
     i2c_master_stop(cmd);
-    bool result = (i2c_master_cmd_begin(_bus, cmd, 500 / portTICK_RATE_MS) == ESP_OK);
+    bool result = (i2c_master_cmd_begin(_bus, cmd, timeout) == ESP_OK);
     i2c_cmd_link_delete(cmd);
     return result;
 }
 
 // ----------------------------------------------------------------------------
 
-void internals::hal::i2c::probe(std::vector<uint8_t> &result, I2CBus bus)
+void doProbeAll(std::vector<uint8_t> &result, i2c_port_t _bus)
 {
-    auto _bus = static_cast<i2c_port_t>(bus);
     result.clear();
+    // Probe at minimum speed, so slow devices are found
     if (isInitialized[_bus])
+        setClock(I2C_STANDARD_MODE, _bus);
+    else if (!doInitializeI2C(sdaPin[_bus], sclPin[_bus], I2C_STANDARD_MODE, _bus, internalPullup[_bus]))
+        i2cError(sdaPin[_bus], sclPin[_bus], I2C_STANDARD_MODE, _bus);
+
+    for (uint8_t address = 0; address < 128; address++)
+        if (!internals::hal::i2c::isReservedAddress(address) &&
+            doProbe(address, _bus, I2C_PROBE_TIMEOUT_TICKS))
+            result.push_back(address);
+
+    if (!isInitialized[_bus])
         // Deinitialize
         ESP_ERROR_CHECK(i2c_driver_delete(_bus));
+}
 
-    // Initialize to minimum speed
-    if (!doInitializeI2C(sdaPin[_bus], sclPin[_bus], 1, _bus, internalPullup[_bus]))
-        i2cError(sdaPin[_bus], sclPin[_bus], 1, _bus);
+// ----------------------------------------------------------------------------
 
-    // Probe
-    for (uint8_t address = 0; address < 128; address++)
+bool internals::hal::i2c::probe(uint8_t address7bits, I2CBus bus, I2CClient client)
+{
+    internals::hal::i2c::abortOnInvalidAddress(address7bits);
+    auto _bus = static_cast<i2c_port_t>(bus);
+    if (isInitialized[_bus])
     {
-        if (internals::hal::i2c::probe(address, bus))
-            result.push_back(address);
+        // An empty write transaction, arbitrated like any other
+        I2CTransaction transaction;
+        transaction.address7bits = address7bits;
+        return busManager[_bus].execute(client, &transaction, 1);
     }
-
-    // Deinitialize
+    // Initialize temporarily at minimum speed
+    if (!doInitializeI2C(sdaPin[_bus], sclPin[_bus], I2C_STANDARD_MODE, _bus, internalPullup[_bus]))
+        i2cError(sdaPin[_bus], sclPin[_bus], I2C_STANDARD_MODE, _bus);
+    bool result = doProbe(address7bits, _bus, I2C_TIMEOUT_TICKS);
     ESP_ERROR_CHECK(i2c_driver_delete(_bus));
+    return result;
+}
 
-    if (isInitialized[_bus])
-        // Reinitialize
-        if (!doInitializeI2C(sdaPin[_bus], sclPin[_bus], max_speed_x[_bus], _bus, internalPullup[_bus]))
-            i2cError(sdaPin[_bus], sclPin[_bus], max_speed_x[_bus], _bus);
+// ----------------------------------------------------------------------------
+
+void internals::hal::i2c::probe(std::vector<uint8_t> &result, I2CBus bus)
+{
+    doProbeAll(result, static_cast<i2c_port_t>(bus));
+}
+
+// ----------------------------------------------------------------------------
+
+void internals::hal::i2c::probe(
+    std::vector<uint8_t> &primary,
+    std::vector<uint8_t> &secondary)
+{
+    secondary.clear();
+#if SOC_I2C_NUM > 1
+    if ((sdaPin[1] != GPIO_NUM_NC) && (sclPin[1] != GPIO_NUM_NC))
+    {
+        // Each bus has its own peripheral, so both are scanned in parallel
+        std::thread secondaryScan(doProbeAll, std::ref(secondary), static_cast<i2c_port_t>(1));
+        doProbeAll(primary, static_cast<i2c_port_t>(0));
+        secondaryScan.join();
+        return;
+    }
+#endif
+    doProbeAll(primary, static_cast<i2c_port_t>(0));
 }
 
 // ----------------------------------------------------------------------------
@@ -168,10 +254,21 @@ void internals::hal::i2c::initialize(
     }
 }
 
-void internals::hal::i2c::require(uint8_t max_speed_multiplier, I2CBus bus)
+void internals::hal::i2c::require(
+    uint8_t max_speed_multiplier,
+    I2CBus bus,
+    uint8_t address7bits)
 {
     auto _bus = static_cast<i2c_port_t>(bus);
     checkSpeedMultiplier(max_speed_multiplier);
+    if (address7bits < 128)
+    {
+        // The clock is switched for this device only
+        busManager[_bus].setDeviceSpeed(address7bits, max_speed_multiplier);
+        if (isInitialized[_bus])
+            return;
+        max_speed_multiplier = max_speed_x[_bus];
+    }
     if (isInitialized[_bus])
     {
         // check clock compatibility
@@ -245,6 +342,115 @@ uint8_t internals::hal::i2c::findFullAddress(
         return fullAddress;
 }
 
+// ----------------------------------------------------------------------------
+// Transactions
+// ----------------------------------------------------------------------------
+
+bool executeI2CTransactions(I2CBus bus, I2CTransaction *transactions, size_t count)
+{
+    // All transactions go to the same device,
+    // so they are joined by repeated start conditions
+    selectClock(transactions[0].address7bits, AS_PORT(bus));
+    uint8_t address8bits = (transactions[0].address7bits << 1);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    for (size_t i = 0; i < count; i++)
+    {
+        I2CTransaction &transaction = transactions[i];
+        if ((transaction.writeSize > 0) || (transaction.readSize == 0))
+        {
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, address8bits | I2C_MASTER_WRITE, true);
+            if (transaction.writeSize > 0)
+                i2c_master_write(cmd, transaction.writeBuffer, transaction.writeSize, true);
+        }
+        if (transaction.readSize > 0)
+        {
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, address8bits | I2C_MASTER_READ, true);
+            i2c_master_read(cmd, transaction.readBuffer, transaction.readSize, I2C_MASTER_LAST_NACK);
+        }
+    }
+    i2c_master_stop(cmd);
+    bool result = (i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS) == ESP_OK);
+    i2c_cmd_link_delete(cmd);
+    return result;
+}
+
+bool recoverI2CBus(I2CBus bus)
+{
+    auto _bus = AS_PORT(bus);
+    if (!isInitialized[_bus])
+        return true;
+    gpio_num_t sda = sdaPin[_bus];
+    gpio_num_t scl = sclPin[_bus];
+
+    // Take control of the bus pins
+    ESP_ERROR_CHECK(i2c_driver_delete(_bus));
+    gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(sda, 1);
+    gpio_set_level(scl, 1);
+    active_wait_ns(5000);
+
+    // Clock SCL until the device holding SDA low releases it
+    for (int pulse = 0; (pulse < 9) && !gpio_get_level(sda); pulse++)
+    {
+        gpio_set_level(scl, 0);
+        active_wait_ns(5000);
+        gpio_set_level(scl, 1);
+        active_wait_ns(5000);
+    }
+
+    // STOP condition: SDA rises while SCL is high
+    gpio_set_level(scl, 0);
+    active_wait_ns(5000);
+    gpio_set_level(sda, 0);
+    active_wait_ns(5000);
+    gpio_set_level(scl, 1);
+    active_wait_ns(5000);
+    gpio_set_level(sda, 1);
+    active_wait_ns(5000);
+    bool idle = gpio_get_level(sda) && gpio_get_level(scl);
+
+    // Give the pins back to the driver
+    isInitialized[_bus] = doInitializeI2C(sda, scl, max_speed_x[_bus], _bus, internalPullup[_bus]);
+    return idle && isInitialized[_bus];
+}
+
+bool internals::hal::i2c::recover(I2CBus bus, I2CClient client)
+{
+    return busManager[static_cast<int>(bus)].recover(client);
+}
+
+bool internals::hal::i2c::execute(
+    I2CBus bus,
+    I2CClient client,
+    I2CTransaction *transactions,
+    size_t count)
+{
+    return busManager[static_cast<int>(bus)].execute(client, transactions, count);
+}
+
+bool internals::hal::i2c::submit(I2CBus bus, I2CRequest &request)
+{
+    return busManager[static_cast<int>(bus)].submit(request);
+}
+
+I2CClientStatistics internals::hal::i2c::getStatistics(I2CBus bus, I2CClient client)
+{
+    return busManager[static_cast<int>(bus)].getStatistics(client);
+}
+
+void internals::hal::i2c::getDeviceStatistics(
+    std::vector<I2CDeviceStatistics> &result,
+    I2CBus bus)
+{
+    busManager[static_cast<int>(bus)].getDeviceStatistics(result);
+    for (I2CDeviceStatistics &device : result)
+        if (device.speedMultiplier == 0)
+            device.speedMultiplier = max_speed_x[static_cast<int>(bus)];
+}
+
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 // GPIO
@@ -383,3 +589,14 @@ void internals::hal::gpio::enableISR(InputGPIO pin, ISRHandler handler, void *pa
     ESP_ERROR_CHECK(gpio_isr_handler_add(AS_GPIO(pin), handler, param));
     ESP_ERROR_CHECK(gpio_intr_enable(AS_GPIO(pin)));
 }
+
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+// Task monitoring
+//-------------------------------------------------------------------
+//-------------------------------------------------------------------
+
+uint32_t internals::hal::task::getStackHighWaterMark(void *handle)
+{
+    return uxTaskGetStackHighWaterMark(static_cast<TaskHandle_t>(handle));
+}
@@ -15,7 +15,6 @@
 
 #include "InputHardware.hpp"
 #include "HAL.hpp"
-#include "driver/i2c.h"  // For I2C operation
 #include "esp32-hal.h"   // For portSET_INTERRUPT_MASK_FROM_ISR
 #include "driver/gpio.h" // For gpio_set_level/gpio_get_level()
 
@@ -23,10 +22,7 @@
 // Globals
 //-------------------------------------------------------------------
 
-// I2C
-#define I2C_TIMEOUT_TICKS pdMS_TO_TICKS(30)
-
-// MCP23017 registers
+// MCP23017 registers (BANK=0)
 #define MCP23017_IO_CONFIGURATION 0x0A
 #define MCP23017_IO_DIRECTION 0x00
 #define MCP23017_PULL_UP_RESISTORS 0x0C
@@ -35,6 +31,15 @@
 #define MCP23017_INTERRUPT_ON_CHANGE 0x04
 #define MCP23017_INTERRUPT_CONTROL 0x08
 #define MCP23017_INTERRUPT_DEFAULT_VALUE 0x06
+// Count of configuration registers, from IODIRA to GPPUB
+#define MCP23017_CONFIGURATION_SIZE 14
+// IOCON register:
+// - Registers are in the same bank
+// - Interrupt pins mirrored
+// - Sequential operation
+// - Active driver output for interrupt pins
+// - Interrupt pins active low
+#define MCP23017_IO_CONFIGURATION_VALUE 0b01000000
 
 // Active wait
 #define signal_change_delay(n) active_wait_ns(n)
@@ -47,18 +52,18 @@ DigitalButton::DigitalButton(InputGPIO pinNumber, InputNumber buttonNumber) : Di
 {
     internals::hal::gpio::forInput(pinNumber, false, true);
     this->pinNumber = pinNumber;
-    this->bitmap = (uint64_t)buttonNumber;
+    this->bitmap = (InputBitmap)buttonNumber;
     this->mask = ~(this->bitmap);
 }
 
 //-------------------------------------------------------------------
 
-uint64_t DigitalButton::read(uint64_t lastState)
+InputBitmap DigitalButton::read(InputBitmap lastState)
 {
     int reading = GPIO_GET_LEVEL(pinNumber);
     if (reading)
         // Pulled-up input
-        return 0ULL;
+        return NO_INPUTS;
     else
         return bitmap;
 }
@@ -186,8 +191,8 @@ RotaryEncoderInput::RotaryEncoderInput(
     // Initialize properties
     this->clkPin = clkPin;
     this->dtPin = dtPin;
-    this->cwButtonBitmap = (uint64_t)cwButtonNumber;
-    this->ccwButtonBitmap = (uint64_t)ccwButtonNumber;
+    this->cwButtonBitmap = (InputBitmap)cwButtonNumber;
+    this->ccwButtonBitmap = (InputBitmap)ccwButtonNumber;
     mask = ~((this->cwButtonBitmap) | (this->ccwButtonBitmap));
     sequence = 0;
     pressEventNotified = false;
@@ -226,7 +231,7 @@ RotaryEncoderInput::RotaryEncoderInput(
 
 // ----------------------------------------------------------------------------
 
-uint64_t RotaryEncoderInput::read(uint64_t lastState)
+InputBitmap RotaryEncoderInput::read(InputBitmap lastState)
 {
     if (currentPulseWidth > 0)
     {
@@ -238,7 +243,7 @@ uint64_t RotaryEncoderInput::read(uint64_t lastState)
                 pressEventNotified = false;
                 currentPulseWidth = pulseMultiplier;
             }
-            return 0ULL;
+            return NO_INPUTS;
         }
         // "pulse" in progress
         return lastState & ~mask;
@@ -258,7 +263,7 @@ uint64_t RotaryEncoderInput::read(uint64_t lastState)
         }
         else
             // No input event
-            return 0ULL;
+            return NO_INPUTS;
     }
 }
 
@@ -281,16 +286,16 @@ ButtonMatrixInput::ButtonMatrixInput(
         for (auto col : row.second)
         {
             internals::hal::gpio::forInput(col.first, !negativeLogic, negativeLogic);
-            addToMask((uint64_t)col.second);
+            addToMask((InputBitmap)col.second);
         }
     }
 }
 
 //-------------------------------------------------------------------
 
-uint64_t ButtonMatrixInput::read(uint64_t lastState)
+InputBitmap ButtonMatrixInput::read(InputBitmap lastState)
 {
-    uint64_t state = 0ULL;
+    InputBitmap state = NO_INPUTS;
     for (auto row : matrix)
     {
         GPIO_SET_LEVEL(row.first, !negativeLogic);
@@ -300,7 +305,7 @@ uint64_t ButtonMatrixInput::read(uint64_t lastState)
         {
             int level = GPIO_GET_LEVEL((int)col.first);
             if (level ^ negativeLogic)
-                state |= (uint64_t)col.second;
+                state |= (InputBitmap)col.second;
         }
         GPIO_SET_LEVEL(row.first, negativeLogic);
         // Wait for the signal to change from HIGH to LOW.
@@ -321,10 +326,10 @@ uint64_t ButtonMatrixInput::read(uint64_t lastState)
  * @tparam PinTags Pin tags
  * @param selectorCount Count of selector pins
  * @param chips Group of analog multiplexer chips
- * @return uint64_t* A bitmap array
+ * @return InputBitmap* A bitmap array
  */
 template <typename PinTags>
-uint64_t *createBitmap(
+InputBitmap *createBitmap(
     uint8_t selectorCount,
     const AnalogMultiplexerGroup<PinTags> &chips)
 {
@@ -332,8 +337,7 @@ uint64_t *createBitmap(
 
     // Create bidimensional array for input bitmaps
     size_t arrayLength = (inputCount << selectorCount);
-    uint64_t *bitmap = new uint64_t[arrayLength];
-    std::memset(bitmap, 0, arrayLength * sizeof(uint64_t));
+    InputBitmap *bitmap = new InputBitmap[arrayLength]();
 
     // Populate the array of input bitmaps
     for (size_t chipIndex = 0; chipIndex < inputCount; chipIndex++)
@@ -344,7 +348,7 @@ uint64_t *createBitmap(
             uint8_t chipPinIndex = static_cast<uint8_t>(map_pair.first); // first is PinTags
             // NOTE: switchIndex = (chipIndex * 2^selectors.size) + chipPinIndex
             uint8_t switchIndex = (chipIndex << selectorCount) + chipPinIndex;
-            bitmap[switchIndex] = (uint64_t)(map_pair.second); // second is InputNumber
+            bitmap[switchIndex] = (InputBitmap)(map_pair.second); // second is InputNumber
         }
     }
     return bitmap;
@@ -435,9 +439,9 @@ AnalogMultiplexerInput::AnalogMultiplexerInput(
 
 //-------------------------------------------------------------------
 
-uint64_t AnalogMultiplexerInput::read(uint64_t lastState)
+InputBitmap AnalogMultiplexerInput::read(InputBitmap lastState)
 {
-    uint64_t state = 0ULL;
+    InputBitmap state = NO_INPUTS;
     for (uint8_t switchIndex = 0; switchIndex < switchCount; switchIndex++)
     {
         // Choose selector pins
@@ -476,9 +480,68 @@ I2CInput::I2CInput(
     internals::hal::i2c::abortOnInvalidAddress(address7Bits);
     this->deviceAddress = (address7Bits << 1);
     this->bus = bus;
-    internals::hal::i2c::require(max_speed_mult, bus);
+    internals::hal::i2c::require(max_speed_mult, bus, address7Bits);
     if (!internals::hal::i2c::probe(address7Bits, bus))
         throw i2c_device_not_found(address7Bits, (int)bus);
+    gpioRead.address7bits = address7Bits;
+    gpioRead.readBuffer = gpioData;
+    gpioRequest.client = I2CClient::INPUTS;
+    gpioRequest.transactions = &gpioRead;
+    gpioRequest.count = 1;
+}
+
+//-------------------------------------------------------------------
+
+bool I2CInput::readGPIO(uint8_t *data, bool pipelined)
+{
+    bool result;
+    if (pipelined && gpioRequestStarted)
+    {
+        // Collect the result of the previous call
+        if (gpioRequest.pending)
+            return false;
+        result = gpioRequest.result;
+    }
+    else
+        result = internals::hal::i2c::execute(bus, I2CClient::INPUTS, &gpioRead);
+    if (result)
+        for (size_t i = 0; i < gpioRead.readSize; i++)
+            data[i] = gpioData[i];
+    // Start the next read, unless the device is failing
+    gpioRequestStarted =
+        pipelined && result &&
+        internals::hal::i2c::submit(bus, gpioRequest);
+    return result;
+}
+
+//-------------------------------------------------------------------
+
+bool I2CInput::scanGPIO(uint8_t *data)
+{
+    if (gpioRequestStarted && gpioRequest.pending)
+        // Not a failure
+        return false;
+    return health.attempt(
+        [this, data]()
+        { return readGPIO(data, pipelined); },
+        [this]()
+        { return recover(); });
+}
+
+//-------------------------------------------------------------------
+
+bool I2CInput::recover()
+{
+    uint8_t address7bits = (deviceAddress >> 1);
+    if (!internals::hal::i2c::probe(address7bits, bus))
+    {
+        // Something may be holding the bus
+        if (!internals::hal::i2c::recover(bus, I2CClient::INPUTS) ||
+            !internals::hal::i2c::probe(address7bits, bus))
+            return false;
+    }
+    // The device may have lost its configuration
+    return configure();
 }
 
 //-------------------------------------------------------------------
@@ -488,47 +551,43 @@ PCF8574ButtonsInput::PCF8574ButtonsInput(
     const PCF8574Expander &inputNumbers,
     uint8_t address7Bits,
     I2CBus bus)
-    : I2CInput(address7Bits, bus, 1)
+    : I2CInput(address7Bits, bus, I2C_STANDARD_MODE)
 {
     this->inputNumbers = inputNumbers;
 
     // Compute mask
     for (auto spec : inputNumbers)
-        addToMask((uint64_t)spec.second);
+        addToMask((InputBitmap)spec.second);
 
     // The PCF8574 does not have internal registers
+    gpioRead.readSize = 1;
+
     // Read GPIO registers in order to clear all interrupts
     uint64_t dummy;
-    getGPIOstate(dummy);
+    getGPIOstate(dummy, false);
 }
 
 //-------------------------------------------------------------------
 
-bool PCF8574ButtonsInput::getGPIOstate(uint64_t &state)
+bool PCF8574ButtonsInput::getGPIOstate(uint64_t &state, bool scan)
 {
-    state = 0ULL;
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress | I2C_MASTER_READ, true);
-    i2c_master_read_byte(cmd, (unsigned char *)&state, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    bool result = (i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS) == ESP_OK);
-    i2c_cmd_link_delete(cmd);
-    state = ~state; // convert to positive logic
+    uint8_t data = 0;
+    bool result = scan ? scanGPIO(&data) : readGPIO(&data, false);
+    state = ~(uint64_t)data; // convert to positive logic
     return result;
 }
 //-------------------------------------------------------------------
 
-uint64_t PCF8574ButtonsInput::read(uint64_t lastState)
+InputBitmap PCF8574ButtonsInput::read(InputBitmap lastState)
 {
     uint64_t GPIOstate;
-    if (getGPIOstate(GPIOstate))
+    if (getGPIOstate(GPIOstate, true))
     {
-        uint64_t result = 0ULL;
+        InputBitmap result = NO_INPUTS;
         for (auto spec : inputNumbers)
         {
             if (GPIOstate & (1ULL << (int)spec.first))
-                result |= (uint64_t)spec.second;
+                result |= (InputBitmap)spec.second;
         }
         return result;
     }
@@ -541,139 +600,101 @@ uint64_t PCF8574ButtonsInput::read(uint64_t lastState)
 MCP23017ButtonsInput::MCP23017ButtonsInput(
     const MCP23017Expander &inputNumbers,
     uint8_t address7Bits,
-    I2CBus bus) : I2CInput(address7Bits, bus, 1)
+    I2CBus bus) : I2CInput(address7Bits, bus, MCP23017_MAX_SPEED)
 {
     this->inputNumbers = inputNumbers;
 
     // Compute mask
     for (auto spec : inputNumbers)
-        addToMask((uint64_t)spec.second);
+        addToMask((InputBitmap)spec.second);
+
+    if (!configure())
+        throw i2c_device_not_configured(address7Bits, (int)bus);
 
-    configure();
+    // Both GPIO registers are read in sequence
+    static const uint8_t gpioRegister = MCP23017_GPIO;
+    gpioRead.writeBuffer = &gpioRegister;
+    gpioRead.writeSize = 1;
+    gpioRead.readSize = 2;
 
     // Read GPIO registers in order to clear all interrupts
     uint64_t dummy;
-    getGPIOstate(dummy);
-}
-
-//-------------------------------------------------------------------
-
-void MCP23017ButtonsInput::configure()
-{
-    i2c_cmd_handle_t cmd;
-
-    // Configure IOCON register:
-    // - Registers are in the same bank
-    // - Interrupt pins mirrored
-    // - Sequential operation
-    // - Active driver output for interrupt pins
-    // - Interrupt pins active low
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_IO_CONFIGURATION, true);
-    i2c_master_write_byte(cmd, 0b01000000, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Set mode to "input"
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_IO_DIRECTION, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Enable pull-up resistors
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_PULL_UP_RESISTORS, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Automatically convert negative logic to positive logic
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_POLARITY, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Enable interrupts at all GPIO pins
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_INTERRUPT_ON_CHANGE, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Trigger interrupts by comparison with DEFVAL registers
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_INTERRUPT_CONTROL, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_write_byte(cmd, 0xFF, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-
-    // Set DEFVAL registers for interrupts
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_INTERRUPT_DEFAULT_VALUE, true);
-    i2c_master_write_byte(cmd, 0, true); // Note: negative logic
-    i2c_master_write_byte(cmd, 0, true);
-    i2c_master_stop(cmd);
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS));
-    i2c_cmd_link_delete(cmd);
-}
-
-//-------------------------------------------------------------------
-
-bool MCP23017ButtonsInput::getGPIOstate(uint64_t &state)
-{
-    state = 0ULL;
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress, true);
-    i2c_master_write_byte(cmd, MCP23017_GPIO, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, deviceAddress | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, (uint8_t *)&state, 2, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    bool result = (i2c_master_cmd_begin(AS_PORT(bus), cmd, I2C_TIMEOUT_TICKS) == ESP_OK);
-    i2c_cmd_link_delete(cmd);
+    getGPIOstate(dummy, false);
+}
+
+//-------------------------------------------------------------------
+
+bool MCP23017ButtonsInput::configure()
+{
+    // Sets BANK=0 and sequential operation first
+    static const uint8_t ioConfiguration[] = {
+        MCP23017_IO_CONFIGURATION,
+        MCP23017_IO_CONFIGURATION_VALUE};
+    // All configuration registers in address order,
+    // written at once thanks to sequential operation
+    static const uint8_t configuration[MCP23017_CONFIGURATION_SIZE + 1] = {
+        MCP23017_IO_DIRECTION,
+        // IODIRA/B: set mode to "input"
+        0xFF, 0xFF,
+        // IPOLA/B: automatically convert negative logic to positive logic
+        0xFF, 0xFF,
+        // GPINTENA/B: enable interrupts at all GPIO pins
+        0xFF, 0xFF,
+        // DEFVALA/B: default values for interrupts (note: negative logic)
+        0, 0,
+        // INTCONA/B: trigger interrupts by comparison with DEFVAL registers
+        0xFF, 0xFF,
+        // IOCON (twice): same as above
+        MCP23017_IO_CONFIGURATION_VALUE, MCP23017_IO_CONFIGURATION_VALUE,
+        // GPPUA/B: enable pull-up resistors
+        0xFF, 0xFF};
+    static const uint8_t firstRegister = MCP23017_IO_DIRECTION;
+    uint8_t readBack[MCP23017_CONFIGURATION_SIZE];
+
+    // Configure, then read back in a single bus operation
+    I2CTransaction transactions[3];
+    for (size_t i = 0; i < 3; i++)
+        transactions[i].address7bits = (deviceAddress >> 1);
+    transactions[0].writeBuffer = ioConfiguration;
+    transactions[0].writeSize = sizeof(ioConfiguration);
+    transactions[1].writeBuffer = configuration;
+    transactions[1].writeSize = sizeof(configuration);
+    transactions[2].writeBuffer = &firstRegister;
+    transactions[2].writeSize = 1;
+    transactions[2].readBuffer = readBack;
+    transactions[2].readSize = sizeof(readBack);
+    if (!internals::hal::i2c::execute(bus, I2CClient::INPUTS, transactions, 3))
+        return false;
+
+    // Verify
+    for (size_t i = 0; i < MCP23017_CONFIGURATION_SIZE; i++)
+        if (readBack[i] != configuration[i + 1])
+            return false;
+    return true;
+}
+
+//-------------------------------------------------------------------
+
+bool MCP23017ButtonsInput::getGPIOstate(uint64_t &state, bool scan)
+{
+    uint8_t data[2] = {0, 0};
+    bool result = scan ? scanGPIO(data) : readGPIO(data, false);
+    state = data[0] | (data[1] << 8);
     return result;
 }
 
 //-------------------------------------------------------------------
 
-uint64_t MCP23017ButtonsInput::read(uint64_t lastState)
+InputBitmap MCP23017ButtonsInput::read(InputBitmap lastState)
 {
     uint64_t GPIOstate;
-    if (getGPIOstate(GPIOstate))
+    if (getGPIOstate(GPIOstate, true))
     {
-        uint64_t result = 0ULL;
+        InputBitmap result = NO_INPUTS;
         for (auto spec : inputNumbers)
         {
             if (GPIOstate & (1ULL << (int)spec.first))
-                result |= (uint64_t)spec.second;
+                result |= (InputBitmap)spec.second;
         }
         return result;
     }
@@ -691,9 +712,9 @@ uint64_t MCP23017ButtonsInput::read(uint64_t lastState)
  * @param[in] chain Chain of shift registers
  * @param[in] SER_inputNumber Input number assigned to SER in the last chip
  * @param[out] switchCount Count of switches (or array length)
- * @return uint64_t* Bitmap
+ * @return InputBitmap* Bitmap
  */
-uint64_t *createBitmap(
+InputBitmap *createBitmap(
     const ShiftRegisterChain &chain,
     InputNumber SER_inputNumber,
     size_t &switchCount)
@@ -704,8 +725,7 @@ uint64_t *createBitmap(
         switchCount++;
 
     // Reserve memory for all input bitmaps
-    uint64_t *bitmap = new uint64_t[switchCount];
-    std::memset(bitmap, 0, switchCount * sizeof(uint64_t));
+    InputBitmap *bitmap = new InputBitmap[switchCount]();
 
     // Populate input bitmap array
     for (size_t chipIndex = 0; chipIndex < chain.size(); chipIndex++)
@@ -715,11 +735,11 @@ uint64_t *createBitmap(
         {
             uint8_t chipPinIndex = static_cast<uint8_t>(map_pair.first); // first is SR8Pin
             size_t arrayIndex = (chipIndex * 8) + static_cast<uint8_t>(chipPinIndex);
-            bitmap[arrayIndex] = (uint64_t)(map_pair.second); // second is InputNumber
+            bitmap[arrayIndex] = (InputBitmap)(map_pair.second); // second is InputNumber
         }
     }
     if (SER_inputNumber != UNSPECIFIED::VALUE)
-        bitmap[switchCount - 1] = (uint64_t)SER_inputNumber;
+        bitmap[switchCount - 1] = (InputBitmap)SER_inputNumber;
     return bitmap;
 }
 
@@ -753,9 +773,9 @@ ShiftRegistersInput::ShiftRegistersInput(
 
 //-------------------------------------------------------------------
 
-uint64_t ShiftRegistersInput::read(uint64_t lastState)
+InputBitmap ShiftRegistersInput::read(InputBitmap lastState)
 {
-    uint64_t state = 0ULL;
+    InputBitmap state = NO_INPUTS;
 
     // Parallel load
     GPIO_SET_LEVEL(loadPin, loadHighOrLow);
@@ -795,14 +815,14 @@ RotaryCodedSwitchInput::RotaryCodedSwitchInput(
 
     // Initialize input bitmap
     uint8_t positionCount = (1 << pins.size());
-    bitmap = (uint64_t *)malloc(sizeof(uint64_t) * positionCount);
+    bitmap = (InputBitmap *)malloc(sizeof(InputBitmap) * positionCount);
     for (int i = 0; i < positionCount; i++)
-        bitmap[i] = 0ULL;
+        bitmap[i] = NO_INPUTS;
 
     // Copy the input specification to the input bitmap
     for (auto pair : spec)
     {
-        uint64_t inputBmp = (1ULL << pair.second);
+        InputBitmap inputBmp = (InputBitmap)pair.second;
         addToMask(inputBmp);
         uint8_t index;
         if (complementaryCode)
@@ -823,7 +843,7 @@ RotaryCodedSwitchInput::~RotaryCodedSwitchInput()
 
 //-------------------------------------------------------------------
 
-uint64_t RotaryCodedSwitchInput::read(uint64_t lastState)
+InputBitmap RotaryCodedSwitchInput::read(InputBitmap lastState)
 {
     uint8_t switchPosition = 0;
     for (uint8_t pinIndex = 0; pinIndex < inputPins.size(); pinIndex++)
@@ -197,6 +197,7 @@ void batteryMonitorStart()
             tskIDLE_PRIORITY + 1, &batteryMonitorDaemon);
         if (!batteryMonitorDaemon)
             throw std::runtime_error("Unable to start the battery monitor daemon");
+        COUNT_TASK(FirmwareTask::BATTERY_MONITOR, batteryMonitorDaemon);
 #else
         std::jthread daemon(batteryMonitorDaemonLoop, nullptr);
         daemon.detach();
@@ -48,8 +48,10 @@ void firmware::run()
     if (!FirmwareService::call::isRunning())
     {
         internals::storage::getReady();
-        internals::hid::common::getReady();
+        // Note: the input map must start before HID,
+        // since the input report may depend on it
         internals::inputMap::getReady();
+        internals::hid::common::getReady();
         internals::inputHub::getReady();
         internals::inputs::getReady();
         internals::batteryCalibration::getReady();
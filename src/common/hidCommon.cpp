@@ -19,30 +19,130 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include "HID_definitions.hpp"
+#include "Checksum.hpp"
+#include "HAL.hpp"
+#include "SettingsImage.hpp"
 
 #if !CD_CI
 #include "esp_mac.h"
+#include "esp_system.h"       // For esp_get_free_heap_size()
+#include "freertos/FreeRTOS.h" // For the HID worker task
 #endif
 
 #include <string>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
 // #include <iostream> // For testing
 
 //-------------------------------------------------------------------
 // Globals
 //-------------------------------------------------------------------
 
-uint8_t selectedInput = 0xFF;
+// Data selected by the host computer for the next read.
+// Written by the transport layer at once (see postSetFeature()),
+// so reads never wait for the HID worker task.
+std::atomic<uint8_t> selectedInput = 0xFF;
+std::atomic<uint8_t> selectedProfile = 0;
+std::atomic<uint32_t> selectedTrace = 0;
 uint8_t selected_ui = 0xFF;
+std::atomic<uint8_t> selectedMapPage = 0;
+std::atomic<uint8_t> selectedImagePage = 0;
+
+//-------------------------------------------------------------------
+
+static_assert(BUTTONS_MAP_PAGE_COUNT <= 8, "Too many pages in the bulk input map");
+
+// Bulk input map being written by the host computer
+uint8_t stagedMap[2][INPUT_BITMAP_WIDTH];
+// One bit per page received
+uint8_t stagedMapPages = 0;
+
+// Snapshot of the settings image being read by the host computer
+uint8_t exportedImage[SETTINGS_IMAGE_MAX_SIZE];
+uint16_t exportedImageSize = 0;
+std::mutex exportedImageMutex;
+
+// Settings image being written by the host computer
+uint8_t stagedImage[SETTINGS_IMAGE_MAX_SIZE];
+uint16_t stagedImageSize = 0;
+// Count of pages written so far
+uint8_t stagedImagePages = 0;
+
+#define SETTINGS_IMAGE_MAX_PAGES \
+    ((SETTINGS_IMAGE_MAX_SIZE + SETTINGS_IMAGE_PAGE_SIZE - 1) / SETTINGS_IMAGE_PAGE_SIZE)
+
+// Telemetry groups in delta reports (tag = (group + 1) << 4 | byte offset)
+#define TELEMETRY_GROUP_POWERTRAIN 0
+#define TELEMETRY_GROUP_ECU 1
+#define TELEMETRY_GROUP_RACE_CONTROL 2
+#define TELEMETRY_GROUP_GAUGES 3
+#define TELEMETRY_GROUP_COUNT 4
+
+// Last known content of each fixed-layout telemetry report
+const uint8_t telemetryReportSize[TELEMETRY_GROUP_COUNT] = {
+    POWERTRAIN_REPORT_SIZE,
+    ECU_REPORT_SIZE,
+    RACE_CONTROL_REPORT_SIZE,
+    GAUGES_REPORT_SIZE};
+uint8_t telemetryShadow[TELEMETRY_GROUP_COUNT][16] = {{' '}};
+static_assert(
+    HID_MAX_SIZE(
+        HID_MAX_SIZE(POWERTRAIN_REPORT_SIZE, ECU_REPORT_SIZE),
+        HID_MAX_SIZE(RACE_CONTROL_REPORT_SIZE, GAUGES_REPORT_SIZE)) <= 16,
+    "Telemetry report too large for delta tags");
+uint8_t lastTelemetrySequence = 0;
+bool telemetrySequenceIsValid = false;
+
+//-------------------------------------------------------------------
+
+#if !CD_CI
+// Output and feature reports waiting for the HID worker task
+typedef struct
+{
+    uint8_t reportID;
+    bool isFeature;
+    uint16_t len;
+    uint8_t data[HID_MAX_REPORT_SIZE];
+} PostedReport;
+
+#define HID_WORKER_FEATURE_QUEUE_LENGTH 8
+#define HID_WORKER_OUTPUT_QUEUE_LENGTH 8
+#define HID_WORKER_STACK_SIZE 4 * 1024
+
+// Feature reports have their own queue, so output reports never starve them
+static QueueHandle_t postedFeatures = nullptr;
+static QueueHandle_t postedOutputs = nullptr;
+static TaskHandle_t hidWorkerTask = nullptr;
+#endif
 
 //-------------------------------------------------------------------
 
 uint16_t _factoryVID = BLE_VENDOR_ID;
 uint16_t _factoryPID = BLE_PRODUCT_ID;
-#define MAX_INPUT_NUMBER 63
+
+//-------------------------------------------------------------------
+
+// Fields in the input report and the matching HID descriptor
+HidInputLayout inputLayout;
+HidDescriptor hidDescriptor = buildHidDescriptor(HidInputLayout{});
+
+// Last input report sent to the host computer (without report ID).
+// Written by the input hub, the transport stacks and the HID worker.
+static std::mutex lastInputReportMutex;
+uint8_t lastInputReport[GAMEPAD_REPORT_SIZE];
+bool lastInputReportIsValid = false;
+std::atomic<uint32_t> suppressedInputReportCount = 0;
+
+//-------------------------------------------------------------------
 
 std::string _deviceName = "ESP32SimWheel";
 std::string _deviceManufacturer = "Mamandurrio";
 bool _autoPowerOff = true;
+USBReportRate _usbReportRate = USBReportRate::HZ_1000;
 
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
@@ -55,7 +155,8 @@ void hid::configure(
     std::string deviceManufacturer,
     bool enableAutoPowerOff,
     uint16_t vendorID,
-    uint16_t productID)
+    uint16_t productID,
+    USBReportRate reportRate)
 {
     if (vendorID == 0)
         vendorID = BLE_VENDOR_ID;
@@ -67,6 +168,7 @@ void hid::configure(
     _autoPowerOff = enableAutoPowerOff;
     _factoryVID = vendorID;
     _factoryPID = productID;
+    _usbReportRate = reportRate;
 }
 
 //-------------------------------------------------------------------
@@ -101,12 +203,238 @@ private:
     inline static uint16_t _customPID = 0;
 };
 
+//-------------------------------------------------------------------
+// Input report layout
+//-------------------------------------------------------------------
+
+#if HID_COMPACT_INPUT_REPORT
+HidInputLayout compactInputLayout()
+{
+    bool analogClutch = DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_ANALOG);
+    bool digitalClutch = DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_BUTTON);
+    // Clutch paddles may work as ALT buttons
+    bool alt = DeviceCapabilities::hasFlag(DeviceCapability::ALT) || analogClutch || digitalClutch;
+
+    // Highest user-defined input number in the factory map.
+    // Note: the user-defined map is not taken into account,
+    // so the report descriptor does not change from boot to boot
+    // (Bluetooth hosts cache it).
+    uint8_t highest = 0;
+    for (uint8_t n = 0; n < INPUT_BITMAP_WIDTH; n++)
+        if (InputNumber::booked(n))
+        {
+            uint8_t user, userAlt;
+            internals::inputMap::getFactoryMap(n, user, userAlt);
+            if ((user < BUTTON_COUNT) && (user > highest))
+                highest = user;
+            if (alt && (userAlt < BUTTON_COUNT) && (userAlt > highest))
+                highest = userAlt;
+        }
+    return HidInputLayout::fit(
+        highest,
+        analogClutch || digitalClutch,
+        analogClutch,
+        DeviceCapabilities::hasFlag(DeviceCapability::DPAD));
+}
+#endif
+
+void internals::hid::common::setInputLayout(const HidInputLayout &layout)
+{
+    inputLayout = layout;
+    hidDescriptor = buildHidDescriptor(layout);
+    internals::hid::common::forgetLastInputReport();
+}
+
+uint8_t internals::hid::common::getInputReportSize()
+{
+    return inputLayout.reportSize();
+}
+
+uint16_t internals::hid::common::getUSBReportRate()
+{
+    return static_cast<uint16_t>(_usbReportRate);
+}
+
+const uint8_t *internals::hid::common::getDescriptor(uint16_t &size)
+{
+    size = hidDescriptor.size;
+    return hidDescriptor.data;
+}
+
+/**
+ * @brief Write the fields of the input report
+ *
+ * @return uint8_t Size of the report
+ */
+static uint8_t packInputReport(
+    uint8_t *report,
+    uint64_t inputsLow,
+    uint64_t inputsHigh,
+    uint8_t POVstate,
+    uint8_t leftAxis,
+    uint8_t rightAxis,
+    uint8_t clutchAxis)
+{
+    // Note: little-endian
+    uint8_t buttonBytes = inputLayout.buttonCount / 8;
+    uint8_t index = (buttonBytes > 8) ? 8 : buttonBytes;
+    memcpy(report, &inputsLow, index);
+    if (buttonBytes > 8)
+    {
+        memcpy(report + 8, &inputsHigh, buttonBytes - 8);
+        index = buttonBytes;
+    }
+    if (inputLayout.clutchAxis)
+        report[index++] = clutchAxis;
+    if (inputLayout.analogAxes)
+    {
+        report[index++] = leftAxis;
+        report[index++] = rightAxis;
+    }
+    report[index++] = (inputLayout.hatSwitch) ? POVstate : 0;
+    return index;
+}
+
+//-------------------------------------------------------------------
+// Report worker
+//-------------------------------------------------------------------
+
+static void selectFeature(uint8_t report_id, const uint8_t *buffer, uint16_t len);
+static void applyFeature(uint8_t report_id, const uint8_t *buffer, uint16_t len);
+
+#if !CD_CI
+/**
+ * @brief Process output and feature reports posted by the transport layer
+ *
+ * @note Pixel transmission and storage may block for a while.
+ *       This way, the BLE host and USB stacks never stall.
+ *       Pending feature reports are processed before the next output report.
+ *
+ * @param unused Not used
+ */
+static void hidWorkerLoop(void *unused)
+{
+    PostedReport report;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        bool pending = true;
+        while (pending)
+        {
+            while (xQueueReceive(postedFeatures, &report, 0))
+                applyFeature(report.reportID, report.data, report.len);
+            pending = xQueueReceive(postedOutputs, &report, 0);
+            if (pending)
+                internals::hid::common::onOutput(report.reportID, report.data, report.len);
+        }
+    }
+}
+
+/**
+ * @brief Copy a report into a queue of the HID worker task
+ *
+ * @note Never waits. Dropped if the queue is full.
+ *       Feature and output reports go to different queues.
+ *
+ * @param report_id Report ID
+ * @param isFeature True for feature reports, false for output reports
+ * @param buffer Report data
+ * @param len Size of @p buffer
+ */
+static void postReport(
+    uint8_t report_id,
+    bool isFeature,
+    const uint8_t *buffer,
+    uint16_t len)
+{
+    if (hidWorkerTask == nullptr)
+    {
+        // Not started yet
+        if (isFeature)
+            applyFeature(report_id, buffer, len);
+        else
+            internals::hid::common::onOutput(report_id, buffer, len);
+        return;
+    }
+    PostedReport report;
+    report.reportID = report_id;
+    report.isFeature = isFeature;
+    report.len = std::min<uint16_t>(len, HID_MAX_REPORT_SIZE);
+    memcpy(report.data, buffer, report.len);
+    QueueHandle_t queue = isFeature ? postedFeatures : postedOutputs;
+    if (xQueueSend(queue, &report, 0) == pdTRUE)
+        xTaskNotifyGive(hidWorkerTask);
+    else
+        COUNT_EVENT(hidReportDrops);
+}
+
+/**
+ * @brief Create the HID worker task
+ *
+ */
+static void startHidWorker()
+{
+    postedFeatures = xQueueCreate(HID_WORKER_FEATURE_QUEUE_LENGTH, sizeof(PostedReport));
+    postedOutputs = xQueueCreate(HID_WORKER_OUTPUT_QUEUE_LENGTH, sizeof(PostedReport));
+    if ((postedFeatures == nullptr) || (postedOutputs == nullptr))
+        throw std::runtime_error("Unable to create the HID report queues");
+    TaskHandle_t task = nullptr;
+    xTaskCreate(
+        hidWorkerLoop,
+        "HidWorker",
+        HID_WORKER_STACK_SIZE,
+        nullptr,
+        tskIDLE_PRIORITY + 1,
+        &task);
+    if (task == nullptr)
+        throw std::runtime_error("Unable to create the HID worker task");
+    COUNT_TASK(FirmwareTask::HID_WORKER, task);
+    hidWorkerTask = task;
+}
+#endif
+
+//-------------------------------------------------------------------
+
+void internals::hid::common::postSetFeature(
+    uint8_t report_id,
+    const uint8_t *buffer,
+    uint16_t len)
+{
+#if CD_CI
+    internals::hid::common::onSetFeature(report_id, buffer, len);
+#else
+    // Reads must follow previous selections
+    selectFeature(report_id, buffer, len);
+    postReport(report_id, true, buffer, len);
+#endif
+}
+
+void internals::hid::common::postOutput(
+    uint8_t report_id,
+    const uint8_t *buffer,
+    uint16_t len)
+{
+#if CD_CI
+    internals::hid::common::onOutput(report_id, buffer, len);
+#else
+    postReport(report_id, false, buffer, len);
+#endif
+}
+
 //-------------------------------------------------------------------
 // Start
 //-------------------------------------------------------------------
 
 void commonHidStart()
 {
+#if !CD_CI
+    startHidWorker();
+#endif
+
+#if HID_COMPACT_INPUT_REPORT
+    internals::hid::common::setInputLayout(compactInputLayout());
+#endif
+
     uint16_t customVID = 0;
     uint16_t customPID = 0;
     if (internals::hid::supportsCustomHardwareID())
@@ -140,9 +468,18 @@ void commonHidStart()
 
 //-------------------------------------------------------------------
 
+void commonHidConnected()
+{
+    // The host computer does not know the last report
+    internals::hid::common::forgetLastInputReport();
+}
+
+//-------------------------------------------------------------------
+
 void internals::hid::common::getReady()
 {
     OnStart::subscribe(commonHidStart);
+    OnConnected::subscribe(commonHidConnected);
     OnBatteryLevel::subscribe(internals::hid::reportBatteryLevel);
     HidService::inject(new HidServiceProvider());
 }
@@ -151,6 +488,20 @@ void internals::hid::common::getReady()
 // Feature reports
 //-------------------------------------------------------------------
 
+/**
+ * @brief Checksum of a bulk input map report (all bytes but the checksum)
+ *
+ * @param report Report data (without report ID)
+ * @return uint16_t CRC-16
+ */
+static uint16_t bulkMapChecksum(const uint8_t *report)
+{
+    uint16_t crc = crc16(report, 2);
+    return crc16(report + 4, 2 * BUTTONS_MAP_PAGE_SIZE, crc);
+}
+
+//-------------------------------------------------------------------
+
 uint16_t internals::hid::common::onGetFeature(
     uint8_t report_id,
     uint8_t *buffer,
@@ -173,6 +524,46 @@ uint16_t internals::hid::common::onGetFeature(
         buffer[19] = internals::pixels::getCount(PixelGroup::GRP_INDIVIDUAL);
         return CAPABILITIES_REPORT_SIZE;
     }
+    if ((report_id == RID_FEATURE_HEALTH) && (len >= HEALTH_REPORT_SIZE))
+    {
+        *(uint32_t *)(buffer) = FirmwareCounters::scanCount;
+        *(uint32_t *)(buffer + 4) = FirmwareCounters::scanOverruns;
+        *(uint32_t *)(buffer + 8) = FirmwareCounters::hubEvents;
+        *(uint32_t *)(buffer + 12) = FirmwareCounters::queueDrops;
+        *(uint32_t *)(buffer + 16) = FirmwareCounters::reportsSent;
+        *(uint32_t *)(buffer + 20) = suppressedInputReportCount;
+        *(uint32_t *)(buffer + 24) = FirmwareCounters::i2cErrors[0];
+        *(uint32_t *)(buffer + 28) = FirmwareCounters::i2cErrors[1];
+        *(uint32_t *)(buffer + 32) = FirmwareCounters::bitQueueOverflows;
+#if !CD_CI
+        *(uint32_t *)(buffer + 36) = esp_get_free_heap_size();
+#else
+        *(uint32_t *)(buffer + 36) = 0;
+#endif
+        *(uint16_t *)(buffer + 40) = FirmwareCounters::queueHighWaterMark;
+        // Lowest stack high-water mark of each task kind, in bytes
+        uint16_t stack[FIRMWARE_TASK_COUNT];
+        for (uint8_t task = 0; task < FIRMWARE_TASK_COUNT; task++)
+            stack[task] = 0xFFFF;
+        FirmwareTask task;
+        for (uint8_t slot = 0; slot < FIRMWARE_TASK_SLOTS; slot++)
+        {
+            void *handle = FirmwareCounters::getTask(slot, task);
+            if (handle)
+            {
+                uint32_t hwm = internals::hal::task::getStackHighWaterMark(handle);
+                uint16_t &current = stack[static_cast<uint8_t>(task)];
+                if (hwm < current)
+                    current = hwm;
+            }
+        }
+        for (uint8_t task = 0; task <= static_cast<uint8_t>(FirmwareTask::BATTERY_MONITOR); task++)
+            *(uint16_t *)(buffer + 42 + 2 * task) = stack[task];
+        *(uint16_t *)(buffer + 50) = (uint16_t)FirmwareCounters::telemetryDeltasLost;
+        *(uint32_t *)(buffer + 52) = FirmwareCounters::hidReportDrops;
+        *(uint16_t *)(buffer + 56) = stack[static_cast<uint8_t>(FirmwareTask::HID_WORKER)];
+        return HEALTH_REPORT_SIZE;
+    }
     if ((report_id == RID_FEATURE_CONFIG) && (len >= CONFIG_REPORT_SIZE))
     {
         buffer[0] = (uint8_t)InputHubService::call::getClutchWorkingMode();
@@ -225,17 +616,187 @@ uint16_t internals::hid::common::onGetFeature(
         }
         return HARDWARE_ID_REPORT_SIZE;
     }
+    if ((report_id == RID_FEATURE_INPUT_PROFILE) && (len >= INPUT_PROFILE_REPORT_SIZE))
+    {
+        InputReadCost cost;
+        buffer[0] = selectedProfile;
+        buffer[1] = InputService::call::getReadCostCount();
+        buffer[2] = (InputService::call::getReadProfiling()) ? 0x01 : 0x00;
+        if (!InputService::call::getReadCost(selectedProfile, cost))
+            cost = InputReadCost();
+        else if (cost.busInput)
+            buffer[2] |= 0x02;
+        buffer[3] = cost.firstInputNumber;
+        buffer[4] = cost.inputCount;
+        buffer[5] = 0;
+        buffer[6] = 0;
+        buffer[7] = 0;
+        *(uint32_t *)(buffer + 8) = cost.minNs;
+        *(uint32_t *)(buffer + 12) = cost.avgNs;
+        *(uint32_t *)(buffer + 16) = cost.maxNs;
+        *(uint32_t *)(buffer + 20) = cost.readCount;
+        return INPUT_PROFILE_REPORT_SIZE;
+    }
+    if ((report_id == RID_FEATURE_EVENT_TRACE) && (len >= EVENT_TRACE_REPORT_SIZE))
+    {
+        InputTraceEntry entry;
+        uint32_t count = InputHubService::call::getEventTraceCount();
+        uint32_t oldest = (count > EVENT_TRACE_DEPTH) ? (count - EVENT_TRACE_DEPTH) : 0;
+        // Overwritten: skip to the oldest event kept
+        uint32_t sequence = std::max<uint32_t>(selectedTrace, oldest);
+        bool valid = InputHubService::call::getEventTraceEntry(sequence, entry);
+        memset(buffer, 0, EVENT_TRACE_REPORT_SIZE);
+        *(uint32_t *)(buffer) = sequence;
+        *(uint32_t *)(buffer + 4) = count;
+        buffer[8] = (InputHubService::call::getEventTrace()) ? 0x01 : 0x00;
+        buffer[9] = INPUT_BITMAP_WIDTH / 8;
+        if (valid)
+        {
+            buffer[8] |= 0x02;
+            buffer[10] = entry.input.leftAxisValue;
+            buffer[11] = entry.input.rightAxisValue;
+            *(uint32_t *)(buffer + 12) = entry.timestampUs;
+            if (entry.reported)
+            {
+                buffer[8] |= 0x04;
+                *(uint64_t *)(buffer + 16) = entry.inputsLow;
+                *(uint64_t *)(buffer + 24) = entry.inputsHigh;
+                buffer[32] = entry.POVstate;
+                buffer[33] = entry.leftAxis;
+                buffer[34] = entry.rightAxis;
+                buffer[35] = entry.clutchAxis;
+            }
+            for (uint8_t word = 0; word < INPUT_BITMAP_WORD_COUNT; word++)
+            {
+                uint64_t raw = inputBitmapWord(entry.input.rawInputBitmap, word);
+                uint64_t changes = inputBitmapWord(entry.input.rawInputChanges, word);
+                memcpy(buffer + 36 + (word * 8), &raw, 8);
+                memcpy(buffer + 36 + (INPUT_BITMAP_WIDTH / 8) + (word * 8), &changes, 8);
+            }
+        }
+        return EVENT_TRACE_REPORT_SIZE;
+    }
+    if ((report_id == RID_FEATURE_BUTTONS_MAP_BULK) && (len >= BUTTONS_MAP_BULK_REPORT_SIZE))
+    {
+        buffer[0] = selectedMapPage;
+        buffer[1] = BUTTONS_MAP_PAGE_COUNT;
+        for (uint8_t i = 0; i < BUTTONS_MAP_PAGE_SIZE; i++)
+        {
+            uint8_t firmware_defined = (selectedMapPage * BUTTONS_MAP_PAGE_SIZE) + i;
+            uint8_t *pair = buffer + 4 + (2 * i);
+            if (InputNumber::booked(firmware_defined))
+                InputMapService::call::getMap(firmware_defined, pair[0], pair[1]);
+            else
+            {
+                pair[0] = 0xFF;
+                pair[1] = 0xFF;
+            }
+        }
+        *(uint16_t *)(buffer + 2) = bulkMapChecksum(buffer);
+        return BUTTONS_MAP_BULK_REPORT_SIZE;
+    }
+    if ((report_id == RID_FEATURE_SETTINGS_IMAGE) && (len >= SETTINGS_IMAGE_REPORT_SIZE))
+    {
+        std::lock_guard<std::mutex> lock(exportedImageMutex);
+        uint8_t pageCount =
+            (exportedImageSize + SETTINGS_IMAGE_PAGE_SIZE - 1) / SETTINGS_IMAGE_PAGE_SIZE;
+        uint16_t offset = selectedImagePage * SETTINGS_IMAGE_PAGE_SIZE;
+        buffer[0] = selectedImagePage;
+        buffer[1] = pageCount;
+        *(uint16_t *)(buffer + 2) = exportedImageSize;
+        memset(buffer + 4, 0, SETTINGS_IMAGE_PAGE_SIZE);
+        if (offset < exportedImageSize)
+            memcpy(
+                buffer + 4,
+                exportedImage + offset,
+                std::min<uint16_t>(SETTINGS_IMAGE_PAGE_SIZE, exportedImageSize - offset));
+        return SETTINGS_IMAGE_REPORT_SIZE;
+    }
+    if ((report_id == RID_FEATURE_BLE_CONNECTION) && (len >= BLE_CONNECTION_REPORT_SIZE))
+    {
+        BleConnectionStatus status = internals::hid::getConnectionStatus();
+        buffer[0] = (uint8_t)status.profile;
+        buffer[1] = (uint8_t)status.state;
+        *(uint16_t *)(buffer + 2) = status.interval;
+        *(uint16_t *)(buffer + 4) = status.latency;
+        *(uint16_t *)(buffer + 6) = status.timeout;
+        buffer[8] = status.attempts;
+        return BLE_CONNECTION_REPORT_SIZE;
+    }
     return 0;
 }
 
 //-------------------------------------------------------------------
 
-void internals::hid::common::onSetFeature(
+/**
+ * @brief Select the data to read next from a feature report
+ *
+ * @note Called by the transport layer before posting the report,
+ *       so it must not block.
+ *
+ * @param report_id Report ID
+ * @param buffer Report data
+ * @param len Size of @p buffer
+ */
+static void selectFeature(
     uint8_t report_id,
     const uint8_t *buffer,
     uint16_t len)
 {
-    if ((InputHubService::call::getSecurityLock()) || (report_id == RID_FEATURE_CAPABILITIES))
+    if (InputHubService::call::getSecurityLock())
+        return;
+    if ((report_id == RID_FEATURE_BUTTONS_MAP) && (len >= BUTTONS_MAP_REPORT_SIZE))
+    {
+        if (buffer[0] <= MAX_INPUT_NUMBER)
+            selectedInput = buffer[0];
+    }
+    else if ((report_id == RID_FEATURE_INPUT_PROFILE) && (len >= INPUT_PROFILE_REPORT_SIZE))
+        selectedProfile = buffer[0];
+    else if ((report_id == RID_FEATURE_EVENT_TRACE) && (len >= EVENT_TRACE_REPORT_SIZE))
+    {
+        uint32_t sequence = *(uint32_t *)(buffer);
+        if (sequence != 0xFFFFFFFF)
+            selectedTrace = sequence;
+    }
+    else if ((report_id == RID_FEATURE_BUTTONS_MAP_BULK) && (len >= BUTTONS_MAP_BULK_REPORT_SIZE))
+    {
+        if (buffer[0] < BUTTONS_MAP_PAGE_COUNT)
+            selectedMapPage = buffer[0];
+    }
+    else if ((report_id == RID_FEATURE_SETTINGS_IMAGE) && (len >= SETTINGS_IMAGE_REPORT_SIZE))
+    {
+        uint8_t page = buffer[0];
+        if ((buffer[1] == 0x00) && (page < SETTINGS_IMAGE_MAX_PAGES))
+        {
+            if (page == 0)
+            {
+                // Take a new snapshot.
+                // Note: settings are read from memory, not from flash.
+                std::lock_guard<std::mutex> lock(exportedImageMutex);
+                exportedImageSize = StorageService::call::exportSettings(exportedImage);
+            }
+            selectedImagePage = page;
+        }
+    }
+}
+
+/**
+ * @brief Apply the changes written to a feature report
+ *
+ * @note Called by the HID worker task
+ *
+ * @param report_id Report ID
+ * @param buffer Report data
+ * @param len Size of @p buffer
+ */
+static void applyFeature(
+    uint8_t report_id,
+    const uint8_t *buffer,
+    uint16_t len)
+{
+    if ((InputHubService::call::getSecurityLock()) ||
+        (report_id == RID_FEATURE_CAPABILITIES) ||
+        (report_id == RID_FEATURE_HEALTH))
         return;
     if (report_id == RID_FEATURE_CONFIG)
     {
@@ -315,16 +876,14 @@ void internals::hid::common::onSetFeature(
     }
     else if ((report_id == RID_FEATURE_BUTTONS_MAP) && (len >= BUTTONS_MAP_REPORT_SIZE))
     {
-        if (buffer[0] <= MAX_INPUT_NUMBER)
-        {
-            selectedInput = buffer[0];
-            if ((buffer[1] <= MAX_INPUT_NUMBER) && (buffer[2] <= MAX_INPUT_NUMBER))
-                InputMapService::call::setMap(buffer[0], buffer[1], buffer[2]);
-        }
+        if ((buffer[0] <= MAX_INPUT_NUMBER) &&
+            (buffer[1] <= MAX_INPUT_NUMBER) &&
+            (buffer[2] <= MAX_INPUT_NUMBER))
+            InputMapService::call::setMap(buffer[0], buffer[1], buffer[2]);
     }
     else if ((report_id == RID_FEATURE_HARDWARE_ID) && (len >= HARDWARE_ID_REPORT_SIZE))
     {
-        if (hid::supportsCustomHardwareID())
+        if (internals::hid::supportsCustomHardwareID())
         {
             uint16_t vid = *(uint16_t *)(buffer);
             uint16_t pid = *(uint16_t *)(buffer + 2);
@@ -340,14 +899,223 @@ void internals::hid::common::onSetFeature(
                 HidService::call::setCustomHardwareID(vid, pid);
         } // else ignore
     }
+    else if ((report_id == RID_FEATURE_INPUT_PROFILE) && (len >= INPUT_PROFILE_REPORT_SIZE))
+    {
+        if (buffer[2] != 0xFF)
+            InputService::call::setReadProfiling(buffer[2] & 0x01);
+    }
+    else if ((report_id == RID_FEATURE_EVENT_TRACE) && (len >= EVENT_TRACE_REPORT_SIZE))
+    {
+        if (buffer[8] != 0xFF)
+            InputHubService::call::setEventTrace(buffer[8] & 0x01);
+    }
+    else if ((report_id == RID_FEATURE_BUTTONS_MAP_BULK) && (len >= BUTTONS_MAP_BULK_REPORT_SIZE))
+    {
+        uint8_t page = buffer[0];
+        if (page < BUTTONS_MAP_PAGE_COUNT)
+        {
+            if (buffer[1] == 0x01)
+            {
+                // Write this page
+                if (page == 0)
+                    // A new map starts
+                    stagedMapPages = 0;
+                if (*(uint16_t *)(buffer + 2) == bulkMapChecksum(buffer))
+                {
+                    for (uint8_t i = 0; i < BUTTONS_MAP_PAGE_SIZE; i++)
+                    {
+                        stagedMap[0][(page * BUTTONS_MAP_PAGE_SIZE) + i] = buffer[4 + (2 * i)];
+                        stagedMap[1][(page * BUTTONS_MAP_PAGE_SIZE) + i] = buffer[5 + (2 * i)];
+                    }
+                    stagedMapPages |= (1 << page);
+                    if (stagedMapPages == ((1 << BUTTONS_MAP_PAGE_COUNT) - 1))
+                    {
+                        // All pages received
+                        InputMapService::call::setMaps(stagedMap[0], stagedMap[1]);
+                        stagedMapPages = 0;
+                    }
+                }
+                else
+                    // Corrupted: discard the whole map
+                    stagedMapPages = 0;
+            }
+        }
+    }
+    else if ((report_id == RID_FEATURE_SETTINGS_IMAGE) && (len >= SETTINGS_IMAGE_REPORT_SIZE))
+    {
+        uint8_t page = buffer[0];
+        uint16_t size = *(uint16_t *)(buffer + 2);
+        if (buffer[1] == 0x01)
+        {
+            // Write a page
+            if (page == 0)
+            {
+                // A new image starts
+                stagedImageSize = size;
+                stagedImagePages = 0;
+            }
+            uint16_t offset = page * SETTINGS_IMAGE_PAGE_SIZE;
+            if ((page == stagedImagePages) &&
+                (size == stagedImageSize) &&
+                (size <= SETTINGS_IMAGE_MAX_SIZE) &&
+                (offset < size))
+            {
+                memcpy(
+                    stagedImage + offset,
+                    buffer + 4,
+                    std::min<uint16_t>(SETTINGS_IMAGE_PAGE_SIZE, size - offset));
+                stagedImagePages++;
+                if ((offset + SETTINGS_IMAGE_PAGE_SIZE) >= size)
+                {
+                    // All pages received
+                    StorageService::call::importSettings(stagedImage, size);
+                    stagedImagePages = 0;
+                    stagedImageSize = 0;
+                }
+            }
+            else
+            {
+                // Out of order or too big: discard the whole image
+                stagedImagePages = 0;
+                stagedImageSize = 0;
+            }
+        }
+    }
+    else if ((report_id == RID_FEATURE_BLE_CONNECTION) && (len >= BLE_CONNECTION_REPORT_SIZE))
+    {
+        // Other fields are read-only
+        if (buffer[0] <= (uint8_t)BleConnectionProfile::_MAX_VALUE)
+            internals::hid::setConnectionProfile((BleConnectionProfile)buffer[0]);
+    }
     else
         assert("Set feature report: Unknown ID");
 }
 
+//-------------------------------------------------------------------
+
+void internals::hid::common::onSetFeature(
+    uint8_t report_id,
+    const uint8_t *buffer,
+    uint16_t len)
+{
+    selectFeature(report_id, buffer, len);
+    applyFeature(report_id, buffer, len);
+}
+
 //-------------------------------------------------------------------
 // Output reports
 //-------------------------------------------------------------------
 
+static void decodePowertrain(const uint8_t *buffer)
+{
+    telemetry::data.powertrain.gear = (char)buffer[0];
+    telemetry::data.powertrain.rpm = *((uint16_t *)(buffer + 1));
+    telemetry::data.powertrain.rpmPercent = buffer[3];
+    if (telemetry::data.powertrain.rpmPercent > 100)
+        telemetry::data.powertrain.rpmPercent = 100;
+    telemetry::data.powertrain.shiftLight1 = buffer[4];
+    telemetry::data.powertrain.shiftLight2 = buffer[5];
+    telemetry::data.powertrain.revLimiter = buffer[6];
+    telemetry::data.powertrain.engineStarted = buffer[7];
+    telemetry::data.powertrain.speed = *((uint16_t *)(buffer + 8));
+}
+
+static void decodeEcu(const uint8_t *buffer)
+{
+    telemetry::data.ecu.absEngaged = buffer[0];
+    telemetry::data.ecu.tcEngaged = buffer[1];
+    telemetry::data.ecu.drsEngaged = buffer[2];
+    telemetry::data.ecu.pitLimiter = buffer[3];
+    telemetry::data.ecu.lowFuelAlert = buffer[4];
+    telemetry::data.ecu.absLevel = buffer[5];
+    telemetry::data.ecu.tcLevel = buffer[6];
+    telemetry::data.ecu.tcCut = buffer[7];
+    telemetry::data.ecu.brakeBias = buffer[8];
+    if (telemetry::data.ecu.brakeBias > 100)
+        telemetry::data.ecu.brakeBias = 100;
+}
+
+static void decodeRaceControl(const uint8_t *buffer)
+{
+    telemetry::data.raceControl.blackFlag = buffer[0];
+    telemetry::data.raceControl.blueFlag = buffer[1];
+    telemetry::data.raceControl.checkeredFlag = buffer[2];
+    telemetry::data.raceControl.greenFlag = buffer[3];
+    telemetry::data.raceControl.orangeFlag = buffer[4];
+    telemetry::data.raceControl.whiteFlag = buffer[5];
+    telemetry::data.raceControl.yellowFlag = buffer[6];
+    telemetry::data.raceControl.remainingLaps = *((uint16_t *)(buffer + 7));
+    telemetry::data.raceControl.remainingMinutes = *((uint16_t *)(buffer + 9));
+}
+
+static void decodeGauges(const uint8_t *buffer)
+{
+    telemetry::data.gauges.relativeTurboPressure = buffer[0];
+    if (telemetry::data.gauges.relativeTurboPressure > 100)
+        telemetry::data.gauges.relativeTurboPressure = 100;
+    telemetry::data.gauges.absoluteTurboPressure = static_cast<float>(*((uint16_t *)(buffer + 1)) / 100.0);
+    telemetry::data.gauges.waterTemperature = *((uint16_t *)(buffer + 3));
+    telemetry::data.gauges.oilPressure = static_cast<float>(*((uint16_t *)(buffer + 5)) / 100.0);
+    telemetry::data.gauges.oilTemperature = *((uint16_t *)(buffer + 7));
+    telemetry::data.gauges.relativeRemainingFuel = buffer[9];
+    if (telemetry::data.gauges.relativeRemainingFuel > 100)
+        telemetry::data.gauges.relativeRemainingFuel = 100;
+    telemetry::data.gauges.absoluteRemainingFuel = *((uint16_t *)(buffer + 10));
+}
+
+/**
+ * @brief Apply a telemetry delta report
+ *
+ * @note Each entry patches the last known content of a fixed-layout
+ *       telemetry report (ID 20 to 23). Patched reports are decoded
+ *       again into telemetry::data.
+ *
+ * @param buffer Report data
+ */
+static void applyTelemetryDelta(const uint8_t *buffer)
+{
+    uint8_t sequence = buffer[0];
+    if (telemetrySequenceIsValid && !(buffer[1] & TELEMETRY_DELTA_FLAG_RESYNC))
+    {
+        uint8_t lost = sequence - lastTelemetrySequence - 1;
+        // A huge gap means the host started over
+        if (lost < 128)
+            COUNT_EVENTS(telemetryDeltasLost, lost);
+    }
+    lastTelemetrySequence = sequence;
+    telemetrySequenceIsValid = true;
+
+    uint8_t patchedGroups = 0;
+    uint8_t index = 2;
+    while (index + 2 <= TELEMETRY_DELTA_REPORT_SIZE)
+    {
+        uint8_t tag = buffer[index];
+        uint8_t length = buffer[index + 1];
+        if ((tag == 0) || (index + 2 + length > TELEMETRY_DELTA_REPORT_SIZE))
+            break;
+        uint8_t group = (tag >> 4) - 1;
+        uint8_t offset = tag & 0x0F;
+        // Unknown or out of range entries are skipped
+        if ((group < TELEMETRY_GROUP_COUNT) && (offset + length <= telemetryReportSize[group]))
+        {
+            memcpy(telemetryShadow[group] + offset, buffer + index + 2, length);
+            patchedGroups |= (1 << group);
+        }
+        index += 2 + length;
+    }
+
+    if (patchedGroups & (1 << TELEMETRY_GROUP_POWERTRAIN))
+        decodePowertrain(telemetryShadow[TELEMETRY_GROUP_POWERTRAIN]);
+    if (patchedGroups & (1 << TELEMETRY_GROUP_ECU))
+        decodeEcu(telemetryShadow[TELEMETRY_GROUP_ECU]);
+    if (patchedGroups & (1 << TELEMETRY_GROUP_RACE_CONTROL))
+        decodeRaceControl(telemetryShadow[TELEMETRY_GROUP_RACE_CONTROL]);
+    if (patchedGroups & (1 << TELEMETRY_GROUP_GAUGES))
+        decodeGauges(telemetryShadow[TELEMETRY_GROUP_GAUGES]);
+}
+
+//-------------------------------------------------------------------
+
 void internals::hid::common::onOutput(
     uint8_t report_id,
     const uint8_t *buffer,
@@ -356,57 +1124,26 @@ void internals::hid::common::onOutput(
     // TODO: security lock
     if ((report_id == RID_OUTPUT_POWERTRAIN) && (len >= POWERTRAIN_REPORT_SIZE))
     {
-        telemetry::data.powertrain.gear = (char)buffer[0];
-        telemetry::data.powertrain.rpm = *((uint16_t *)(buffer + 1));
-        telemetry::data.powertrain.rpmPercent = buffer[3];
-        if (telemetry::data.powertrain.rpmPercent > 100)
-            telemetry::data.powertrain.rpmPercent = 100;
-        telemetry::data.powertrain.shiftLight1 = buffer[4];
-        telemetry::data.powertrain.shiftLight2 = buffer[5];
-        telemetry::data.powertrain.revLimiter = buffer[6];
-        telemetry::data.powertrain.engineStarted = buffer[7];
-        telemetry::data.powertrain.speed = *((uint16_t *)(buffer + 8));
+        memcpy(telemetryShadow[TELEMETRY_GROUP_POWERTRAIN], buffer, POWERTRAIN_REPORT_SIZE);
+        decodePowertrain(buffer);
     }
     else if ((report_id == RID_OUTPUT_ECU) && (len >= ECU_REPORT_SIZE))
     {
-        telemetry::data.ecu.absEngaged = buffer[0];
-        telemetry::data.ecu.tcEngaged = buffer[1];
-        telemetry::data.ecu.drsEngaged = buffer[2];
-        telemetry::data.ecu.pitLimiter = buffer[3];
-        telemetry::data.ecu.lowFuelAlert = buffer[4];
-        telemetry::data.ecu.absLevel = buffer[5];
-        telemetry::data.ecu.tcLevel = buffer[6];
-        telemetry::data.ecu.tcCut = buffer[7];
-        telemetry::data.ecu.brakeBias = buffer[8];
-        if (telemetry::data.ecu.brakeBias > 100)
-            telemetry::data.ecu.brakeBias = 100;
+        memcpy(telemetryShadow[TELEMETRY_GROUP_ECU], buffer, ECU_REPORT_SIZE);
+        decodeEcu(buffer);
     }
     else if ((report_id == RID_OUTPUT_RACE_CONTROL) && (len >= RACE_CONTROL_REPORT_SIZE))
     {
-        telemetry::data.raceControl.blackFlag = buffer[0];
-        telemetry::data.raceControl.blueFlag = buffer[1];
-        telemetry::data.raceControl.checkeredFlag = buffer[2];
-        telemetry::data.raceControl.greenFlag = buffer[3];
-        telemetry::data.raceControl.orangeFlag = buffer[4];
-        telemetry::data.raceControl.whiteFlag = buffer[5];
-        telemetry::data.raceControl.yellowFlag = buffer[6];
-        telemetry::data.raceControl.remainingLaps = *((uint16_t *)(buffer + 7));
-        telemetry::data.raceControl.remainingMinutes = *((uint16_t *)(buffer + 9));
+        memcpy(telemetryShadow[TELEMETRY_GROUP_RACE_CONTROL], buffer, RACE_CONTROL_REPORT_SIZE);
+        decodeRaceControl(buffer);
     }
     else if ((report_id == RID_OUTPUT_GAUGES) && (len >= GAUGES_REPORT_SIZE))
     {
-        telemetry::data.gauges.relativeTurboPressure = buffer[0];
-        if (telemetry::data.gauges.relativeTurboPressure > 100)
-            telemetry::data.gauges.relativeTurboPressure = 100;
-        telemetry::data.gauges.absoluteTurboPressure = static_cast<float>(*((uint16_t *)(buffer + 1)) / 100.0);
-        telemetry::data.gauges.waterTemperature = *((uint16_t *)(buffer + 3));
-        telemetry::data.gauges.oilPressure = static_cast<float>(*((uint16_t *)(buffer + 5)) / 100.0);
-        telemetry::data.gauges.oilTemperature = *((uint16_t *)(buffer + 7));
-        telemetry::data.gauges.relativeRemainingFuel = buffer[9];
-        if (telemetry::data.gauges.relativeRemainingFuel > 100)
-            telemetry::data.gauges.relativeRemainingFuel = 100;
-        telemetry::data.gauges.absoluteRemainingFuel = *((uint16_t *)(buffer + 10));
+        memcpy(telemetryShadow[TELEMETRY_GROUP_GAUGES], buffer, GAUGES_REPORT_SIZE);
+        decodeGauges(buffer);
     }
+    else if ((report_id == RID_OUTPUT_TELEMETRY_DELTA) && (len >= TELEMETRY_DELTA_REPORT_SIZE))
+        applyTelemetryDelta(buffer);
     else if ((report_id == RID_OUTPUT_PIXEL) && (len >= PIXEL_REPORT_SIZE))
     {
         if (buffer[0] == 0xFF)
@@ -431,6 +1168,55 @@ void internals::hid::common::onOutput(
             buffer[2]);
         return;
     }
+    else if ((report_id == RID_OUTPUT_PIXEL_FRAME) && (len >= PIXEL_FRAME_REPORT_SIZE))
+    {
+        if (buffer[0] > (uint8_t)PixelGroup::GRP_INDIVIDUAL)
+            // Invalid pixel group
+            return;
+        PixelGroup group = (PixelGroup)buffer[0];
+        uint8_t flags = buffer[1];
+        uint16_t pixelIndex = buffer[2];
+        uint8_t itemCount = buffer[3];
+        const uint8_t *item = buffer + 4;
+        if (flags & PIXEL_FRAME_FLAG_RLE)
+        {
+            if (itemCount > PIXEL_FRAME_MAX_RUNS)
+                return;
+            // Each run is: length, blue, green, red
+            for (uint8_t run = 0; (run < itemCount) && (pixelIndex < 256); run++, item += 4)
+            {
+                if (item[0] == 0)
+                    continue;
+                uint16_t lastIndex = pixelIndex + item[0] - 1;
+                if (lastIndex > 255)
+                    lastIndex = 255;
+                internals::pixels::setRange(
+                    group,
+                    pixelIndex,
+                    lastIndex,
+                    item[3],
+                    item[2],
+                    item[1]);
+                pixelIndex = lastIndex + 1;
+            }
+        }
+        else
+        {
+            if (itemCount > PIXEL_FRAME_MAX_PIXELS)
+                return;
+            // Each pixel is: blue, green, red
+            for (uint8_t i = 0; (i < itemCount) && (pixelIndex < 256); i++, pixelIndex++, item += 3)
+                internals::pixels::set(
+                    group,
+                    pixelIndex,
+                    item[2],
+                    item[1],
+                    item[0]);
+        }
+        if (flags & PIXEL_FRAME_FLAG_SHOW)
+            internals::pixels::show();
+        return;
+    }
     telemetry::data.frameID = telemetry::data.frameID + 1;
     // log_d("frame id: %u", telemetry::data.frameID);
 }
@@ -441,31 +1227,22 @@ void internals::hid::common::onOutput(
 
 void internals::hid::common::onReset(uint8_t *report)
 {
-    report[0] = 0;
-    report[1] = 0;
-    report[2] = 0;
-    report[3] = 0;
-    report[4] = 0;
-    report[5] = 0;
-    report[6] = 0;
-    report[7] = 0;
-    report[8] = 0;
-    report[9] = 0;
-    report[10] = 0;
-    report[11] = 0;
-    report[12] = 0;
-    report[13] = 0;
-    report[14] = 0;
-    report[15] = 0;
-    report[16] = CLUTCH_NONE_VALUE;
-    report[17] = CLUTCH_NONE_VALUE;
-    report[18] = CLUTCH_NONE_VALUE;
-    report[19] = 0;
+    uint8_t size = packInputReport(
+        report,
+        0ULL,
+        0ULL,
+        0,
+        CLUTCH_NONE_VALUE,
+        CLUTCH_NONE_VALUE,
+        CLUTCH_NONE_VALUE);
+    std::lock_guard<std::mutex> lock(lastInputReportMutex);
+    memcpy(lastInputReport, report, size);
+    lastInputReportIsValid = true;
 }
 
 //-------------------------------------------------------------------
 
-void internals::hid::common::onReportInput(
+bool internals::hid::common::onReportInput(
     uint8_t *report,
     bool &notifyConfigChanges,
     uint64_t &inputsLow,
@@ -473,31 +1250,50 @@ void internals::hid::common::onReportInput(
     uint8_t &POVstate,
     uint8_t &leftAxis,
     uint8_t &rightAxis,
-    uint8_t &clutchAxis)
-{
-    report[0] = ((uint8_t *)&inputsLow)[0];
-    report[1] = ((uint8_t *)&inputsLow)[1];
-    report[2] = ((uint8_t *)&inputsLow)[2];
-    report[3] = ((uint8_t *)&inputsLow)[3];
-    report[4] = ((uint8_t *)&inputsLow)[4];
-    report[5] = ((uint8_t *)&inputsLow)[5];
-    report[6] = ((uint8_t *)&inputsLow)[6];
-    report[7] = ((uint8_t *)&inputsLow)[7];
-    report[8] = ((uint8_t *)&inputsHigh)[0];
-    report[9] = ((uint8_t *)&inputsHigh)[1];
-    report[10] = ((uint8_t *)&inputsHigh)[2];
-    report[11] = ((uint8_t *)&inputsHigh)[3];
-    report[12] = ((uint8_t *)&inputsHigh)[4];
-    report[13] = ((uint8_t *)&inputsHigh)[5];
-    report[14] = ((uint8_t *)&inputsHigh)[6];
-    report[15] = ((uint8_t *)&inputsHigh)[7];
-    report[16] = (uint8_t)clutchAxis;
-    report[17] = (uint8_t)leftAxis;
-    report[18] = (uint8_t)rightAxis;
-    report[19] = POVstate;
+    uint8_t &clutchAxis,
+    bool keepAlive)
+{
+    uint8_t size = packInputReport(
+        report,
+        inputsLow,
+        inputsHigh,
+        POVstate,
+        leftAxis,
+        rightAxis,
+        clutchAxis);
+    // Note: changes in the device configuration are always reported
+    bool mustSend = keepAlive || notifyConfigChanges;
     if (notifyConfigChanges)
     {
-        report[19] |= (RID_FEATURE_CONFIG << 4);
+        report[size - 1] |= (RID_FEATURE_CONFIG << 4);
         notifyConfigChanges = false;
     }
+    {
+        std::lock_guard<std::mutex> lock(lastInputReportMutex);
+        if (!mustSend &&
+            lastInputReportIsValid &&
+            (memcmp(report, lastInputReport, size) == 0))
+        {
+            // Nothing new for the host computer
+            suppressedInputReportCount++;
+            return false;
+        }
+        memcpy(lastInputReport, report, size);
+        lastInputReportIsValid = true;
+    }
+    COUNT_EVENT(reportsSent);
+    return true;
+}
+
+//-------------------------------------------------------------------
+
+uint32_t internals::hid::common::getSuppressedReportCount()
+{
+    return suppressedInputReportCount;
+}
+
+void internals::hid::common::forgetLastInputReport()
+{
+    std::lock_guard<std::mutex> lock(lastInputReportMutex);
+    lastInputReportIsValid = false;
 }
@@ -25,6 +25,7 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include "HID_definitions.hpp"
+#include "HidRouter.hpp"
 #include "esp_mac.h" // For esp_efuse_mac_get_default()
 // #include <Arduino.h> // For debugging
 
@@ -106,30 +107,38 @@ uint16_t byteswap(uint16_t value)
 // BLE Server callbacks and advertising
 // ----------------------------------------------------------------------------
 
-class BleConnectionStatus : public BLEServerCallbacks
+class BleServerCallbacks : public BLEServerCallbacks
 {
 public:
-    BleConnectionStatus(void) {};
+    BleServerCallbacks(void) {};
     bool connected = false;
     void onConnect(BLEServer *pServer) override
     {
         if (autoPowerOffTimer != nullptr)
             esp_timer_stop(autoPowerOffTimer);
-        internals::hid::reset();
+        HID_BLE_API::reset();
         connected = true;
+#if HID_ROUTER
+        internals::hid::router::update();
+#else
         OnConnected::notify();
+#endif
     };
 
     void onDisconnect(BLEServer *pServer) override
     {
         connected = false;
         BLEDevice::startAdvertising();
+#if HID_ROUTER
+        internals::hid::router::update();
+#else
         OnDisconnected::notify();
+#endif
         if (autoPowerOffTimer != nullptr)
             esp_timer_start_once(autoPowerOffTimer, AUTO_POWER_OFF_DELAY_SECS * 1000000);
     };
 
-} connectionStatus;
+} serverCallbacks;
 
 // ----------------------------------------------------------------------------
 // HID FEATURE REQUEST callbacks
@@ -153,7 +162,7 @@ void FeatureReport::onWrite(BLECharacteristic *pCharacteristic)
 {
     size_t size = pCharacteristic->getValue().length();
     const uint8_t *data = pCharacteristic->getData();
-    internals::hid::common::onSetFeature(_reportID, data, size);
+    internals::hid::common::postSetFeature(_reportID, data, size);
 }
 
 // SEND REQUESTED DATA
@@ -208,7 +217,7 @@ void OutputReport::onWrite(BLECharacteristic *pCharacteristic)
 {
     size_t size = pCharacteristic->getValue().length();
     const uint8_t *data = pCharacteristic->getData();
-    internals::hid::common::onOutput(_reportID, data, size);
+    internals::hid::common::postOutput(_reportID, data, size);
 }
 
 // Attach to HID device
@@ -229,6 +238,14 @@ void OutputReport::attachTo(BLEHIDDeviceFix *hidDevice, uint8_t RID)
 
 void autoPowerOffCallback(void *unused)
 {
+#if HID_ROUTER
+    if (internals::hid::isConnected())
+    {
+        // Connected through another transport: check again later
+        esp_timer_start_once(autoPowerOffTimer, AUTO_POWER_OFF_DELAY_SECS * 1000000);
+        return;
+    }
+#endif
     PowerService::call::shutdown();
 }
 
@@ -236,7 +253,7 @@ void autoPowerOffCallback(void *unused)
 // Initialization
 // ----------------------------------------------------------------------------
 
-void internals::hid::begin(
+void HID_BLE_API::begin(
     std::string deviceName,
     std::string deviceManufacturer,
     bool enableAutoPowerOff,
@@ -261,7 +278,7 @@ void internals::hid::begin(
         BLEDevice::setMTU(BLE_MTU_SIZE);
         setDefaultPhy(ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK);
         pServer = BLEDevice::createServer();
-        pServer->setCallbacks(&connectionStatus);
+        pServer->setCallbacks(&serverCallbacks);
         BLESecurity *pSecurity = new BLESecurity();
         pSecurity->setAuthenticationMode(ESP_LE_AUTH_REQ_SC_MITM_BOND);
         pSecurity->setInitEncryptionKey(ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK);
@@ -279,7 +296,9 @@ void internals::hid::begin(
 
         hidDevice->pnp(BLE_VENDOR_SOURCE, debugged_vid, debugged_pid, PRODUCT_REVISION);
         hidDevice->hidInfo(0x00, 0x01);
-        hidDevice->reportMap((uint8_t *)hid_descriptor, sizeof(hid_descriptor));
+        uint16_t descriptorSize;
+        const uint8_t *descriptor = internals::hid::common::getDescriptor(descriptorSize);
+        hidDevice->reportMap((uint8_t *)descriptor, descriptorSize);
 
         // Add the serial number to the "Device Information" service
         uint64_t serialNumber;
@@ -305,14 +324,22 @@ void internals::hid::begin(
         // Create HID reports
         inputGamePad = hidDevice->inputReport(RID_INPUT_GAMEPAD);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_CAPABILITIES, CAPABILITIES_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_HEALTH, HEALTH_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_CONFIG, CONFIG_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_BUTTONS_MAP, BUTTONS_MAP_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_HARDWARE_ID, HARDWARE_ID_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_INPUT_PROFILE, INPUT_PROFILE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_EVENT_TRACE, EVENT_TRACE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_BUTTONS_MAP_BULK, BUTTONS_MAP_BULK_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_SETTINGS_IMAGE, SETTINGS_IMAGE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_BLE_CONNECTION, BLE_CONNECTION_REPORT_SIZE);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_POWERTRAIN);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_ECU);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_RACE_CONTROL);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_GAUGES);
+        OutputReport::attachTo(hidDevice, RID_OUTPUT_TELEMETRY_DELTA);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_PIXEL);
+        OutputReport::attachTo(hidDevice, RID_OUTPUT_PIXEL_FRAME);
 
         // Configure BLE advertising
         BLEAdvertising *pAdvertising = pServer->getAdvertising();
@@ -327,7 +354,7 @@ void internals::hid::begin(
         // Start services
         hidDevice->startServices();
         hidDevice->setBatteryLevel(UNKNOWN_BATTERY_LEVEL);
-        connectionStatus.onDisconnect(pServer); // start advertising
+        serverCallbacks.onDisconnect(pServer); // start advertising
     }
 }
 
@@ -335,43 +362,47 @@ void internals::hid::begin(
 // HID profile
 // ----------------------------------------------------------------------------
 
-void internals::hid::reset()
+void HID_BLE_API::reset()
 {
-    if (connectionStatus.connected)
+    if (serverCallbacks.connected)
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
         internals::hid::common::onReset(report);
-        inputGamePad->setValue(report, GAMEPAD_REPORT_SIZE);
+        inputGamePad->setValue(report, internals::hid::common::getInputReportSize());
         inputGamePad->notify();
     }
 }
 
-void internals::hid::reportInput(
+void HID_BLE_API::reportInput(
     uint64_t inputsLow,
     uint64_t inputsHigh,
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
-    if (connectionStatus.connected)
+    if (serverCallbacks.connected)
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
-        internals::hid::common::onReportInput(
-            report,
-            notifyConfigChanges,
-            inputsLow,
-            inputsHigh,
-            POVstate,
-            leftAxis,
-            rightAxis,
-            clutchAxis);
-        inputGamePad->setValue(report, GAMEPAD_REPORT_SIZE);
-        inputGamePad->notify(true);
+        if (internals::hid::common::onReportInput(
+                report,
+                notifyConfigChanges,
+                inputsLow,
+                inputsHigh,
+                POVstate,
+                leftAxis,
+                rightAxis,
+                clutchAxis,
+                keepAlive))
+        {
+            inputGamePad->setValue(report, internals::hid::common::getInputReportSize());
+            inputGamePad->notify(true);
+        }
     }
 }
 
-void internals::hid::reportBatteryLevel(int level)
+void HID_BLE_API::reportBatteryLevel(int level)
 {
     if (hidDevice)
     {
@@ -383,18 +414,32 @@ void internals::hid::reportBatteryLevel(int level)
     }
 }
 
-void internals::hid::reportChangeInConfig()
+void HID_BLE_API::reportChangeInConfig()
 {
     notifyConfigChanges = true; // Will be reported in next input report
 }
 
-bool internals::hid::supportsCustomHardwareID() { return true; }
+bool HID_BLE_API::supportsCustomHardwareID() { return true; }
+
+// ----------------------------------------------------------------------------
+// Connection parameters
+// ----------------------------------------------------------------------------
+
+void HID_BLE_API::setConnectionProfile(BleConnectionProfile profile)
+{
+    // Not supported by this BLE stack
+}
+
+BleConnectionStatus HID_BLE_API::getConnectionStatus()
+{
+    return BleConnectionStatus();
+}
 
 // ----------------------------------------------------------------------------
 // Status
 // ----------------------------------------------------------------------------
 
-bool internals::hid::isConnected()
+bool HID_BLE_API::isConnected()
 {
-    return connectionStatus.connected;
+    return serverCallbacks.connected;
 }
@@ -34,7 +34,11 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include "HID_definitions.hpp"
+#include "HidRouter.hpp"
+#include "BleConnectionManager.hpp"
+#include "BleAdvertisingScheduler.hpp"
 #include "esp_mac.h" // For esp_efuse_mac_get_default()
+#include <mutex>
 // #include <Arduino.h> // For debugging
 
 // ----------------------------------------------------------------------------
@@ -136,30 +140,152 @@ bool setDefaultPhy(uint8_t txPhyMask, uint8_t rxPhyMask)
     return rc == 0;
 }
 
+// ----------------------------------------------------------------------------
+// Connection parameters
+// ----------------------------------------------------------------------------
+
+class NimBLEConnection : public BleConnection
+{
+public:
+    uint16_t connHandle = BLE_HS_CONN_HANDLE_NONE;
+    esp_timer_handle_t requestTimer = nullptr;
+
+    virtual bool requestParameters(const BleConnectionParameters &params) override
+    {
+        if (connHandle == BLE_HS_CONN_HANDLE_NONE)
+            return false;
+        ble_gap_upd_params update;
+        update.itvl_min = params.minInterval;
+        update.itvl_max = params.maxInterval;
+        update.latency = params.latency;
+        update.supervision_timeout = params.timeout;
+        update.min_ce_len = BLE_GAP_INITIAL_CONN_MIN_CE_LEN;
+        update.max_ce_len = BLE_GAP_INITIAL_CONN_MAX_CE_LEN;
+        if (ble_gap_update_params(connHandle, &update) != 0)
+            return false;
+        // The host computer does not answer a rejected request
+        if (requestTimer != nullptr)
+        {
+            esp_timer_stop(requestTimer);
+            esp_timer_start_once(requestTimer, BLE_CONN_REQUEST_TIMEOUT_MS * 1000);
+        }
+        return true;
+    }
+} bleConnection;
+
+static std::mutex connectionMutex;
+static BleConnectionManager connectionManager(bleConnection);
+
+void connectionRequestTimeoutCallback(void *unused)
+{
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    connectionManager.onRequestTimeout();
+}
+
+// ----------------------------------------------------------------------------
+// Advertising phases
+// ----------------------------------------------------------------------------
+
+class NimBLEAdvertiser : public BleAdvertiser
+{
+public:
+    // Identity address of the last connected host, if bonded
+    NimBLEAddress lastHost;
+    bool hasLastHost = false;
+
+    virtual bool startAdvertising(const BleAdvertisingParameters &params) override
+    {
+        NimBLEAdvertising *pAdvertising = NimBLEDevice::getAdvertising();
+        if (pAdvertising->isAdvertising())
+            pAdvertising->stop();
+        // Note: the white list can not change while in use
+        while (NimBLEDevice::getWhiteListCount() > 0)
+            NimBLEDevice::whiteListRemove(NimBLEDevice::getWhiteListAddress(0));
+        if (params.bondedOnly)
+        {
+            int bondCount = NimBLEDevice::getNumBonds();
+            if (bondCount <= 0)
+                return false;
+            // Note: bonds are stored in creation order, not by last use.
+            // Unknown after a restart, so any bonded host may connect.
+            if (hasLastHost && NimBLEDevice::isBonded(lastHost))
+                NimBLEDevice::whiteListAdd(lastHost);
+            else
+                for (int i = 0; i < bondCount; i++)
+                    NimBLEDevice::whiteListAdd(NimBLEDevice::getBondedAddress(i));
+        }
+        pAdvertising->setScanFilter(false, params.bondedOnly);
+        pAdvertising->setMinInterval(params.minInterval);
+        pAdvertising->setMaxInterval(params.maxInterval);
+        return pAdvertising->start();
+    }
+} bleAdvertiser;
+
+static std::mutex advertisingMutex;
+static BleAdvertisingScheduler advertisingScheduler(bleAdvertiser);
+static esp_timer_handle_t advertisingTimer = nullptr;
+
+static uint64_t nowMs()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+// Must be called with advertisingMutex taken
+static void scheduleNextPhase(uint32_t durationMs)
+{
+    if ((advertisingTimer != nullptr) && (durationMs > 0))
+    {
+        esp_timer_stop(advertisingTimer);
+        esp_timer_start_once(advertisingTimer, durationMs * 1000ULL);
+    }
+}
+
+void advertisingTimerCallback(void *unused)
+{
+    std::lock_guard<std::mutex> lock(advertisingMutex);
+    if ((pServer == nullptr) || (pServer->getConnectedCount() == 0))
+        scheduleNextPhase(advertisingScheduler.onPhaseTimeout());
+}
+
 // ----------------------------------------------------------------------------
 // BLE Server callbacks and advertising
 // ----------------------------------------------------------------------------
 
 void startBLEAdvertising()
 {
-    NimBLEDevice::startAdvertising();
+    {
+        std::lock_guard<std::mutex> lock(advertisingMutex);
+        scheduleNextPhase(advertisingScheduler.start(nowMs(), NimBLEDevice::getNumBonds() > 0));
+    }
+#if HID_ROUTER
+    internals::hid::router::update();
+#else
     OnDisconnected::notify();
+#endif
     if (autoPowerOffTimer != nullptr)
         esp_timer_start_once(autoPowerOffTimer, AUTO_POWER_OFF_DELAY_SECS * 1000000);
 }
 
-class BleConnectionStatus : public NimBLEServerCallbacks
+class BleServerCallbacks : public NimBLEServerCallbacks
 {
 public:
-    BleConnectionStatus(void) {};
+    BleServerCallbacks(void) {};
     bool connected = false;
 
-    // Not needed for now
-    // void onConnect(
-    //     NimBLEServer *pServer,
-    //     NimBLEConnInfo &connInfo) override {
-    //     pServer->updateConnParams(connInfo.getConnHandle(), 6, 7, 0, 600);
-    // };
+    void onConnect(
+        NimBLEServer *pServer,
+        NimBLEConnInfo &connInfo) override
+    {
+        std::lock_guard<std::mutex> lock(advertisingMutex);
+        if (advertisingTimer != nullptr)
+            esp_timer_stop(advertisingTimer);
+        BleAdvertisingPhase phase = advertisingScheduler.getPhase();
+        uint32_t time = advertisingScheduler.onConnected(nowMs());
+        log_i(
+            "BLE host connected in %u ms (advertising phase %u)",
+            (unsigned int)time,
+            (unsigned int)phase);
+    }
 
     // Fix Windows notifications not being sent on reconnection
     // See https://github.com/lemmingDev/ESP32-BLE-Gamepad/pull/257/files
@@ -168,6 +294,20 @@ public:
         if (autoPowerOffTimer != nullptr)
             esp_timer_stop(autoPowerOffTimer);
         connected = true;
+        if (connInfo.isBonded())
+        {
+            std::lock_guard<std::mutex> lock(advertisingMutex);
+            bleAdvertiser.lastHost = connInfo.getIdAddress();
+            bleAdvertiser.hasLastHost = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            bleConnection.connHandle = connInfo.getConnHandle();
+            connectionManager.onConnected(
+                connInfo.getConnInterval(),
+                connInfo.getConnLatency(),
+                connInfo.getConnTimeout());
+        }
         //************************************************
         // Do not call internals::hid::reset() here
         //************************************************
@@ -178,7 +318,11 @@ public:
         // If a notification is sent when Windows reconnects it will overwrite the stored subscription value
         // in the NimBLE stack configuration with an invalid value which
         // results in notifications/indications not being sent.
+#if HID_ROUTER
+        internals::hid::router::update();
+#else
         OnConnected::notify();
+#endif
     }
 
     void onDisconnect(
@@ -187,10 +331,28 @@ public:
         int reason) override
     {
         connected = false;
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            if (bleConnection.requestTimer != nullptr)
+                esp_timer_stop(bleConnection.requestTimer);
+            bleConnection.connHandle = BLE_HS_CONN_HANDLE_NONE;
+            connectionManager.onDisconnected();
+        }
         startBLEAdvertising();
     };
 
-} connectionStatus;
+    void onConnParamsUpdate(NimBLEConnInfo &connInfo) override
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (bleConnection.requestTimer != nullptr)
+            esp_timer_stop(bleConnection.requestTimer);
+        connectionManager.onParametersUpdated(
+            connInfo.getConnInterval(),
+            connInfo.getConnLatency(),
+            connInfo.getConnTimeout());
+    }
+
+} serverCallbacks;
 
 // ----------------------------------------------------------------------------
 // HID FEATURE REQUEST callbacks
@@ -220,7 +382,7 @@ void FeatureReport::onWrite(
 {
     size_t size = pCharacteristic->getValue().length();
     const uint8_t *data = pCharacteristic->getValue().data();
-    internals::hid::common::onSetFeature(_reportID, data, size);
+    internals::hid::common::postSetFeature(_reportID, data, size);
 
     // Workaround for bug in NimBLE-Arduino v2.1.0
     onRead(pCharacteristic, connInfo);
@@ -285,7 +447,7 @@ void OutputReport::onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo
 {
     size_t size = pCharacteristic->getValue().length();
     const uint8_t *data = pCharacteristic->getValue().data();
-    internals::hid::common::onOutput(_reportID, data, size);
+    internals::hid::common::postOutput(_reportID, data, size);
 }
 
 // Attach to HID device
@@ -306,6 +468,14 @@ void OutputReport::attachTo(NimBLEHIDDeviceFix *hidDevice, uint8_t RID)
 
 void autoPowerOffCallback(void *unused)
 {
+#if HID_ROUTER
+    if (internals::hid::isConnected())
+    {
+        // Connected through another transport: check again later
+        esp_timer_start_once(autoPowerOffTimer, AUTO_POWER_OFF_DELAY_SECS * 1000000);
+        return;
+    }
+#endif
     PowerService::call::shutdown();
 }
 
@@ -313,7 +483,7 @@ void autoPowerOffCallback(void *unused)
 // Initialization
 // ----------------------------------------------------------------------------
 
-void internals::hid::begin(
+void HID_BLE_API::begin(
     std::string deviceName,
     std::string deviceManufacturer,
     bool enableAutoPowerOff,
@@ -333,6 +503,26 @@ void internals::hid::begin(
             ESP_ERROR_CHECK(esp_timer_create(&args, &autoPowerOffTimer));
         }
 
+        // Advertising initialization
+        {
+            esp_timer_create_args_t args;
+            args.callback = &advertisingTimerCallback;
+            args.arg = nullptr;
+            args.name = nullptr;
+            args.dispatch_method = ESP_TIMER_TASK;
+            ESP_ERROR_CHECK(esp_timer_create(&args, &advertisingTimer));
+        }
+
+        // Connection parameters initialization
+        {
+            esp_timer_create_args_t args;
+            args.callback = &connectionRequestTimeoutCallback;
+            args.arg = nullptr;
+            args.name = nullptr;
+            args.dispatch_method = ESP_TIMER_TASK;
+            ESP_ERROR_CHECK(esp_timer_create(&args, &bleConnection.requestTimer));
+        }
+
         // Stack initialization
         NimBLEDevice::init(deviceName);
         // NimBLEDevice::setSecurityAuth(BLE_SM_PAIR_AUTHREQ_BOND);
@@ -340,7 +530,7 @@ void internals::hid::begin(
         NimBLEDevice::setMTU(BLE_MTU_SIZE);
         setDefaultPhy(BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK);
         pServer = NimBLEDevice::createServer();
-        pServer->setCallbacks(&connectionStatus);
+        pServer->setCallbacks(&serverCallbacks);
 
         // HID initialization
         hidDevice = new NimBLEHIDDeviceFix(pServer);
@@ -352,7 +542,9 @@ void internals::hid::begin(
         hidDevice->setManufacturer(deviceManufacturer);
         hidDevice->setPnp(BLE_VENDOR_SOURCE, vendorID, productID, PRODUCT_REVISION);
         hidDevice->setHidInfo(0x00, 0x01);
-        hidDevice->setReportMap((uint8_t *)hid_descriptor, sizeof(hid_descriptor));
+        uint16_t descriptorSize;
+        const uint8_t *descriptor = internals::hid::common::getDescriptor(descriptorSize);
+        hidDevice->setReportMap((uint8_t *)descriptor, descriptorSize);
 
         // Add the serial number to the "Device Information" service
         uint64_t serialNumber;
@@ -378,14 +570,22 @@ void internals::hid::begin(
         // Create HID reports
         inputGamePad = hidDevice->getInputReport(RID_INPUT_GAMEPAD);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_CAPABILITIES, CAPABILITIES_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_HEALTH, HEALTH_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_CONFIG, CONFIG_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_BUTTONS_MAP, BUTTONS_MAP_REPORT_SIZE);
         FeatureReport::attachTo(hidDevice, RID_FEATURE_HARDWARE_ID, HARDWARE_ID_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_INPUT_PROFILE, INPUT_PROFILE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_EVENT_TRACE, EVENT_TRACE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_BUTTONS_MAP_BULK, BUTTONS_MAP_BULK_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_SETTINGS_IMAGE, SETTINGS_IMAGE_REPORT_SIZE);
+        FeatureReport::attachTo(hidDevice, RID_FEATURE_BLE_CONNECTION, BLE_CONNECTION_REPORT_SIZE);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_POWERTRAIN);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_ECU);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_RACE_CONTROL);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_GAUGES);
+        OutputReport::attachTo(hidDevice, RID_OUTPUT_TELEMETRY_DELTA);
         OutputReport::attachTo(hidDevice, RID_OUTPUT_PIXEL);
+        OutputReport::attachTo(hidDevice, RID_OUTPUT_PIXEL_FRAME);
 
         // Configure BLE advertising
         NimBLEAdvertising *pAdvertising = pServer->getAdvertising();
@@ -405,43 +605,47 @@ void internals::hid::begin(
 // HID profile
 // ----------------------------------------------------------------------------
 
-void internals::hid::reset()
+void HID_BLE_API::reset()
 {
-    if (connectionStatus.connected)
+    if (serverCallbacks.connected)
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
         internals::hid::common::onReset(report);
-        inputGamePad->setValue((const uint8_t *)report, GAMEPAD_REPORT_SIZE);
+        inputGamePad->setValue((const uint8_t *)report, internals::hid::common::getInputReportSize());
         inputGamePad->notify();
     }
 }
 
-void internals::hid::reportInput(
+void HID_BLE_API::reportInput(
     uint64_t inputsLow,
     uint64_t inputsHigh,
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
-    if (connectionStatus.connected)
+    if (serverCallbacks.connected)
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
-        internals::hid::common::onReportInput(
-            report,
-            notifyConfigChanges,
-            inputsLow,
-            inputsHigh,
-            POVstate,
-            leftAxis,
-            rightAxis,
-            clutchAxis);
-        inputGamePad->setValue((const uint8_t *)report, GAMEPAD_REPORT_SIZE);
-        inputGamePad->notify();
+        if (internals::hid::common::onReportInput(
+                report,
+                notifyConfigChanges,
+                inputsLow,
+                inputsHigh,
+                POVstate,
+                leftAxis,
+                rightAxis,
+                clutchAxis,
+                keepAlive))
+        {
+            inputGamePad->setValue((const uint8_t *)report, internals::hid::common::getInputReportSize());
+            inputGamePad->notify();
+        }
     }
 }
 
-void internals::hid::reportBatteryLevel(int level)
+void HID_BLE_API::reportBatteryLevel(int level)
 {
     if (hidDevice)
     {
@@ -453,18 +657,34 @@ void internals::hid::reportBatteryLevel(int level)
     }
 }
 
-void internals::hid::reportChangeInConfig()
+void HID_BLE_API::reportChangeInConfig()
 {
     notifyConfigChanges = true; // Will be reported in next input report
 }
 
-bool internals::hid::supportsCustomHardwareID() { return true; }
+bool HID_BLE_API::supportsCustomHardwareID() { return true; }
+
+// ----------------------------------------------------------------------------
+// Connection parameters
+// ----------------------------------------------------------------------------
+
+void HID_BLE_API::setConnectionProfile(BleConnectionProfile profile)
+{
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    connectionManager.setProfile(profile);
+}
+
+BleConnectionStatus HID_BLE_API::getConnectionStatus()
+{
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    return connectionManager.getStatus();
+}
 
 // ----------------------------------------------------------------------------
 // Status
 // ----------------------------------------------------------------------------
 
-bool internals::hid::isConnected()
+bool HID_BLE_API::isConnected()
 {
-    return connectionStatus.connected;
+    return serverCallbacks.connected;
 }
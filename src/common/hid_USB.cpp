@@ -19,7 +19,12 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include "HID_definitions.hpp"
+#include "HidRouter.hpp"
+#include "InputReportPacer.hpp"
 #include "esp_mac.h" // For esp_efuse_mac_get_default()
+#include "esp_timer.h"
+#include "tusb.h" // For tud_hid_n_report()
+#include <mutex>
 // #include <Arduino.h> // For debugging
 
 // ----------------------------------------------------------------------------
@@ -30,8 +35,10 @@ class SimWheelHIDImpl : public USBHIDDevice
 {
     virtual uint16_t _onGetDescriptor(uint8_t *buffer) override
     {
-        memcpy(buffer, hid_descriptor, sizeof(hid_descriptor));
-        return sizeof(hid_descriptor);
+        uint16_t size;
+        const uint8_t *descriptor = internals::hid::common::getDescriptor(size);
+        memcpy(buffer, descriptor, size);
+        return size;
     }
 
     virtual uint16_t _onGetFeature(uint8_t report_id, uint8_t *buffer, uint16_t len) override
@@ -44,16 +51,16 @@ class SimWheelHIDImpl : public USBHIDDevice
         // Note: for unknown reasons, output reports trigger this callback instead of _onOutput()
         if (report_id >= RID_OUTPUT_POWERTRAIN)
             // Output report
-            internals::hid::common::onOutput(report_id, buffer, len);
+            internals::hid::common::postOutput(report_id, buffer, len);
         else
             // Feature report
-            internals::hid::common::onSetFeature(report_id, buffer, len);
+            internals::hid::common::postSetFeature(report_id, buffer, len);
     }
 
     virtual void _onOutput(uint8_t report_id, const uint8_t *buffer, uint16_t len) override
     {
         // Note: never gets called unless report_id is zero. Reason unknown.
-        internals::hid::common::onOutput(report_id, buffer, len);
+        internals::hid::common::postOutput(report_id, buffer, len);
     }
 };
 
@@ -65,11 +72,87 @@ static bool notifyConfigChanges = false;
 USBHID hidDevice;
 SimWheelHIDImpl simWheelHID;
 
+// ----------------------------------------------------------------------------
+// Non-blocking send
+// ----------------------------------------------------------------------------
+
+class USBInputReportEndpoint : public InputReportEndpoint
+{
+public:
+    virtual bool sendInputReport(const uint8_t *report, uint8_t size) override
+    {
+        return tud_hid_n_ready(0) &&
+               tud_hid_n_report(0, RID_INPUT_GAMEPAD, report, size);
+    }
+} inputReportEndpoint;
+
+// Latest input report not sent yet (see InputReportPacer.hpp)
+static std::mutex pendingReportMutex;
+static InputReportPacer inputReportPacer(inputReportEndpoint);
+static esp_timer_handle_t flushTimer = nullptr;
+
+/**
+ * @brief Send the pending input report if the endpoint is free and
+ *        the report period has elapsed. Otherwise, retry later.
+ *
+ * @note Must be called with pendingReportMutex taken.
+ *       Never waits for the host computer.
+ */
+static void flushPendingReport()
+{
+    int64_t wait = inputReportPacer.flush(esp_timer_get_time());
+    if ((wait > 0) && (flushTimer != nullptr))
+        // Note: does nothing if the timer is already running
+        esp_timer_start_once(flushTimer, wait);
+}
+
+static void flushTimerCallback(void *unused)
+{
+    std::lock_guard<std::mutex> lock(pendingReportMutex);
+    flushPendingReport();
+}
+
+/**
+ * @brief Queue an input report for sending
+ *
+ * @note Replaces any pending input report, since it is outdated,
+ *       but keeps its feature notification
+ */
+static void sendInputReport(const uint8_t *report, uint8_t size)
+{
+    std::lock_guard<std::mutex> lock(pendingReportMutex);
+    inputReportPacer.post(report, size);
+    flushPendingReport();
+}
+
+// ----------------------------------------------------------------------------
+// USB events
+// ----------------------------------------------------------------------------
+
+#if HID_ROUTER
+/**
+ * @brief Report USB status changes to the router
+ *
+ * @note The router raises the connection events and fails over
+ *       to another transport when the USB host is gone.
+ *       Self-powered boards are not detached when the cable is unplugged:
+ *       the bus is just suspended.
+ */
+static void onUSBEvent(
+    void *arg,
+    esp_event_base_t event_base,
+    int32_t event_id,
+    void *event_data)
+{
+    internals::hid::router::update();
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // Initialization
 // ----------------------------------------------------------------------------
 
-void internals::hid::begin(
+void HID_USB_API::begin(
     std::string deviceName,
     std::string deviceManufacturer,
     bool enableAutoPowerOff,
@@ -90,11 +173,31 @@ void internals::hid::begin(
             snprintf(serialAsStr,9,"%08llX",serialNumber);
             USB.serialNumber(serialAsStr);
         }
-        hidDevice.addDevice(&simWheelHID, sizeof(hid_descriptor));
+        uint16_t descriptorSize;
+        internals::hid::common::getDescriptor(descriptorSize);
+        hidDevice.addDevice(&simWheelHID, descriptorSize);
+        inputReportPacer.setPeriod(1000000 / internals::hid::common::getUSBReportRate());
+        if (flushTimer == nullptr)
+        {
+            esp_timer_create_args_t args;
+            args.callback = &flushTimerCallback;
+            args.arg = nullptr;
+            args.name = nullptr;
+            args.dispatch_method = ESP_TIMER_TASK;
+            ESP_ERROR_CHECK(esp_timer_create(&args, &flushTimer));
+        }
+#if HID_ROUTER
+        USB.onEvent(ARDUINO_USB_STARTED_EVENT, onUSBEvent);
+        USB.onEvent(ARDUINO_USB_STOPPED_EVENT, onUSBEvent);
+        USB.onEvent(ARDUINO_USB_SUSPEND_EVENT, onUSBEvent);
+        USB.onEvent(ARDUINO_USB_RESUME_EVENT, onUSBEvent);
+#endif
         hidDevice.begin();
         USB.begin();
+#if !HID_ROUTER
         OnConnected::notify();
-        internals::hid::reset();
+#endif
+        HID_USB_API::reset();
     }
 }
 
@@ -102,57 +205,78 @@ void internals::hid::begin(
 // HID profile
 // ----------------------------------------------------------------------------
 
-void internals::hid::reset()
+void HID_USB_API::reset()
 {
-    if (hidDevice.ready())
+    if (tud_mounted())
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
         internals::hid::common::onReset(report);
-        hidDevice.SendReport(RID_INPUT_GAMEPAD, report, GAMEPAD_REPORT_SIZE);
+        sendInputReport(report, internals::hid::common::getInputReportSize());
     }
 }
 
-void internals::hid::reportInput(
+void HID_USB_API::reportInput(
     uint64_t inputsLow,
     uint64_t inputsHigh,
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis)
+    uint8_t clutchAxis,
+    bool keepAlive)
 {
-    if (hidDevice.ready())
+    if (tud_mounted())
     {
         uint8_t report[GAMEPAD_REPORT_SIZE];
-        internals::hid::common::onReportInput(
-            report,
-            notifyConfigChanges,
-            inputsLow,
-            inputsHigh,
-            POVstate,
-            leftAxis,
-            rightAxis,
-            clutchAxis);
-        hidDevice.SendReport(RID_INPUT_GAMEPAD, report, GAMEPAD_REPORT_SIZE);
+        if (internals::hid::common::onReportInput(
+                report,
+                notifyConfigChanges,
+                inputsLow,
+                inputsHigh,
+                POVstate,
+                leftAxis,
+                rightAxis,
+                clutchAxis,
+                keepAlive))
+        {
+            sendInputReport(report, internals::hid::common::getInputReportSize());
+        }
     }
 }
 
-void internals::hid::reportBatteryLevel(int level)
+void HID_USB_API::reportBatteryLevel(int level)
 {
     // Do nothing
 }
 
-void internals::hid::reportChangeInConfig()
+void HID_USB_API::reportChangeInConfig()
 {
     notifyConfigChanges = true; // Will be reported in next input report
 }
 
-bool internals::hid::supportsCustomHardwareID() { return false; }
+bool HID_USB_API::supportsCustomHardwareID() { return false; }
+
+// ----------------------------------------------------------------------------
+// Connection parameters
+// ----------------------------------------------------------------------------
+
+void HID_USB_API::setConnectionProfile(BleConnectionProfile profile)
+{
+    // Not supported
+}
+
+BleConnectionStatus HID_USB_API::getConnectionStatus()
+{
+    return BleConnectionStatus();
+}
 
 // ----------------------------------------------------------------------------
 // Status
 // ----------------------------------------------------------------------------
 
-bool internals::hid::isConnected()
+bool HID_USB_API::isConnected()
 {
-    return hidDevice.ready();
+    // Note: hidDevice.ready() is false while the endpoint is busy.
+    // A suspended bus is also reported when the cable is unplugged
+    // from self-powered boards.
+    return tud_mounted() && !tud_suspended();
 }
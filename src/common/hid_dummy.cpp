@@ -22,10 +22,23 @@ void internals::hid::reportInput(
     uint8_t POVstate,
     uint8_t leftAxis,
     uint8_t rightAxis,
-    uint8_t clutchAxis) {}
+    uint8_t clutchAxis,
+    bool keepAlive) {}
 
 void internals::hid::reset() {}
 
+static BleConnectionStatus connectionStatus;
+
+void internals::hid::setConnectionProfile(BleConnectionProfile profile)
+{
+    connectionStatus.profile = profile;
+}
+
+BleConnectionStatus internals::hid::getConnectionStatus()
+{
+    return connectionStatus;
+}
+
 void internals::hid::begin(
     std::string deviceName,
     std::string deviceManufacturer,
@@ -0,0 +1,282 @@
+/**
+ * @file hid_router.cpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief HID implementation over simultaneous USB and BLE transports
+ *
+ * @note Input reports go through the connected transport with the lowest
+ *       latency (USB first). Output and feature reports are accepted
+ *       from any transport, since they go straight to `hid::common`.
+ *       The transports report status changes to the router, which is
+ *       the only one raising the OnConnected and OnDisconnected events.
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "SimWheel.hpp"
+#include "SimWheelInternals.hpp"
+#include "InternalServices.hpp"
+#include "HID_definitions.hpp"
+#include "HidRouter.hpp"
+
+#include <mutex>
+
+//-------------------------------------------------------------------
+// Globals
+//-------------------------------------------------------------------
+
+/**
+ * @brief A transport
+ *
+ */
+typedef struct
+{
+    bool (*isConnected)();
+    void (*reportInput)(
+        uint64_t inputsLow,
+        uint64_t inputsHigh,
+        uint8_t POVstate,
+        uint8_t leftAxis,
+        uint8_t rightAxis,
+        uint8_t clutchAxis,
+        bool keepAlive);
+    void (*reset)();
+    void (*reportChangeInConfig)();
+} HidTransport;
+
+// Sorted by latency, lowest first. Indexes match the route constants.
+static const HidTransport transports[] = {
+    {internals::hid::usb::isConnected,
+     internals::hid::usb::reportInput,
+     internals::hid::usb::reset,
+     internals::hid::usb::reportChangeInConfig},
+    {internals::hid::ble::isConnected,
+     internals::hid::ble::reportInput,
+     internals::hid::ble::reset,
+     internals::hid::ble::reportChangeInConfig}};
+
+#define TRANSPORT_COUNT (sizeof(transports) / sizeof(HidTransport))
+
+static std::mutex routeMutex;
+static uint8_t currentRoute = internals::hid::router::NO_ROUTE;
+
+// Last input state, sent again to a new route
+static uint64_t lastInputsLow = 0ULL;
+static uint64_t lastInputsHigh = 0ULL;
+static uint8_t lastPOVstate = 0;
+static uint8_t lastLeftAxis = CLUTCH_NONE_VALUE;
+static uint8_t lastRightAxis = CLUTCH_NONE_VALUE;
+static uint8_t lastClutchAxis = CLUTCH_NONE_VALUE;
+
+//-------------------------------------------------------------------
+// Routing
+//-------------------------------------------------------------------
+
+/**
+ * @brief Select the connected transport with the lowest latency
+ *
+ * @note Must be called with routeMutex taken. If the route changes,
+ *       the last input state is sent to the new route.
+ *
+ * @return true If the route changed
+ */
+static bool updateRoute()
+{
+    uint8_t route = internals::hid::router::NO_ROUTE;
+    for (uint8_t i = 0; i < TRANSPORT_COUNT; i++)
+        if (transports[i].isConnected())
+        {
+            route = i;
+            break;
+        }
+    if (route == currentRoute)
+        return false;
+    currentRoute = route;
+    if (route != internals::hid::router::NO_ROUTE)
+    {
+        // The host computer behind the new route does not know the input state
+        // and may hold an outdated configuration
+        internals::hid::common::forgetLastInputReport();
+        transports[route].reportChangeInConfig();
+        transports[route].reportInput(
+            lastInputsLow,
+            lastInputsHigh,
+            lastPOVstate,
+            lastLeftAxis,
+            lastRightAxis,
+            lastClutchAxis,
+            false);
+    }
+    return true;
+}
+
+/**
+ * @brief Raise the connection events on behalf of the transports
+ *
+ * @note Must be called with routeMutex released, since subscribers
+ *       may call back into this module.
+ *
+ * @param route Route selected by updateRoute()
+ */
+static void notifyRouteChange(uint8_t route)
+{
+    if (route == internals::hid::router::NO_ROUTE)
+        OnDisconnected::notify();
+    else
+        OnConnected::notify();
+}
+
+void internals::hid::router::update()
+{
+    uint8_t route;
+    {
+        std::lock_guard<std::mutex> lock(routeMutex);
+        if (!updateRoute())
+            return;
+        route = currentRoute;
+    }
+    notifyRouteChange(route);
+}
+
+uint8_t internals::hid::router::getRoute()
+{
+    std::lock_guard<std::mutex> lock(routeMutex);
+    return currentRoute;
+}
+
+//-------------------------------------------------------------------
+// Initialization
+//-------------------------------------------------------------------
+
+void internals::hid::begin(
+    std::string deviceName,
+    std::string deviceManufacturer,
+    bool enableAutoPowerOff,
+    uint16_t vendorID,
+    uint16_t productID)
+{
+    internals::hid::usb::begin(
+        deviceName,
+        deviceManufacturer,
+        enableAutoPowerOff,
+        vendorID,
+        productID);
+    internals::hid::ble::begin(
+        deviceName,
+        deviceManufacturer,
+        enableAutoPowerOff,
+        vendorID,
+        productID);
+    // Initial status
+    notifyRouteChange(internals::hid::router::getRoute());
+}
+
+//-------------------------------------------------------------------
+// HID profile
+//-------------------------------------------------------------------
+
+void internals::hid::reset()
+{
+    uint8_t route;
+    {
+        std::lock_guard<std::mutex> lock(routeMutex);
+        lastInputsLow = 0ULL;
+        lastInputsHigh = 0ULL;
+        lastPOVstate = 0;
+        lastLeftAxis = CLUTCH_NONE_VALUE;
+        lastRightAxis = CLUTCH_NONE_VALUE;
+        lastClutchAxis = CLUTCH_NONE_VALUE;
+        route = currentRoute;
+        if (!updateRoute())
+        {
+            if (route != internals::hid::router::NO_ROUTE)
+                transports[route].reset();
+            return;
+        }
+        route = currentRoute;
+    }
+    notifyRouteChange(route);
+}
+
+void internals::hid::reportInput(
+    uint64_t inputsLow,
+    uint64_t inputsHigh,
+    uint8_t POVstate,
+    uint8_t leftAxis,
+    uint8_t rightAxis,
+    uint8_t clutchAxis,
+    bool keepAlive)
+{
+    uint8_t route;
+    {
+        std::lock_guard<std::mutex> lock(routeMutex);
+        lastInputsLow = inputsLow;
+        lastInputsHigh = inputsHigh;
+        lastPOVstate = POVstate;
+        lastLeftAxis = leftAxis;
+        lastRightAxis = rightAxis;
+        lastClutchAxis = clutchAxis;
+        route = currentRoute;
+        // Note: a new route gets this input state at once
+        if (!updateRoute())
+        {
+            if (route != internals::hid::router::NO_ROUTE)
+                transports[route].reportInput(
+                    inputsLow,
+                    inputsHigh,
+                    POVstate,
+                    leftAxis,
+                    rightAxis,
+                    clutchAxis,
+                    keepAlive);
+            return;
+        }
+        route = currentRoute;
+    }
+    notifyRouteChange(route);
+}
+
+void internals::hid::reportBatteryLevel(int level)
+{
+    internals::hid::usb::reportBatteryLevel(level);
+    internals::hid::ble::reportBatteryLevel(level);
+}
+
+void internals::hid::reportChangeInConfig()
+{
+    // The flag is cleared by the next input report at each transport
+    internals::hid::usb::reportChangeInConfig();
+    internals::hid::ble::reportChangeInConfig();
+}
+
+bool internals::hid::supportsCustomHardwareID()
+{
+    return internals::hid::usb::supportsCustomHardwareID() ||
+           internals::hid::ble::supportsCustomHardwareID();
+}
+
+void internals::hid::setConnectionProfile(BleConnectionProfile profile)
+{
+    internals::hid::ble::setConnectionProfile(profile);
+}
+
+BleConnectionStatus internals::hid::getConnectionStatus()
+{
+    return internals::hid::ble::getConnectionStatus();
+}
+
+//-------------------------------------------------------------------
+// Status
+//-------------------------------------------------------------------
+
+bool internals::hid::isConnected()
+{
+    return internals::hid::usb::isConnected() ||
+           internals::hid::ble::isConnected();
+}
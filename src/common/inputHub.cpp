@@ -17,6 +17,11 @@
 #include "SimWheelInternals.hpp"
 #include "InternalServices.hpp"
 #include "SimWheel.hpp"
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <functional>
+#include <chrono>
 
 // #include <iostream> // For debug
 
@@ -26,25 +31,25 @@
 
 // Related to ALT buttons
 
-static uint64_t altBitmap = 0ULL;
+static InputBitmap altBitmap = NO_INPUTS;
 
 // Related to clutch
 
 #define CALIBRATION_INCREMENT 3
-static uint64_t calibrateUpBitmap = 0ULL;
-static uint64_t calibrateDownBitmap = 0ULL;
-static uint64_t leftClutchBitmap = 0ULL;
-static uint64_t rightClutchBitmap = 0ULL;
-static uint64_t clutchInputMask = ~0ULL;
+static InputBitmap calibrateUpBitmap = NO_INPUTS;
+static InputBitmap calibrateDownBitmap = NO_INPUTS;
+static InputBitmap leftClutchBitmap = NO_INPUTS;
+static InputBitmap rightClutchBitmap = NO_INPUTS;
+static InputBitmap clutchInputMask = ALL_INPUTS;
 
 // Related to wheel functions
 
-static uint64_t cycleALTWorkingModeBitmap = 0ULL;
-static uint64_t cycleClutchWorkingModeBitmap = 0ULL;
-static uint64_t cmdAxisAutocalibrationBitmap = 0ULL;
+static InputBitmap cycleALTWorkingModeBitmap = NO_INPUTS;
+static InputBitmap cycleClutchWorkingModeBitmap = NO_INPUTS;
+static InputBitmap cmdAxisAutocalibrationBitmap = NO_INPUTS;
 // static uint64_t cmdBatteryRecalibrationBitmap = 0ULL;
-static uint64_t cycleDPADWorkingModeBitmap = 0ULL;
-static uint64_t cycleSecurityLockBitmap = 0ULL;
+static InputBitmap cycleDPADWorkingModeBitmap = NO_INPUTS;
+static InputBitmap cycleSecurityLockBitmap = NO_INPUTS;
 
 // Related to POV buttons
 
@@ -57,15 +62,15 @@ static uint64_t cycleSecurityLockBitmap = 0ULL;
 #define DPAD_DOWN_LEFT 6
 #define DPAD_LEFT 7
 #define DPAD_UP_LEFT 8
-static uint64_t dpadBitmap[9] = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
-static uint64_t dpadNegMask = 0ULL;
-static uint64_t dpadMask = ~0ULL;
+static InputBitmap dpadBitmap[9] = {};
+static InputBitmap dpadNegMask = NO_INPUTS;
+static InputBitmap dpadMask = ALL_INPUTS;
 
 // Related to the neutral gear
 
 static bool neutralWasEngaged = false;
-static uint64_t neutralSwitchBitmap = 0ULL;
-static uint64_t neutralCombinationBitmap = 0ULL;
+static InputBitmap neutralSwitchBitmap = NO_INPUTS;
+static InputBitmap neutralCombinationBitmap = NO_INPUTS;
 
 // Related to coded switches
 
@@ -78,12 +83,17 @@ struct CodedSwitch
     InputNumber bit4 = UNSPECIFIED::VALUE;
     InputNumber bit8 = UNSPECIFIED::VALUE;
     InputNumber bit16 = UNSPECIFIED::VALUE;
-    uint64_t mask = ~0ULL;
-    uint64_t decodedMask = ~0ULL;
+    InputBitmap mask = ALL_INPUTS;
+    InputBitmap decodedMask = ALL_INPUTS;
 };
 
 static std::vector<CodedSwitch> _codedSwitches;
 
+// Related to the event trace
+
+static InputEventTrace eventTrace;
+static std::atomic<bool> eventTracing{false};
+
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 // Public API
@@ -100,8 +110,8 @@ void inputHub::clutch::inputs(
     if (leftInputNumber == rightInputNumber)
         throw std::runtime_error("You can not assign the same input number for the left and right clutch paddles");
 
-    leftClutchBitmap = (uint64_t)leftInputNumber;
-    rightClutchBitmap = (uint64_t)rightInputNumber;
+    leftClutchBitmap = (InputBitmap)leftInputNumber;
+    rightClutchBitmap = (InputBitmap)rightInputNumber;
     clutchInputMask = ~(leftClutchBitmap | rightClutchBitmap);
     if (DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_ANALOG))
     {
@@ -123,18 +133,18 @@ void inputHub::clutch::bitePointInputs(
         throw std::runtime_error(
             "You can not assign the same input number for increase and decrease bite point");
 
-    calibrateUpBitmap = (uint64_t)increase;
-    calibrateDownBitmap = (uint64_t)decrease;
+    calibrateUpBitmap = (InputBitmap)increase;
+    calibrateDownBitmap = (InputBitmap)decrease;
 }
 
 void inputHub::clutch::cycleWorkingModeInputs(InputNumberCombination inputNumbers)
 {
-    cycleClutchWorkingModeBitmap = (uint64_t)inputNumbers;
+    cycleClutchWorkingModeBitmap = (InputBitmap)inputNumbers;
 }
 
 void inputHub::clutch::cmdRecalibrateAxisInputs(InputNumberCombination inputNumbers)
 {
-    cmdAxisAutocalibrationBitmap = (uint64_t)inputNumbers;
+    cmdAxisAutocalibrationBitmap = (InputBitmap)inputNumbers;
 }
 
 //-------------------------------------------------------------------
@@ -151,45 +161,45 @@ void inputHub::dpad::inputs(
         (padRightNumber == UNSPECIFIED::VALUE))
         throw invalid_input_number();
 
-    dpadBitmap[DPAD_UP] = (uint64_t)(padUpNumber);
-    dpadBitmap[DPAD_DOWN] = (uint64_t)(padDownNumber);
-    dpadBitmap[DPAD_LEFT] = (uint64_t)(padLeftNumber);
-    dpadBitmap[DPAD_RIGHT] = (uint64_t)(padRightNumber);
+    dpadBitmap[DPAD_UP] = (InputBitmap)(padUpNumber);
+    dpadBitmap[DPAD_DOWN] = (InputBitmap)(padDownNumber);
+    dpadBitmap[DPAD_LEFT] = (InputBitmap)(padLeftNumber);
+    dpadBitmap[DPAD_RIGHT] = (InputBitmap)(padRightNumber);
     dpadBitmap[DPAD_UP_LEFT] = dpadBitmap[DPAD_UP] | dpadBitmap[DPAD_LEFT];
     dpadBitmap[DPAD_UP_RIGHT] = dpadBitmap[DPAD_UP] | dpadBitmap[DPAD_RIGHT];
     dpadBitmap[DPAD_DOWN_LEFT] = dpadBitmap[DPAD_DOWN] | dpadBitmap[DPAD_LEFT];
     dpadBitmap[DPAD_DOWN_RIGHT] = dpadBitmap[DPAD_DOWN] | dpadBitmap[DPAD_RIGHT];
 
-    dpadNegMask = 0ULL;
+    dpadNegMask = NO_INPUTS;
     for (int n = 1; n < 9; n++)
         dpadNegMask |= dpadBitmap[n];
     dpadMask = ~dpadNegMask;
-    DeviceCapabilities::setFlag(DeviceCapability::DPAD, (dpadNegMask != 0ULL));
+    DeviceCapabilities::setFlag(DeviceCapability::DPAD, (dpadNegMask != NO_INPUTS));
 }
 
 void inputHub::dpad::cycleWorkingModeInputs(InputNumberCombination inputNumbers)
 {
-    cycleDPADWorkingModeBitmap = (uint64_t)(inputNumbers);
+    cycleDPADWorkingModeBitmap = (InputBitmap)(inputNumbers);
 }
 
 //-------------------------------------------------------------------
 
 void inputHub::altButtons::inputs(InputNumberCombination inputNumbers)
 {
-    altBitmap = (uint64_t)(inputNumbers);
-    DeviceCapabilities::setFlag(DeviceCapability::ALT, (altBitmap != 0ULL));
+    altBitmap = (InputBitmap)(inputNumbers);
+    DeviceCapabilities::setFlag(DeviceCapability::ALT, (altBitmap != NO_INPUTS));
 }
 
 void inputHub::altButtons::cycleWorkingModeInputs(InputNumberCombination inputNumbers)
 {
-    cycleALTWorkingModeBitmap = (uint64_t)(inputNumbers);
+    cycleALTWorkingModeBitmap = (InputBitmap)(inputNumbers);
 }
 
 //-------------------------------------------------------------------
 
 void inputHub::securityLock::cycleWorkingModeInputs(InputNumberCombination inputNumbers)
 {
-    cycleSecurityLockBitmap = (uint64_t)(inputNumbers);
+    cycleSecurityLockBitmap = (InputBitmap)(inputNumbers);
 }
 
 //-------------------------------------------------------------------
@@ -202,8 +212,8 @@ void inputHub::neutralGear::set(
         throw std::runtime_error(
             "For neutral gear, a combination of two or more hardware inputs is required");
     neutral.book();
-    neutralSwitchBitmap = (uint64_t)neutral;
-    neutralCombinationBitmap = (uint64_t)combination;
+    neutralSwitchBitmap = (InputBitmap)neutral;
+    neutralCombinationBitmap = (InputBitmap)combination;
 }
 
 //-------------------------------------------------------------------
@@ -337,6 +347,371 @@ void inputHub::codedSwitch::add(
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 
+//-------------------------------------------------------------------
+// Configuration snapshot
+//-------------------------------------------------------------------
+
+struct InputHubConfig;
+
+/**
+ * @brief Data computed by the filter pipeline for a single input event
+ *
+ */
+struct InputHubFrame
+{
+    /// @brief True if ALT mode is engaged by the user
+    bool isALTRequested = false;
+    /// @brief Combined clutch position
+    uint8_t clutchAxis = CLUTCH_NONE_VALUE;
+    /// @brief POV (DPAD) input
+    uint8_t povInput = DPAD_CENTERED;
+    /// @brief Configuration snapshot in use
+    const InputHubConfig *config;
+};
+
+/**
+ * @brief A stage in the filter pipeline
+ *
+ * @return true To continue with the next stage
+ * @return false To discard the input event
+ */
+typedef bool (*InputHubFilter)(DecouplingEvent &input, InputHubFrame &frame);
+
+/**
+ * @brief Sequence of filters required by the current configuration
+ *        and working modes
+ *
+ */
+struct InputHubPipeline
+{
+#define INPUT_HUB_MAX_FILTER_COUNT 8
+    InputHubFilter filter[INPUT_HUB_MAX_FILTER_COUNT];
+    uint8_t count = 0;
+
+    void add(InputHubFilter stage)
+    {
+        assert(count < INPUT_HUB_MAX_FILTER_COUNT && "Too many input hub filters");
+        filter[count++] = stage;
+    }
+};
+
+/**
+ * @brief User settings for the input hub
+ *
+ */
+struct InputHubSettings
+{
+    bool securityLock = false;
+    uint8_t bitePoint = CLUTCH_NONE_VALUE;
+    ClutchWorkingMode clutchWorkingMode = ClutchWorkingMode::CLUTCH;
+    AltButtonsWorkingMode altButtonsWorkingMode = AltButtonsWorkingMode::ALT;
+    DPadWorkingMode dpadWorkingMode = DPadWorkingMode::Navigation;
+};
+
+/**
+ * @brief Immutable configuration snapshot
+ *
+ */
+struct InputHubConfig
+{
+    InputHubSettings settings;
+    InputHubPipeline pipeline;
+};
+
+// Configuration snapshots.
+// Writers are serialized by a mutex. The input hub is the only reader
+// on the input path and it never blocks.
+// Three buffers: one published, one in use by the input hub
+// (may be the same) and another one for the next snapshot.
+static InputHubConfig _config[3];
+static std::atomic<InputHubConfig *> _activeConfig = &_config[0];
+static std::atomic<InputHubConfig *> _configInUse = nullptr;
+static std::mutex _configMutex;
+
+// Commands issued by the input hub through button combinations.
+// The input hub never takes _configMutex: the commands are applied
+// to the published snapshot by the next writer holding it.
+#define PENDING_CYCLE_CLUTCH 0
+#define PENDING_CYCLE_ALT 1
+#define PENDING_CYCLE_DPAD 2
+#define PENDING_CYCLE_LOCK 3
+#define PENDING_CYCLE_COUNT 4
+// Count of pending cycles of each working mode
+static std::atomic<uint32_t> _pendingCycles[PENDING_CYCLE_COUNT];
+// Pending bite point steps (positive to increase)
+static std::atomic<int32_t> _pendingBitePointSteps = 0;
+
+/**
+ * @brief Changes in the user settings caused by pending commands
+ *
+ */
+struct InputHubCommandEffects
+{
+    bool clutchWorkingMode = false;
+    bool altButtonsWorkingMode = false;
+    bool dpadWorkingMode = false;
+    bool securityLock = false;
+    bool bitePoint = false;
+
+    bool any() const
+    {
+        return clutchWorkingMode || altButtonsWorkingMode ||
+               dpadWorkingMode || securityLock || bitePoint;
+    }
+};
+
+void inputHubFillPipeline(const InputHubSettings &settings, InputHubPipeline &pipeline);
+
+/**
+ * @brief Publish a new configuration snapshot
+ *
+ * @note _configMutex must be locked
+ *
+ * @param settings User settings in the new snapshot
+ */
+static void inputHubPublishConfig(const InputHubSettings &settings)
+{
+    InputHubConfig *active = _activeConfig.load();
+    InputHubConfig *inUse = _configInUse.load();
+    InputHubConfig *next = &_config[0];
+    while ((next == active) || (next == inUse))
+        next++;
+    next->settings = settings;
+    inputHubFillPipeline(settings, next->pipeline);
+    _activeConfig.store(next);
+}
+
+/**
+ * @brief Apply the pending commands to the given settings
+ *
+ * @note _configMutex must be locked
+ *
+ * @param settings User settings to change
+ * @return InputHubCommandEffects Changed settings
+ */
+static InputHubCommandEffects inputHubApplyPendingCommands(InputHubSettings &settings)
+{
+    InputHubCommandEffects effects;
+    int32_t steps = _pendingBitePointSteps.exchange(0);
+    uint32_t count = _pendingCycles[PENDING_CYCLE_CLUTCH].exchange(0);
+    if (count)
+    {
+        settings.clutchWorkingMode = (ClutchWorkingMode)(((uint8_t)settings.clutchWorkingMode + count) %
+                                                         ((uint8_t)ClutchWorkingMode::_MAX_VALUE + 1));
+        effects.clutchWorkingMode = true;
+    }
+    count = _pendingCycles[PENDING_CYCLE_ALT].exchange(0);
+    if (count)
+    {
+        settings.altButtonsWorkingMode = (AltButtonsWorkingMode)(((uint8_t)settings.altButtonsWorkingMode + count) %
+                                                                 ((uint8_t)AltButtonsWorkingMode::_MAX_VALUE + 1));
+        effects.altButtonsWorkingMode = true;
+    }
+    count = _pendingCycles[PENDING_CYCLE_DPAD].exchange(0);
+    if (count)
+    {
+        settings.dpadWorkingMode = (DPadWorkingMode)(((uint8_t)settings.dpadWorkingMode + count) %
+                                                     ((uint8_t)DPadWorkingMode::_MAX_VALUE + 1));
+        effects.dpadWorkingMode = true;
+    }
+    count = _pendingCycles[PENDING_CYCLE_LOCK].exchange(0);
+    if (count)
+    {
+        settings.securityLock = settings.securityLock ^ (count & 1);
+        effects.securityLock = true;
+    }
+    if (steps)
+    {
+        int next = settings.bitePoint + steps * CALIBRATION_INCREMENT;
+        if (next > CLUTCH_FULL_VALUE)
+            next = CLUTCH_FULL_VALUE;
+        else if (next < CLUTCH_NONE_VALUE)
+            next = CLUTCH_NONE_VALUE;
+        effects.bitePoint = (next != settings.bitePoint);
+        settings.bitePoint = (uint8_t)next;
+    }
+    return effects;
+}
+
+/**
+ * @brief Raise the events caused by pending commands
+ *
+ * @note _configMutex must not be locked
+ *
+ * @param effects Changed settings
+ * @param bitePoint Bite point in the published snapshot
+ */
+static void inputHubNotifyCommandEffects(const InputHubCommandEffects &effects, uint8_t bitePoint)
+{
+    if (effects.clutchWorkingMode)
+        SaveSetting::notify(UserSetting::CLUTCH_WORKING_MODE);
+    if (effects.altButtonsWorkingMode)
+        SaveSetting::notify(UserSetting::ALT_WORKING_MODE);
+    if (effects.dpadWorkingMode)
+        SaveSetting::notify(UserSetting::DPAD_WORKING_MODE);
+    if (effects.securityLock)
+        SaveSetting::notify(UserSetting::SECURITY_LOCK);
+    if (effects.bitePoint)
+    {
+        OnBitePoint::notify(bitePoint);
+        SaveSetting::notify(UserSetting::BITE_POINT);
+    }
+}
+
+/**
+ * @brief Check for commands not applied yet
+ *
+ * @return true If there are pending commands
+ */
+static bool inputHubHasPendingCommands()
+{
+    for (uint8_t i = 0; i < PENDING_CYCLE_COUNT; i++)
+        if (_pendingCycles[i].load())
+            return true;
+    return (_pendingBitePointSteps.load() != 0);
+}
+
+/**
+ * @brief Apply pending commands unless another writer holds the mutex
+ *
+ * @note Never blocks. Every writer calls this after releasing the mutex,
+ *       so no command is left behind.
+ */
+static void inputHubRunPendingCommands()
+{
+    while (inputHubHasPendingCommands())
+    {
+        InputHubCommandEffects effects;
+        uint8_t bitePoint;
+        {
+            std::unique_lock<std::mutex> lock(_configMutex, std::try_to_lock);
+            if (!lock.owns_lock())
+                // The owner will run them
+                return;
+            InputHubSettings settings = _activeConfig.load()->settings;
+            effects = inputHubApplyPendingCommands(settings);
+            if (effects.any())
+                inputHubPublishConfig(settings);
+            bitePoint = settings.bitePoint;
+        }
+        inputHubNotifyCommandEffects(effects, bitePoint);
+    }
+}
+
+/**
+ * @brief Issue a command from the input hub
+ *
+ * @note Never blocks
+ *
+ * @param pendingCycle Working mode to cycle (PENDING_CYCLE_xxx)
+ */
+static void inputHubCycle(uint8_t pendingCycle)
+{
+    _pendingCycles[pendingCycle].fetch_add(1);
+    inputHubRunPendingCommands();
+}
+
+/**
+ * @brief Issue a bite point calibration step from the input hub
+ *
+ * @note Never blocks
+ *
+ * @param step 1 to increase, -1 to decrease
+ */
+static void inputHubStepBitePoint(int32_t step)
+{
+    _pendingBitePointSteps.fetch_add(step);
+    inputHubRunPendingCommands();
+}
+
+/**
+ * @brief Get the configuration snapshot for the input hub
+ *
+ * @note Must be paired with inputHubReleaseConfig()
+ *
+ * @return const InputHubConfig* Current configuration snapshot
+ */
+static const InputHubConfig *inputHubAcquireConfig()
+{
+    InputHubConfig *config;
+    do
+    {
+        config = _activeConfig.load();
+        _configInUse.store(config);
+    } while (config != _activeConfig.load());
+    return config;
+}
+
+/**
+ * @brief Tell writers that the configuration snapshot is not in use
+ *
+ */
+static inline void inputHubReleaseConfig()
+{
+    _configInUse.store(nullptr);
+}
+
+/**
+ * @brief Change user settings and publish a new configuration snapshot
+ *
+ * @param change Function to change the settings.
+ *               Returns true if something changed.
+ * @return true If a new snapshot was published
+ * @return false If there were no changes
+ */
+static bool inputHubUpdateSettings(std::function<bool(InputHubSettings &)> change)
+{
+    bool changed;
+    InputHubCommandEffects effects;
+    uint8_t bitePoint;
+    {
+        std::lock_guard<std::mutex> lock(_configMutex);
+        InputHubSettings settings = _activeConfig.load()->settings;
+        // Pending commands were issued first
+        effects = inputHubApplyPendingCommands(settings);
+        changed = change(settings);
+        if (changed || effects.any())
+            inputHubPublishConfig(settings);
+        bitePoint = settings.bitePoint;
+    }
+    inputHubNotifyCommandEffects(effects, bitePoint);
+    inputHubRunPendingCommands();
+    return changed;
+}
+
+/**
+ * @brief Get a copy of the current user settings
+ *
+ * @return InputHubSettings Current user settings
+ */
+static InputHubSettings inputHubGetSettings()
+{
+    // Note: pending commands are applied first
+    InputHubSettings result;
+    inputHubUpdateSettings(
+        [&result](InputHubSettings &settings)
+        {
+            result = settings;
+            return false;
+        });
+    return result;
+}
+
+/**
+ * @brief Publish a new configuration snapshot without changes
+ *        in the user settings
+ *
+ * @note Required after a change in the device capabilities
+ */
+void inputHubBuildPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(_configMutex);
+        inputHubPublishConfig(_activeConfig.load()->settings);
+    }
+    inputHubRunPendingCommands();
+}
+
 //-------------------------------------------------------------------
 // Service class
 //-------------------------------------------------------------------
@@ -344,42 +719,43 @@ void inputHub::codedSwitch::add(
 class InputHubServiceProvider : public InputHubService
 {
 public:
-    inline static bool securityLock = false;
-    inline static uint8_t bitePoint = CLUTCH_NONE_VALUE;
-    inline static ClutchWorkingMode clutchWorkingMode = ClutchWorkingMode::CLUTCH;
-    inline static AltButtonsWorkingMode altButtonsWorkingMode = AltButtonsWorkingMode::ALT;
-    inline static DPadWorkingMode dpadWorkingMode = DPadWorkingMode::Navigation;
-
     virtual bool getSecurityLock() override
     {
-        return securityLock;
+        return inputHubGetSettings().securityLock;
     }
 
     virtual uint8_t getBitePoint() override
     {
-        return bitePoint;
+        return inputHubGetSettings().bitePoint;
     }
 
     virtual ClutchWorkingMode getClutchWorkingMode() override
     {
-        return clutchWorkingMode;
+        return inputHubGetSettings().clutchWorkingMode;
     }
 
     virtual AltButtonsWorkingMode getAltButtonsWorkingMode() override
     {
-        return altButtonsWorkingMode;
+        return inputHubGetSettings().altButtonsWorkingMode;
     }
 
     virtual DPadWorkingMode getDPadWorkingMode() override
     {
-        return dpadWorkingMode;
+        return inputHubGetSettings().dpadWorkingMode;
     }
 
     virtual void setBitePoint(uint8_t value, bool save) override
     {
-        if ((value < CLUTCH_INVALID_VALUE) && (value != bitePoint))
+        if ((value < CLUTCH_INVALID_VALUE) &&
+            inputHubUpdateSettings(
+                [value](InputHubSettings &settings)
+                {
+                    if (value == settings.bitePoint)
+                        return false;
+                    settings.bitePoint = value;
+                    return true;
+                }))
         {
-            bitePoint = value;
             OnBitePoint::notify(value);
             if (save)
                 SaveSetting::notify(UserSetting::BITE_POINT);
@@ -388,115 +764,95 @@ public:
 
     virtual void setClutchWorkingMode(ClutchWorkingMode mode, bool save) override
     {
-        if (mode != clutchWorkingMode)
-        {
-            clutchWorkingMode = mode;
-            if (save)
-                SaveSetting::notify(UserSetting::CLUTCH_WORKING_MODE);
-        }
+        if (inputHubUpdateSettings(
+                [mode](InputHubSettings &settings)
+                {
+                    if (mode == settings.clutchWorkingMode)
+                        return false;
+                    settings.clutchWorkingMode = mode;
+                    return true;
+                }) &&
+            save)
+            SaveSetting::notify(UserSetting::CLUTCH_WORKING_MODE);
     }
 
     virtual void setAltButtonsWorkingMode(AltButtonsWorkingMode mode, bool save) override
     {
-        if (mode != altButtonsWorkingMode)
-        {
-            altButtonsWorkingMode = mode;
-            if (save)
-                SaveSetting::notify(UserSetting::ALT_WORKING_MODE);
-        }
+        if (inputHubUpdateSettings(
+                [mode](InputHubSettings &settings)
+                {
+                    if (mode == settings.altButtonsWorkingMode)
+                        return false;
+                    settings.altButtonsWorkingMode = mode;
+                    return true;
+                }) &&
+            save)
+            SaveSetting::notify(UserSetting::ALT_WORKING_MODE);
     }
 
     virtual void setDPadWorkingMode(DPadWorkingMode mode, bool save) override
     {
-        if (mode != dpadWorkingMode)
-        {
-            dpadWorkingMode = mode;
-            if (save)
-                SaveSetting::notify(UserSetting::DPAD_WORKING_MODE);
-        }
+        if (inputHubUpdateSettings(
+                [mode](InputHubSettings &settings)
+                {
+                    if (mode == settings.dpadWorkingMode)
+                        return false;
+                    settings.dpadWorkingMode = mode;
+                    return true;
+                }) &&
+            save)
+            SaveSetting::notify(UserSetting::DPAD_WORKING_MODE);
     }
 
     virtual void setSecurityLock(bool value, bool save) override
     {
-        if (securityLock != value)
-        {
-            securityLock = value;
-            if (save)
-                SaveSetting::notify(UserSetting::SECURITY_LOCK);
-        }
+        if (inputHubUpdateSettings(
+                [value](InputHubSettings &settings)
+                {
+                    if (value == settings.securityLock)
+                        return false;
+                    settings.securityLock = value;
+                    return true;
+                }) &&
+            save)
+            SaveSetting::notify(UserSetting::SECURITY_LOCK);
     }
 
-    static void cycleClutchWorkingMode()
+    virtual void setEventTrace(bool enable) override
     {
-        uint8_t next = (uint8_t)clutchWorkingMode + 1;
-        if (next > (uint8_t)ClutchWorkingMode::_MAX_VALUE)
-            next = 0;
-        clutchWorkingMode = (ClutchWorkingMode)next;
-        SaveSetting::notify(UserSetting::CLUTCH_WORKING_MODE);
+        eventTracing = enable;
     }
 
-    static void cycleAltButtonsWorkingMode()
+    virtual bool getEventTrace() override
     {
-        uint8_t next = (uint8_t)altButtonsWorkingMode + 1;
-        if (next > (uint8_t)AltButtonsWorkingMode::_MAX_VALUE)
-            next = 0;
-        altButtonsWorkingMode = (AltButtonsWorkingMode)next;
-        SaveSetting::notify(UserSetting::ALT_WORKING_MODE);
+        return eventTracing;
     }
 
-    static void cycleDPadWorkingMode()
+    virtual uint32_t getEventTraceCount() override
     {
-        uint8_t next = (uint8_t)dpadWorkingMode + 1;
-        if (next > (uint8_t)DPadWorkingMode::_MAX_VALUE)
-            next = 0;
-        dpadWorkingMode = (DPadWorkingMode)next;
-        SaveSetting::notify(UserSetting::DPAD_WORKING_MODE);
-    }
-
-    static void cycleSecurityLock()
-    {
-        securityLock = !securityLock;
-        SaveSetting::notify(UserSetting::SECURITY_LOCK);
-    }
-
-    static void increaseBitePoint()
-    {
-        if (bitePoint >= CLUTCH_FULL_VALUE)
-            return;
-        unsigned int next = bitePoint + CALIBRATION_INCREMENT;
-        if (next > CLUTCH_FULL_VALUE)
-            next = CLUTCH_FULL_VALUE;
-        bitePoint = (uint8_t)next;
-        OnBitePoint::notify(bitePoint);
-        SaveSetting::notify(UserSetting::BITE_POINT);
+        return eventTrace.count();
     }
 
-    static void decreaseBitePoint()
+    virtual bool getEventTraceEntry(uint32_t sequence, InputTraceEntry &entry) override
     {
-        if (bitePoint == CLUTCH_NONE_VALUE)
-            return;
-        int prev = bitePoint - CALIBRATION_INCREMENT;
-        if (prev < CLUTCH_NONE_VALUE)
-            prev = CLUTCH_NONE_VALUE;
-        bitePoint = (uint8_t)prev;
-        OnBitePoint::notify(bitePoint);
-        SaveSetting::notify(UserSetting::BITE_POINT);
+        return eventTrace.get(sequence, entry);
     }
 };
 
+//-------------------------------------------------------------------
 //-------------------------------------------------------------------
 // Get ready
 //-------------------------------------------------------------------
 
-void abortOnUnknownIN(uint64_t bitmap, std::string reason)
+void abortOnUnknownIN(InputBitmap bitmap, std::string reason)
 {
-    if (bitmap == 0ULL)
+    if (bitmap == NO_INPUTS)
         return;
-    uint64_t booked = InputNumber::booked();
-    for (uint8_t i = 0; i < 64; i++)
+    InputBitmap booked = InputNumber::booked();
+    for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
     {
-        uint64_t toCheck = (1ULL << i);
-        if ((bitmap & toCheck) && ((booked & toCheck) == 0ULL))
+        InputBitmap toCheck = inputBitmapOf(i);
+        if ((bitmap & toCheck) && ((booked & toCheck) == NO_INPUTS))
             throw unknown_input_number(reason);
     }
 }
@@ -514,27 +870,27 @@ void internals::inputHub::getReady()
 {
     for (CodedSwitch &csw : _codedSwitches)
     {
-        abortOnUnknownIN((uint64_t)csw.bit1, "Coded switch");
-        abortOnUnknownIN((uint64_t)csw.bit2, "Coded switch");
-        abortOnUnknownIN((uint64_t)csw.bit4, "Coded switch");
-        abortOnUnknownIN((uint64_t)csw.bit8, "Coded switch");
-        abortOnUnknownIN((uint64_t)csw.bit16, "Coded switch");
+        abortOnUnknownIN((InputBitmap)csw.bit1, "Coded switch");
+        abortOnUnknownIN((InputBitmap)csw.bit2, "Coded switch");
+        abortOnUnknownIN((InputBitmap)csw.bit4, "Coded switch");
+        abortOnUnknownIN((InputBitmap)csw.bit8, "Coded switch");
+        abortOnUnknownIN((InputBitmap)csw.bit16, "Coded switch");
         csw.bit1.unbook();
         csw.bit2.unbook();
         csw.bit4.unbook();
         csw.bit8.unbook();
         csw.bit16.unbook();
-        csw.mask = (uint64_t)csw.bit1 | (uint64_t)csw.bit2 | (uint64_t)csw.bit4 |
-                   (uint64_t)csw.bit8 | (uint64_t)csw.bit16;
+        csw.mask = (InputBitmap)csw.bit1 | (InputBitmap)csw.bit2 | (InputBitmap)csw.bit4 |
+                   (InputBitmap)csw.bit8 | (InputBitmap)csw.bit16;
         csw.mask = ~csw.mask;
     }
     for (CodedSwitch &csw : _codedSwitches)
     {
-        csw.decodedMask = ~0ULL;
+        csw.decodedMask = ALL_INPUTS;
         for (uint8_t i = 0; i < csw.size; i++)
         {
             csw.decodedIN[i].book();
-            csw.decodedMask &= ~(uint64_t)csw.decodedIN[i];
+            csw.decodedMask &= ~(InputBitmap)csw.decodedIN[i];
         }
     }
 
@@ -551,7 +907,7 @@ void internals::inputHub::getReady()
     abortOnUnknownIN(cycleSecurityLockBitmap, "cycle security lock working mode");
     if (DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_ANALOG))
     {
-        if (clutchInputMask == ~0ULL)
+        if (clutchInputMask == ALL_INPUTS)
             throw std::runtime_error(
                 "You have analog clutch paddles, but you forgot to call inputHub::clutch::inputs()");
     }
@@ -573,12 +929,13 @@ void internals::inputHub::getReady()
             throw std::runtime_error(
                 "There are no clutch paddles, but you called inputHub::clutch::cycleWorkingModeInputs()");
     }
-    if (!DeviceCapabilities::hasFlag(DeviceCapability::DPAD) && (cycleDPADWorkingModeBitmap != 0ULL))
+    if (!DeviceCapabilities::hasFlag(DeviceCapability::DPAD) && (cycleDPADWorkingModeBitmap != NO_INPUTS))
         throw std::runtime_error(
             "There is no DPAD, but you called inputHub::dpad::cycleWorkingModeInputs()");
-    if (!DeviceCapabilities::hasFlag(DeviceCapability::ALT) && (cycleALTWorkingModeBitmap != 0ULL))
+    if (!DeviceCapabilities::hasFlag(DeviceCapability::ALT) && (cycleALTWorkingModeBitmap != NO_INPUTS))
         throw std::runtime_error(
             "There are no ALT buttons, but you called inputHub::altButtons::cycleWorkingModeInputs()");
+    inputHubBuildPipeline();
     InputHubService::inject(new InputHubServiceProvider());
     OnStart::subscribe(inputHubStart);
 }
@@ -587,41 +944,42 @@ void internals::inputHub::getReady()
 // Input processing
 //-------------------------------------------------------------------
 
+//-------------------------------------------------------------------
+
 /**
  * @brief Decode binary-coded switches
  *
  * @example 0b111 -> 0b01000000
  */
-void inputHub_decode_bin_coded_switches(
-    uint64_t &globalState,
-    uint64_t &changes)
+bool inputHub_decode_bin_coded_switches(DecouplingEvent &input, InputHubFrame &)
 {
-    if (_codedSwitches.size() == 0)
-        return;
-    for (auto sw : _codedSwitches)
+    InputBitmap &globalState = input.rawInputBitmap;
+    InputBitmap &changes = input.rawInputChanges;
+    for (const CodedSwitch &sw : _codedSwitches)
     {
         uint8_t positionIndex = 0;
-        if ((uint64_t)sw.bit1 & globalState)
+        if ((InputBitmap)sw.bit1 & globalState)
             positionIndex = 1;
-        if ((uint64_t)sw.bit2 & globalState)
+        if ((InputBitmap)sw.bit2 & globalState)
             positionIndex += 2;
-        if ((uint64_t)sw.bit4 & globalState)
+        if ((InputBitmap)sw.bit4 & globalState)
             positionIndex += 4;
-        if ((sw.size > 15) && ((uint64_t)sw.bit8 & globalState))
+        if ((sw.size > 15) && ((InputBitmap)sw.bit8 & globalState))
             positionIndex += 8;
-        if ((sw.size > 31) && ((uint64_t)sw.bit16 & globalState))
+        if ((sw.size > 31) && ((InputBitmap)sw.bit16 & globalState))
             positionIndex += 16;
 
         // std::cout << "SW index: " << (int)positionIndex << std::endl;
 
-        uint64_t bitmap = (uint64_t)sw.decodedIN[positionIndex];
+        InputBitmap bitmap = (InputBitmap)sw.decodedIN[positionIndex];
         globalState &= sw.mask & sw.decodedMask;
         globalState |= bitmap;
-        bool changed = (changes & ~sw.mask);
+        bool changed = (bool)(changes & ~sw.mask);
         changes &= sw.mask & sw.decodedMask;
         if (changed)
-            changed |= bitmap;
+            changes |= bitmap;
     }
+    return true;
 }
 
 //-------------------------------------------------------------------
@@ -633,24 +991,24 @@ void inputHub_decode_bin_coded_switches(
  * @return false Otherwise
  */
 bool inputHub_commands_filter(
-    uint64_t globalState,
-    uint64_t changes)
+    InputBitmap globalState,
+    InputBitmap changes)
 {
     // Look for input events requesting a change in functionality
     // These input events never translate into a HID report
     if ((changes & cycleALTWorkingModeBitmap) && (globalState == cycleALTWorkingModeBitmap))
     {
-        InputHubServiceProvider::cycleAltButtonsWorkingMode();
+        inputHubCycle(PENDING_CYCLE_ALT);
         return true;
     }
     if ((changes & cycleClutchWorkingModeBitmap) && (globalState == cycleClutchWorkingModeBitmap))
     {
-        InputHubServiceProvider::cycleClutchWorkingMode();
+        inputHubCycle(PENDING_CYCLE_CLUTCH);
         return true;
     }
     if ((changes & cycleDPADWorkingModeBitmap) && (globalState == cycleDPADWorkingModeBitmap))
     {
-        InputHubServiceProvider::cycleDPadWorkingMode();
+        inputHubCycle(PENDING_CYCLE_DPAD);
         return true;
     }
     if ((changes & cmdAxisAutocalibrationBitmap) && (globalState == cmdAxisAutocalibrationBitmap))
@@ -666,12 +1024,27 @@ bool inputHub_commands_filter(
     // }
     if ((changes & cycleSecurityLockBitmap) && (globalState == cycleSecurityLockBitmap))
     {
-        InputHubServiceProvider::cycleSecurityLock();
+        inputHubCycle(PENDING_CYCLE_LOCK);
         return true;
     }
     return false;
 }
 
+/**
+ * @brief Pipeline stage for user commands
+ *
+ * @note Input events issuing a command are discarded
+ */
+bool inputHub_commands_stage(DecouplingEvent &input, InputHubFrame &)
+{
+    if (inputHub_commands_filter(input.rawInputBitmap, input.rawInputChanges))
+    {
+        internals::hid::reset();
+        return false;
+    }
+    return true;
+}
+
 //-------------------------------------------------------------------
 
 inline bool paddleIsPressed(uint8_t value)
@@ -688,313 +1061,421 @@ inline bool paddleIsReleased(uint8_t value)
  * @brief Executes bite point calibration from user input
  *
  */
-void inputHub_bitePointCalibration_filter(DecouplingEvent &input)
+inline void inputHub_bitePointCalibration(
+    DecouplingEvent &input,
+    bool isCalibrationInProgress)
 {
-    bool isCalibrationInProgress = false;
-    switch (InputHubServiceProvider::clutchWorkingMode)
-    {
-    case ClutchWorkingMode::CLUTCH:
-        isCalibrationInProgress =
-            paddleIsPressed(input.leftAxisValue) &&
-            paddleIsReleased(input.rightAxisValue);
-        isCalibrationInProgress =
-            isCalibrationInProgress ||
-            (paddleIsReleased(input.leftAxisValue) &&
-             paddleIsPressed(input.rightAxisValue));
-        break;
-    case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT:
-        isCalibrationInProgress =
-            paddleIsReleased(input.leftAxisValue) &&
-            paddleIsPressed(input.rightAxisValue);
-        break;
-    case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT:
-        isCalibrationInProgress =
-            paddleIsPressed(input.leftAxisValue) &&
-            paddleIsReleased(input.rightAxisValue);
-        break;
-    default:
-        break;
-    }
-
     if (isCalibrationInProgress)
     {
         // One and only one clutch paddle is pressed
         // Check for bite point calibration events
         if ((calibrateUpBitmap & input.rawInputChanges) &&
             (calibrateUpBitmap & input.rawInputBitmap))
-            InputHubServiceProvider::increaseBitePoint();
+            inputHubStepBitePoint(1);
         else if ((calibrateDownBitmap & input.rawInputChanges) &&
                  (calibrateDownBitmap & input.rawInputBitmap))
-            InputHubServiceProvider::decreaseBitePoint();
+            inputHubStepBitePoint(-1);
         input.rawInputBitmap &= (~(calibrateDownBitmap | calibrateUpBitmap));
         input.rawInputChanges &= (~(calibrateDownBitmap | calibrateUpBitmap));
     }
 }
 
+/**
+ * @brief Bite point calibration in "clutch" working mode
+ *
+ */
+bool inputHub_bitePointCalibration_clutch_filter(DecouplingEvent &input, InputHubFrame &)
+{
+    inputHub_bitePointCalibration(
+        input,
+        (paddleIsPressed(input.leftAxisValue) &&
+         paddleIsReleased(input.rightAxisValue)) ||
+            (paddleIsReleased(input.leftAxisValue) &&
+             paddleIsPressed(input.rightAxisValue)));
+    return true;
+}
+
+/**
+ * @brief Bite point calibration in "launch control" working mode (left paddle is master)
+ *
+ */
+bool inputHub_bitePointCalibration_masterLeft_filter(DecouplingEvent &input, InputHubFrame &)
+{
+    inputHub_bitePointCalibration(
+        input,
+        paddleIsReleased(input.leftAxisValue) &&
+            paddleIsPressed(input.rightAxisValue));
+    return true;
+}
+
+/**
+ * @brief Bite point calibration in "launch control" working mode (right paddle is master)
+ *
+ */
+bool inputHub_bitePointCalibration_masterRight_filter(DecouplingEvent &input, InputHubFrame &)
+{
+    inputHub_bitePointCalibration(
+        input,
+        paddleIsPressed(input.leftAxisValue) &&
+            paddleIsReleased(input.rightAxisValue));
+    return true;
+}
+
 //-------------------------------------------------------------------
 
 /**
- * @brief Transforms input state into axis position and vice-versa,
- *        depending on the working mode of the clutch paddles.
+ * @brief Transforms analog axis position into input state
+ *        ("button" working mode of analog clutch paddles)
  *
  */
-void inputHub_AxisButton_filter(DecouplingEvent &input)
+bool inputHub_AxisToButton_filter(DecouplingEvent &input, InputHubFrame &)
 {
-    if (DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_ANALOG) &&
-        (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::BUTTON))
+    if (input.leftAxisValue >= CLUTCH_3_4_VALUE)
     {
-        // Transform analog axis position into an input state
-        if (input.leftAxisValue >= CLUTCH_3_4_VALUE)
-        {
-            input.rawInputBitmap |= leftClutchBitmap;
-            input.rawInputChanges |= leftClutchBitmap;
-        }
-        else if (input.leftAxisValue <= CLUTCH_1_4_VALUE)
-        {
-            input.rawInputBitmap &= (~leftClutchBitmap);
-            input.rawInputChanges |= leftClutchBitmap;
-        }
-        if (input.rightAxisValue >= CLUTCH_3_4_VALUE)
-        {
-            input.rawInputBitmap |= rightClutchBitmap;
-            input.rawInputChanges |= rightClutchBitmap;
-        }
-        else if (input.rightAxisValue <= CLUTCH_1_4_VALUE)
-        {
-            input.rawInputBitmap &= (~rightClutchBitmap);
-            input.rawInputChanges |= rightClutchBitmap;
-        }
-        input.leftAxisValue = CLUTCH_NONE_VALUE;
-        input.rightAxisValue = CLUTCH_NONE_VALUE;
-        return;
+        input.rawInputBitmap |= leftClutchBitmap;
+        input.rawInputChanges |= leftClutchBitmap;
     }
-
-    if (DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_BUTTON))
+    else if (input.leftAxisValue <= CLUTCH_1_4_VALUE)
     {
-        bool isAxisMode =
-            (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::AXIS) ||
-            (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::CLUTCH) ||
-            (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT) ||
-            (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT);
-        if (isAxisMode)
-        {
-            // Transform input state into an axis position
-            if (input.rawInputBitmap & leftClutchBitmap)
-                input.leftAxisValue = CLUTCH_FULL_VALUE;
-            else
-                input.leftAxisValue = CLUTCH_NONE_VALUE;
-            if (input.rawInputBitmap & rightClutchBitmap)
-                input.rightAxisValue = CLUTCH_FULL_VALUE;
-            else
-                input.rightAxisValue = CLUTCH_NONE_VALUE;
-            input.rawInputChanges = (input.rawInputChanges & clutchInputMask);
-            input.rawInputBitmap = (input.rawInputBitmap & clutchInputMask);
-        }
+        input.rawInputBitmap &= (~leftClutchBitmap);
+        input.rawInputChanges |= leftClutchBitmap;
+    }
+    if (input.rightAxisValue >= CLUTCH_3_4_VALUE)
+    {
+        input.rawInputBitmap |= rightClutchBitmap;
+        input.rawInputChanges |= rightClutchBitmap;
     }
+    else if (input.rightAxisValue <= CLUTCH_1_4_VALUE)
+    {
+        input.rawInputBitmap &= (~rightClutchBitmap);
+        input.rawInputChanges |= rightClutchBitmap;
+    }
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    return true;
+}
+
+/**
+ * @brief Transforms input state into axis position
+ *        (any axis-like working mode of digital clutch paddles)
+ *
+ */
+bool inputHub_ButtonToAxis_filter(DecouplingEvent &input, InputHubFrame &)
+{
+    if (input.rawInputBitmap & leftClutchBitmap)
+        input.leftAxisValue = CLUTCH_FULL_VALUE;
+    else
+        input.leftAxisValue = CLUTCH_NONE_VALUE;
+    if (input.rawInputBitmap & rightClutchBitmap)
+        input.rightAxisValue = CLUTCH_FULL_VALUE;
+    else
+        input.rightAxisValue = CLUTCH_NONE_VALUE;
+    input.rawInputChanges = (input.rawInputChanges & clutchInputMask);
+    input.rawInputBitmap = (input.rawInputBitmap & clutchInputMask);
+    return true;
 }
 
 //-------------------------------------------------------------------
 
 /**
- * @brief Computes a combined clutch position from analog axes,
- *        when needed
+ * @brief Computes a combined clutch position in "clutch" working mode
  *
  */
-void inputHub_combinedAxis_filter(
-    uint8_t &leftAxis,
-    uint8_t &rightAxis,
-    uint8_t &clutchAxis)
+bool inputHub_combinedAxis_clutch_filter(DecouplingEvent &input, InputHubFrame &frame)
 {
-    switch (InputHubServiceProvider::clutchWorkingMode)
-    {
-    case ClutchWorkingMode::CLUTCH:
-        if (leftAxis > rightAxis)
-            clutchAxis =
-                (leftAxis * InputHubServiceProvider::bitePoint +
-                 (rightAxis * (255 - InputHubServiceProvider::bitePoint))) /
-                255;
-        else
-            clutchAxis =
-                (rightAxis * InputHubServiceProvider::bitePoint +
-                 (leftAxis * (255 - InputHubServiceProvider::bitePoint))) /
-                255;
-        leftAxis = CLUTCH_NONE_VALUE;
-        rightAxis = CLUTCH_NONE_VALUE;
-        break;
-
-    case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT:
-        if (rightAxis > CLUTCH_3_4_VALUE)
-            clutchAxis = InputHubServiceProvider::bitePoint;
-        else
-            clutchAxis = CLUTCH_NONE_VALUE;
-        if (leftAxis > clutchAxis)
-            clutchAxis = leftAxis;
-        leftAxis = CLUTCH_NONE_VALUE;
-        rightAxis = CLUTCH_NONE_VALUE;
-        break;
+    uint8_t bitePoint = frame.config->settings.bitePoint;
+    if (input.leftAxisValue > input.rightAxisValue)
+        frame.clutchAxis =
+            (input.leftAxisValue * bitePoint +
+             (input.rightAxisValue * (255 - bitePoint))) /
+            255;
+    else
+        frame.clutchAxis =
+            (input.rightAxisValue * bitePoint +
+             (input.leftAxisValue * (255 - bitePoint))) /
+            255;
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    return true;
+}
 
-    case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT:
-        if (leftAxis > CLUTCH_3_4_VALUE)
-            clutchAxis = InputHubServiceProvider::bitePoint;
-        else
-            clutchAxis = CLUTCH_NONE_VALUE;
-        if (rightAxis > clutchAxis)
-            clutchAxis = rightAxis;
-        leftAxis = CLUTCH_NONE_VALUE;
-        rightAxis = CLUTCH_NONE_VALUE;
-        break;
+/**
+ * @brief Computes a combined clutch position in "launch control" working mode
+ *        (left paddle is master)
+ *
+ */
+bool inputHub_combinedAxis_masterLeft_filter(DecouplingEvent &input, InputHubFrame &frame)
+{
+    if (input.rightAxisValue > CLUTCH_3_4_VALUE)
+        frame.clutchAxis = frame.config->settings.bitePoint;
+    else
+        frame.clutchAxis = CLUTCH_NONE_VALUE;
+    if (input.leftAxisValue > frame.clutchAxis)
+        frame.clutchAxis = input.leftAxisValue;
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    return true;
+}
 
-    case ClutchWorkingMode::AXIS:
-        clutchAxis = CLUTCH_NONE_VALUE;
-        break;
+/**
+ * @brief Computes a combined clutch position in "launch control" working mode
+ *        (right paddle is master)
+ *
+ */
+bool inputHub_combinedAxis_masterRight_filter(DecouplingEvent &input, InputHubFrame &frame)
+{
+    if (input.leftAxisValue > CLUTCH_3_4_VALUE)
+        frame.clutchAxis = frame.config->settings.bitePoint;
+    else
+        frame.clutchAxis = CLUTCH_NONE_VALUE;
+    if (input.rightAxisValue > frame.clutchAxis)
+        frame.clutchAxis = input.rightAxisValue;
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    return true;
+}
 
-    default:
-        leftAxis = CLUTCH_NONE_VALUE;
-        rightAxis = CLUTCH_NONE_VALUE;
-        clutchAxis = CLUTCH_NONE_VALUE;
-        break;
-    }
+/**
+ * @brief Removes analog axes from the HID report
+ *
+ */
+bool inputHub_releaseAxes_filter(DecouplingEvent &input, InputHubFrame &)
+{
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    return true;
 }
 
 //-------------------------------------------------------------------
 
 /**
- * @brief Check if ALT mode is engaged by the user
+ * @brief Check if ALT mode is engaged by the user (ALT buttons)
  *
  */
-void inputHub_AltRequest_filter(
-    uint64_t &rawInputBitmap,
-    uint8_t &leftAxis,
-    uint8_t &rightAxis,
-    bool &isAltRequested)
+bool inputHub_AltButtons_filter(DecouplingEvent &input, InputHubFrame &frame)
 {
-    if (InputHubServiceProvider::altButtonsWorkingMode == AltButtonsWorkingMode::ALT)
-    {
-        isAltRequested = (rawInputBitmap & altBitmap);
-        rawInputBitmap &= ~altBitmap;
-    }
-    if (InputHubServiceProvider::clutchWorkingMode == ClutchWorkingMode::ALT)
-    {
-        isAltRequested =
-            isAltRequested ||
-            (leftAxis >= CLUTCH_DEFAULT_VALUE) ||
-            (rightAxis >= CLUTCH_DEFAULT_VALUE) ||
-            (rawInputBitmap & leftClutchBitmap) ||
-            (rawInputBitmap & rightClutchBitmap);
-        leftAxis = CLUTCH_NONE_VALUE;
-        rightAxis = CLUTCH_NONE_VALUE;
-        rawInputBitmap &= clutchInputMask;
-    }
+    frame.isALTRequested = (bool)(input.rawInputBitmap & altBitmap);
+    input.rawInputBitmap &= ~altBitmap;
+    return true;
+}
+
+/**
+ * @brief Check if ALT mode is engaged by the user (clutch paddles)
+ *
+ */
+bool inputHub_AltClutch_filter(DecouplingEvent &input, InputHubFrame &frame)
+{
+    frame.isALTRequested =
+        frame.isALTRequested ||
+        (input.leftAxisValue >= CLUTCH_DEFAULT_VALUE) ||
+        (input.rightAxisValue >= CLUTCH_DEFAULT_VALUE) ||
+        (input.rawInputBitmap & leftClutchBitmap) ||
+        (input.rawInputBitmap & rightClutchBitmap);
+    input.leftAxisValue = CLUTCH_NONE_VALUE;
+    input.rightAxisValue = CLUTCH_NONE_VALUE;
+    input.rawInputBitmap &= clutchInputMask;
+    return true;
 }
 
 //-------------------------------------------------------------------
 
 /**
- * @brief Transform DPAD input into navigational input depending on user preferences
+ * @brief Transform DPAD input into navigational input
  *
+ * @note Not applied while ALT mode is engaged
  */
-void inputHub_DPAD_filter(
-    uint64_t &rawInputBitmap,
-    uint8_t &povInput)
+bool inputHub_DPAD_filter(DecouplingEvent &input, InputHubFrame &frame)
 {
-    povInput = DPAD_CENTERED;
-    if (InputHubServiceProvider::dpadWorkingMode == DPadWorkingMode::Navigation)
-    {
-        // Map directional buttons to POV input as needed
-        uint64_t povState = rawInputBitmap & dpadNegMask;
+    if (frame.isALTRequested)
+        return true;
 
-        if (povState)
+    // Map directional buttons to POV input as needed
+    InputBitmap povState = input.rawInputBitmap & dpadNegMask;
+    if (povState)
+    {
+        uint8_t n = 1;
+        while ((frame.povInput == DPAD_CENTERED) && (n < 9))
         {
-            uint8_t n = 1;
-            while ((povInput == DPAD_CENTERED) && (n < 9))
-            {
-                if (povState == dpadBitmap[n])
-                    povInput = n;
-                n++;
-            }
+            if (povState == dpadBitmap[n])
+                frame.povInput = n;
+            n++;
         }
-        rawInputBitmap = rawInputBitmap & dpadMask;
     }
+    input.rawInputBitmap = input.rawInputBitmap & dpadMask;
+    return true;
 }
 
 /**
  * @brief Engage or disengage neutral gear
  *
  */
-void inputHub_neutralGear_filter(uint64_t &rawInputBitmap)
+bool inputHub_neutralGear_filter(DecouplingEvent &input, InputHubFrame &)
 {
-    if (neutralSwitchBitmap)
+    InputBitmap &rawInputBitmap = input.rawInputBitmap;
+    bool combinationPressed = ((~rawInputBitmap & neutralCombinationBitmap) == NO_INPUTS);
+    if (neutralWasEngaged && ((rawInputBitmap & neutralCombinationBitmap) == NO_INPUTS))
+        // all buttons in the combination are now released at the same time
+        neutralWasEngaged = false;
+    else if (!neutralWasEngaged && combinationPressed)
+        // all buttons in the combination are now pressed at the same time
+        neutralWasEngaged = true;
+    if (neutralWasEngaged)
     {
-        bool combinationPressed = ((~rawInputBitmap & neutralCombinationBitmap) == 0ULL);
-        if (neutralWasEngaged && ((rawInputBitmap & neutralCombinationBitmap) == 0ULL))
-            // all buttons in the combination are now released at the same time
-            neutralWasEngaged = false;
-        else if (!neutralWasEngaged && combinationPressed)
-            // all buttons in the combination are now pressed at the same time
-            neutralWasEngaged = true;
-        if (neutralWasEngaged)
-        {
-            // Remove the button combination
-            rawInputBitmap &= ~neutralCombinationBitmap;
-            if (combinationPressed)
-                // Add the "virtual" neutral gear button
-                rawInputBitmap |= neutralSwitchBitmap;
-        }
+        // Remove the button combination
+        rawInputBitmap &= ~neutralCombinationBitmap;
+        if (combinationPressed)
+            // Add the "virtual" neutral gear button
+            rawInputBitmap |= neutralSwitchBitmap;
     }
+    return true;
 }
 
+//-------------------------------------------------------------------
+// Pipeline
 //-------------------------------------------------------------------
 
-void internals::inputHub::onRawInput(DecouplingEvent &input)
+void inputHubFillPipeline(const InputHubSettings &settings, InputHubPipeline &pipeline)
 {
-
-    // Decode binary-coded switches when required
-    inputHub_decode_bin_coded_switches(input.rawInputBitmap, input.rawInputChanges);
-
-    // Step 1: Execute user commands if any
-    if (inputHub_commands_filter(input.rawInputBitmap, input.rawInputChanges))
+    InputHubPipeline *next = &pipeline;
+    next->count = 0;
+
+    ClutchWorkingMode clutchMode = settings.clutchWorkingMode;
+    bool analogClutch = DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_ANALOG);
+    bool digitalClutch = DeviceCapabilities::hasFlag(DeviceCapability::CLUTCH_BUTTON);
+    bool hasClutch = analogClutch || digitalClutch;
+    bool analogAsButtons = analogClutch && (clutchMode == ClutchWorkingMode::BUTTON);
+
+    // Step 0: decode binary-coded switches
+    if (_codedSwitches.size() > 0)
+        next->add(inputHub_decode_bin_coded_switches);
+
+    // Step 1: execute user commands
+    if (cycleALTWorkingModeBitmap || cycleClutchWorkingModeBitmap ||
+        cycleDPADWorkingModeBitmap || cmdAxisAutocalibrationBitmap ||
+        cycleSecurityLockBitmap)
+        next->add(inputHub_commands_stage);
+
+    if (hasClutch)
     {
-        internals::hid::reset();
-        return;
+        // Step 2: digital input <--> analog axes
+        if (analogAsButtons)
+            next->add(inputHub_AxisToButton_filter);
+        else if (digitalClutch &&
+                 ((clutchMode == ClutchWorkingMode::AXIS) ||
+                  (clutchMode == ClutchWorkingMode::CLUTCH) ||
+                  (clutchMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT) ||
+                  (clutchMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT)))
+            next->add(inputHub_ButtonToAxis_filter);
+
+        // Step 3: bite point calibration
+        if (calibrateUpBitmap || calibrateDownBitmap)
+        {
+            if (clutchMode == ClutchWorkingMode::CLUTCH)
+                next->add(inputHub_bitePointCalibration_clutch_filter);
+            else if (clutchMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT)
+                next->add(inputHub_bitePointCalibration_masterLeft_filter);
+            else if (clutchMode == ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT)
+                next->add(inputHub_bitePointCalibration_masterRight_filter);
+        }
     }
 
-    // Step 2: digital input <--> analog axes
-    inputHub_AxisButton_filter(input);
-
-    // Step 3: bite point calibration
-    inputHub_bitePointCalibration_filter(input);
-
     // Step 4: check if ALT mode is requested
-    bool isALTRequested = false;
-    inputHub_AltRequest_filter(
-        input.rawInputBitmap,
-        input.leftAxisValue,
-        input.rightAxisValue,
-        isALTRequested);
+    if ((settings.altButtonsWorkingMode == AltButtonsWorkingMode::ALT) &&
+        (altBitmap != NO_INPUTS))
+        next->add(inputHub_AltButtons_filter);
 
     // Step 5: compute F1-style clutch position
-    uint8_t clutchAxis;
-    inputHub_combinedAxis_filter(input.leftAxisValue, input.rightAxisValue, clutchAxis);
+    if (hasClutch)
+    {
+        switch (clutchMode)
+        {
+        case ClutchWorkingMode::CLUTCH:
+            next->add(inputHub_combinedAxis_clutch_filter);
+            break;
+        case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_LEFT:
+            next->add(inputHub_combinedAxis_masterLeft_filter);
+            break;
+        case ClutchWorkingMode::LAUNCH_CONTROL_MASTER_RIGHT:
+            next->add(inputHub_combinedAxis_masterRight_filter);
+            break;
+        case ClutchWorkingMode::ALT:
+            next->add(inputHub_AltClutch_filter);
+            break;
+        case ClutchWorkingMode::AXIS:
+            break;
+        default:
+            if (!analogAsButtons)
+                next->add(inputHub_releaseAxes_filter);
+            break;
+        }
+    }
 
     // Step 6: compute DPAD input
-    uint8_t povInput = DPAD_CENTERED;
-    if (!isALTRequested)
-        inputHub_DPAD_filter(input.rawInputBitmap, povInput);
+    if ((settings.dpadWorkingMode == DPadWorkingMode::Navigation) &&
+        (dpadNegMask != NO_INPUTS))
+        next->add(inputHub_DPAD_filter);
 
     // Step 7: compute neutral gear engagement
-    inputHub_neutralGear_filter(input.rawInputBitmap);
+    if (neutralSwitchBitmap)
+        next->add(inputHub_neutralGear_filter);
+}
+
+
+//-------------------------------------------------------------------
+
+void internals::inputHub::onRawInput(DecouplingEvent &input)
+{
+    InputTraceEntry trace;
+    bool tracing = eventTracing.load(std::memory_order_relaxed);
+    if (tracing)
+    {
+        trace.timestampUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+        trace.input = input;
+        trace.reported = false;
+    }
+
+    InputHubFrame frame;
+    frame.config = inputHubAcquireConfig();
+    const InputHubPipeline &pipeline = frame.config->pipeline;
+
+    // Steps 0 to 7: filters required by the current configuration
+    for (uint8_t i = 0; i < pipeline.count; i++)
+        if (!pipeline.filter[i](input, frame))
+        {
+            inputHubReleaseConfig();
+            if (tracing)
+                eventTrace.push(trace);
+            return;
+        }
+    inputHubReleaseConfig();
 
     // Step 8: map raw input state into HID button state
     uint64_t inputsLow, inputsHigh;
-    internals::inputMap::map(isALTRequested, input.rawInputBitmap, inputsLow, inputsHigh);
+    internals::inputMap::map(frame.isALTRequested, input.rawInputBitmap, inputsLow, inputsHigh);
+
+    if (tracing)
+    {
+        trace.reported = true;
+        trace.inputsLow = inputsLow;
+        trace.inputsHigh = inputsHigh;
+        trace.POVstate = frame.povInput;
+        trace.leftAxis = input.leftAxisValue;
+        trace.rightAxis = input.rightAxisValue;
+        trace.clutchAxis = frame.clutchAxis;
+        eventTrace.push(trace);
+    }
 
     // Step 9: send HID report
     internals::hid::reportInput(
         inputsLow,
         inputsHigh,
-        povInput,
+        frame.povInput,
         input.leftAxisValue,
-        input.rightAxisValue, clutchAxis);
+        input.rightAxisValue,
+        frame.clutchAxis,
+        input.keepAlive);
 }
 
 //-------------------------------------------------------------------
@@ -18,6 +18,8 @@
 #include "InternalServices.hpp"
 #include <array>
 #include <vector>
+#include <atomic>
+#include <mutex>
 // #include <iostream> // For testing
 
 //-------------------------------------------------------------------
@@ -31,11 +33,65 @@ struct DefaultMap
     uint8_t alt;
 };
 
-static std::array<uint8_t, 64> mapNoAlt;
-static std::array<uint8_t, 64> mapAlt;
+struct InputMapTables
+{
+    std::array<uint8_t, INPUT_BITMAP_WIDTH> noAlt;
+    std::array<uint8_t, INPUT_BITMAP_WIDTH> alt;
+};
+
+// Map snapshots, so a whole map is replaced at once.
+// Writers are serialized by a mutex. The input hub is the only reader
+// on the input path and it never blocks.
+// Three buffers: one published, one in use by the input hub
+// (may be the same) and another one for the next map.
+static InputMapTables mapTables[3];
+static std::atomic<InputMapTables *> currentMap{&mapTables[0]};
+static std::atomic<InputMapTables *> mapInUse{nullptr};
+static std::mutex mapMutex;
 static std::vector<DefaultMap> defaultMap;
 static bool computeOptimal = false;
 
+/**
+ * @brief Default user-defined input number for a firmware-defined input number
+ *
+ * @note There are 128 user-defined input numbers, so firmware-defined
+ *       inputs wrap around when the input bitmap is wider.
+ */
+#define DEFAULT_USER_INPUT_NUMBER(firmware, alt) (((firmware) + ((alt) ? 64 : 0)) % 128)
+
+/**
+ * @brief Get a copy of the published map, not in use by the input hub
+ *
+ * @note Must be called with mapMutex taken.
+ *       Publish it with currentMap.store() when done.
+ *
+ * @return InputMapTables* Table to write into
+ */
+static InputMapTables *nextMap()
+{
+    InputMapTables *current = currentMap.load();
+    InputMapTables *inUse = mapInUse.load();
+    InputMapTables *next = &mapTables[0];
+    while ((next == current) || (next == inUse))
+        next++;
+    *next = *current;
+    return next;
+}
+
+/**
+ * @brief Fill a map with the absolute default map
+ *
+ * @param tables Map to fill
+ */
+static void setAbsoluteDefaultMap(InputMapTables *tables)
+{
+    for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
+    {
+        tables->noAlt[i] = DEFAULT_USER_INPUT_NUMBER(i, false);
+        tables->alt[i] = DEFAULT_USER_INPUT_NUMBER(i, true);
+    }
+}
+
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 // Internal API
@@ -53,23 +109,43 @@ class InputMapServiceProvider : public InputMapService
         uint8_t user_defined,
         uint8_t user_defined_alt) override
     {
-        if ((firmware_defined < 64) && (user_defined < 128) && (user_defined_alt < 128))
+        if ((firmware_defined < INPUT_BITMAP_WIDTH) && (user_defined < 128) && (user_defined_alt < 128))
         {
-            mapNoAlt[firmware_defined] = user_defined;
-            mapAlt[firmware_defined] = user_defined_alt;
+            std::lock_guard<std::mutex> lock(mapMutex);
+            InputMapTables *next = nextMap();
+            next->noAlt[firmware_defined] = user_defined;
+            next->alt[firmware_defined] = user_defined_alt;
+            currentMap.store(next);
             // SaveSetting::notify(UserSetting::INPUT_MAP);
         }
     }
 
+    virtual void setMaps(
+        const uint8_t *user_defined,
+        const uint8_t *user_defined_alt) override
+    {
+        std::lock_guard<std::mutex> lock(mapMutex);
+        InputMapTables *next = nextMap();
+        for (uint8_t i = 0; i < INPUT_BITMAP_WIDTH; i++)
+            if ((user_defined[i] < 128) && (user_defined_alt[i] < 128))
+            {
+                next->noAlt[i] = user_defined[i];
+                next->alt[i] = user_defined_alt[i];
+            }
+        currentMap.store(next);
+    }
+
     virtual void getMap(
         uint8_t firmware_defined,
         uint8_t &user_defined,
         uint8_t &user_defined_alt) override
     {
-        if (firmware_defined < 64)
+        if (firmware_defined < INPUT_BITMAP_WIDTH)
         {
-            user_defined = mapNoAlt[firmware_defined];
-            user_defined_alt = mapAlt[firmware_defined];
+            std::lock_guard<std::mutex> lock(mapMutex);
+            InputMapTables *tables = currentMap.load();
+            user_defined = tables->noAlt[firmware_defined];
+            user_defined_alt = tables->alt[firmware_defined];
         }
         else
         {
@@ -81,17 +157,16 @@ class InputMapServiceProvider : public InputMapService
     virtual void resetMap() override
     {
         // Create an absolute default map
-        for (uint8_t i = 0; i < 64; i++)
-        {
-            mapNoAlt[i] = i;
-            mapAlt[i] = (i + 64);
-        }
+        std::lock_guard<std::mutex> lock(mapMutex);
+        InputMapTables *next = nextMap();
+        setAbsoluteDefaultMap(next);
         // Override with custom defaults
         for (auto defMap : defaultMap)
         {
-            mapNoAlt[defMap.firmware] = defMap.noAlt;
-            mapAlt[defMap.firmware] = defMap.alt;
+            next->noAlt[defMap.firmware] = defMap.noAlt;
+            next->alt[defMap.firmware] = defMap.alt;
         }
+        currentMap.store(next);
     }
 };
 
@@ -109,11 +184,10 @@ void inputMapStart()
 
 void internals::inputMap::clear()
 {
-    for (uint8_t i = 0; i < 64; i++)
-    {
-        mapNoAlt[i] = i;
-        mapAlt[i] = (i + 64);
-    }
+    std::lock_guard<std::mutex> lock(mapMutex);
+    InputMapTables *next = nextMap();
+    setAbsoluteDefaultMap(next);
+    currentMap.store(next);
     defaultMap.clear();
 }
 
@@ -126,12 +200,12 @@ void internals::inputMap::getReady()
         // Compute the highest firmware-defined input number
         uint8_t max_firmware_in;
         for (
-            max_firmware_in = 64;
+            max_firmware_in = INPUT_BITMAP_WIDTH;
             (max_firmware_in > 0) && !InputNumber::booked(max_firmware_in - 1);
             max_firmware_in--)
             ;
         // Automatically assign a new map
-        for (uint8_t i = 0; i < 64; i++)
+        for (uint8_t i = 0; (i < INPUT_BITMAP_WIDTH) && (i < 128); i++)
             if (InputNumber::booked(i))
             {
                 // Do not overwrite other custom settings
@@ -142,8 +216,10 @@ void internals::inputMap::getReady()
                         found = true;
                         break;
                     }
-                if (!found)
+                if (!found && (i + max_firmware_in < 128))
                     ::inputMap::set(i, i, i + max_firmware_in);
+                else if (!found)
+                    ::inputMap::set(i, i, i);
             }
     }
     for (auto defMap : defaultMap)
@@ -162,21 +238,55 @@ void internals::inputMap::getReady()
 
 void internals::inputMap::map(
     bool isAltModeEngaged,
-    uint64_t firmware_bitmap,
+    const InputBitmap &firmware_bitmap,
     uint64_t &low,
     uint64_t &high)
 {
     high = 0ULL;
     low = 0ULL;
-    for (uint8_t i = 0; i < 64; i++)
-        if (firmware_bitmap & (1ULL << i))
+    // Tell writers which map is in use (hazard pointer)
+    InputMapTables *tables;
+    do
+    {
+        tables = currentMap.load();
+        mapInUse.store(tables);
+    } while (tables != currentMap.load());
+    const std::array<uint8_t, INPUT_BITMAP_WIDTH> &map =
+        (isAltModeEngaged) ? tables->alt : tables->noAlt;
+    for (uint8_t w = 0; w < INPUT_BITMAP_WORD_COUNT; w++)
+    {
+        // Visit active inputs only
+        uint64_t pending = inputBitmapWord(firmware_bitmap, w);
+        while (pending)
         {
-            uint8_t user_input_number = (isAltModeEngaged) ? mapAlt[i] : mapNoAlt[i];
+            uint8_t i = (w * 64) + __builtin_ctzll(pending);
+            pending &= (pending - 1ULL);
+            uint8_t user_input_number = map[i];
             if (user_input_number < 64)
                 low |= (1ULL << user_input_number);
             else
                 high |= (1ULL << (user_input_number - 64));
         }
+    }
+    mapInUse.store(nullptr);
+}
+
+//-------------------------------------------------------------------
+
+void internals::inputMap::getFactoryMap(
+    uint8_t firmware_defined,
+    uint8_t &user_defined,
+    uint8_t &user_defined_alt)
+{
+    // Same as resetMap(): custom defaults override the absolute default
+    user_defined = DEFAULT_USER_INPUT_NUMBER(firmware_defined, false);
+    user_defined_alt = DEFAULT_USER_INPUT_NUMBER(firmware_defined, true);
+    for (auto defMap : defaultMap)
+        if (defMap.firmware == firmware_defined)
+        {
+            user_defined = defMap.noAlt;
+            user_defined_alt = defMap.alt;
+        }
 }
 
 //-------------------------------------------------------------------
@@ -24,16 +24,20 @@
 #include <cstring> // For memset()
 #include <forward_list>
 #include <algorithm> // For find()
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <bit> // For popcount() and countr_zero()
 
 #if !CD_CI
 
 #include "freertos/FreeRTOS.h"
+#include "esp_cpu.h" // For esp_cpu_get_cycle_count()
 static QueueHandle_t decouplingQueue = nullptr;
 
 #else
 
 #include <thread>
-#include <chrono>
 
 #endif
 
@@ -43,6 +47,7 @@ static QueueHandle_t decouplingQueue = nullptr;
 
 // Input hardware
 static std::forward_list<DigitalInput *> digitalInputsChain = {};
+static std::forward_list<DigitalInput *> busInputsChain = {};
 static AnalogInput *leftAxis = nullptr;
 static AnalogInput *rightAxis = nullptr;
 static bool _reverseLeftAxis = false;
@@ -53,6 +58,35 @@ static bool _reverseRightAxis = false;
 #define POLLING_TASK_STACK_SIZE (2 * 1024) + 512
 static bool forceUpdate;
 #define MAX_VOID_LOOP_COUNT (15000 / DEBOUNCE_MS)
+#define SCAN_PERIOD_MS (DEBOUNCE_MS * 2)
+// A scan is overrun when started 1.5 periods after the previous one
+#define SCAN_OVERRUN std::chrono::milliseconds(SCAN_PERIOD_MS * 3 / 2)
+
+// Bus polling daemon
+#define BUS_POLLING_TASK_STACK_SIZE (2 * 1024) + 512
+static InputBitmap busInputsState = NO_INPUTS;
+static std::mutex busInputsMutex;
+
+// Scanning tasks configuration (priority is relative to the idle task)
+static int8_t fastTaskCore = FAST_INPUT_TASK_CORE;
+static int8_t busTaskCore = BUS_INPUT_TASK_CORE;
+static uint8_t fastTaskPriority = 2;
+static uint8_t busTaskPriority = 2;
+
+// Read cost profiling
+static std::atomic<bool> readProfiling{false};
+
+// I2C device discovery
+struct I2CDeviceMap
+{
+    /// @brief Known 7-bit addresses, either cached or probed
+    std::vector<uint8_t> addresses;
+    /// @brief True if @p addresses were loaded from flash memory
+    bool loaded = false;
+    /// @brief True if @p addresses were probed in this boot
+    bool probed = false;
+};
+static I2CDeviceMap i2cDevices[2];
 
 // Hub daemon
 #define HUB_STACK_SIZE 4 * 1024
@@ -72,36 +106,85 @@ static void abortIfStarted()
 
 //-------------------------------------------------------------------
 
-uint8_t getI2CFullAddress(uint8_t I2CAddress, bool isFullAddress, I2CBus bus)
+void loadI2CDeviceMap(I2CBus bus)
 {
-    static bool firstRun = true;
-    static std::vector<uint8_t> i2cAddressesFromProbe;
+    I2CDeviceMap &map = i2cDevices[static_cast<int>(bus)];
+    map.loaded = true;
+    internals::storage::loadI2CDeviceMap(bus, map.addresses);
+}
 
-    // Retrieve all 7-bit addresses found in the bus (only once)
-    if (firstRun)
+//-------------------------------------------------------------------
+
+void saveI2CDeviceMap(I2CBus bus)
+{
+    I2CDeviceMap &map = i2cDevices[static_cast<int>(bus)];
+    internals::storage::saveI2CDeviceMap(bus, map.addresses);
+}
+
+//-------------------------------------------------------------------
+
+void probeI2CDevices(I2CBus bus)
+{
+    std::vector<uint8_t> found[2];
+    bool otherBusProbed = i2cDevices[0].probed || i2cDevices[1].probed;
+    if (otherBusProbed)
+        internals::hal::i2c::probe(found[static_cast<int>(bus)], bus);
+    else
+        // First time: both buses are probed in parallel
+        internals::hal::i2c::probe(found[0], found[1]);
+
+    for (int i = 0; i < 2; i++)
     {
-        firstRun = false;
-        internals::hal::i2c::probe(i2cAddressesFromProbe, bus);
+        // Note: an empty secondary bus may be initialized later,
+        // so it is probed again on demand
+        if ((i != static_cast<int>(bus)) && (otherBusProbed || found[i].empty()))
+            continue;
+        I2CDeviceMap &map = i2cDevices[i];
+        map.probed = true;
+        if (found[i] != map.addresses)
+        {
+            map.addresses = found[i];
+            saveI2CDeviceMap(static_cast<I2CBus>(i));
+        }
     }
+}
+
+//-------------------------------------------------------------------
 
-    // Check if a device is responding to the given
-    // I2C address
-    uint8_t fullAddress;
+uint8_t findI2CAddress(
+    std::vector<uint8_t> &addresses,
+    uint8_t I2CAddress,
+    bool isFullAddress)
+{
     if (isFullAddress)
     {
-        if (std::find(
-                i2cAddressesFromProbe.begin(),
-                i2cAddressesFromProbe.end(),
-                I2CAddress) != i2cAddressesFromProbe.end())
-            fullAddress = I2CAddress;
-        else
-            fullAddress = 0xFF; // Device not found
+        if (std::find(addresses.begin(), addresses.end(), I2CAddress) != addresses.end())
+            return I2CAddress;
+        return 0xFF; // Device not found
     }
-    else
+    return internals::hal::i2c::findFullAddress(addresses, I2CAddress);
+}
+
+//-------------------------------------------------------------------
+
+uint8_t getI2CFullAddress(uint8_t I2CAddress, bool isFullAddress, I2CBus bus)
+{
+    I2CDeviceMap &map = i2cDevices[static_cast<int>(bus)];
+    if (!map.loaded && !map.probed)
+        loadI2CDeviceMap(bus);
+
+    // Try the last known-good device map first,
+    // verified with a single probe
+    uint8_t fullAddress = findI2CAddress(map.addresses, I2CAddress, isFullAddress);
+    if ((fullAddress < 128) &&
+        (map.probed || internals::hal::i2c::probe(fullAddress, bus)))
+        return fullAddress;
+
+    // Retrieve all 7-bit addresses found in the bus (only once)
+    if (!map.probed)
     {
-        fullAddress = internals::hal::i2c::findFullAddress(
-            i2cAddressesFromProbe,
-            I2CAddress);
+        probeI2CDevices(bus);
+        fullAddress = findI2CAddress(map.addresses, I2CAddress, isFullAddress);
     }
 
     if (fullAddress == 0xFF)
@@ -114,6 +197,14 @@ uint8_t getI2CFullAddress(uint8_t I2CAddress, bool isFullAddress, I2CBus bus)
 
 //-------------------------------------------------------------------
 
+void internals::inputs::forgetI2CDevices()
+{
+    for (int i = 0; i < 2; i++)
+        i2cDevices[i] = {};
+}
+
+//-------------------------------------------------------------------
+
 void inputs::addButton(InputGPIO pin, InputNumber inputNumber)
 {
     abortIfStarted();
@@ -378,6 +469,122 @@ void inputs::initializeI2C(GPIO sclPin,
 
 //-------------------------------------------------------------------
 
+void inputs::setScanningTasks(
+    int8_t fastCore,
+    int8_t busCore,
+    uint8_t fastPriority,
+    uint8_t busPriority)
+{
+    abortIfStarted();
+    if ((fastPriority == 0) || (busPriority == 0))
+        throw std::runtime_error("Input scanning tasks must run above the idle priority");
+    fastTaskCore = fastCore;
+    busTaskCore = busCore;
+    fastTaskPriority = fastPriority;
+    busTaskPriority = busPriority;
+}
+
+//-------------------------------------------------------------------
+
+void inputs::pipelineI2CReads(bool enable)
+{
+    abortIfStarted();
+    I2CInput::pipelined = enable;
+}
+
+//-------------------------------------------------------------------
+// Read cost profiling
+//-------------------------------------------------------------------
+
+static void setReadProfiling(bool enable)
+{
+    if (enable && !readProfiling)
+    {
+        for (DigitalInput *input : digitalInputsChain)
+            input->readCost.reset();
+        for (DigitalInput *input : busInputsChain)
+            input->readCost.reset();
+    }
+    readProfiling = enable;
+}
+
+static DigitalInput *getProfiledInput(uint8_t index, bool &busInput)
+{
+    busInput = false;
+    for (DigitalInput *input : digitalInputsChain)
+        if (index-- == 0)
+            return input;
+    busInput = true;
+    for (DigitalInput *input : busInputsChain)
+        if (index-- == 0)
+            return input;
+    return nullptr;
+}
+
+static uint8_t getReadCostCount()
+{
+    size_t count = std::distance(digitalInputsChain.begin(), digitalInputsChain.end()) +
+                   std::distance(busInputsChain.begin(), busInputsChain.end());
+    return (count > 0xFF) ? 0xFF : count;
+}
+
+static bool getReadCost(uint8_t index, InputReadCost &cost)
+{
+    bool busInput;
+    DigitalInput *input = getProfiledInput(index, busInput);
+    if (!input)
+        return false;
+
+    // Input numbers are cleared in the mask
+    cost.firstInputNumber = 0xFF;
+    cost.inputCount = 0;
+    for (uint8_t word = 0; word < INPUT_BITMAP_WORD_COUNT; word++)
+    {
+        uint64_t bits = ~inputBitmapWord(input->mask, word);
+        if (bits && (cost.firstInputNumber == 0xFF))
+            cost.firstInputNumber = (word * 64) + std::countr_zero(bits);
+        cost.inputCount += std::popcount(bits);
+    }
+    cost.busInput = busInput;
+    cost.minNs = CPU_CYCLES_TO_NS(input->readCost.min());
+    cost.avgNs = CPU_CYCLES_TO_NS(input->readCost.avg());
+    cost.maxNs = CPU_CYCLES_TO_NS(input->readCost.max());
+    cost.readCount = input->readCost.count();
+    return true;
+}
+
+void inputs::profileReads(bool enable)
+{
+    setReadProfiling(enable);
+}
+
+void inputs::getReadCosts(std::vector<InputReadCost> &costs)
+{
+    costs.clear();
+    InputReadCost cost;
+    for (uint8_t index = 0; getReadCost(index, cost); index++)
+        costs.push_back(cost);
+}
+
+/**
+ * @brief Read a hardware input, profiling if enabled
+ *
+ * @param input Hardware input
+ * @param lastState Previous state of all inputs
+ * @return InputBitmap Current state of @p input
+ */
+inline InputBitmap scanInput(DigitalInput *input, const InputBitmap &lastState)
+{
+    if (!readProfiling.load(std::memory_order_relaxed))
+        return input->read(lastState);
+    uint32_t start = CPU_CYCLE_COUNT();
+    InputBitmap state = input->read(lastState);
+    input->readCost.record(CPU_CYCLE_COUNT() - start);
+    return state;
+}
+
+//-------------------------------------------------------------------
+
 void internals::inputs::addFakeInput(FakeInput *instance)
 {
     abortIfStarted();
@@ -486,6 +693,26 @@ public:
     {
         forceUpdate = true;
     }
+
+    virtual void setReadProfiling(bool enable) override
+    {
+        ::setReadProfiling(enable);
+    }
+
+    virtual bool getReadProfiling() override
+    {
+        return readProfiling;
+    }
+
+    virtual uint8_t getReadCostCount() override
+    {
+        return ::getReadCostCount();
+    }
+
+    virtual bool getReadCost(uint8_t index, InputReadCost &cost) override
+    {
+        return ::getReadCost(index, cost);
+    }
 };
 
 // ----------------------------------------------------------------------------
@@ -502,21 +729,38 @@ void inputPollingLoop(void *param)
     uint16_t voidLoopCount = 0;
     currentState.leftAxisValue = CLUTCH_NONE_VALUE;
     currentState.rightAxisValue = CLUTCH_NONE_VALUE;
-    currentState.rawInputBitmap = 0ULL;
+    currentState.rawInputBitmap = NO_INPUTS;
     previousState = currentState;
     forceUpdate = true;
+#if FIRMWARE_COUNTERS
+    auto lastScan = std::chrono::steady_clock::now();
+#endif
 
     // loop
     while (true)
     {
+#if FIRMWARE_COUNTERS
+        auto now = std::chrono::steady_clock::now();
+        if ((now - lastScan) > SCAN_OVERRUN)
+            COUNT_EVENT(scanOverruns);
+        lastScan = now;
+        COUNT_EVENT(scanCount);
+#endif
+
         // Read digital inputs
-        currentState.rawInputBitmap = 0ULL;
+        currentState.rawInputBitmap = NO_INPUTS;
         for (DigitalInput *input : digitalInputsChain)
         {
             // currentState.rawInputBitmap =
             //     (currentState.rawInputBitmap & input->mask) |
             //     input->read(previousState.rawInputBitmap);
-            currentState.rawInputBitmap |= input->read(previousState.rawInputBitmap);
+            currentState.rawInputBitmap |= scanInput(input, previousState.rawInputBitmap);
+        }
+        if (!busInputsChain.empty())
+        {
+            // Merge the last known state of bus inputs
+            std::lock_guard<std::mutex> lock(busInputsMutex);
+            currentState.rawInputBitmap |= busInputsState;
         }
         currentState.rawInputChanges = currentState.rawInputBitmap ^ previousState.rawInputBitmap;
         stateChanged = forceUpdate || (currentState.rawInputChanges);
@@ -551,6 +795,7 @@ void inputPollingLoop(void *param)
         if (stateChanged || (voidLoopCount > MAX_VOID_LOOP_COUNT))
         {
             // Push state into the decoupling queue
+            currentState.keepAlive = !stateChanged;
             internals::inputs::notifyInputEvent(currentState);
             previousState = currentState;
             voidLoopCount = 0;
@@ -559,7 +804,53 @@ void inputPollingLoop(void *param)
             voidLoopCount++;
 
         // wait for the next sampling interval
-        DELAY_MS(DEBOUNCE_MS * 2);
+        DELAY_MS(SCAN_PERIOD_MS);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Bus poll daemon
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Scan inputs attached to a shared bus
+ *
+ * @note I2C transactions may block for a long time.
+ *       Scanning them here keeps the polling of GPIO-based inputs
+ *       on schedule. The result is merged by inputPollingLoop().
+ */
+void busPollingLoop(void *param)
+{
+    InputBitmap state = NO_INPUTS;
+#if !CD_CI
+    TickType_t lastWakeTime = xTaskGetTickCount();
+#else
+    auto lastWakeTime = std::chrono::steady_clock::now();
+#endif
+    while (true)
+    {
+        InputBitmap newState = NO_INPUTS;
+        for (DigitalInput *input : busInputsChain)
+            newState |= scanInput(input, state);
+        state = newState;
+        {
+            std::lock_guard<std::mutex> lock(busInputsMutex);
+            busInputsState = state;
+        }
+        // Wait for the next scan period, so the time spent
+        // in bus transactions does not delay the schedule.
+        // After an overrun, start over instead of catching up.
+#if !CD_CI
+        if (xTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(SCAN_PERIOD_MS)) != pdTRUE)
+            lastWakeTime = xTaskGetTickCount();
+#else
+        lastWakeTime += std::chrono::milliseconds(SCAN_PERIOD_MS);
+        auto now = std::chrono::steady_clock::now();
+        if (lastWakeTime > now)
+            std::this_thread::sleep_until(lastWakeTime);
+        else
+            lastWakeTime = now;
+#endif
     }
 }
 
@@ -575,7 +866,10 @@ void hubLoop(void *unused)
     while (true)
     {
         if (xQueueReceive(decouplingQueue, &currentState, portMAX_DELAY))
+        {
+            COUNT_EVENT(hubEvents);
             internals::inputHub::onRawInput(currentState);
+        }
     } // end while
 }
 #endif
@@ -588,9 +882,13 @@ inline void internals::inputs::notifyInputEvent(const DecouplingEvent &input)
 {
 #if CD_CI
     DecouplingEvent copy = input;
+    COUNT_EVENT(hubEvents);
     internals::inputHub::onRawInput(copy);
 #else
-    xQueueSend(decouplingQueue, &input, 0);
+    if (xQueueSend(decouplingQueue, &input, 0) == pdTRUE)
+        COUNT_MAX(queueHighWaterMark, uxQueueMessagesWaiting(decouplingQueue));
+    else
+        COUNT_EVENT(queueDrops);
 #endif
 }
 
@@ -598,6 +896,34 @@ inline void internals::inputs::notifyInputEvent(const DecouplingEvent &input)
 // Start
 // ----------------------------------------------------------------------------
 
+/**
+ * @brief Move bus inputs from the chain of digital inputs
+ *        to their own chain
+ *
+ */
+void splitInputChains()
+{
+    for (DigitalInput *input : digitalInputsChain)
+        if (input->isBusInput())
+            busInputsChain.push_front(input);
+    digitalInputsChain.remove_if(
+        [](DigitalInput *input)
+        { return input->isBusInput(); });
+}
+
+#if !CD_CI
+/**
+ * @brief Get a valid core affinity for a scanning task
+ *
+ */
+BaseType_t taskAffinity(int8_t core)
+{
+    if ((core < 0) || (core >= portNUM_PROCESSORS))
+        return tskNO_AFFINITY;
+    return core;
+}
+#endif
+
 void inputStart()
 {
     if (!FirmwareService::call::isRunning())
@@ -609,6 +935,7 @@ void inputStart()
             LoadSetting::notify(UserSetting::AXIS_CALIBRATION);
             LoadSetting::notify(UserSetting::AXIS_POLARITY);
         }
+        splitInputChains();
 
 #if !CD_CI
 
@@ -622,21 +949,46 @@ void inputStart()
         xTaskCreate(hubLoop, "hub", HUB_STACK_SIZE, (void *)nullptr, INPUT_TASK_PRIORITY, &task);
         if (task == nullptr)
             throw std::runtime_error("Unable to create inputHub task");
+        COUNT_TASK(FirmwareTask::INPUT_HUB, task);
+
+        // Create and run the bus polling task
+        if (!busInputsChain.empty())
+        {
+            task = nullptr;
+            xTaskCreatePinnedToCore(
+                busPollingLoop,
+                "BusInputs",
+                BUS_POLLING_TASK_STACK_SIZE,
+                nullptr,
+                tskIDLE_PRIORITY + busTaskPriority,
+                &task,
+                taskAffinity(busTaskCore));
+            if (task == nullptr)
+                throw std::runtime_error("Unable to create bus polling task");
+            COUNT_TASK(FirmwareTask::INPUT_POLLING, task);
+        }
 
         // Create and run the polling task
         task = nullptr;
-        xTaskCreate(
+        xTaskCreatePinnedToCore(
             inputPollingLoop,
             "PolledInputs",
             POLLING_TASK_STACK_SIZE,
             nullptr,
-            INPUT_TASK_PRIORITY,
-            &task);
+            tskIDLE_PRIORITY + fastTaskPriority,
+            &task,
+            taskAffinity(fastTaskCore));
         if (task == nullptr)
             throw std::runtime_error("Unable to create polling task");
+        COUNT_TASK(FirmwareTask::INPUT_POLLING, task);
 
 #else
 
+        if (!busInputsChain.empty())
+        {
+            std::jthread busPollingThread(busPollingLoop, nullptr);
+            busPollingThread.detach();
+        }
         std::jthread pollingThread(inputPollingLoop, nullptr);
         pollingThread.detach();
 
@@ -168,6 +168,21 @@ void internals::pixels::setAll(
     }
 }
 
+void internals::pixels::setRange(
+    PixelGroup group,
+    uint8_t fromPixelIndex,
+    uint8_t toPixelIndex,
+    uint8_t red,
+    uint8_t green,
+    uint8_t blue)
+{
+    if (pixelData[INT(group)] && CAN_TAKE_MUTEX)
+    {
+        pixelData[INT(group)]->pixelRangeRGB(fromPixelIndex, toPixelIndex, red, green, blue);
+        GIVE_MUTEX;
+    }
+}
+
 void internals::pixels::shiftToNext(PixelGroup group)
 {
     if (pixelData[INT(group)] && CAN_TAKE_MUTEX)
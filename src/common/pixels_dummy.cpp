@@ -22,6 +22,12 @@ void internals::pixels::setAll(PixelGroup group,
                                uint8_t red,
                                uint8_t green,
                                uint8_t blue) {}
+void internals::pixels::setRange(PixelGroup group,
+                                 uint8_t fromPixelIndex,
+                                 uint8_t toPixelIndex,
+                                 uint8_t red,
+                                 uint8_t green,
+                                 uint8_t blue) {}
 void internals::pixels::shiftToNext(PixelGroup group) {}
 void internals::pixels::shiftToPrevious(PixelGroup group) {}
 void internals::pixels::show() {}
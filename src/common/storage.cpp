@@ -16,6 +16,8 @@
 #include "SimWheelInternals.hpp"
 #include "Preferences.h"
 #include "InternalServices.hpp"
+#include "SettingsImage.hpp"
+#include "Checksum.hpp"
 
 #if !CD_CI
 #include "freertos/FreeRTOS.h" // For esp_timer_handle_t
@@ -23,6 +25,7 @@
 
 #include <atomic>
 #include <cstdio>
+#include <cstring>
 
 //-------------------------------------------------------------------
 // GLOBALS
@@ -80,6 +83,12 @@ static const char *K_BATT_CALIBRATION_DATA = "battCalD";
 static const char *K_INPUT_MAP_NO_ALT = "inMapNoAlt_%hhx";
 static const char *K_INPUT_MAP_ALT = "inMapAlt_%hhx";
 
+//-------------------------------------------------------------------
+
+// Not a user setting: kept apart from the settings namespace
+static const char *I2C_DEVICES_NAMESPACE = "SimwheelI2C";
+static const char *K_I2C_DEVICES[] = {"bus0", "bus1"};
+
 //-------------------------------------------------------------------
 // Auxiliary
 //-------------------------------------------------------------------
@@ -241,7 +250,7 @@ void loadInputMap(Preferences &prefs)
 {
     char key[32];
     uint8_t alt, noAlt;
-    for (uint8_t firmware_defined = 0; firmware_defined < 64; firmware_defined++)
+    for (uint8_t firmware_defined = 0; firmware_defined < INPUT_BITMAP_WIDTH; firmware_defined++)
     {
         snprintf(key, 32, K_INPUT_MAP_NO_ALT, firmware_defined);
         if (prefs.isKey(key))
@@ -261,7 +270,7 @@ void saveInputMap(Preferences &prefs)
 {
     char key[32];
     uint8_t alt, noAlt;
-    for (uint8_t firmware_defined = 0; firmware_defined < 64; firmware_defined++)
+    for (uint8_t firmware_defined = 0; firmware_defined < INPUT_BITMAP_WIDTH; firmware_defined++)
     {
         InputMapService::call::getMap(firmware_defined, noAlt, alt);
         if ((noAlt < 128) && (alt < 128))
@@ -345,6 +354,316 @@ void saveBatteryCalibrationData(Preferences &prefs)
     }
 }
 
+//-------------------------------------------------------------------
+// Settings image
+//-------------------------------------------------------------------
+
+/**
+ * @brief Sequential writer of a settings image
+ *
+ */
+struct ImageWriter
+{
+    uint8_t *image;
+    uint16_t size = SETTINGS_IMAGE_HEADER_SIZE;
+    uint8_t recordCount = 0;
+
+    ImageWriter(uint8_t *image) : image{image} {}
+
+    void put8(uint8_t value) { image[size++] = value; }
+
+    void put16(uint16_t value)
+    {
+        put8(value & 0xFF);
+        put8(value >> 8);
+    }
+
+    void put32(uint32_t value)
+    {
+        put16(value & 0xFFFF);
+        put16(value >> 16);
+    }
+
+    /**
+     * @brief Start a record
+     *
+     * @param setting User setting
+     * @param payloadSize Size of the payload in bytes
+     * @return true If there is room for the record
+     * @return false Otherwise, so the record must not be written
+     */
+    bool record(UserSetting setting, uint16_t payloadSize)
+    {
+        if ((size + SETTINGS_IMAGE_RECORD_HEADER_SIZE + payloadSize) > SETTINGS_IMAGE_MAX_SIZE)
+            return false;
+        put8((uint8_t)setting);
+        put16(payloadSize);
+        recordCount++;
+        return true;
+    }
+};
+
+static uint16_t get16(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+    return get16(data) | ((uint32_t)get16(data + 2) << 16);
+}
+
+static uint16_t imageChecksum(const uint8_t *image, uint16_t size)
+{
+    uint16_t crc = crc16(image, SETTINGS_IMAGE_CRC_INDEX);
+    return crc16(
+        image + SETTINGS_IMAGE_HEADER_SIZE,
+        size - SETTINGS_IMAGE_HEADER_SIZE,
+        crc);
+}
+
+//-------------------------------------------------------------------
+
+void exportSetting(ImageWriter &writer, UserSetting setting)
+{
+    // Note: the security lock and the custom hardware ID are not
+    // part of the image. The host computer must not change them this way.
+    switch (setting)
+    {
+    case UserSetting::AXIS_CALIBRATION:
+    {
+        int minLeft, maxLeft, minRight, maxRight;
+        if (InputService::call::getAxisCalibration(minLeft, maxLeft, minRight, maxRight) &&
+            writer.record(setting, 16))
+        {
+            writer.put32(minLeft);
+            writer.put32(maxLeft);
+            writer.put32(minRight);
+            writer.put32(maxRight);
+        }
+        break;
+    }
+    case UserSetting::AXIS_POLARITY:
+    {
+        bool left, right;
+        InputService::call::getAxisPolarity(left, right);
+        if (writer.record(setting, 2))
+        {
+            writer.put8(left);
+            writer.put8(right);
+        }
+        break;
+    }
+    case UserSetting::PULSE_WIDTH:
+        if (writer.record(setting, 1))
+            writer.put8((uint8_t)InputService::call::getRotaryPulseWidthMultiplier());
+        break;
+    case UserSetting::BITE_POINT:
+        if (writer.record(setting, 1))
+            writer.put8(InputHubService::call::getBitePoint());
+        break;
+    case UserSetting::CLUTCH_WORKING_MODE:
+        if (writer.record(setting, 1))
+            writer.put8((uint8_t)InputHubService::call::getClutchWorkingMode());
+        break;
+    case UserSetting::ALT_WORKING_MODE:
+        if (writer.record(setting, 1))
+            writer.put8((uint8_t)InputHubService::call::getAltButtonsWorkingMode());
+        break;
+    case UserSetting::DPAD_WORKING_MODE:
+        if (writer.record(setting, 1))
+            writer.put8((uint8_t)InputHubService::call::getDPadWorkingMode());
+        break;
+    case UserSetting::INPUT_MAP:
+        if (writer.record(setting, 2 * INPUT_BITMAP_WIDTH))
+            for (uint8_t firmware_defined = 0; firmware_defined < INPUT_BITMAP_WIDTH; firmware_defined++)
+            {
+                uint8_t noAlt, alt;
+                InputMapService::call::getMap(firmware_defined, noAlt, alt);
+                writer.put8(noAlt);
+                writer.put8(alt);
+            }
+        break;
+    case UserSetting::BATTERY_AUTO_CALIBRATION:
+        if (writer.record(setting, 4))
+            writer.put32(BatteryCalibrationService::call::getAutoCalibrationParameter());
+        break;
+    case UserSetting::BATTERY_CALIBRATION_DATA:
+    {
+        uint8_t count = BatteryCalibrationService::call::getCalibrationDataCount();
+        if ((count > 0) && writer.record(setting, 2 * count))
+            for (uint8_t i = 0; i < count; i++)
+                writer.put16(BatteryCalibrationService::call::getCalibrationData(i));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+//-------------------------------------------------------------------
+
+bool isValidRecord(UserSetting setting, uint16_t payloadSize)
+{
+    switch (setting)
+    {
+    case UserSetting::AXIS_CALIBRATION:
+        return (payloadSize == 16);
+    case UserSetting::AXIS_POLARITY:
+        return (payloadSize == 2);
+    case UserSetting::PULSE_WIDTH:
+    case UserSetting::BITE_POINT:
+    case UserSetting::CLUTCH_WORKING_MODE:
+    case UserSetting::ALT_WORKING_MODE:
+    case UserSetting::DPAD_WORKING_MODE:
+        return (payloadSize == 1);
+    case UserSetting::BATTERY_AUTO_CALIBRATION:
+        return (payloadSize == 4);
+    case UserSetting::INPUT_MAP:
+    case UserSetting::BATTERY_CALIBRATION_DATA:
+        return ((payloadSize % 2) == 0);
+    default:
+        // Unknown records are ignored
+        return true;
+    }
+}
+
+bool isValidImage(const uint8_t *image, uint16_t size)
+{
+    if ((size < SETTINGS_IMAGE_HEADER_SIZE) ||
+        (size > SETTINGS_IMAGE_MAX_SIZE) ||
+        (memcmp(image, SETTINGS_IMAGE_MAGIC, 4) != 0) ||
+        (image[4] != SETTINGS_IMAGE_VERSION) ||
+        (get16(image + 6) != size) ||
+        (get16(image + SETTINGS_IMAGE_CRC_INDEX) != imageChecksum(image, size)))
+        return false;
+
+    uint16_t index = SETTINGS_IMAGE_HEADER_SIZE;
+    for (uint8_t record = 0; record < image[5]; record++)
+    {
+        if ((index + SETTINGS_IMAGE_RECORD_HEADER_SIZE) > size)
+            return false;
+        UserSetting setting = static_cast<UserSetting>(image[index]);
+        uint16_t payloadSize = get16(image + index + 1);
+        index += SETTINGS_IMAGE_RECORD_HEADER_SIZE;
+        if (((index + payloadSize) > size) || !isValidRecord(setting, payloadSize))
+            return false;
+        index += payloadSize;
+    }
+    return (index == size);
+}
+
+//-------------------------------------------------------------------
+
+void importSetting(UserSetting setting, const uint8_t *payload, uint16_t payloadSize)
+{
+    // Note: invalid values are ignored, as they are when loaded from flash memory.
+    //       Records of the security lock and the custom hardware ID
+    //       are ignored as unknown ones.
+    switch (setting)
+    {
+    case UserSetting::AXIS_CALIBRATION:
+        InputService::call::setAxisCalibration(
+            (int32_t)get32(payload),
+            (int32_t)get32(payload + 4),
+            (int32_t)get32(payload + 8),
+            (int32_t)get32(payload + 12),
+            false);
+        break;
+    case UserSetting::AXIS_POLARITY:
+        InputService::call::setAxisPolarity(payload[0], payload[1], false);
+        break;
+    case UserSetting::PULSE_WIDTH:
+        if ((payload[0] >= (uint8_t)PulseWidthMultiplier::X1) &&
+            (payload[0] <= (uint8_t)PulseWidthMultiplier::_MAX_VALUE))
+            InputService::call::setRotaryPulseWidthMultiplier((PulseWidthMultiplier)payload[0], false);
+        break;
+    case UserSetting::BITE_POINT:
+        if (payload[0] != CLUTCH_INVALID_VALUE)
+            InputHubService::call::setBitePoint(payload[0], false);
+        break;
+    case UserSetting::CLUTCH_WORKING_MODE:
+        if (payload[0] <= (uint8_t)ClutchWorkingMode::_MAX_VALUE)
+            InputHubService::call::setClutchWorkingMode(static_cast<ClutchWorkingMode>(payload[0]), false);
+        break;
+    case UserSetting::ALT_WORKING_MODE:
+        if (payload[0] <= (uint8_t)AltButtonsWorkingMode::_MAX_VALUE)
+            InputHubService::call::setAltButtonsWorkingMode(static_cast<AltButtonsWorkingMode>(payload[0]), false);
+        break;
+    case UserSetting::DPAD_WORKING_MODE:
+        if (payload[0] <= (uint8_t)DPadWorkingMode::_MAX_VALUE)
+            InputHubService::call::setDPadWorkingMode(static_cast<DPadWorkingMode>(payload[0]), false);
+        break;
+    case UserSetting::INPUT_MAP:
+    {
+        // The image may come from a device with a different input bitmap width
+        uint8_t noAlt[INPUT_BITMAP_WIDTH];
+        uint8_t alt[INPUT_BITMAP_WIDTH];
+        memset(noAlt, 0xFF, INPUT_BITMAP_WIDTH);
+        memset(alt, 0xFF, INPUT_BITMAP_WIDTH);
+        for (uint16_t i = 0; (i < (payloadSize / 2)) && (i < INPUT_BITMAP_WIDTH); i++)
+        {
+            noAlt[i] = payload[2 * i];
+            alt[i] = payload[(2 * i) + 1];
+        }
+        InputMapService::call::setMaps(noAlt, alt);
+        break;
+    }
+    case UserSetting::BATTERY_AUTO_CALIBRATION:
+        BatteryCalibrationService::call::setAutoCalibrationParameter((int32_t)get32(payload), false);
+        break;
+    case UserSetting::BATTERY_CALIBRATION_DATA:
+        if ((payloadSize / 2) == BatteryCalibrationService::call::getCalibrationDataCount())
+            for (uint8_t i = 0; i < (payloadSize / 2); i++)
+                BatteryCalibrationService::call::setCalibrationData(i, get16(payload + (2 * i)), false);
+        break;
+    default:
+        break;
+    }
+}
+
+//-------------------------------------------------------------------
+// Service class
+//-------------------------------------------------------------------
+
+class StorageServiceProvider : public StorageService
+{
+public:
+    virtual uint16_t exportSettings(uint8_t *image) override
+    {
+        ImageWriter writer(image);
+        for (uint8_t i = (uint8_t)UserSetting::ALL + 1; i <= (uint8_t)UserSetting::_MAX_VALUE; i++)
+            exportSetting(writer, static_cast<UserSetting>(i));
+        memcpy(image, SETTINGS_IMAGE_MAGIC, 4);
+        image[4] = SETTINGS_IMAGE_VERSION;
+        image[5] = writer.recordCount;
+        image[6] = writer.size & 0xFF;
+        image[7] = writer.size >> 8;
+        uint16_t crc = imageChecksum(image, writer.size);
+        image[SETTINGS_IMAGE_CRC_INDEX] = crc & 0xFF;
+        image[SETTINGS_IMAGE_CRC_INDEX + 1] = crc >> 8;
+        return writer.size;
+    }
+
+    virtual bool importSettings(const uint8_t *image, uint16_t size) override
+    {
+        if (!isValidImage(image, size))
+            return false;
+        uint16_t index = SETTINGS_IMAGE_HEADER_SIZE;
+        while (index < size)
+        {
+            UserSetting setting = static_cast<UserSetting>(image[index]);
+            uint16_t payloadSize = get16(image + index + 1);
+            index += SETTINGS_IMAGE_RECORD_HEADER_SIZE;
+            importSetting(setting, image + index, payloadSize);
+            index += payloadSize;
+        }
+        // Save all settings at once
+        SaveSetting::notify(UserSetting::ALL);
+        return true;
+    }
+};
+
 //-------------------------------------------------------------------
 // Event Callbacks
 //-------------------------------------------------------------------
@@ -504,6 +823,44 @@ void load_setting(UserSetting setting)
     }
 }
 
+//-------------------------------------------------------------------
+// I2C device map
+//-------------------------------------------------------------------
+
+void internals::storage::loadI2CDeviceMap(I2CBus bus, std::vector<uint8_t> &addresses)
+{
+    // Stored as a bitmap of 128 bits
+    addresses.clear();
+    uint8_t bitmap[16];
+    Preferences prefs;
+    if (prefs.begin(I2C_DEVICES_NAMESPACE, true))
+    {
+        if (prefs.getBytesLength(K_I2C_DEVICES[static_cast<int>(bus)]) == sizeof(bitmap))
+        {
+            prefs.getBytes(K_I2C_DEVICES[static_cast<int>(bus)], bitmap, sizeof(bitmap));
+            for (uint8_t address = 0; address < 128; address++)
+                if (bitmap[address / 8] & (1 << (address % 8)))
+                    addresses.push_back(address);
+        }
+        prefs.end();
+    }
+}
+
+//-------------------------------------------------------------------
+
+void internals::storage::saveI2CDeviceMap(I2CBus bus, const std::vector<uint8_t> &addresses)
+{
+    uint8_t bitmap[16] = {};
+    for (uint8_t address : addresses)
+        bitmap[address / 8] |= (1 << (address % 8));
+    Preferences prefs;
+    if (prefs.begin(I2C_DEVICES_NAMESPACE, false))
+    {
+        prefs.putBytes(K_I2C_DEVICES[static_cast<int>(bus)], bitmap, sizeof(bitmap));
+        prefs.end();
+    }
+}
+
 //-------------------------------------------------------------------
 // API
 //-------------------------------------------------------------------
@@ -526,5 +883,6 @@ void internals::storage::getReady()
 #endif
         LoadSetting::subscribe(load_setting);
         SaveSetting::subscribe(request_save_setting);
+        StorageService::inject(new StorageServiceProvider());
     }
 }
@@ -349,6 +349,7 @@ void internals::ui::getReady()
             &task);
         if (task == nullptr)
             throw std::runtime_error("Unable to create UI daemon");
+        COUNT_TASK(FirmwareTask::UI, task);
         q->reader = task;
     }
     _ui_instances.clear();
@@ -92,6 +92,8 @@ class MAX1704x : public BatteryMonitorInterface
 protected:
     /// @brief Configured I2C address in 8 bit format
     uint8_t fg_i2c_address = 0xFF;
+    /// @brief Configured I2C bus
+    I2CBus _bus = I2CBus::PRIMARY;
 
     /**
      * @brief Read from a register
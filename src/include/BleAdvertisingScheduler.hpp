@@ -0,0 +1,243 @@
+/**
+ * @file BleAdvertisingScheduler.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Advertising phases for fast BLE reconnection
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+
+//-------------------------------------------------------------------
+// Compile-time configuration
+//-------------------------------------------------------------------
+
+#ifndef BLE_ADV_BONDED_MS
+/**
+ * @brief Duration of the advertising phase restricted to bonded hosts
+ *
+ * @note In milliseconds. Set to 0 as a build flag to skip this phase.
+ */
+#define BLE_ADV_BONDED_MS 3000
+#endif
+
+#ifndef BLE_ADV_FAST_MS
+/**
+ * @brief Duration of the fast advertising phase
+ *
+ * @note In milliseconds. Set to 0 as a build flag to skip this phase.
+ *       Slow advertising follows until a connection is made.
+ */
+#define BLE_ADV_FAST_MS 30000
+#endif
+
+//-------------------------------------------------------------------
+// Globals
+//-------------------------------------------------------------------
+
+/**
+ * @brief Advertising phases, in order
+ *
+ */
+enum class BleAdvertisingPhase : uint8_t
+{
+    /// @brief Not advertising
+    IDLE = 0,
+    /// @brief High duty cycle, only bonded hosts may connect
+    BONDED,
+    /// @brief High duty cycle, any host may connect
+    FAST,
+    /// @brief Low duty cycle, any host may connect
+    SLOW
+};
+
+/**
+ * @brief Advertising parameters of a phase
+ *
+ */
+struct BleAdvertisingParameters
+{
+    /// @brief Only bonded hosts may connect
+    ///        (the last connected one, if known)
+    bool bondedOnly;
+    /// @brief Minimum advertising interval in 0.625 ms units
+    uint16_t minInterval;
+    /// @brief Maximum advertising interval in 0.625 ms units
+    uint16_t maxInterval;
+};
+
+//-------------------------------------------------------------------
+// Advertiser
+//-------------------------------------------------------------------
+
+/**
+ * @brief BLE advertising
+ *
+ */
+class BleAdvertiser
+{
+public:
+    /**
+     * @brief Start advertising, replacing the current parameters
+     *
+     * @param params Advertising parameters
+     * @return true On success
+     * @return false If advertising could not start
+     *               (for example, there is no bonded host)
+     */
+    virtual bool startAdvertising(const BleAdvertisingParameters &params) = 0;
+};
+
+//-------------------------------------------------------------------
+// Scheduler
+//-------------------------------------------------------------------
+
+/**
+ * @brief Advertise in phases of decreasing duty cycle
+ *
+ * @note The caller must call onPhaseTimeout() after the duration
+ *       returned by start() or onPhaseTimeout() itself,
+ *       unless it is zero.
+ *       Not thread-safe.
+ */
+class BleAdvertisingScheduler
+{
+public:
+    /**
+     * @brief Create an advertising scheduler
+     *
+     * @param advertiser BLE advertising
+     * @param bondedMs Duration of the BONDED phase in milliseconds (0 to skip)
+     * @param fastMs Duration of the FAST phase in milliseconds (0 to skip)
+     */
+    BleAdvertisingScheduler(
+        BleAdvertiser &advertiser,
+        uint32_t bondedMs = BLE_ADV_BONDED_MS,
+        uint32_t fastMs = BLE_ADV_FAST_MS)
+        : _advertiser{advertiser}, _bondedMs{bondedMs}, _fastMs{fastMs} {}
+
+    /**
+     * @brief Get the advertising parameters of a phase
+     *
+     * @param phase Advertising phase other than IDLE
+     * @return BleAdvertisingParameters Parameters
+     */
+    static BleAdvertisingParameters parametersFor(BleAdvertisingPhase phase)
+    {
+        switch (phase)
+        {
+        case BleAdvertisingPhase::BONDED:
+            // 20 ms
+            return {true, 32, 32};
+        case BleAdvertisingPhase::FAST:
+            // 20 to 30 ms
+            return {false, 32, 48};
+        default:
+            // 211.25 to 318.75 ms
+            return {false, 338, 510};
+        }
+    }
+
+    /**
+     * @brief Start advertising after a disconnection or at startup
+     *
+     * @param nowMs Current time in milliseconds
+     * @param hasBond True if there is a bonded host
+     * @return uint32_t Duration of the current phase in milliseconds,
+     *                  or zero if it lasts until a connection is made
+     */
+    uint32_t start(uint64_t nowMs, bool hasBond)
+    {
+        _startTime = nowMs;
+        _phase = BleAdvertisingPhase::IDLE;
+        return enter(hasBond ? BleAdvertisingPhase::BONDED : BleAdvertisingPhase::FAST);
+    }
+
+    /**
+     * @brief Move to the next phase
+     *
+     * @return uint32_t Duration of the new phase in milliseconds,
+     *                  or zero if it lasts until a connection is made
+     */
+    uint32_t onPhaseTimeout()
+    {
+        if (_phase == BleAdvertisingPhase::BONDED)
+            return enter(BleAdvertisingPhase::FAST);
+        if (_phase == BleAdvertisingPhase::FAST)
+            return enter(BleAdvertisingPhase::SLOW);
+        return 0;
+    }
+
+    /**
+     * @brief Notify a connection
+     *
+     * @param nowMs Current time in milliseconds
+     * @return uint32_t Time to connect since advertising started,
+     *                  in milliseconds
+     */
+    uint32_t onConnected(uint64_t nowMs)
+    {
+        if (_phase != BleAdvertisingPhase::IDLE)
+        {
+            lastConnectionPhase = _phase;
+            lastConnectionTime = static_cast<uint32_t>(nowMs - _startTime);
+            _phase = BleAdvertisingPhase::IDLE;
+        }
+        return lastConnectionTime;
+    }
+
+    /**
+     * @brief Get the current phase
+     *
+     * @return BleAdvertisingPhase Current phase
+     */
+    BleAdvertisingPhase getPhase() const { return _phase; }
+
+    /// @brief Time to connect at the last connection, in milliseconds
+    uint32_t lastConnectionTime = 0;
+    /// @brief Advertising phase at the last connection
+    BleAdvertisingPhase lastConnectionPhase = BleAdvertisingPhase::IDLE;
+
+private:
+    BleAdvertiser &_advertiser;
+    uint32_t _bondedMs;
+    uint32_t _fastMs;
+    uint64_t _startTime = 0;
+    BleAdvertisingPhase _phase = BleAdvertisingPhase::IDLE;
+
+    uint32_t durationOf(BleAdvertisingPhase phase) const
+    {
+        if (phase == BleAdvertisingPhase::BONDED)
+            return _bondedMs;
+        if (phase == BleAdvertisingPhase::FAST)
+            return _fastMs;
+        return 0;
+    }
+
+    uint32_t enter(BleAdvertisingPhase phase)
+    {
+        // Skip disabled phases and phases that fail to start
+        while (phase != BleAdvertisingPhase::SLOW)
+        {
+            if ((durationOf(phase) > 0) &&
+                _advertiser.startAdvertising(parametersFor(phase)))
+            {
+                _phase = phase;
+                return durationOf(phase);
+            }
+            phase = static_cast<BleAdvertisingPhase>(static_cast<uint8_t>(phase) + 1);
+        }
+        _advertiser.startAdvertising(parametersFor(phase));
+        _phase = phase;
+        return 0;
+    }
+};
@@ -0,0 +1,258 @@
+/**
+ * @file BleConnectionManager.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Negotiation of BLE connection parameters
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include "InternalTypes.hpp"
+
+//-------------------------------------------------------------------
+// Globals
+//-------------------------------------------------------------------
+
+/// @brief Maximum count of requests for a profile
+#define BLE_CONN_MAX_ATTEMPTS 3
+/// @brief Time to wait for the host computer to answer a request
+#define BLE_CONN_REQUEST_TIMEOUT_MS 2000
+/// @brief Highest connection interval allowed by the BLE specification (1.25 ms units)
+#define BLE_CONN_MAX_INTERVAL 3200
+
+/**
+ * @brief Connection parameters to request
+ *
+ */
+struct BleConnectionParameters
+{
+    /// @brief Minimum connection interval in 1.25 ms units
+    uint16_t minInterval;
+    /// @brief Maximum connection interval in 1.25 ms units
+    uint16_t maxInterval;
+    /// @brief Peripheral latency in connection events
+    uint16_t latency;
+    /// @brief Supervision timeout in 10 ms units
+    uint16_t timeout;
+};
+
+//-------------------------------------------------------------------
+// Connection
+//-------------------------------------------------------------------
+
+/**
+ * @brief Connection to the host computer
+ *
+ */
+class BleConnection
+{
+public:
+    /**
+     * @brief Ask the host computer for new connection parameters
+     *
+     * @note The answer is expected at BleConnectionManager::onParametersUpdated()
+     *       or BleConnectionManager::onRequestTimeout()
+     *
+     * @param params Requested parameters
+     * @return true If the request was sent
+     * @return false If the request could not be sent
+     */
+    virtual bool requestParameters(const BleConnectionParameters &params) = 0;
+};
+
+//-------------------------------------------------------------------
+// Connection manager
+//-------------------------------------------------------------------
+
+/**
+ * @brief Request the connection parameters of the selected profile
+ *
+ * @note When the host computer rejects a request, or answers with
+ *       parameters out of the requested range, the request is sent
+ *       again with a wider connection interval, up to
+ *       BLE_CONN_MAX_ATTEMPTS times. Then, the parameters of the
+ *       host computer are used.
+ *       Not thread-safe.
+ */
+class BleConnectionManager
+{
+public:
+    /**
+     * @brief Create a connection manager
+     *
+     * @param connection Connection to the host computer
+     */
+    BleConnectionManager(BleConnection &connection) : _connection{connection} {}
+
+    /**
+     * @brief Get the parameters to request for a profile
+     *
+     * @param profile Connection profile
+     * @param attempt Count of rejected requests for this profile
+     * @return BleConnectionParameters Parameters to request
+     */
+    static BleConnectionParameters parametersFor(BleConnectionProfile profile, uint8_t attempt = 0)
+    {
+        BleConnectionParameters params;
+        switch (profile)
+        {
+        case BleConnectionProfile::COMPETITIVE:
+            params = {6, 6, 0, 200};
+            break;
+        case BleConnectionProfile::BATTERY:
+            params = {24, 40, 4, 600};
+            break;
+        default:
+            params = {9, 12, 0, 400};
+            break;
+        }
+        // Each rejection doubles the maximum connection interval
+        uint32_t maxInterval = static_cast<uint32_t>(params.maxInterval) << attempt;
+        params.maxInterval =
+            (maxInterval > BLE_CONN_MAX_INTERVAL) ? BLE_CONN_MAX_INTERVAL : maxInterval;
+        return params;
+    }
+
+    /**
+     * @brief Select a profile
+     *
+     * @note If connected, the new parameters are requested at once
+     *
+     * @param profile Connection profile
+     */
+    void setProfile(BleConnectionProfile profile)
+    {
+        if (profile > BleConnectionProfile::_MAX_VALUE)
+            return;
+        _status.profile = profile;
+        if (_status.state != BleConnectionState::DISCONNECTED)
+            restart();
+    }
+
+    /**
+     * @brief Notify a new connection
+     *
+     * @param interval Current connection interval in 1.25 ms units
+     * @param latency Current peripheral latency
+     * @param timeout Current supervision timeout in 10 ms units
+     */
+    void onConnected(uint16_t interval, uint16_t latency, uint16_t timeout)
+    {
+        record(interval, latency, timeout);
+        restart();
+    }
+
+    /**
+     * @brief Notify a disconnection
+     *
+     */
+    void onDisconnected()
+    {
+        _status.state = BleConnectionState::DISCONNECTED;
+        _status.interval = 0;
+        _status.latency = 0;
+        _status.timeout = 0;
+        _status.attempts = 0;
+    }
+
+    /**
+     * @brief Notify new connection parameters from the host computer
+     *
+     * @param interval Connection interval in 1.25 ms units
+     * @param latency Peripheral latency
+     * @param timeout Supervision timeout in 10 ms units
+     */
+    void onParametersUpdated(uint16_t interval, uint16_t latency, uint16_t timeout)
+    {
+        if (_status.state == BleConnectionState::DISCONNECTED)
+            return;
+        record(interval, latency, timeout);
+        bool fits = fitsRequest();
+        if (_status.state == BleConnectionState::PENDING)
+        {
+            if (fits)
+                _status.state = BleConnectionState::ACCEPTED;
+            else
+                retry();
+        }
+        else if ((_status.state == BleConnectionState::ACCEPTED) && !fits)
+            // The host computer changed the parameters on its own
+            restart();
+    }
+
+    /**
+     * @brief Notify that the host computer did not answer the last request
+     *
+     */
+    void onRequestTimeout()
+    {
+        if (_status.state == BleConnectionState::PENDING)
+            retry();
+    }
+
+    /**
+     * @brief Get the negotiation status
+     *
+     * @return const BleConnectionStatus& Status
+     */
+    const BleConnectionStatus &getStatus() const { return _status; }
+
+private:
+    BleConnection &_connection;
+    BleConnectionStatus _status;
+
+    void record(uint16_t interval, uint16_t latency, uint16_t timeout)
+    {
+        _status.interval = interval;
+        _status.latency = latency;
+        _status.timeout = timeout;
+    }
+
+    bool fitsRequest() const
+    {
+        BleConnectionParameters params =
+            parametersFor(_status.profile, _status.attempts - 1);
+        return (_status.interval >= params.minInterval) &&
+               (_status.interval <= params.maxInterval) &&
+               (_status.latency <= params.latency);
+    }
+
+    void restart()
+    {
+        _status.attempts = 0;
+        request();
+    }
+
+    void retry()
+    {
+        if (_status.attempts < BLE_CONN_MAX_ATTEMPTS)
+            request();
+        else
+            _status.state = BleConnectionState::SETTLED;
+    }
+
+    void request()
+    {
+        // Note: a request that can not be sent counts as rejected
+        while (_status.attempts < BLE_CONN_MAX_ATTEMPTS)
+        {
+            BleConnectionParameters params = parametersFor(_status.profile, _status.attempts);
+            _status.attempts++;
+            if (_connection.requestParameters(params))
+            {
+                _status.state = BleConnectionState::PENDING;
+                return;
+            }
+        }
+        _status.state = BleConnectionState::SETTLED;
+    }
+};
@@ -0,0 +1,49 @@
+/**
+ * @file Checksum.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Checksums for data exchanged with the host computer
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+
+//-------------------------------------------------------------------
+// CRC
+//-------------------------------------------------------------------
+
+/// @brief Initial value of a CRC-16
+#define CRC16_INIT 0xFFFF
+
+/**
+ * @brief Compute a CRC-16/CCITT-FALSE (polynomial 1021 hexadecimal)
+ *
+ * @note Bitwise, since data is short. To compute the CRC
+ *       of non-contiguous data, pass the previous result
+ *       as @p crc.
+ *
+ * @param data Data
+ * @param size Size of @p data in bytes
+ * @param crc Previous CRC or CRC16_INIT
+ * @return constexpr uint16_t CRC
+ */
+constexpr uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc = CRC16_INIT)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= ((uint16_t)data[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    return crc;
+}
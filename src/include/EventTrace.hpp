@@ -0,0 +1,152 @@
+/**
+ * @file EventTrace.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Lock-free trace of the last input events
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "InternalTypes.hpp"
+#include <cstdint>
+#include <atomic>
+
+//-------------------------------------------------------------------
+// Compile-time configuration
+//-------------------------------------------------------------------
+
+#ifndef EVENT_TRACE_DEPTH
+/**
+ * @brief Count of input events kept in the trace
+ *
+ * @note Memory is statically reserved, even if
+ *       the trace is never enabled.
+ */
+#define EVENT_TRACE_DEPTH 64
+#endif
+
+//-------------------------------------------------------------------
+// Trace entry
+//-------------------------------------------------------------------
+
+/**
+ * @brief An input event as seen by the input hub
+ *
+ * @note Not initialized at construction, for performance.
+ */
+struct InputTraceEntry
+{
+    /// @brief Time of processing in microseconds (wraps around)
+    uint32_t timestampUs;
+    /// @brief Input event before any filter
+    DecouplingEvent input;
+    /// @brief False if the event was consumed by the input hub
+    ///        (for example, a command), so no HID report was sent
+    bool reported;
+    /// @brief HID buttons state (low-order bytes)
+    uint64_t inputsLow;
+    /// @brief HID buttons state (high-order bytes)
+    uint64_t inputsHigh;
+    /// @brief HID state of the DPAD
+    uint8_t POVstate;
+    /// @brief HID position of the left axis
+    uint8_t leftAxis;
+    /// @brief HID position of the right axis
+    uint8_t rightAxis;
+    /// @brief HID position of the clutch axis
+    uint8_t clutchAxis;
+};
+
+//-------------------------------------------------------------------
+// Ring buffer
+//-------------------------------------------------------------------
+
+/**
+ * @brief Ring buffer for a single writer and any count of readers
+ *
+ * @note Neither the writer nor the readers ever block.
+ *       Each item is identified by a sequence number,
+ *       starting from zero. A reader detects when an item
+ *       is overwritten while being copied.
+ *
+ * @tparam T Item type (trivially copyable)
+ * @tparam N Count of items kept
+ */
+template <typename T, uint32_t N>
+class TraceRing
+{
+    static_assert(N > 0, "TraceRing capacity must be greater than zero");
+
+public:
+    /**
+     * @brief Add an item, overwriting the oldest one if full
+     *
+     * @note Not thread-safe. Call from a single thread.
+     *
+     * @param item Item
+     */
+    void push(const T &item)
+    {
+        uint32_t sequence = _count.load(std::memory_order_relaxed);
+        _started.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _items[sequence % N] = item;
+        _count.store(sequence + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Get an item
+     *
+     * @param sequence Sequence number of the item
+     * @param[out] item Copy of the item
+     * @return true On success
+     * @return false If @p sequence was not pushed yet
+     *               or it was overwritten
+     */
+    bool get(uint32_t sequence, T &item) const
+    {
+        uint32_t count = _count.load(std::memory_order_acquire);
+        if ((sequence >= count) || ((count - sequence) > N))
+            return false;
+        item = _items[sequence % N];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (_started.load(std::memory_order_relaxed) - sequence) <= N;
+    }
+
+    /**
+     * @brief Count of items pushed since the beginning
+     *
+     * @return uint32_t Sequence number of the next item
+     */
+    uint32_t count() const { return _count.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Sequence number of the oldest item kept
+     *
+     * @return uint32_t Sequence number
+     */
+    uint32_t oldest() const
+    {
+        uint32_t count = _count.load(std::memory_order_acquire);
+        return (count > N) ? (count - N) : 0;
+    }
+
+    /// @brief Count of items kept
+    static constexpr uint32_t capacity() { return N; }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _count{0};
+    std::atomic<uint32_t> _started{0};
+};
+
+/// @brief Trace of input events
+typedef TraceRing<InputTraceEntry, EVENT_TRACE_DEPTH> InputEventTrace;
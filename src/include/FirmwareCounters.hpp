@@ -0,0 +1,189 @@
+/**
+ * @file FirmwareCounters.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Health and performance counters of the firmware itself
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include <atomic>
+
+//-------------------------------------------------------------------
+// Compile-time configuration
+//-------------------------------------------------------------------
+
+#ifndef FIRMWARE_COUNTERS
+/**
+ * @brief Enable the firmware health counters
+ *
+ * @note Counters are relaxed atomics, so they cost a few
+ *       CPU instructions. Set to 0 as a build flag to remove them.
+ */
+#define FIRMWARE_COUNTERS 1
+#endif
+
+//-------------------------------------------------------------------
+// Tasks
+//-------------------------------------------------------------------
+
+/**
+ * @brief Firmware tasks whose stack usage is tracked
+ *
+ */
+enum class FirmwareTask : uint8_t
+{
+    /// @brief Input polling (GPIO and bus polling tasks)
+    INPUT_POLLING = 0,
+    /// @brief Input hub
+    INPUT_HUB,
+    /// @brief User interfaces (one task per instance)
+    UI,
+    /// @brief Battery monitor
+    BATTERY_MONITOR,
+    /// @brief HID worker (output and feature reports)
+    HID_WORKER,
+    _MAX_VALUE = HID_WORKER
+};
+
+/// @brief Count of tracked task kinds
+#define FIRMWARE_TASK_COUNT (static_cast<uint8_t>(FirmwareTask::_MAX_VALUE) + 1)
+/// @brief Maximum count of tracked task instances
+#define FIRMWARE_TASK_SLOTS 8
+
+//-------------------------------------------------------------------
+// Counters
+//-------------------------------------------------------------------
+
+/**
+ * @brief Health and performance counters
+ *
+ * @note Counters are never reset at run time. They wrap around.
+ *       Use the macros below to update them, so they can be
+ *       compiled out.
+ */
+struct FirmwareCounters
+{
+    /// @brief Count of input polling iterations
+    inline static std::atomic<uint32_t> scanCount{0};
+    /// @brief Count of input polling iterations started too late
+    inline static std::atomic<uint32_t> scanOverruns{0};
+    /// @brief Highest count of events waiting in the decoupling queue
+    inline static std::atomic<uint32_t> queueHighWaterMark{0};
+    /// @brief Count of events lost because the decoupling queue was full
+    inline static std::atomic<uint32_t> queueDrops{0};
+    /// @brief Count of events processed by the input hub
+    inline static std::atomic<uint32_t> hubEvents{0};
+    /// @brief Count of input reports sent to the host
+    inline static std::atomic<uint32_t> reportsSent{0};
+    /// @brief Count of failed I2C transactions per bus
+    inline static std::atomic<uint32_t> i2cErrors[2]{};
+    /// @brief Count of bits lost because a BitQueue was full
+    inline static std::atomic<uint32_t> bitQueueOverflows{0};
+    /// @brief Count of telemetry delta reports lost (sequence gaps)
+    inline static std::atomic<uint32_t> telemetryDeltasLost{0};
+    /// @brief Count of output and feature reports lost because
+    ///        the queue of the HID worker task was full
+    inline static std::atomic<uint32_t> hidReportDrops{0};
+
+    /**
+     * @brief Update a high-water mark
+     *
+     * @param counter High-water mark
+     * @param value Current value
+     */
+    static void updateMax(std::atomic<uint32_t> &counter, uint32_t value)
+    {
+        uint32_t current = counter.load(std::memory_order_relaxed);
+        while ((value > current) &&
+               !counter.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            ;
+    }
+
+    /**
+     * @brief Track the stack usage of a task
+     *
+     * @note Ignored if there are no free slots
+     *
+     * @param task Kind of task
+     * @param handle Task handle
+     */
+    static void registerTask(FirmwareTask task, void *handle)
+    {
+        uint8_t slot = _taskCount.fetch_add(1);
+        if (slot < FIRMWARE_TASK_SLOTS)
+        {
+            _taskKind[slot] = task;
+            _taskHandle[slot].store(handle);
+        }
+    }
+
+    /**
+     * @brief Get a tracked task
+     *
+     * @param slot Slot index
+     * @param[out] task Kind of task
+     * @return void* Task handle or nullptr if the slot is empty
+     */
+    static void *getTask(uint8_t slot, FirmwareTask &task)
+    {
+        if (slot >= FIRMWARE_TASK_SLOTS)
+            return nullptr;
+        void *handle = _taskHandle[slot].load();
+        task = _taskKind[slot];
+        return handle;
+    }
+
+    /**
+     * @brief Clear all counters and tracked tasks
+     *
+     * @note For testing
+     */
+    static void reset()
+    {
+        scanCount = 0;
+        scanOverruns = 0;
+        queueHighWaterMark = 0;
+        queueDrops = 0;
+        hubEvents = 0;
+        reportsSent = 0;
+        i2cErrors[0] = 0;
+        i2cErrors[1] = 0;
+        bitQueueOverflows = 0;
+        telemetryDeltasLost = 0;
+        hidReportDrops = 0;
+        for (uint8_t slot = 0; slot < FIRMWARE_TASK_SLOTS; slot++)
+            _taskHandle[slot] = nullptr;
+        _taskCount = 0;
+    }
+
+private:
+    inline static std::atomic<uint8_t> _taskCount{0};
+    inline static FirmwareTask _taskKind[FIRMWARE_TASK_SLOTS]{};
+    inline static std::atomic<void *> _taskHandle[FIRMWARE_TASK_SLOTS]{};
+};
+
+#if FIRMWARE_COUNTERS
+/// @brief Increment a firmware counter
+#define COUNT_EVENT(counter) FirmwareCounters::counter.fetch_add(1, std::memory_order_relaxed)
+/// @brief Add a number of events to a firmware counter
+#define COUNT_EVENTS(counter, n) FirmwareCounters::counter.fetch_add((n), std::memory_order_relaxed)
+/// @brief Update a firmware high-water mark
+#define COUNT_MAX(counter, value) FirmwareCounters::updateMax(FirmwareCounters::counter, (value))
+/// @brief Track the stack usage of a firmware task
+#define COUNT_TASK(task, handle) FirmwareCounters::registerTask((task), (void *)(handle))
+#else
+#define COUNT_EVENT(counter)
+#define COUNT_EVENTS(counter, n)
+#define COUNT_MAX(counter, value)
+#define COUNT_TASK(task, handle)
+#endif
@@ -17,6 +17,7 @@
 
 #include "InternalTypes.hpp"
 #include "SimWheelTypes.hpp"
+#include "I2CBusManager.hpp"
 
 //-------------------------------------------------------------------
 // GLOBALS
@@ -43,6 +44,20 @@ typedef void (*ISRHandler)(void *arg);
 #define DELAY_MS(ms) std::this_thread::sleep_for(std::chrono::milliseconds(ms))
 #endif
 
+#if !CD_CI
+/// @brief Current value of the CPU cycle counter (requires "esp_cpu.h")
+#define CPU_CYCLE_COUNT() ((uint32_t)esp_cpu_get_cycle_count())
+/// @brief Convert a count of CPU cycles to nanoseconds
+#define CPU_CYCLES_TO_NS(cycles) \
+    ((uint32_t)(((uint64_t)(cycles) * 1000ULL) / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ))
+#else
+#define CPU_CYCLE_COUNT()                                                   \
+    ((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(       \
+         std::chrono::steady_clock::now().time_since_epoch())               \
+         .count())
+#define CPU_CYCLES_TO_NS(cycles) ((uint32_t)(cycles))
+#endif
+
 // Each CPU instruction takes 6.25 nanoseconds in an ESP32 RISC-V @ 160 Mhz
 // Each CPU instruction takes 4.16 nanoseconds in an ESP32 Xtensa @ 240 Mhz
 
@@ -129,6 +144,30 @@ public:
     virtual ~i2c_device_not_found() noexcept {}
 };
 
+/**
+ * @brief Exception for I2C devices not accepting their configuration
+ *
+ */
+class i2c_device_not_configured : public std::runtime_error
+{
+public:
+    /**
+     * @brief Construct a new i2c_device_not_configured exception
+     *
+     * @param address I2C full address
+     * @param bus I2C bus
+     */
+    i2c_device_not_configured(uint8_t address, int bus = 0)
+        : std::runtime_error(
+              "I2C: unable to configure device. Bus=" +
+              std::to_string(bus) +
+              " Full address=" +
+              std::to_string(address) +
+              " (dec)") {}
+
+    virtual ~i2c_device_not_configured() noexcept {}
+};
+
 /**
  * @brief Exception for unknown full I2C address
  *
@@ -203,35 +242,52 @@ namespace internals
              *
              * @note Called from other namespaces. No need to call in user code.
              *
+             * @note If a device address is given, the bus clock is switched
+             *       to @p max_speed_multiplier for every transaction to that
+             *       device, so other devices are not slowed down.
+             *       Otherwise, the whole bus is downgraded to
+             *       @p max_speed_multiplier for devices with no known speed.
+             *
              * @param max_speed_multiplier Maximum clock speed multiplier
-             *                             supported in the range from 1 to 4.
+             *                             supported in the range from
+             *                             I2C_STANDARD_MODE to I2C_FAST_MODE_PLUS.
+             *                             Limited to I2C_FAST_MODE on the
+             *                             original ESP32.
              * @param bus I2C bus required.
+             * @param address7bits Address of the device in 7-bit format
+             *                     or 0xFF for none.
              */
             void require(
-                uint8_t max_speed_multiplier = 4,
-                I2CBus bus = I2CBus::PRIMARY);
+                uint8_t max_speed_multiplier = I2C_FAST_MODE,
+                I2CBus bus = I2CBus::PRIMARY,
+                uint8_t address7bits = 0xFF);
 
             /**
              * @brief Check slave device availability on an I2C bus.
              *
-             * @note require() must be called first.
+             * @note No need to call require(). If not initialized,
+             *       the bus is initialized temporarily to minimum speed.
+             *       Otherwise, the probe is a bus transaction
+             *       on behalf of @p client, so it is thread-safe.
              *
              * @param address7bits I2C address of a slave device in 7 bits format.
              * @param bus I2C bus.
+             * @param client Bus client for arbitration and statistics.
              * @return true If the slave device is available and ready.
-             * @return false If the slave device is not responding or
-             *         the bus was not initialized.
+             * @return false If the slave device is not responding.
              */
             bool probe(
                 uint8_t address7bits,
-                I2CBus bus = I2CBus::PRIMARY);
+                I2CBus bus = I2CBus::PRIMARY,
+                I2CClient client = I2CClient::INPUTS);
 
             /**
              * @brief Retrieve all devices available on an I2C bus.
              *
              * @note No need to call require().
-             *       The bus will be initialized to minimum speed temporarily,
-             *       then reinitialized to previous parameters (if any).
+             *       The bus clock is set to minimum speed while probing.
+             *       Reserved addresses are not probed.
+             *       Not thread-safe. To be called at setup only.
              *
              * @param[out] result List of addresses found,
              *                    in 7-bit format.
@@ -241,6 +297,34 @@ namespace internals
                 std::vector<uint8_t> &result,
                 I2CBus bus = I2CBus::PRIMARY);
 
+            /**
+             * @brief Retrieve all devices available on both I2C buses
+             *
+             * @note Both buses are probed in parallel.
+             *       The secondary bus is not probed if not initialized.
+             *       Not thread-safe. To be called at setup only.
+             *
+             * @param[out] primary List of addresses found in the primary bus,
+             *                     in 7-bit format.
+             * @param[out] secondary List of addresses found in the secondary bus,
+             *                       in 7-bit format.
+             */
+            void probe(
+                std::vector<uint8_t> &primary,
+                std::vector<uint8_t> &secondary);
+
+            /**
+             * @brief Check if an address is reserved by the I2C specification
+             *
+             * @param address7bits I2C address in 7 bits format.
+             * @return true If reserved (0x00 to 0x07 and 0x78 to 0x7F)
+             * @return false If available for devices
+             */
+            inline bool isReservedAddress(uint8_t address7bits)
+            {
+                return (address7bits < 0x08) || (address7bits > 0x77);
+            }
+
             /**
              * @brief Abort and reboot on an invalid I2C address
              *
@@ -274,6 +358,89 @@ namespace internals
                 std::vector<uint8_t> &fullAddressList,
                 uint8_t hardwareAddress,
                 uint8_t hardwareAddressMask = 0b00000111);
+
+            /**
+             * @brief Execute a number of transactions in an I2C bus
+             *
+             * @note Blocking. Thread-safe. Pending clients are served by priority
+             *       and back-to-back transactions to the same device are
+             *       coalesced into a single bus operation.
+             *
+             * @note require() must be called first.
+             *
+             * @param bus I2C bus
+             * @param client Client requesting the transactions
+             * @param transactions Transactions to execute in strict order
+             * @param count Count of transactions
+             * @return true If all transactions were successful
+             * @return false Otherwise
+             */
+            bool execute(
+                I2CBus bus,
+                I2CClient client,
+                I2CTransaction *transactions,
+                size_t count = 1);
+
+            /**
+             * @brief Release a stuck I2C bus
+             *
+             * @note Blocking. Thread-safe. SCL is clocked until
+             *       the device holding SDA low releases it,
+             *       then a STOP condition is generated.
+             *
+             * @param bus I2C bus
+             * @param client Client requesting the recovery
+             * @return true If the bus is idle
+             * @return false If the bus is still stuck
+             */
+            bool recover(I2CBus bus, I2CClient client);
+
+            /**
+             * @brief Start the execution of a number of transactions in an I2C bus
+             *
+             * @note Non-blocking. Thread-safe.
+             *       Requests are served by priority as in execute().
+             *
+             * @note require() must be called first.
+             *
+             * @param bus I2C bus
+             * @param request Transactions to execute.
+             *                Check request.pending for completion.
+             * @return true If the request was queued
+             * @return false If the request is still pending from a previous call
+             */
+            bool submit(I2CBus bus, I2CRequest &request);
+
+            /**
+             * @brief Get the bus usage of an I2C client
+             *
+             * @param bus I2C bus
+             * @param client I2C client
+             * @return I2CClientStatistics Bus usage
+             */
+            I2CClientStatistics getStatistics(I2CBus bus, I2CClient client);
+
+            /**
+             * @brief Get the bus usage of every device at its clock speed
+             *
+             * @note Useful to balance devices between buses.
+             *
+             * @param[out] result Bus usage of every device accessed so far
+             * @param[in] bus I2C bus
+             */
+            void getDeviceStatistics(
+                std::vector<I2CDeviceStatistics> &result,
+                I2CBus bus = I2CBus::PRIMARY);
+
+#if CD_CI
+            /**
+             * @brief Replace the bus hardware with a fake one
+             *
+             * @param executor Function executing transactions
+             *                 or nullptr to succeed always
+             */
+            void setFakeExecutor(I2CExecutor executor);
+#endif
         } // namespace i2c
 
         //---------------------------------------------------------------
@@ -340,5 +507,23 @@ namespace internals
             void enableISR(InputGPIO pin, ISRHandler handler, void *param = nullptr);
 
         } // namespace gpio
+
+        //---------------------------------------------------------------
+        // Task monitoring
+        //---------------------------------------------------------------
+
+        namespace task
+        {
+            /**
+             * @brief Get the minimum free stack space ever seen by a task
+             *
+             * @note On testing, the fake task handle is the result.
+             *
+             * @param handle Task handle
+             * @return uint32_t Stack high-water mark in bytes
+             */
+            uint32_t getStackHighWaterMark(void *handle);
+
+        } // namespace task
     } // namespace hal
 } // namespace internals
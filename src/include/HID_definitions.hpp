@@ -18,6 +18,8 @@
 //-------------------------------------------------------------------
 
 #include <cinttypes>
+#include <initializer_list>
+#include "InputBitmap.hpp" // For INPUT_BITMAP_WIDTH
 
 //-------------------------------------------------------------------
 // Report ID's
@@ -33,6 +35,18 @@
 #define RID_FEATURE_BUTTONS_MAP 0x04
 /// @brief Custom VID/PID report ID
 #define RID_FEATURE_HARDWARE_ID 0x05
+/// @brief Input read cost report ID
+#define RID_FEATURE_INPUT_PROFILE 0x06
+/// @brief Firmware health report ID
+#define RID_FEATURE_HEALTH 0x07
+/// @brief Input event trace report ID
+#define RID_FEATURE_EVENT_TRACE 0x08
+/// @brief Bulk input map report ID
+#define RID_FEATURE_BUTTONS_MAP_BULK 0x09
+/// @brief Settings image report ID
+#define RID_FEATURE_SETTINGS_IMAGE 0x0A
+/// @brief BLE connection parameters report ID
+#define RID_FEATURE_BLE_CONNECTION 0x0B
 
 /// @brief Powertrain telemetry report ID
 #define RID_OUTPUT_POWERTRAIN 0x14   // 20 dec
@@ -42,8 +56,12 @@
 #define RID_OUTPUT_RACE_CONTROL 0x16 // 22 dec
 /// @brief Gauges report ID
 #define RID_OUTPUT_GAUGES 0x17       // 23 dec
+/// @brief Telemetry delta report ID
+#define RID_OUTPUT_TELEMETRY_DELTA 0x18 // 24 dec
 /// @brief Pixel control report ID
 #define RID_OUTPUT_PIXEL 0x1E        // 30 dec
+/// @brief Pixel frame report ID
+#define RID_OUTPUT_PIXEL_FRAME 0x1F  // 31 dec
 
 //-------------------------------------------------------------------
 // Report sizes (bytes)
@@ -59,6 +77,24 @@
 #define BUTTONS_MAP_REPORT_SIZE 3
 /// @brief Custom VID/PID report size
 #define HARDWARE_ID_REPORT_SIZE 6
+/// @brief Input read cost report size
+#define INPUT_PROFILE_REPORT_SIZE 24
+/// @brief Firmware health report size
+#define HEALTH_REPORT_SIZE 58
+/// @brief Input event trace report size (depends on the input bitmap width)
+#define EVENT_TRACE_REPORT_SIZE (36 + 2 * (INPUT_BITMAP_WIDTH / 8))
+/// @brief Count of firmware-defined input numbers in a page of the bulk input map
+#define BUTTONS_MAP_PAGE_SIZE 32
+/// @brief Count of pages in the bulk input map
+#define BUTTONS_MAP_PAGE_COUNT (INPUT_BITMAP_WIDTH / BUTTONS_MAP_PAGE_SIZE)
+/// @brief Bulk input map report size
+#define BUTTONS_MAP_BULK_REPORT_SIZE (4 + 2 * BUTTONS_MAP_PAGE_SIZE)
+/// @brief Bytes of the settings image in a page
+#define SETTINGS_IMAGE_PAGE_SIZE 64
+/// @brief Settings image report size
+#define SETTINGS_IMAGE_REPORT_SIZE (4 + SETTINGS_IMAGE_PAGE_SIZE)
+/// @brief BLE connection parameters report size
+#define BLE_CONNECTION_REPORT_SIZE 9
 /// @brief Powertrain telemetry report size
 #define POWERTRAIN_REPORT_SIZE 10
 /// @brief ECU telemetry report size
@@ -67,8 +103,22 @@
 #define RACE_CONTROL_REPORT_SIZE 11
 /// @brief Gauges report size
 #define GAUGES_REPORT_SIZE 12
+/// @brief Telemetry delta report size
+#define TELEMETRY_DELTA_REPORT_SIZE 24
+/// @brief Telemetry delta flag: the sequence number starts over
+#define TELEMETRY_DELTA_FLAG_RESYNC 0x01
 /// @brief Pixel control report size
 #define PIXEL_REPORT_SIZE 6
+/// @brief Maximum count of pixels in a pixel frame report (range mode)
+#define PIXEL_FRAME_MAX_PIXELS 20
+/// @brief Maximum count of runs in a pixel frame report (RLE mode)
+#define PIXEL_FRAME_MAX_RUNS 15
+/// @brief Pixel frame report size
+#define PIXEL_FRAME_REPORT_SIZE (4 + 3 * PIXEL_FRAME_MAX_PIXELS)
+/// @brief Pixel frame flag: show all pixels after this report
+#define PIXEL_FRAME_FLAG_SHOW 0x01
+/// @brief Pixel frame flag: items are RLE runs instead of single pixels
+#define PIXEL_FRAME_FLAG_RLE 0x02
 
 //-------------------------------------------------------------------
 // GAME CONTROLLER APPEARANCES
@@ -105,8 +155,17 @@
 // BLE_MTU_SIZE must be greater than 23 bytes
 // BLE_MTU_SIZE = max report size + report ID + payload metadata
 
+/// @brief Greatest of two report sizes
+#define HID_MAX_SIZE(a, b) (((a) > (b)) ? (a) : (b))
+
+/// @brief Size of the largest report
+#define HID_MAX_REPORT_SIZE                                                \
+    HID_MAX_SIZE(                                                          \
+        HID_MAX_SIZE(EVENT_TRACE_REPORT_SIZE, SETTINGS_IMAGE_REPORT_SIZE), \
+        HID_MAX_SIZE(BUTTONS_MAP_BULK_REPORT_SIZE, PIXEL_FRAME_REPORT_SIZE))
+
 /// @brief MTU size for BLE
-#define BLE_MTU_SIZE GAMEPAD_REPORT_SIZE + 1 + 14
+#define BLE_MTU_SIZE (HID_MAX_REPORT_SIZE + 1 + 14)
 
 //-------------------------------------------------------------------
 // Hardware revision
@@ -122,7 +181,7 @@
 /// @brief Major version of the data exchange protocol
 #define DATA_MAJOR_VERSION 1
 /// @brief Minor version of the data exchange protocol
-#define DATA_MINOR_VERSION 6
+#define DATA_MINOR_VERSION 14
 
 //-------------------------------------------------------------------
 // Magic number, do not change
@@ -134,64 +193,91 @@
 #define MAGIC_NUMBER_HIGH 0xBF
 
 //-------------------------------------------------------------------
-// HID report descriptor
+// Input report layout
 //-------------------------------------------------------------------
 
+#ifndef HID_COMPACT_INPUT_REPORT
+/**
+ * @brief Fit the input report to the device capabilities
+ *
+ * @note If 0, the input report always holds 128 buttons, three axes
+ *       and a hat switch (GAMEPAD_REPORT_SIZE bytes).
+ *       If 1, unused axes are left out and buttons are limited
+ *       to the highest user-defined input number in the factory map
+ *       (not the user-defined map), so the report descriptor
+ *       only changes with a new firmware.
+ *       Buttons mapped by the user beyond that limit are not reported.
+ *       Host software parsing raw input reports must read the
+ *       HID report descriptor to locate the fields.
+ */
+#define HID_COMPACT_INPUT_REPORT 0
+#endif
+
 /**
- * @brief HID descriptor
+ * @brief Fields in the input report
  *
+ * @note Fields are always in the same order: buttons, clutch axis,
+ *       left and right axes, and a byte holding the hat switch
+ *       and the feature notification.
  */
-static const uint8_t hid_descriptor[] = {
-    0x05, 0x01,                    // UsagePage(Generic Desktop[1])
-    0x09, CONTROLLER_TYPE_GAMEPAD, // UsageId
-    0xA1, 0x01,                    // Collection(Application)
-
-    // ___ INPUT REPORT ___
-    0x85, RID_INPUT_GAMEPAD, //     ReportId
-
-    //     Buttons (128 bits=16 bytes)
-    0x05, 0x09, //     UsagePage(Button[9])
-    0x19, 0x01, //     UsageIdMin(Button 1[1])
-    0x29, 0x80, //     UsageIdMax(Button 128[128])
-    0x15, 0x00, //     LogicalMinimum(0)
-    0x25, 0x01, //     LogicalMaximum(1)
-    0x95, 0x80, //     ReportCount(128)
-    0x75, 0x01, //     ReportSize(1)
-    0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-
-    //     axis (1 byte)
-    0x05, 0x01, //     UsagePage(Generic Desktop[1])
-    0x09, 0x35, //     UsageId(Rz[53])
-    // 0x15, 0x00, //     LogicalMinimum
-    // 0x25, CLUTCH_FULL_VALUE, //     LogicalMaximum
-    0x26, 0xFE, 0x00, //     LogicalMaximum(254)
-    0x95, 0x01,       //     ReportCount(1)
-    0x75, 0x08,       //     ReportSize(8)
-    0x81, 0x02,       //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-
-    //     axis (1 byte)
-    0x09, 0x34, //     UsageId(Ry[52])
-    0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-
-    //     axis (1 byte)
-    0x09, 0x33, //     UsageId(Rx[51])
-    0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-
-    //     D-PAD (hat switch), (4 bits)
-    0x09, 0x39,       //     UsageId(Hat Switch[57])
-    0x46, 0x40, 0x01, //     PhysicalMaximum(320)
-    0x65, 0x14,       //     Unit('degrees', EnglishRotation, Degrees:1)
-    0x15, 0x01,       //     LogicalMinimum(1)
-    0x25, 0x08,       //     LogicalMaximum(8)
-    0x75, 0x04,       //     ReportSize(4)
-    0x81, 0x02,       //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-
-    //     Feature notification (4 bits)
-    0x09, 0x47, //     UsageId(Feature Notification[71])
-    0x45, 0x00, //     PhysicalMaximum(0)
-    0x65, 0x00, //     Unit(None)
-    0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+struct HidInputLayout
+{
+    /// @brief Count of buttons (a multiple of 8 in the range [8,BUTTON_COUNT])
+    uint8_t buttonCount = BUTTON_COUNT;
+    /// @brief Report the clutch axis (Rz)
+    bool clutchAxis = true;
+    /// @brief Report the left and right axes (Ry and Rx)
+    bool analogAxes = true;
+    /// @brief Report the hat switch. Otherwise, those bits are constant.
+    bool hatSwitch = true;
+
+    /**
+     * @brief Get the size of the input report
+     *
+     * @return constexpr uint8_t Size in bytes (without report ID)
+     */
+    constexpr uint8_t reportSize() const
+    {
+        return (buttonCount / 8) + (clutchAxis ? 1 : 0) + (analogAxes ? 2 : 0) + 1;
+    }
+
+    /**
+     * @brief Get a layout for a number of buttons
+     *
+     * @param highestButton Highest button number (zero-based)
+     * @param clutchAxis Report the clutch axis
+     * @param analogAxes Report the left and right axes
+     * @param hatSwitch Report the hat switch
+     * @return constexpr HidInputLayout Layout
+     */
+    static constexpr HidInputLayout fit(
+        uint8_t highestButton,
+        bool clutchAxis,
+        bool analogAxes,
+        bool hatSwitch)
+    {
+        HidInputLayout layout;
+        uint16_t buttonCount = ((highestButton / 8) + 1) * 8;
+        layout.buttonCount = (buttonCount > BUTTON_COUNT) ? BUTTON_COUNT : buttonCount;
+        layout.clutchAxis = clutchAxis;
+        layout.analogAxes = analogAxes;
+        layout.hatSwitch = hatSwitch;
+        return layout;
+    }
+};
+
+//-------------------------------------------------------------------
+// HID report descriptor
+//-------------------------------------------------------------------
+
+/// @brief Maximum size of the input report part of the HID descriptor
+#define HID_INPUT_DESCRIPTOR_MAX_SIZE 68
 
+/**
+ * @brief HID descriptor of all reports but the input report
+ *
+ */
+static constexpr uint8_t hid_descriptor_tail[] = {
     // ___ CAPABILITIES (FEATURE) REPORT ___
     0x09, 0x00,                     // USAGE (undefined)
     0x15, 0x00,                     // LogicalMinimum(0)
@@ -201,6 +287,13 @@ static const uint8_t hid_descriptor[] = {
     0x95, CAPABILITIES_REPORT_SIZE, // Report count
     0xb1, 0x23,                     // FEATURE (Cnst,var,abs,Nprf)
 
+    // ___ HEALTH (FEATURE) REPORT ___
+    0x09, 0x00,               // USAGE (undefined)
+    0x85, RID_FEATURE_HEALTH, // REPORT ID
+    0x75, 0x08,               // Report Size (8)
+    0x95, HEALTH_REPORT_SIZE, // Report count
+    0xb1, 0x23,               // FEATURE (Cnst,var,abs,Nprf)
+
     // ___ CONFIG (FEATURE) REPORT ___
     0x09, 0x00,               // USAGE (undefined)
     0x85, RID_FEATURE_CONFIG, // REPORT ID
@@ -222,6 +315,41 @@ static const uint8_t hid_descriptor[] = {
     0x95, HARDWARE_ID_REPORT_SIZE, // Report count
     0xb1, 0xa2,                    // FEATURE (Data,var,abs,Nprf,Vol)
 
+    // ___ INPUT PROFILE (FEATURE) REPORT ___
+    0x09, 0x00,                      // USAGE (undefined)
+    0x85, RID_FEATURE_INPUT_PROFILE, // REPORT ID
+    0x75, 0x08,                      // Report Size (8)
+    0x95, INPUT_PROFILE_REPORT_SIZE, // Report count
+    0xb1, 0xa2,                      // FEATURE (Data,var,abs,Nprf,Vol)
+
+    // ___ EVENT TRACE (FEATURE) REPORT ___
+    0x09, 0x00,                    // USAGE (undefined)
+    0x85, RID_FEATURE_EVENT_TRACE, // REPORT ID
+    0x75, 0x08,                    // Report Size (8)
+    0x95, EVENT_TRACE_REPORT_SIZE, // Report count
+    0xb1, 0xa2,                    // FEATURE (Data,var,abs,Nprf,Vol)
+
+    // ___ BULK MAP (FEATURE) REPORT ___
+    0x09, 0x00,                         // USAGE (undefined)
+    0x85, RID_FEATURE_BUTTONS_MAP_BULK, // REPORT ID
+    0x75, 0x08,                         // Report Size (8)
+    0x95, BUTTONS_MAP_BULK_REPORT_SIZE, // Report count
+    0xb1, 0xa2,                         // FEATURE (Data,var,abs,Nprf,Vol)
+
+    // ___ SETTINGS IMAGE (FEATURE) REPORT ___
+    0x09, 0x00,                       // USAGE (undefined)
+    0x85, RID_FEATURE_SETTINGS_IMAGE, // REPORT ID
+    0x75, 0x08,                       // Report Size (8)
+    0x95, SETTINGS_IMAGE_REPORT_SIZE, // Report count
+    0xb1, 0xa2,                       // FEATURE (Data,var,abs,Nprf,Vol)
+
+    // ___ BLE CONNECTION (FEATURE) REPORT ___
+    0x09, 0x00,                       // USAGE (undefined)
+    0x85, RID_FEATURE_BLE_CONNECTION, // REPORT ID
+    0x75, 0x08,                       // Report Size (8)
+    0x95, BLE_CONNECTION_REPORT_SIZE, // Report count
+    0xb1, 0xa2,                       // FEATURE (Data,var,abs,Nprf,Vol)
+
     // ___ POWERTRAIN TELEMETRY (OUTPUT) REPORT ___
     0x09, 0x00,                   // USAGE (undefined)
     0x85, RID_OUTPUT_POWERTRAIN,  // REPORT ID
@@ -250,6 +378,13 @@ static const uint8_t hid_descriptor[] = {
     0x95, GAUGES_REPORT_SIZE, // Report count
     0x91, 0x22,               // OUTPUT (Data,var,abs,Nprf)
 
+    // ___ TELEMETRY DELTA (OUTPUT) REPORT ___
+    0x09, 0x00,                        // USAGE (undefined)
+    0x85, RID_OUTPUT_TELEMETRY_DELTA,  // REPORT ID
+    0x75, 0x08,                        // Report Size (8)
+    0x95, TELEMETRY_DELTA_REPORT_SIZE, // Report count
+    0x91, 0x22,                        // OUTPUT (Data,var,abs,Nprf)
+
     // ___ PIXEL CONTROL (OUTPUT) REPORT ___
     0x09, 0x00,              // USAGE (undefined)
     0x85, RID_OUTPUT_PIXEL,  // REPORT ID
@@ -257,11 +392,135 @@ static const uint8_t hid_descriptor[] = {
     0x95, PIXEL_REPORT_SIZE, // Report count
     0x91, 0x22,              // OUTPUT (Data,var,abs,Nprf)
 
+    // ___ PIXEL FRAME (OUTPUT) REPORT ___
+    0x09, 0x00,                    // USAGE (undefined)
+    0x85, RID_OUTPUT_PIXEL_FRAME,  // REPORT ID
+    0x75, 0x08,                    // Report Size (8)
+    0x95, PIXEL_FRAME_REPORT_SIZE, // Report count
+    0x91, 0x22,                    // OUTPUT (Data,var,abs,Nprf)
+
     // END APPLICATION
     0xC0 // EndCollection()
 };
 
-// Input report packed structure:
+/// @brief Maximum size of the HID descriptor
+#define HID_DESCRIPTOR_MAX_SIZE (HID_INPUT_DESCRIPTOR_MAX_SIZE + sizeof(hid_descriptor_tail))
+
+/**
+ * @brief A HID report descriptor
+ *
+ */
+struct HidDescriptor
+{
+    /// @brief Descriptor items
+    uint8_t data[HID_DESCRIPTOR_MAX_SIZE]{};
+    /// @brief Size of the descriptor in bytes
+    uint16_t size = 0;
+
+    /**
+     * @brief Append bytes
+     *
+     * @param bytes Bytes
+     */
+    constexpr void add(std::initializer_list<uint8_t> bytes)
+    {
+        for (uint8_t byte : bytes)
+            data[size++] = byte;
+    }
+};
+
+/**
+ * @brief Build the HID descriptor for an input report layout
+ *
+ * @note The default layout gives the same descriptor
+ *       as previous firmware versions.
+ *
+ * @param layout Input report layout
+ * @return constexpr HidDescriptor HID descriptor
+ */
+constexpr HidDescriptor buildHidDescriptor(const HidInputLayout &layout)
+{
+    HidDescriptor descriptor;
+    descriptor.add({
+        0x05, 0x01,                    // UsagePage(Generic Desktop[1])
+        0x09, CONTROLLER_TYPE_GAMEPAD, // UsageId
+        0xA1, 0x01,                    // Collection(Application)
+
+        // ___ INPUT REPORT ___
+        0x85, RID_INPUT_GAMEPAD, //     ReportId
+
+        //     Buttons (1 bit each)
+        0x05, 0x09,               //     UsagePage(Button[9])
+        0x19, 0x01,               //     UsageIdMin(Button 1[1])
+        0x29, layout.buttonCount, //     UsageIdMax
+        0x15, 0x00,               //     LogicalMinimum(0)
+        0x25, 0x01,               //     LogicalMaximum(1)
+        0x95, layout.buttonCount, //     ReportCount
+        0x75, 0x01,               //     ReportSize(1)
+        0x81, 0x02,               //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+        0x05, 0x01,               //     UsagePage(Generic Desktop[1])
+    });
+
+    //     Axes (1 byte each)
+    uint8_t axes[3] = {};
+    uint8_t axisCount = 0;
+    if (layout.clutchAxis)
+        axes[axisCount++] = 0x35; // UsageId(Rz[53])
+    if (layout.analogAxes)
+    {
+        axes[axisCount++] = 0x34; // UsageId(Ry[52])
+        axes[axisCount++] = 0x33; // UsageId(Rx[51])
+    }
+    for (uint8_t i = 0; i < axisCount; i++)
+    {
+        descriptor.add({0x09, axes[i]}); // UsageId
+        if (i == 0)
+            descriptor.add({
+                0x26, 0xFE, 0x00, //     LogicalMaximum(254)
+                0x95, 0x01,       //     ReportCount(1)
+                0x75, 0x08,       //     ReportSize(8)
+            });
+        descriptor.add({0x81, 0x02}); // Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+    }
+    if (axisCount == 0)
+        descriptor.add({0x95, 0x01}); // ReportCount(1)
+
+    if (layout.hatSwitch)
+        descriptor.add({
+            //     D-PAD (hat switch), (4 bits)
+            0x09, 0x39,       //     UsageId(Hat Switch[57])
+            0x46, 0x40, 0x01, //     PhysicalMaximum(320)
+            0x65, 0x14,       //     Unit('degrees', EnglishRotation, Degrees:1)
+            0x15, 0x01,       //     LogicalMinimum(1)
+            0x25, 0x08,       //     LogicalMaximum(8)
+            0x75, 0x04,       //     ReportSize(4)
+            0x81, 0x02,       //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+
+            //     Feature notification (4 bits)
+            0x09, 0x47, //     UsageId(Feature Notification[71])
+            0x45, 0x00, //     PhysicalMaximum(0)
+            0x65, 0x00, //     Unit(None)
+            0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+        });
+    else
+        descriptor.add({
+            //     Padding (4 bits)
+            0x75, 0x04, //     ReportSize(4)
+            0x81, 0x03, //     Input(Constant, Variable, Absolute)
+
+            //     Feature notification (4 bits)
+            0x09, 0x47, //     UsageId(Feature Notification[71])
+            0x15, 0x00, //     LogicalMinimum(0)
+            0x25, 0x0F, //     LogicalMaximum(15)
+            0x81, 0x02, //     Input(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+        });
+
+    for (uint8_t byte : hid_descriptor_tail)
+        descriptor.add({byte});
+    return descriptor;
+}
+
+// Input report packed structure (default layout):
 // typedef struct {
 //     uint64_t inputsLow;
 //     uint64_t inputsHigh;
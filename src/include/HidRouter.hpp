@@ -0,0 +1,143 @@
+/**
+ * @file HidRouter.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Simultaneous USB and BLE transports
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include <string>
+#include "InternalTypes.hpp"
+
+//-------------------------------------------------------------------
+// Build configuration
+//-------------------------------------------------------------------
+
+#ifndef HID_ROUTER
+/**
+ * @brief Use the USB and BLE transports at the same time
+ *
+ * @note If 1, the USB and BLE implementations do not implement
+ *       the `internals::hid` API, but `internals::hid::usb` and
+ *       `internals::hid::ble`. `hid_router.cpp` implements
+ *       `internals::hid` on top of both. Link `hid_router.cpp`,
+ *       `hid_USB.cpp` and either `hid_NimBLE.cpp` or `hid_ESPBLE.cpp`.
+ *       Requires a board with USB OTG (ESP32-S3, for example).
+ */
+#define HID_ROUTER 0
+#endif
+
+#if HID_ROUTER
+/// @brief Namespace implemented by the USB transport
+#define HID_USB_API internals::hid::usb
+/// @brief Namespace implemented by the BLE transport
+#define HID_BLE_API internals::hid::ble
+#else
+#define HID_USB_API internals::hid
+#define HID_BLE_API internals::hid
+#endif
+
+//-------------------------------------------------------------------
+// Transports
+//-------------------------------------------------------------------
+
+// Same semantics as the `internals::hid` API (see SimWheelInternals.hpp)
+
+namespace internals
+{
+    namespace hid
+    {
+        /// @brief USB transport (when HID_ROUTER is set)
+        namespace usb
+        {
+            void begin(
+                std::string deviceName,
+                std::string deviceManufacturer,
+                bool enableAutoPowerOff,
+                uint16_t VID,
+                uint16_t PID);
+            bool supportsCustomHardwareID();
+            bool isConnected();
+            void reportChangeInConfig();
+            void reportBatteryLevel(int batteryLevel);
+            void reportInput(
+                uint64_t inputsLow,
+                uint64_t inputsHigh,
+                uint8_t POVstate,
+                uint8_t leftAxis,
+                uint8_t rightAxis,
+                uint8_t clutchAxis,
+                bool keepAlive);
+            void reset();
+            void setConnectionProfile(BleConnectionProfile profile);
+            BleConnectionStatus getConnectionStatus();
+        } // namespace usb
+
+        /// @brief BLE transport (when HID_ROUTER is set)
+        namespace ble
+        {
+            void begin(
+                std::string deviceName,
+                std::string deviceManufacturer,
+                bool enableAutoPowerOff,
+                uint16_t VID,
+                uint16_t PID);
+            bool supportsCustomHardwareID();
+            bool isConnected();
+            void reportChangeInConfig();
+            void reportBatteryLevel(int batteryLevel);
+            void reportInput(
+                uint64_t inputsLow,
+                uint64_t inputsHigh,
+                uint8_t POVstate,
+                uint8_t leftAxis,
+                uint8_t rightAxis,
+                uint8_t clutchAxis,
+                bool keepAlive);
+            void reset();
+            void setConnectionProfile(BleConnectionProfile profile);
+            BleConnectionStatus getConnectionStatus();
+        } // namespace ble
+
+        /// @brief Transport routing
+        namespace router
+        {
+            /// @brief No connected transport
+            constexpr uint8_t NO_ROUTE = 0xFF;
+            /// @brief Route index of the USB transport
+            constexpr uint8_t USB_ROUTE = 0;
+            /// @brief Route index of the BLE transport
+            constexpr uint8_t BLE_ROUTE = 1;
+
+            /**
+             * @brief Get the transport currently used for input reports
+             *
+             * @note The connected transport with the lowest latency
+             *
+             * @return uint8_t USB_ROUTE, BLE_ROUTE or NO_ROUTE
+             */
+            uint8_t getRoute();
+
+            /**
+             * @brief Select the route again
+             *
+             * @note Called by the transports on every status change
+             *       instead of raising the OnConnected and OnDisconnected
+             *       events. Those events are raised here when the route
+             *       changes: OnConnected if there is a new route,
+             *       OnDisconnected if there is no route at all.
+             */
+            void update();
+        } // namespace router
+    } // namespace hid
+} // namespace internals
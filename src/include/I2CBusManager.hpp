@@ -0,0 +1,469 @@
+/**
+ * @file I2CBusManager.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Arbitration of I2C transactions from many clients
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include "InternalTypes.hpp"
+#include "SimWheelTypes.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+//-------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------
+
+/**
+ * @brief Clients of an I2C bus
+ *
+ * @note Sorted by priority. The first one has the highest priority.
+ */
+enum class I2CClient : uint8_t
+{
+    /// @brief Input hardware (GPIO expanders)
+    INPUTS = 0,
+    /// @brief User interfaces (LED drivers)
+    UI,
+    /// @brief Battery monitor (fuel gauges)
+    BATTERY_MONITOR,
+    _MAX_VALUE = BATTERY_MONITOR
+};
+
+/// @brief Count of I2C clients
+#define I2C_CLIENT_COUNT (static_cast<uint8_t>(I2CClient::_MAX_VALUE) + 1)
+
+/// @brief I2C clock speed multiplier for Standard-mode (100 KHz)
+#define I2C_STANDARD_MODE 1
+/// @brief I2C clock speed multiplier for Fast-mode (400 KHz)
+#define I2C_FAST_MODE 4
+/**
+ * @brief I2C clock speed multiplier for Fast-mode Plus (1 MHz)
+ *
+ * @note Not supported by the original ESP32, which is rated up to
+ *       Fast-mode. The HAL lowers it to I2C_FAST_MODE on that SoC.
+ */
+#define I2C_FAST_MODE_PLUS 10
+
+/**
+ * @brief A single I2C transaction to a device
+ *
+ * @note The write phase comes first, then the read phase
+ *       after a repeated start condition.
+ *       Any of them may be empty.
+ */
+struct I2CTransaction
+{
+    /// @brief Device address in 7-bit format
+    uint8_t address7bits = 0;
+    /// @brief Bytes to write
+    const uint8_t *writeBuffer = nullptr;
+    /// @brief Count of bytes to write
+    size_t writeSize = 0;
+    /// @brief Buffer for the bytes to read
+    uint8_t *readBuffer = nullptr;
+    /// @brief Count of bytes to read
+    size_t readSize = 0;
+    /// @brief Set to true after a successful execution
+    bool success = false;
+};
+
+/**
+ * @brief Bus usage of an I2C client
+ *
+ */
+struct I2CClientStatistics
+{
+    /// @brief Count of transactions
+    uint32_t transactionCount = 0;
+    /// @brief Count of failed transactions
+    uint32_t errorCount = 0;
+    /// @brief Count of bus operations after coalescing transactions
+    uint32_t batchCount = 0;
+    /// @brief Time holding the bus, in microseconds
+    uint64_t busTimeUs = 0;
+    /// @brief Longest wait for the bus, in microseconds
+    uint32_t maxWaitUs = 0;
+    /// @brief Count of bus recoveries
+    uint32_t recoveryCount = 0;
+};
+
+/**
+ * @brief Bus usage of an I2C device
+ *
+ */
+struct I2CDeviceStatistics
+{
+    /// @brief Device address in 7-bit format
+    uint8_t address7bits = 0;
+    /// @brief Clock speed multiplier used for this device.
+    ///        Zero if the bus default applies.
+    uint8_t speedMultiplier = 0;
+    /// @brief Count of bus operations
+    uint32_t batchCount = 0;
+    /// @brief Count of failed bus operations
+    uint32_t errorCount = 0;
+    /// @brief Time holding the bus, in microseconds
+    uint64_t busTimeUs = 0;
+};
+
+/**
+ * @brief Request for asynchronous execution of transactions
+ *
+ * @note Must live until completion. Buffers must not be touched
+ *       while pending.
+ */
+struct I2CRequest
+{
+    /// @brief Client requesting the transactions
+    I2CClient client = I2CClient::INPUTS;
+    /// @brief Transactions to execute in strict order
+    I2CTransaction *transactions = nullptr;
+    /// @brief Count of transactions
+    size_t count = 0;
+    /// @brief True while not completed
+    std::atomic<bool> pending{false};
+    /// @brief True if all transactions were successful. Valid after completion.
+    bool result = false;
+};
+
+/**
+ * @brief Execute a number of back-to-back transactions to the same device
+ *        as a single bus operation
+ *
+ * @param bus I2C bus
+ * @param transactions Transactions sharing the same device address
+ * @param count Count of transactions. Greater than zero.
+ * @return true On success
+ * @return false On failure
+ */
+typedef bool (*I2CExecutor)(I2CBus bus, I2CTransaction *transactions, size_t count);
+
+/**
+ * @brief Release a stuck I2C bus
+ *
+ * @param bus I2C bus
+ * @return true If the bus is idle
+ * @return false If the bus is still stuck
+ */
+typedef bool (*I2CRecovery)(I2CBus bus);
+
+//-------------------------------------------------------------------
+// Bus manager
+//-------------------------------------------------------------------
+
+/**
+ * @brief Owner of an I2C bus
+ *
+ * @note Clients are granted the bus by priority, never in parallel.
+ *       A running bus operation is never interrupted, but pending
+ *       clients with higher priority are served first.
+ *       Back-to-back transactions to the same device are coalesced
+ *       into a single bus operation.
+ */
+class I2CBusManager
+{
+public:
+    /**
+     * @brief Create a bus manager
+     *
+     * @param bus I2C bus
+     * @param executor Function executing transactions in the bus hardware
+     * @param recovery Function releasing a stuck bus or nullptr
+     */
+    I2CBusManager(I2CBus bus, I2CExecutor executor, I2CRecovery recovery = nullptr)
+        : _bus{bus}, _executor{executor}, _recovery{recovery} {}
+
+    ~I2CBusManager()
+    {
+        if (_worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _requested.notify_all();
+            _worker.join();
+        }
+    }
+
+    /**
+     * @brief Execute a number of transactions in strict order
+     *
+     * @note Blocking. Thread-safe.
+     *
+     * @param client Client requesting the transactions
+     * @param transactions Transactions to execute
+     * @param count Count of transactions
+     * @return true If all transactions were successful
+     * @return false Otherwise
+     */
+    bool execute(I2CClient client, I2CTransaction *transactions, size_t count)
+    {
+        if ((count == 0) || (transactions == nullptr))
+            return true;
+        uint8_t priority = static_cast<uint8_t>(client);
+        auto waitStart = std::chrono::steady_clock::now();
+        acquire(priority);
+        auto busStart = std::chrono::steady_clock::now();
+
+        bool result = true;
+        uint32_t errorCount = 0;
+        uint32_t batchCount = 0;
+        size_t first = 0;
+        while (first < count)
+        {
+            // Coalesce back-to-back transactions to the same device
+            size_t last = first + 1;
+            while ((last < count) &&
+                   (transactions[last].address7bits == transactions[first].address7bits))
+                last++;
+            auto batchStart = std::chrono::steady_clock::now();
+            bool success = _executor(_bus, transactions + first, last - first);
+            auto batchEnd = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                I2CDeviceStatistics &device =
+                    _deviceStatistics[transactions[first].address7bits & 0x7F];
+                device.batchCount++;
+                if (!success)
+                    device.errorCount++;
+                device.busTimeUs +=
+                    std::chrono::duration_cast<std::chrono::microseconds>(batchEnd - batchStart).count();
+            }
+            for (size_t i = first; i < last; i++)
+            {
+                transactions[i].success = success;
+                if (!success)
+                    errorCount++;
+            }
+            result = result && success;
+            batchCount++;
+            first = last;
+        }
+
+        auto busEnd = std::chrono::steady_clock::now();
+        uint64_t busTimeUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(busEnd - busStart).count();
+        uint32_t waitUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(busStart - waitStart).count();
+        release(priority, count, errorCount, batchCount, busTimeUs, waitUs);
+        return result;
+    }
+
+    /**
+     * @brief Release a stuck bus
+     *
+     * @note Blocking. Thread-safe. Waits for the bus as execute() does.
+     *
+     * @param client Client requesting the recovery
+     * @return true If the bus is idle
+     * @return false If the bus is still stuck
+     */
+    bool recover(I2CClient client)
+    {
+        uint8_t priority = static_cast<uint8_t>(client);
+        acquire(priority);
+        bool result = (_recovery == nullptr) || _recovery(_bus);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _statistics[priority].recoveryCount++;
+        }
+        release(priority, 0, 0, 0, 0, 0);
+        return result;
+    }
+
+    /**
+     * @brief Start the execution of a number of transactions
+     *
+     * @note Non-blocking. Thread-safe. Requests are executed in a
+     *       dedicated thread, by priority, as if execute() was called.
+     *
+     * @param request Transactions to execute
+     * @return true If the request was queued
+     * @return false If the request is still pending from a previous call
+     */
+    bool submit(I2CRequest &request)
+    {
+        if (request.pending)
+            return false;
+        request.pending = true;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(&request);
+            if (!_worker.joinable())
+                _worker = std::thread(&I2CBusManager::workerLoop, this);
+        }
+        _requested.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Get the bus usage of a client
+     *
+     * @param client I2C client
+     * @return I2CClientStatistics Bus usage since the last reset
+     */
+    I2CClientStatistics getStatistics(I2CClient client)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _statistics[static_cast<uint8_t>(client)];
+    }
+
+    /**
+     * @brief Get the bus usage of all devices
+     *
+     * @param[out] result Bus usage of every device
+     *                    that was accessed since the last reset,
+     *                    sorted by address.
+     */
+    void getDeviceStatistics(std::vector<I2CDeviceStatistics> &result)
+    {
+        result.clear();
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint8_t address = 0; address < 128; address++)
+            if (_deviceStatistics[address].batchCount > 0)
+            {
+                I2CDeviceStatistics stats = _deviceStatistics[address];
+                stats.address7bits = address;
+                stats.speedMultiplier = _deviceSpeed[address];
+                result.push_back(stats);
+            }
+    }
+
+    /**
+     * @brief Reset the bus usage of all clients and devices
+     *
+     */
+    void resetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint8_t i = 0; i < I2C_CLIENT_COUNT; i++)
+            _statistics[i] = {};
+        for (uint8_t address = 0; address < 128; address++)
+            _deviceStatistics[address] = {};
+    }
+
+    /**
+     * @brief Register the maximum clock speed of a device
+     *
+     * @note If registered many times, the lowest speed is kept.
+     *       Must be called before the device is accessed.
+     *
+     * @param address7bits Device address in 7-bit format
+     * @param speedMultiplier Clock speed multiplier. Greater than zero.
+     */
+    void setDeviceSpeed(uint8_t address7bits, uint8_t speedMultiplier)
+    {
+        uint8_t &current = _deviceSpeed[address7bits & 0x7F];
+        if ((current == 0) || (speedMultiplier < current))
+            current = speedMultiplier;
+    }
+
+    /**
+     * @brief Get the maximum clock speed of a device
+     *
+     * @param address7bits Device address in 7-bit format
+     * @return uint8_t Clock speed multiplier or zero if not registered
+     */
+    uint8_t getDeviceSpeed(uint8_t address7bits) const
+    {
+        return _deviceSpeed[address7bits & 0x7F];
+    }
+
+    PRIVATE : I2CBus _bus;
+    I2CExecutor _executor;
+    I2CRecovery _recovery;
+    std::mutex _mutex;
+    std::condition_variable _released;
+    bool _busy = false;
+    uint32_t _waiting[I2C_CLIENT_COUNT] = {};
+    I2CClientStatistics _statistics[I2C_CLIENT_COUNT];
+    I2CDeviceStatistics _deviceStatistics[128];
+    uint8_t _deviceSpeed[128] = {};
+    std::condition_variable _requested;
+    std::vector<I2CRequest *> _queue;
+    std::thread _worker;
+    bool _stopping = false;
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            I2CRequest *request;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _requested.wait(lock, [this]()
+                                { return _stopping || !_queue.empty(); });
+                if (_stopping)
+                    return;
+                // Highest priority first, then in order of arrival
+                auto next = _queue.begin();
+                for (auto it = _queue.begin(); it != _queue.end(); it++)
+                    if ((*it)->client < (*next)->client)
+                        next = it;
+                request = *next;
+                _queue.erase(next);
+            }
+            request->result = execute(request->client, request->transactions, request->count);
+            request->pending = false;
+        }
+    }
+
+    bool mustWait(uint8_t priority)
+    {
+        if (_busy)
+            return true;
+        for (uint8_t i = 0; i < priority; i++)
+            if (_waiting[i] > 0)
+                return true;
+        return false;
+    }
+
+    void acquire(uint8_t priority)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _waiting[priority]++;
+        _released.wait(lock, [this, priority]()
+                       { return !mustWait(priority); });
+        _waiting[priority]--;
+        _busy = true;
+    }
+
+    void release(
+        uint8_t priority,
+        uint32_t transactionCount,
+        uint32_t errorCount,
+        uint32_t batchCount,
+        uint64_t busTimeUs,
+        uint32_t waitUs)
+    {
+        COUNT_EVENTS(i2cErrors[static_cast<uint8_t>(_bus)], errorCount);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            I2CClientStatistics &stats = _statistics[priority];
+            stats.transactionCount += transactionCount;
+            stats.errorCount += errorCount;
+            stats.batchCount += batchCount;
+            stats.busTimeUs += busTimeUs;
+            if (waitUs > stats.maxWaitUs)
+                stats.maxWaitUs = waitUs;
+            _busy = false;
+        }
+        _released.notify_all();
+    }
+};
@@ -0,0 +1,109 @@
+/**
+ * @file I2CDeviceHealth.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Health tracking of I2C devices with exponential backoff
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+
+//-------------------------------------------------------------------
+// Globals
+//-------------------------------------------------------------------
+
+/// @brief Maximum count of periods a failing device is skipped
+#define I2C_HEALTH_MAX_BACKOFF 128
+
+//-------------------------------------------------------------------
+// Health tracking
+//-------------------------------------------------------------------
+
+/**
+ * @brief Health of an I2C device accessed periodically
+ *
+ * @note A failing device is skipped for a number of periods that doubles
+ *       after each consecutive failure, up to I2C_HEALTH_MAX_BACKOFF.
+ *       Then, it is recovered before being accessed again.
+ *       Recovery runs inline, in the calling task, at that period.
+ *       A successful access makes it healthy again.
+ *       Not thread-safe.
+ */
+class I2CDeviceHealth
+{
+public:
+    /**
+     * @brief Access the device at a new period, if healthy
+     *
+     * @param access Function accessing the device.
+     *               Returns true on success.
+     * @param recover Function recovering a failing device.
+     *                Returns true on success.
+     * @return true If the device was accessed successfully
+     * @return false If the device is skipped at this period
+     *               or it failed
+     */
+    template <typename Access, typename Recover>
+    bool attempt(Access access, Recover recover)
+    {
+        if (_skip > 0)
+        {
+            _skip--;
+            skippedCount++;
+            return false;
+        }
+        if (_failures > 0)
+        {
+            recoveryCount++;
+            if (!recover())
+            {
+                onFailure();
+                return false;
+            }
+        }
+        if (access())
+        {
+            _failures = 0;
+            return true;
+        }
+        onFailure();
+        return false;
+    }
+
+    /**
+     * @brief Check if the device is working
+     *
+     * @return true If the last access was successful
+     * @return false If the device is failing
+     */
+    bool isHealthy() const { return (_failures == 0); }
+
+    /// @brief Count of failed accesses or recoveries
+    uint32_t errorCount = 0;
+    /// @brief Count of recovery attempts
+    uint32_t recoveryCount = 0;
+    /// @brief Count of skipped periods
+    uint32_t skippedCount = 0;
+
+private:
+    uint32_t _failures = 0;
+    uint32_t _skip = 0;
+
+    void onFailure()
+    {
+        errorCount++;
+        if (_failures < 31)
+            _failures++;
+        uint32_t backoff = (1UL << (_failures - 1));
+        _skip = (backoff > I2C_HEALTH_MAX_BACKOFF) ? I2C_HEALTH_MAX_BACKOFF : backoff;
+    }
+};
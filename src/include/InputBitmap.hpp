@@ -0,0 +1,258 @@
+/**
+ * @file InputBitmap.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Bit arrays holding the state of firmware-defined inputs
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+
+//-------------------------------------------------------------------
+// Compile-time configuration
+//-------------------------------------------------------------------
+
+#ifndef INPUT_BITMAP_WIDTH
+/**
+ * @brief Count of firmware-defined inputs
+ *
+ * @note Must be 64, 128 or 192. Input number 255 is reserved
+ *       as the unspecified value. 64 inputs fit into a single
+ *       CPU register, which is the fastest choice.
+ *       Override as a build flag for bigger button boxes.
+ */
+#define INPUT_BITMAP_WIDTH 64
+#endif
+
+static_assert(
+    (INPUT_BITMAP_WIDTH == 64) || (INPUT_BITMAP_WIDTH == 128) || (INPUT_BITMAP_WIDTH == 192),
+    "INPUT_BITMAP_WIDTH must be 64, 128 or 192");
+
+/// @brief Highest valid firmware-defined input number
+#define MAX_INPUT_NUMBER (INPUT_BITMAP_WIDTH - 1)
+
+/// @brief Count of 64-bit words in an input bitmap
+#define INPUT_BITMAP_WORD_COUNT (INPUT_BITMAP_WIDTH / 64)
+
+//-------------------------------------------------------------------
+// Wide bitmaps
+//-------------------------------------------------------------------
+
+/**
+ * @brief Fixed-width bit array made of 64-bit words
+ *
+ * @note Word 0 holds bits 0 to 63, word 1 holds bits 64 to 127, and so on.
+ *       All operations work word by word, so the compiler is free
+ *       to unroll or vectorize them.
+ *
+ * @tparam WIDTH Count of bits. Must be a multiple of 64.
+ */
+template <size_t WIDTH>
+struct WideBitmap
+{
+    static_assert((WIDTH > 0) && ((WIDTH % 64) == 0), "WIDTH must be a multiple of 64");
+
+    /// @brief Count of 64-bit words
+    static constexpr size_t WORD_COUNT = WIDTH / 64;
+
+    /// @brief Bit array
+    uint64_t word[WORD_COUNT];
+
+    /// @brief Create a bitmap with all bits cleared
+    constexpr WideBitmap() : word{} {}
+
+    /**
+     * @brief Create a bitmap from a 64-bit value
+     *
+     * @param low Bits 0 to 63. Other bits are cleared.
+     */
+    constexpr WideBitmap(uint64_t low) : word{}
+    {
+        word[0] = low;
+    }
+
+    /**
+     * @brief Create a bitmap with a single bit set
+     *
+     * @param n Bit index
+     * @return WideBitmap A bitmap
+     */
+    static constexpr WideBitmap bit(size_t n)
+    {
+        WideBitmap result;
+        if (n < WIDTH)
+            result.word[n / 64] = (1ULL << (n % 64));
+        return result;
+    }
+
+    /**
+     * @brief Check if any bit is set
+     *
+     */
+    constexpr explicit operator bool() const
+    {
+        uint64_t any = 0ULL;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            any |= word[i];
+        return (any != 0ULL);
+    }
+
+    /// @cond
+
+    constexpr WideBitmap operator~() const
+    {
+        WideBitmap result;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            result.word[i] = ~word[i];
+        return result;
+    }
+
+    constexpr WideBitmap &operator|=(const WideBitmap &other)
+    {
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            word[i] |= other.word[i];
+        return *this;
+    }
+
+    constexpr WideBitmap &operator&=(const WideBitmap &other)
+    {
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            word[i] &= other.word[i];
+        return *this;
+    }
+
+    constexpr WideBitmap &operator^=(const WideBitmap &other)
+    {
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            word[i] ^= other.word[i];
+        return *this;
+    }
+
+    friend constexpr WideBitmap operator|(WideBitmap a, const WideBitmap &b) { return (a |= b); }
+    friend constexpr WideBitmap operator&(WideBitmap a, const WideBitmap &b) { return (a &= b); }
+    friend constexpr WideBitmap operator^(WideBitmap a, const WideBitmap &b) { return (a ^= b); }
+
+    friend constexpr bool operator==(const WideBitmap &a, const WideBitmap &b)
+    {
+        uint64_t diff = 0ULL;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            diff |= (a.word[i] ^ b.word[i]);
+        return (diff == 0ULL);
+    }
+
+    friend constexpr bool operator!=(const WideBitmap &a, const WideBitmap &b) { return !(a == b); }
+
+    /// @endcond
+};
+
+//-------------------------------------------------------------------
+// Input bitmaps
+//-------------------------------------------------------------------
+
+#if INPUT_BITMAP_WIDTH == 64
+
+/**
+ * @brief A bit array which assembles the state of every firmware-defined input,
+ *        being the least significant bit the input numbered as 0.
+ *        A bit set to 1 means the input is active, 0 means not active.
+ *        May be used to identify a number of inputs, too.
+ */
+typedef uint64_t InputBitmap;
+
+/**
+ * @brief Get an input bitmap with a single input
+ *
+ * @param n Input number
+ * @return InputBitmap A bitmap
+ */
+inline constexpr InputBitmap inputBitmapOf(uint8_t n)
+{
+    return (n < 64) ? (1ULL << n) : 0ULL;
+}
+
+/**
+ * @brief Get a 64-bit word from an input bitmap
+ *
+ * @param bitmap Input bitmap
+ * @param index Word index in the range [0,INPUT_BITMAP_WORD_COUNT-1]
+ * @return uint64_t Input numbers from 64*index to 64*index+63
+ */
+inline constexpr uint64_t inputBitmapWord(const InputBitmap &bitmap, uint8_t index)
+{
+    return bitmap;
+}
+
+/**
+ * @brief Set a 64-bit word of an input bitmap
+ *
+ * @param bitmap Input bitmap
+ * @param index Word index in the range [0,INPUT_BITMAP_WORD_COUNT-1]
+ * @param word Input numbers from 64*index to 64*index+63
+ */
+inline constexpr void setInputBitmapWord(InputBitmap &bitmap, uint8_t index, uint64_t word)
+{
+    bitmap = word;
+}
+
+#else
+
+/**
+ * @brief A bit array which assembles the state of every firmware-defined input,
+ *        being the least significant bit the input numbered as 0.
+ *        A bit set to 1 means the input is active, 0 means not active.
+ *        May be used to identify a number of inputs, too.
+ */
+typedef WideBitmap<INPUT_BITMAP_WIDTH> InputBitmap;
+
+/**
+ * @brief Get an input bitmap with a single input
+ *
+ * @param n Input number
+ * @return InputBitmap A bitmap
+ */
+inline constexpr InputBitmap inputBitmapOf(uint8_t n)
+{
+    return InputBitmap::bit(n);
+}
+
+/**
+ * @brief Get a 64-bit word from an input bitmap
+ *
+ * @param bitmap Input bitmap
+ * @param index Word index in the range [0,INPUT_BITMAP_WORD_COUNT-1]
+ * @return uint64_t Input numbers from 64*index to 64*index+63
+ */
+inline constexpr uint64_t inputBitmapWord(const InputBitmap &bitmap, uint8_t index)
+{
+    return bitmap.word[index];
+}
+
+/**
+ * @brief Set a 64-bit word of an input bitmap
+ *
+ * @param bitmap Input bitmap
+ * @param index Word index in the range [0,INPUT_BITMAP_WORD_COUNT-1]
+ * @param word Input numbers from 64*index to 64*index+63
+ */
+inline constexpr void setInputBitmapWord(InputBitmap &bitmap, uint8_t index, uint64_t word)
+{
+    bitmap.word[index] = word;
+}
+
+#endif
+
+/// @brief Input bitmap with no inputs
+#define NO_INPUTS (InputBitmap{})
+
+/// @brief Input bitmap with all inputs
+#define ALL_INPUTS (~InputBitmap{})
@@ -17,6 +17,85 @@
 
 #include "InternalTypes.hpp" // For BitQueue
 #include "InputSpecification.hpp"
+#include "I2CBusManager.hpp"
+#include "I2CDeviceHealth.hpp"
+#include <atomic>
+
+//-------------------------------------------------------------------
+// Compile-time configuration
+//-------------------------------------------------------------------
+
+#ifndef MCP23017_MAX_SPEED
+/**
+ * @brief Maximum clock speed multiplier of MCP23017 expanders
+ *
+ * @note The chip supports I2C_FAST_MODE_PLUS (1 MHz), but most
+ *       pull-up resistors and wiring do not. Set to I2C_FAST_MODE or
+ *       I2C_FAST_MODE_PLUS as a build flag if your hardware allows it.
+ *       The original ESP32 runs I2C_FAST_MODE_PLUS as I2C_FAST_MODE.
+ */
+#define MCP23017_MAX_SPEED I2C_STANDARD_MODE
+#endif
+
+//-------------------------------------------------------------------
+// Read cost profiling
+//-------------------------------------------------------------------
+
+/**
+ * @brief Running statistics of the time spent in DigitalInput::read()
+ *
+ * @note Written by the scanning task only. Other tasks may read
+ *       the statistics at any time.
+ */
+class ReadCostProfile
+{
+public:
+    /**
+     * @brief Record the duration of a read
+     *
+     * @param cycles Duration in CPU cycles
+     */
+    void record(uint32_t cycles)
+    {
+        uint32_t count = _count.load(std::memory_order_relaxed);
+        if ((count == 0) || (cycles < _min.load(std::memory_order_relaxed)))
+            _min.store(cycles, std::memory_order_relaxed);
+        if (cycles > _max.load(std::memory_order_relaxed))
+            _max.store(cycles, std::memory_order_relaxed);
+        // Exponential moving average (weight 1/8) in 1/8 cycle units
+        uint32_t avg8 = _avg8.load(std::memory_order_relaxed);
+        avg8 = (count == 0) ? (cycles << 3) : (avg8 - (avg8 >> 3) + cycles);
+        _avg8.store(avg8, std::memory_order_relaxed);
+        _count.store(count + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Clear all statistics
+     *
+     */
+    void reset()
+    {
+        _count.store(0, std::memory_order_relaxed);
+        _min.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+        _avg8.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief Minimum read duration in CPU cycles
+    uint32_t min() const { return _min.load(std::memory_order_relaxed); }
+    /// @brief Average read duration in CPU cycles
+    uint32_t avg() const { return _avg8.load(std::memory_order_relaxed) >> 3; }
+    /// @brief Maximum read duration in CPU cycles
+    uint32_t max() const { return _max.load(std::memory_order_relaxed); }
+    /// @brief Count of recorded reads
+    uint32_t count() const { return _count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _min{0};
+    std::atomic<uint32_t> _max{0};
+    std::atomic<uint32_t> _avg8{0};
+    std::atomic<uint32_t> _count{0};
+};
 
 //-------------------------------------------------------------------
 // (Abstract) DigitalInput
@@ -35,7 +114,13 @@ public:
      * @brief Input mask. For read-only.
      *
      */
-    uint64_t mask = ~0ULL;
+    InputBitmap mask = ALL_INPUTS;
+
+    /**
+     * @brief Time spent in read(). Only recorded while profiling.
+     *
+     */
+    ReadCostProfile readCost;
 
 public:
     virtual ~DigitalInput() noexcept {}
@@ -50,10 +135,21 @@ public:
      *                  Whether the current state is unknown,
      *                  @p lastState must be returned (properly masked).
      *                  Must be set to zero at first call.
-     * @return uint64_t Current state of the inputs
+     * @return InputBitmap Current state of the inputs
      *                  (a bit set to 1 means a pressed button).
      */
-    virtual uint64_t read(uint64_t lastState) = 0;
+    virtual InputBitmap read(InputBitmap lastState) = 0;
+
+    /**
+     * @brief Check if this input is attached to a shared bus
+     *
+     * @note Bus inputs are slow to read, so they are scanned
+     *       in a separate task.
+     *
+     * @return true If attached to a shared bus (I2C)
+     * @return false If attached to GPIO pins
+     */
+    virtual bool isBusInput() const { return false; }
 
 protected:
     /**
@@ -61,7 +157,7 @@ protected:
      *
      * @param bitmap Input bitmap
      */
-    void addToMask(uint64_t bitmap) { mask &= ~bitmap; }
+    void addToMask(InputBitmap bitmap) { mask &= ~bitmap; }
 };
 
 //-------------------------------------------------------------------
@@ -78,7 +174,7 @@ protected:
     /// @brief Configured input pin
     InputGPIO pinNumber;
     /// @brief Input bitmap
-    uint64_t bitmap;
+    InputBitmap bitmap;
 
 public:
     /**
@@ -89,7 +185,7 @@ public:
      */
     DigitalButton(InputGPIO pinNumber, InputNumber buttonNumber);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -106,8 +202,8 @@ private:
     InputGPIO clkPin, dtPin; // pins
     uint8_t code;            // State of the decoding algorithm
     uint16_t sequence;       // Last sequence of states in "alternate encoding"
-    uint64_t cwButtonBitmap;
-    uint64_t ccwButtonBitmap;
+    InputBitmap cwButtonBitmap;
+    InputBitmap ccwButtonBitmap;
     BitQueue queue;
 
     // duration of the current "pulse" event in polling cycles
@@ -166,7 +262,7 @@ public:
         return false;
     };
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -196,7 +292,7 @@ public:
         const ButtonMatrix &matrix,
         bool negativeLogic = false);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -214,7 +310,7 @@ class AnalogMultiplexerInput : public DigitalInput
 private:
     OutputGPIOCollection selectorPins;
     InputGPIOCollection inputPins;
-    const uint64_t *bitmap;
+    const InputBitmap *bitmap;
     size_t switchCount;
 
 public:
@@ -266,7 +362,7 @@ public:
         OutputGPIO selectorPin5,
         const AnalogMultiplexerGroup<Mux32Pin> &chips);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 
 private:
     void initializeMux();
@@ -284,7 +380,7 @@ class RotaryCodedSwitchInput : public DigitalInput
 {
 private:
     InputGPIOCollection inputPins;
-    uint64_t *bitmap = nullptr;
+    InputBitmap *bitmap = nullptr;
     bool complementaryCode;
 
 public:
@@ -301,7 +397,7 @@ public:
         bool complementaryCode);
     ~RotaryCodedSwitchInput();
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -323,18 +419,89 @@ protected:
     /// @brief Configured I2C bus
     I2CBus bus;
 
+    /// @brief Transaction reading the GPIO registers
+    I2CTransaction gpioRead;
+
+    /// @brief Raw GPIO registers as read from the chip
+    uint8_t gpioData[2] = {0, 0};
+
+    /// @brief Asynchronous execution of @p gpioRead
+    I2CRequest gpioRequest;
+
+    /// @brief True if @p gpioRequest was submitted
+    bool gpioRequestStarted = false;
+
+    /// @brief Health of this chip
+    I2CDeviceHealth health;
+
+    /**
+     * @brief Read the GPIO registers
+     *
+     * @note In pipelined mode, the read is started and the result
+     *       of the previous call is retrieved, so the caller never blocks.
+     *
+     * @param[out] data Raw GPIO registers.
+     *                  Size given by `gpioRead.readSize`.
+     * @param pipelined True for pipelined mode. False for blocking mode.
+     * @return true On success.
+     * @return false On failure or if the result is not available yet.
+     */
+    bool readGPIO(uint8_t *data, bool pipelined);
+
+    /**
+     * @brief Read the GPIO registers at a scan period
+     *
+     * @note A failing chip is skipped for a number of scan periods,
+     *       so it does not stall the bus task at every scan.
+     *       Recovery runs inline at the scan period when the backoff
+     *       expires, delaying that scan.
+     *
+     * @param[out] data Raw GPIO registers.
+     *                  Size given by `gpioRead.readSize`.
+     * @return true On success.
+     * @return false If skipped, failed or not available yet.
+     */
+    bool scanGPIO(uint8_t *data);
+
+    /**
+     * @brief Bring a failing chip back to work
+     *
+     * @return true On success.
+     * @return false If the chip is still failing.
+     */
+    bool recover();
+
+    /**
+     * @brief Write the chip configuration
+     *
+     * @return true On success.
+     * @return false On failure.
+     */
+    virtual bool configure() { return true; }
+
 public:
+    /**
+     * @brief If true, GPIO registers are read in pipelined mode
+     *        at each scan period.
+     *
+     */
+    inline static bool pipelined = false;
+
     /**
      * @brief Construct a new I2CButtonsInput object
      *
      * @param address7Bits I2C address in 7 bits format
      * @param bus Bus where the chip is attached to
-     * @param max_speed_mult Bus speed multiplier in the range from 1 to 4
+     * @param max_speed_mult Maximum clock speed multiplier of this chip
+     *                       in the range from I2C_STANDARD_MODE
+     *                       to I2C_FAST_MODE_PLUS
      */
     I2CInput(
         uint8_t address7Bits,
         I2CBus bus = I2CBus::PRIMARY,
-        uint8_t max_speed_mult = 1);
+        uint8_t max_speed_mult = I2C_STANDARD_MODE);
+
+    virtual bool isBusInput() const override { return true; }
 };
 
 /**
@@ -345,7 +512,7 @@ class PCF8574ButtonsInput : public I2CInput
 {
 private:
     PCF8574Expander inputNumbers;
-    bool getGPIOstate(uint64_t &state);
+    bool getGPIOstate(uint64_t &state, bool scan);
 
 public:
     /**
@@ -360,7 +527,7 @@ public:
         uint8_t address7Bits,
         I2CBus bus = I2CBus::PRIMARY);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 /**
@@ -371,8 +538,8 @@ class MCP23017ButtonsInput : public I2CInput
 {
 private:
     MCP23017Expander inputNumbers;
-    bool getGPIOstate(uint64_t &state);
-    void configure();
+    bool getGPIOstate(uint64_t &state, bool scan);
+    virtual bool configure() override;
 
 public:
     /**
@@ -387,7 +554,7 @@ public:
         uint8_t address7Bits,
         I2CBus bus = I2CBus::PRIMARY);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -405,7 +572,7 @@ private:
     InputGPIO serialPin;
     OutputGPIO loadPin;
     OutputGPIO nextPin;
-    const uint64_t *bitmap;
+    const InputBitmap *bitmap;
     bool loadHighOrLow;
     bool nextHighToLowOrLowToHigh;
     bool negativeLogic;
@@ -438,7 +605,7 @@ public:
         const bool nextHighToLowOrLowToHigh = false,
         const bool negativeLogic = true);
 
-    virtual uint64_t read(uint64_t lastState) override;
+    virtual InputBitmap read(InputBitmap lastState) override;
 };
 
 //-------------------------------------------------------------------
@@ -541,12 +708,18 @@ public:
      *
      * @param instance Fake input specification
      */
-    FakeDigitalInput(FakeInput *instance) { _instance = instance; }
+    FakeDigitalInput(FakeInput *instance)
+    {
+        _instance = instance;
+        mask = instance->mask;
+    }
 
-    virtual uint64_t read(uint64_t lastState) override
+    virtual InputBitmap read(InputBitmap lastState) override
     {
         return _instance->state;
     }
+
+    virtual bool isBusInput() const override { return _instance->isBusInput; }
 };
 
 /**
@@ -0,0 +1,138 @@
+/**
+ * @file InputReportPacer.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-19
+ * @brief Non-blocking, paced sending of input reports
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstring>
+#include "HID_definitions.hpp"
+
+//-------------------------------------------------------------------
+// Globals
+//-------------------------------------------------------------------
+
+/// @brief Time to wait for a busy endpoint before retrying (microseconds)
+#define INPUT_REPORT_BUSY_RETRY_US 250
+
+//-------------------------------------------------------------------
+// Endpoint
+//-------------------------------------------------------------------
+
+/**
+ * @brief Endpoint of input reports
+ *
+ */
+class InputReportEndpoint
+{
+public:
+    /**
+     * @brief Send an input report without waiting for the host computer
+     *
+     * @param report Input report
+     * @param size Size of the input report in bytes
+     * @return true If the report was sent
+     * @return false If the endpoint is busy
+     */
+    virtual bool sendInputReport(const uint8_t *report, uint8_t size) = 0;
+};
+
+//-------------------------------------------------------------------
+// Pacer
+//-------------------------------------------------------------------
+
+/**
+ * @brief Send the latest input report no faster than the report period
+ *
+ * @note There is a single pending slot. A new report replaces the
+ *       pending one, since it is outdated, but the feature notification
+ *       of the pending report is carried over, since it is sent once.
+ *       Not thread-safe.
+ */
+class InputReportPacer
+{
+public:
+    /**
+     * @brief Create an input report pacer
+     *
+     * @param endpoint Endpoint of input reports
+     * @param periodUs Report period in microseconds
+     */
+    InputReportPacer(InputReportEndpoint &endpoint, int64_t periodUs = 1000)
+        : _endpoint{endpoint}, _periodUs{periodUs} {}
+
+    /**
+     * @brief Set the report period
+     *
+     * @param periodUs Report period in microseconds
+     */
+    void setPeriod(int64_t periodUs) { _periodUs = periodUs; }
+
+    /**
+     * @brief Replace the pending input report
+     *
+     * @param report Input report
+     * @param size Size of the input report in bytes.
+     *             The feature notification is at the high nibble
+     *             of the last byte.
+     */
+    void post(const uint8_t *report, uint8_t size)
+    {
+        if ((size == 0) || (size > GAMEPAD_REPORT_SIZE))
+            return;
+        uint8_t notification =
+            ((_size == size) && ((_report[_size - 1] & 0xF0) == (RID_FEATURE_CONFIG << 4)))
+                ? (RID_FEATURE_CONFIG << 4)
+                : 0;
+        memcpy(_report, report, size);
+        _report[size - 1] |= notification;
+        _size = size;
+    }
+
+    /**
+     * @brief Send the pending input report if the endpoint is free and
+     *        the report period has elapsed
+     *
+     * @param nowUs Current time in microseconds
+     * @return int64_t Time to wait before calling again in microseconds,
+     *                 or zero if there is nothing pending
+     */
+    int64_t flush(int64_t nowUs)
+    {
+        if (_size == 0)
+            return 0;
+        int64_t wait = _lastReportTime + _periodUs - nowUs;
+        if ((wait <= 0) && _endpoint.sendInputReport(_report, _size))
+        {
+            _lastReportTime = nowUs;
+            _size = 0;
+            return 0;
+        }
+        return (wait > INPUT_REPORT_BUSY_RETRY_US) ? wait : INPUT_REPORT_BUSY_RETRY_US;
+    }
+
+    /**
+     * @brief Check if there is a pending input report
+     *
+     * @return true If there is a report not sent yet
+     */
+    bool isPending() const { return _size > 0; }
+
+private:
+    InputReportEndpoint &_endpoint;
+    int64_t _periodUs;
+    int64_t _lastReportTime = 0;
+    uint8_t _report[GAMEPAD_REPORT_SIZE];
+    uint8_t _size = 0;
+};
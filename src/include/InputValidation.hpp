@@ -53,7 +53,7 @@ namespace internals
             {
                 OutputGPIOCollection selectors;
                 InputGPIOCollection inputs;
-                uint64_t previousInputNumbers = InputNumber::booked();
+                InputBitmap previousInputNumbers = InputNumber::booked();
                 for (ButtonMatrix::const_iterator row = matrix.begin(); row != matrix.end(); row++)
                 {
                     OutputGPIO selectorPin = row->first;
@@ -82,7 +82,7 @@ namespace internals
             template <typename PinTags>
             void analogMultiplexer(const OutputGPIOCollection &selectors, const AnalogMultiplexerGroup<PinTags> chips)
             {
-                uint64_t previousInputNumbers = InputNumber::booked();
+                InputBitmap previousInputNumbers = InputNumber::booked();
                 reserve<OutputGPIO>(selectors);
                 for (auto chip : chips)
                     chip.reserve_and_book();
@@ -104,7 +104,7 @@ namespace internals
                 InputGPIO inputPin,
                 const ShiftRegisterChain &chain)
             {
-                uint64_t previousInputNumbers = InputNumber::booked();
+                InputBitmap previousInputNumbers = InputNumber::booked();
                 loadPin.reserve();
                 nextPin.reserve();
                 inputPin.reserve();
@@ -126,7 +126,7 @@ namespace internals
             template <typename PinTags>
             void GPIOExpander(const GPIOExpanderChip<PinTags> &chip)
             {
-                uint64_t previousInputNumbers = InputNumber::booked();
+                InputBitmap previousInputNumbers = InputNumber::booked();
                 for (auto i = chip.begin(); i != chip.end(); i++)
                     (i->second).book();
                 if (previousInputNumbers == InputNumber::booked())
@@ -143,7 +143,7 @@ namespace internals
              */
             void rotaryEncoder(InputGPIO dtPin, InputGPIO clkPin, InputNumber cw, InputNumber ccw)
             {
-                uint64_t previousInputNumbers = InputNumber::booked();
+                InputBitmap previousInputNumbers = InputNumber::booked();
                 dtPin.reserve();
                 clkPin.reserve();
                 cw.book();
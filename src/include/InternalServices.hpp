@@ -16,6 +16,8 @@
 //-------------------------------------------------------------------
 
 #include "InternalTypes.hpp"
+#include "SimWheelTypes.hpp" // For InputReadCost
+#include "EventTrace.hpp"   // For InputTraceEntry
 #include <cstdint>
 #include <type_traits>
 #include <cassert>
@@ -282,6 +284,41 @@ public:
      */
     virtual void update() MOCK;
 
+    /**
+     * @brief Enable or disable the profiling of input reads
+     *
+     * @note Statistics are cleared when enabled
+     *
+     * @param enable True to enable, false to disable
+     */
+    virtual void setReadProfiling(bool enable) MOCK;
+
+    /**
+     * @brief Check if input reads are being profiled
+     *
+     * @return true If enabled
+     * @return false If disabled
+     */
+    virtual bool getReadProfiling() MOCK_R(false);
+
+    /**
+     * @brief Get the count of profiled hardware inputs
+     *
+     * @return uint8_t Count of hardware inputs
+     */
+    virtual uint8_t getReadCostCount() MOCK_R(0);
+
+    /**
+     * @brief Get the read cost of a hardware input
+     *
+     * @param index Index of the hardware input,
+     *              from 0 to getReadCostCount()-1
+     * @param[out] cost Read cost
+     * @return true On success
+     * @return false If @p index is out of range
+     */
+    virtual bool getReadCost(uint8_t index, InputReadCost &cost) MOCK_R(false);
+
     /// @cond
 
     struct call
@@ -329,6 +366,13 @@ public:
                 rightAxisReversed,
                 save))
         VOID_SINGLETON_INVOKER(update(), update());
+        VOID_SINGLETON_INVOKER(setReadProfiling(bool enable), setReadProfiling(enable))
+        SINGLETON_INVOKER(bool, getReadProfiling(), getReadProfiling())
+        SINGLETON_INVOKER(uint8_t, getReadCostCount(), getReadCostCount())
+        SINGLETON_INVOKER(
+            bool,
+            getReadCost(uint8_t index, InputReadCost &cost),
+            getReadCost(index, cost))
     };
 
     /// @endcond
@@ -357,6 +401,40 @@ public:
     virtual void setDPadWorkingMode(DPadWorkingMode mode, bool save) MOCK;
     virtual void setSecurityLock(bool value, bool save) MOCK;
 
+    /**
+     * @brief Enable or disable the trace of input events
+     *
+     * @param enable True to record, false to stop
+     */
+    virtual void setEventTrace(bool enable) MOCK;
+
+    /**
+     * @brief Check if input events are being recorded
+     *
+     * @return true If recording
+     * @return false If not recording
+     */
+    virtual bool getEventTrace() MOCK_R(false);
+
+    /**
+     * @brief Get the count of input events recorded since boot
+     *
+     * @return uint32_t Sequence number of the next event
+     */
+    virtual uint32_t getEventTraceCount() MOCK_R(0);
+
+    /**
+     * @brief Get a recorded input event
+     *
+     * @note Only the last EVENT_TRACE_DEPTH events are kept
+     *
+     * @param sequence Sequence number of the event
+     * @param[out] entry Recorded event
+     * @return true On success
+     * @return false If not recorded yet or not kept any more
+     */
+    virtual bool getEventTraceEntry(uint32_t sequence, InputTraceEntry &entry) MOCK_R(false);
+
     /// @cond
 
     struct call
@@ -380,6 +458,13 @@ public:
         VOID_SINGLETON_INVOKER(
             setSecurityLock(bool value, bool save = true),
             setSecurityLock(value, save))
+        VOID_SINGLETON_INVOKER(setEventTrace(bool enable), setEventTrace(enable))
+        SINGLETON_INVOKER(bool, getEventTrace(), getEventTrace())
+        SINGLETON_INVOKER(uint32_t, getEventTraceCount(), getEventTraceCount())
+        SINGLETON_INVOKER(
+            bool,
+            getEventTraceEntry(uint32_t sequence, InputTraceEntry &entry),
+            getEventTraceEntry(sequence, entry))
     };
 
     /// @endcond
@@ -411,11 +496,30 @@ public:
     };
     virtual void resetMap() MOCK;
 
+    /**
+     * @brief Set the whole map at once
+     *
+     * @note The input hub never sees a partially applied map.
+     *
+     * @param user_defined User-defined input numbers when ALT mode
+     *                     is disengaged (INPUT_BITMAP_WIDTH items).
+     *                     0xFF means "do not change".
+     * @param user_defined_alt User-defined input numbers when ALT mode
+     *                         is engaged (INPUT_BITMAP_WIDTH items).
+     *                         0xFF means "do not change".
+     */
+    virtual void setMaps(
+        const uint8_t *user_defined,
+        const uint8_t *user_defined_alt) MOCK;
+
     struct call
     {
         VOID_SINGLETON_INVOKER(
             setMap(uint8_t firmware_defined, uint8_t user_defined, uint8_t user_defined_alt),
             setMap(firmware_defined, user_defined, user_defined_alt))
+        VOID_SINGLETON_INVOKER(
+            setMaps(const uint8_t *user_defined, const uint8_t *user_defined_alt),
+            setMaps(user_defined, user_defined_alt))
         VOID_SINGLETON_INVOKER(
             getMap(uint8_t firmware_defined, uint8_t &user_defined, uint8_t &user_defined_alt),
             getMap(firmware_defined, user_defined, user_defined_alt))
@@ -647,6 +751,50 @@ public:
     };
 };
 
+//-------------------------------------------------------------------
+// Storage
+//-------------------------------------------------------------------
+
+/**
+ * @brief Storage service
+ *
+ * @note See SettingsImage.hpp for the image format
+ */
+class SERVICE(StorageService)
+{
+public:
+    /**
+     * @brief Build a binary image of all user settings
+     *
+     * @param[out] image Buffer of SETTINGS_IMAGE_MAX_SIZE bytes
+     * @return uint16_t Size of the image in bytes
+     */
+    virtual uint16_t exportSettings(uint8_t *image) MOCK_R(0);
+
+    /**
+     * @brief Apply all user settings from a binary image,
+     *        then save them
+     *
+     * @note Nothing is applied if the image is not valid.
+     *       Settings not found in the image are kept as is.
+     *
+     * @param image Settings image
+     * @param size Size of @p image in bytes
+     * @return true On success
+     * @return false If the image is not valid
+     */
+    virtual bool importSettings(const uint8_t *image, uint16_t size) MOCK_R(false);
+
+    struct call
+    {
+        SINGLETON_INVOKER(uint16_t, exportSettings(uint8_t *image), exportSettings(image))
+        SINGLETON_INVOKER(
+            bool,
+            importSettings(const uint8_t *image, uint16_t size),
+            importSettings(image, size))
+    };
+};
+
 //-------------------------------------------------------------------
 // UI
 //-------------------------------------------------------------------
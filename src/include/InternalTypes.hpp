@@ -23,6 +23,8 @@
 #include <semaphore>
 #include <chrono>
 #include <optional>
+#include "InputBitmap.hpp"
+#include "FirmwareCounters.hpp"
 
 #if !CD_CI
 /// @brief For tesing
@@ -48,15 +50,17 @@
 struct FakeInput
 {
     /// @brief Input bitmap
-    uint64_t state = 0ULL;
+    InputBitmap state = NO_INPUTS;
     /// @brief Input bitmask
-    uint64_t mask = ~(0ULL);
+    InputBitmap mask = ALL_INPUTS;
     /// @brief Left axis position
     uint8_t leftAxis = 0;
     /// @brief Right axis position
     uint8_t rightAxis = 0;
     /// @brief Count of times axis recalibration was asked
     size_t recalibrationRequestCount = 0;
+    /// @brief Simulate an input attached to a shared bus
+    bool isBusInput = false;
 
     /**
      * @brief Simulate a button press
@@ -65,7 +69,7 @@ struct FakeInput
      */
     void press(uint8_t n)
     {
-        uint64_t bmp = (1ULL << n);
+        InputBitmap bmp = inputBitmapOf(n);
         state = state | bmp;
     }
 
@@ -76,7 +80,7 @@ struct FakeInput
      */
     void release(uint8_t n)
     {
-        uint64_t bmp = (1ULL << n);
+        InputBitmap bmp = inputBitmapOf(n);
         state = state & ~bmp;
     }
 
@@ -86,7 +90,7 @@ struct FakeInput
      */
     void clear()
     {
-        state = 0ULL;
+        state = NO_INPUTS;
         leftAxis = 0;
         rightAxis = 0;
     }
@@ -99,14 +103,6 @@ struct FakeInput
 // Input bitmaps
 //-------------------------------------------------------------------
 
-// /**
-//  * @brief A bit array which assembles the state of every button, being the least significant bit
-//  *        the button numbered as 0, and the most significant bit the button numbered as 63.
-//  *        A bit set to 1 means the button is pressed, 0 means not pressed.
-//  *        May be used to identify a number of buttons, too.
-//  */
-// typedef uint64_t InputBitmap;
-
 /**
  * @brief Return a mask for a number of consecutive buttons (`count`) starting from `first`.
  *        A mask is a bit array where each bit determines if a button is to be used or not.
@@ -307,6 +303,18 @@ enum class DPadWorkingMode : uint8_t
  */
 #define INPUT_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
 
+/**
+ * @brief Default CPU core for scanning GPIO-based inputs
+ *
+ */
+#define FAST_INPUT_TASK_CORE 1
+
+/**
+ * @brief Default CPU core for scanning I2C-based inputs
+ *
+ */
+#define BUS_INPUT_TASK_CORE 0
+
 //-------------------------------------------------------------------
 // Queues
 //-------------------------------------------------------------------
@@ -339,7 +347,9 @@ public:
             if (value)
                 bitsQueue |= aux;
             bqTail = bqTailNext;
-        } // else queue full, overflow
+        }
+        else
+            COUNT_EVENT(bitQueueOverflows);
     }
 
     /**
@@ -386,13 +396,16 @@ public:
 struct DecouplingEvent
 {
     /// @brief Input bitmap
-    uint64_t rawInputBitmap;
+    InputBitmap rawInputBitmap;
     /// @brief Bitmap of changes from the previous event
-    uint64_t rawInputChanges;
+    InputBitmap rawInputChanges;
     /// @brief Position of the left axis
     uint8_t leftAxisValue;
     /// @brief Position of the right axis
     uint8_t rightAxisValue;
+    /// @brief True if there is no change, but the host computer
+    ///        must receive a report anyway to prevent inactivity
+    bool keepAlive = false;
 };
 
 /// @brief Queue size for decoupling events
@@ -440,6 +453,8 @@ enum class InternalEventType : uint8_t
  * @brief User setting to be stored in flash memory
  *
  * @warning Must be in the range [0,63]
+ * @note Values are part of the settings image format
+ *       (see SettingsImage.hpp). Do not reorder.
  *
  */
 enum class UserSetting : uint8_t
@@ -703,3 +718,59 @@ public:
     /// @brief True if there is wired power
     std::optional<bool> usingExternalPower;
 };
+
+//-------------------------------------------------------------------
+// BLE connection parameters
+//-------------------------------------------------------------------
+
+/**
+ * @brief User-selected BLE connection parameters
+ *
+ */
+enum class BleConnectionProfile : uint8_t
+{
+    /// @brief Lowest input latency (7.5 ms connection interval)
+    COMPETITIVE = 0,
+    /// @brief Low input latency (11.25 to 15 ms connection interval)
+    BALANCED,
+    /// @brief Low power consumption (30 to 50 ms connection interval and peripheral latency)
+    BATTERY,
+    _MAX_VALUE = BATTERY,
+    _DEFAULT_VALUE = BALANCED
+};
+
+/**
+ * @brief State of the negotiation of BLE connection parameters
+ *
+ */
+enum class BleConnectionState : uint8_t
+{
+    /// @brief Not connected or not supported
+    DISCONNECTED = 0,
+    /// @brief Waiting for the host computer to accept the requested parameters
+    PENDING,
+    /// @brief The host computer accepted the requested parameters
+    ACCEPTED,
+    /// @brief The host computer rejected all requests. Its parameters are used.
+    SETTLED
+};
+
+/**
+ * @brief Negotiated BLE connection parameters
+ *
+ */
+struct BleConnectionStatus
+{
+    /// @brief Selected profile
+    BleConnectionProfile profile = BleConnectionProfile::_DEFAULT_VALUE;
+    /// @brief Negotiation state
+    BleConnectionState state = BleConnectionState::DISCONNECTED;
+    /// @brief Connection interval in 1.25 ms units
+    uint16_t interval = 0;
+    /// @brief Peripheral latency in connection events
+    uint16_t latency = 0;
+    /// @brief Supervision timeout in 10 ms units
+    uint16_t timeout = 0;
+    /// @brief Count of requests sent to the host computer for the selected profile
+    uint8_t attempts = 0;
+};
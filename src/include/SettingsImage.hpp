@@ -0,0 +1,51 @@
+/**
+ * @file SettingsImage.hpp
+ *
+ * @author Ángel Fernández Pineda. Madrid. Spain.
+ * @date 2026-10-18
+ * @brief Binary image of all user settings (export/import)
+ *
+ * @copyright Licensed under the EUPL
+ *
+ */
+
+#pragma once
+
+//-------------------------------------------------------------------
+// Imports
+//-------------------------------------------------------------------
+
+#include <cstdint>
+
+//-------------------------------------------------------------------
+// Image format
+//-------------------------------------------------------------------
+
+// All multi-byte fields are little-endian.
+//
+// Header:
+//   [0..3]  Magic number ("SWST")
+//   [4]     Format version
+//   [5]     Count of records
+//   [6..7]  Image size in bytes, including this header
+//   [8..9]  CRC-16 of the whole image (this field excluded)
+//
+// Followed by one record per user setting:
+//   [0]     UserSetting
+//   [1..2]  Payload size in bytes
+//   [3..]   Payload
+//
+// Unknown records are ignored at import.
+
+/// @brief Magic number of a settings image
+#define SETTINGS_IMAGE_MAGIC "SWST"
+/// @brief Format version of a settings image
+#define SETTINGS_IMAGE_VERSION 1
+/// @brief Size of the settings image header in bytes
+#define SETTINGS_IMAGE_HEADER_SIZE 10
+/// @brief Index of the CRC in the settings image header
+#define SETTINGS_IMAGE_CRC_INDEX 8
+/// @brief Size of a record header in bytes
+#define SETTINGS_IMAGE_RECORD_HEADER_SIZE 3
+/// @brief Maximum size of a settings image in bytes
+#define SETTINGS_IMAGE_MAX_SIZE 1024
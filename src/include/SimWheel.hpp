@@ -275,6 +275,66 @@ namespace inputs
         ADC_GPIO leftClutchPin,
         ADC_GPIO rightClutchPin);
 
+    /**
+     * @brief Configure the tasks that scan the inputs.
+     *
+     * @note Inputs attached to GPIO pins (buttons, rotary encoders, matrices,
+     *       multiplexers and shift registers) are scanned in the "fast" task.
+     *       Inputs attached to I2C GPIO expanders are scanned concurrently
+     *       in the "bus" task, so slow I2C transactions do not delay the others.
+     *       The "bus" task is not created if there are no I2C inputs.
+     *       This call is optional. By default, the fast task runs at core 1,
+     *       the bus task runs at core 0 and both have priority 2.
+     *       Core affinity is ignored in single-core boards.
+     *
+     * @param fastCore CPU core for the fast task. -1 means any core.
+     * @param busCore CPU core for the bus task. -1 means any core.
+     * @param fastPriority Priority of the fast task over the idle task.
+     *                     Must be greater than zero.
+     * @param busPriority Priority of the bus task over the idle task.
+     *                    Must be greater than zero.
+     */
+    void setScanningTasks(
+        int8_t fastCore,
+        int8_t busCore,
+        uint8_t fastPriority = 2,
+        uint8_t busPriority = 2);
+
+    /**
+     * @brief Read I2C GPIO expanders without blocking the scanning task
+     *
+     * @note Each scan period starts a read and collects the result of the
+     *       read started at the previous scan period, so the I2C transaction
+     *       runs in the background. This call is optional.
+     *       Saves CPU time at the cost of one scan period of latency.
+     *       Not useful if the bus is shared with other slow devices.
+     *
+     * @param enable True to pipeline I2C reads. False to block (default).
+     */
+    void pipelineI2CReads(bool enable = true);
+
+    /**
+     * @brief Measure the time spent reading each hardware input
+     *
+     * @note For diagnostics. May be called at any time, even after start.
+     *       Statistics are cleared when enabled.
+     *       Adds a small overhead to every scan, so keep it disabled
+     *       in production.
+     *
+     * @param enable True to profile reads. False to stop (default).
+     */
+    void profileReads(bool enable = true);
+
+    /**
+     * @brief Get the read cost of every hardware input
+     *
+     * @note Inputs scanned by the fast task come first,
+     *       then inputs scanned by the bus task.
+     *
+     * @param[out] costs Read cost of each hardware input
+     */
+    void getReadCosts(std::vector<InputReadCost> &costs);
+
 } // namespace inputs
 
 //-------------------------------------------------------------------
@@ -573,13 +633,16 @@ namespace hid
      * @param productID Factory PID. Set to zero to use a default product ID.
      *                  Value 0xFFFF is reserved for testing.
      *                  Ignored in the USB implementation.
+     * @param reportRate Maximum rate of input reports.
+     *                   Ignored in the BLE implementation.
      */
     void configure(
         std::string deviceName,
         std::string deviceManufacturer,
         bool enableAutoPowerOff = true,
         uint16_t vendorID = 0,
-        uint16_t productID = 0);
+        uint16_t productID = 0,
+        USBReportRate reportRate = USBReportRate::HZ_1000);
 } // namespace hid
 
 //-------------------------------------------------------------------
@@ -22,6 +22,8 @@
 // GLOBALS
 //-------------------------------------------------------------------
 
+struct HidInputLayout; // See HID_definitions.hpp
+
 //-------------------------------------------------------------------
 // API
 //-------------------------------------------------------------------
@@ -131,6 +133,26 @@ namespace internals
                     uint8_t green,
                     uint8_t blue);
 
+        /**
+         * @brief Set the color of a contiguous range of pixels in a group
+         *
+         * @note Not displayed immediately
+         * @note Non-existing pixels will be ignored
+         *
+         * @param group A group of pixels
+         * @param fromPixelIndex Index of the first pixel in the range
+         * @param toPixelIndex Index of the last pixel in the range (inclusive)
+         * @param red Red component of the pixel color
+         * @param green Green component of the pixel color
+         * @param blue Blue component of the pixel color
+         */
+        void setRange(PixelGroup group,
+                      uint8_t fromPixelIndex,
+                      uint8_t toPixelIndex,
+                      uint8_t red,
+                      uint8_t green,
+                      uint8_t blue);
+
         /**
          * @brief Shift all pixel colors to the next pixel index
          *
@@ -189,6 +211,14 @@ namespace internals
          */
         void addFakeInput(FakeInput *instance);
 
+        /**
+         * @brief Forget all I2C devices found in the buses,
+         *        as in a fresh boot (for testing)
+         *
+         * @note Cached device maps in flash memory are kept.
+         */
+        void forgetI2CDevices();
+
         /**
          * @brief Push an input event into the decoupling queue
          *        (for testing)
@@ -218,6 +248,27 @@ namespace internals
     {
         /// @brief Prepare to run
         void getReady();
+
+        /**
+         * @brief Load the last known I2C device addresses
+         *
+         * @note Available before getReady(), since
+         *       I2C devices are looked up at setup.
+         *
+         * @param bus I2C bus
+         * @param[out] addresses 7-bit addresses. Empty if not stored.
+         */
+        void loadI2CDeviceMap(I2CBus bus, std::vector<uint8_t> &addresses);
+
+        /**
+         * @brief Save the I2C device addresses found in a bus
+         *
+         * @note Available before getReady()
+         *
+         * @param bus I2C bus
+         * @param addresses 7-bit addresses
+         */
+        void saveI2CDeviceMap(I2CBus bus, const std::vector<uint8_t> &addresses);
     } // namespace storage
 
     namespace inputMap
@@ -246,9 +297,23 @@ namespace internals
          */
         void map(
             bool isAltModeEngaged,
-            uint64_t firmware_bitmap,
+            const InputBitmap &firmware_bitmap,
             uint64_t &low,
             uint64_t &high);
+
+        /**
+         * @brief Get the factory default map of a firmware-defined input number
+         *
+         * @note Fixed at startup. Not affected by the user-defined map.
+         *
+         * @param[in] firmware_defined Firmware-defined input number
+         * @param[out] user_defined User-defined input number when ALT is disengaged
+         * @param[out] user_defined_alt User-defined input number when ALT is engaged
+         */
+        void getFactoryMap(
+            uint8_t firmware_defined,
+            uint8_t &user_defined,
+            uint8_t &user_defined_alt);
     } // namespace inputMap
 
     namespace power
@@ -321,6 +386,8 @@ namespace internals
          * @param[in] leftAxis Position of the left clutch, in the range 0-254.
          * @param[in] rightAxis Position of the right clutch, in the range 0-254.
          * @param[in] clutchAxis Position of the combined clutch, in the range 0-254.
+         * @param[in] keepAlive True to send the report even if identical to the last one,
+         *                      so the host computer does not disconnect for inactivity.
          */
         void reportInput(
             uint64_t inputsLow,
@@ -328,7 +395,8 @@ namespace internals
             uint8_t POVstate,
             uint8_t leftAxis,
             uint8_t rightAxis,
-            uint8_t clutchAxis);
+            uint8_t clutchAxis,
+            bool keepAlive = false);
 
         /**
          * @brief Report all inputs as not active
@@ -336,6 +404,23 @@ namespace internals
          */
         void reset();
 
+        /**
+         * @brief Select the BLE connection parameters
+         *
+         * @note Ignored if not supported by the HID implementation
+         *
+         * @param profile Connection profile
+         */
+        void setConnectionProfile(BleConnectionProfile profile);
+
+        /**
+         * @brief Get the negotiated BLE connection parameters
+         *
+         * @return BleConnectionStatus Negotiation status.
+         *         The state is always DISCONNECTED if not supported.
+         */
+        BleConnectionStatus getConnectionStatus();
+
         /**
          * @brief Common functionality to all HID implementations
          *
@@ -347,9 +432,45 @@ namespace internals
             /// @brief Prepare to run
             void getReady();
 
+            /**
+             * @brief Set the fields in the input report
+             *
+             * @note Must be called before the HID implementation starts.
+             *
+             * @param layout Input report layout
+             */
+            void setInputLayout(const HidInputLayout &layout);
+
+            /**
+             * @brief Get the size of the input report
+             *
+             * @return uint8_t Size in bytes (without report ID),
+             *                 never greater than GAMEPAD_REPORT_SIZE
+             */
+            uint8_t getInputReportSize();
+
+            /**
+             * @brief Get the configured rate of USB input reports
+             *
+             * @return uint16_t Reports per second
+             */
+            uint16_t getUSBReportRate();
+
+            /**
+             * @brief Get the HID report descriptor
+             *
+             * @param[out] size Size of the descriptor in bytes
+             * @return const uint8_t* Descriptor
+             */
+            const uint8_t *getDescriptor(uint16_t &size);
+
             /**
              * @brief Send feature report
              *
+             * @note Never waits for the HID worker task.
+             *       The data selected by previous writes
+             *       (see postSetFeature()) is retrieved.
+             *
              * @param[in] report_id A valid report id
              * @param[out] buffer Pointer to buffer to be sent
              * @param[in] len Size of @p buffer
@@ -375,11 +496,39 @@ namespace internals
              */
             void onOutput(uint8_t report_id, const uint8_t *buffer, uint16_t len);
 
+            /**
+             * @brief Receive a feature report from the transport layer
+             *
+             * @note The data to read next (page, sequence number, etc.)
+             *       is selected at once, so the next read retrieves it.
+             *       The report is copied and processed later
+             *       by the HID worker task, so this call never blocks
+             *       on pixel transmission or storage.
+             *       Dropped if the queue is full.
+             *
+             * @param[in] report_id Report identification
+             * @param[in] buffer Pointer to buffer that contains received data
+             * @param[in] len Size of @p buffer
+             */
+            void postSetFeature(uint8_t report_id, const uint8_t *buffer, uint16_t len);
+
+            /**
+             * @brief Receive an output report from the transport layer
+             *
+             * @note The report is copied and processed later
+             *       by the HID worker task. Dropped if the queue is full.
+             *
+             * @param[in] report_id Report identification
+             * @param[in] buffer Pointer to buffer that contains received data
+             * @param[in] len Size of @p buffer
+             */
+            void postOutput(uint8_t report_id, const uint8_t *buffer, uint16_t len);
+
             /**
              * @brief Resets data for the input report
              *
              * @param[out] report Pointer to report buffer.
-             *                    Size is defined by GAMEPAD_REPORT_SIZE.
+             *                    Size is given by getInputReportSize().
              */
             void onReset(uint8_t *report);
 
@@ -387,7 +536,7 @@ namespace internals
              * @brief  Sets data for the input report
              *
              * @param report Pointer to report buffer.
-             *               Size is defined by GAMEPAD_REPORT_SIZE.
+             *               Size is given by getInputReportSize().
              * @param notifyConfigChanges True to notify changes in the device settings
              * @param inputsLow State of inputs (low-order bytes)
              * @param inputsHigh State of inputs (high-order bytes)
@@ -395,8 +544,12 @@ namespace internals
              * @param leftAxis State of the left axis
              * @param rightAxis State of the right axis
              * @param clutchAxis State of the clutch axis
+             * @param keepAlive True to send the report even if identical to the last one
+             * @return true If the report must be sent to the host computer
+             * @return false If the report is identical to the last one sent,
+             *               so there is no need to send it
              */
-            void onReportInput(
+            bool onReportInput(
                 uint8_t *report,
                 bool &notifyConfigChanges,
                 uint64_t &inputsLow,
@@ -404,7 +557,24 @@ namespace internals
                 uint8_t &POVstate,
                 uint8_t &leftAxis,
                 uint8_t &rightAxis,
-                uint8_t &clutchAxis);
+                uint8_t &clutchAxis,
+                bool keepAlive = false);
+
+            /**
+             * @brief Get the count of input reports not sent
+             *        because they were identical to the last one
+             *
+             * @return uint32_t Count of suppressed input reports
+             */
+            uint32_t getSuppressedReportCount();
+
+            /**
+             * @brief Send the next input report even if identical to the last one
+             *
+             * @note To be called when the input report goes to another host
+             *       computer.
+             */
+            void forgetLastInputReport();
         } // namespace common
     } // namespace hid
 } // namespace internals
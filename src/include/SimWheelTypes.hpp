@@ -47,6 +47,7 @@
 #include <initializer_list>
 #include <map>
 #include <algorithm>
+#include "InputBitmap.hpp"
 
 #if !CD_CI
 #include "driver/rtc_io.h"   // For rtc_gpio_is_valid_gpio()
@@ -62,7 +63,7 @@
 /**
  * @brief Exception for invalid input numbers
  *
- * @note Valid input numbers are in the range [0,63]
+ * @note Valid input numbers are in the range [0,MAX_INPUT_NUMBER]
  */
 class invalid_input_number : public std::runtime_error
 {
@@ -76,7 +77,7 @@ public:
         : std::runtime_error(
               "The input number " +
               std::to_string(value) +
-              " is out of range [0,63]") {}
+              " is out of range [0," + std::to_string(MAX_INPUT_NUMBER) + "]") {}
     /**
      * @brief Construct a new invalid input number object
      *        for unspecified input numbers
@@ -244,7 +245,7 @@ enum class UNSPECIFIED
 //-------------------------------------------------------------------
 
 /**
- * @brief Firmware-defined input numbers in the range [0,63] or
+ * @brief Firmware-defined input numbers in the range [0,MAX_INPUT_NUMBER] or
  *        unspecified.
  *
  */
@@ -260,11 +261,11 @@ public:
     /**
      * @brief Cast an integer to a input number
      *
-     * @param value Input number in the range [0,63]
+     * @param value Input number in the range [0,MAX_INPUT_NUMBER]
      */
     InputNumber(uint8_t value)
     {
-        if (value >= 64)
+        if (value > MAX_INPUT_NUMBER)
             throw invalid_input_number(value);
         _value = value;
     }
@@ -290,16 +291,13 @@ public:
     }
 
     /**
-     * @brief Typecast this input number to a 64-bit bitmap
+     * @brief Typecast this input number to an input bitmap
      *
      * @return A bitmap
      */
-    explicit operator uint64_t() const
+    explicit operator InputBitmap() const
     {
-        if (_value < 64)
-            return (1ULL << _value);
-        else
-            return 0ULL;
+        return inputBitmapOf(_value);
     }
 
     /**
@@ -309,7 +307,7 @@ public:
      */
     operator uint8_t() const
     {
-        if (_value > 63)
+        if (_value > MAX_INPUT_NUMBER)
             throw std::bad_cast();
         else
             return _value;
@@ -322,7 +320,7 @@ public:
      * @return true If unspecified
      * @return false otherwise
      */
-    bool operator==(const UNSPECIFIED value) const { return (_value > 63); }
+    bool operator==(const UNSPECIFIED value) const { return (_value > MAX_INPUT_NUMBER); }
 
     /**
      * @brief Check if this input number was specified
@@ -331,7 +329,7 @@ public:
      * @return true If specified
      * @return false otherwise
      */
-    bool operator!=(const UNSPECIFIED value) const { return (_value < 64); }
+    bool operator!=(const UNSPECIFIED value) const { return (_value <= MAX_INPUT_NUMBER); }
 
     /// @cond
 
@@ -347,7 +345,7 @@ public:
 
     constexpr InputNumber &operator=(uint8_t value)
     {
-        if (value >= 64)
+        if (value > MAX_INPUT_NUMBER)
             throw invalid_input_number(value);
         _value = value;
         return *this;
@@ -361,8 +359,7 @@ public:
      */
     void book() const
     {
-        if (_value < 64)
-            _registered |= (1ULL << _value);
+        _registered |= inputBitmapOf(_value);
     }
 
     /**
@@ -371,8 +368,7 @@ public:
      */
     void unbook() const
     {
-        if (_value < 64)
-            _registered &= ~(1ULL << _value);
+        _registered &= ~inputBitmapOf(_value);
     }
 
     /**
@@ -381,7 +377,7 @@ public:
      */
     static void bookAll()
     {
-        _registered = ~(0ULL);
+        _registered = ALL_INPUTS;
     }
 
     /**
@@ -393,7 +389,7 @@ public:
      */
     static bool booked(InputNumber inputNumber)
     {
-        return _registered & (uint64_t)inputNumber;
+        return (bool)(_registered & (InputBitmap)inputNumber);
     }
 
     /**
@@ -406,29 +402,26 @@ public:
     static bool booked(uint8_t inputNumber)
     {
         // Avoid two implicit typecasts
-        if (inputNumber < 64)
-            return _registered & (1ULL << inputNumber);
-        else
-            return false;
+        return (bool)(_registered & inputBitmapOf(inputNumber));
     }
 
     /**
      * @brief Get a bitmap of all booked input numbers
      *
-     * @return uint64_t A bitmap
+     * @return InputBitmap A bitmap
      */
-    static uint64_t booked() { return _registered; }
+    static InputBitmap booked() { return _registered; }
 
 #if CD_CI
     static void clearBook()
     {
-        _registered = 0ULL;
+        _registered = NO_INPUTS;
     };
 #endif
 
 private:
     uint8_t _value;
-    inline static uint64_t _registered = 0ULL;
+    inline static InputBitmap _registered = NO_INPUTS;
 };
 
 /**
@@ -466,7 +459,7 @@ public:
         this->clear();
         for (auto item = items.begin(); item != items.end(); ++item)
         {
-            if (*item > 63)
+            if (*item > MAX_INPUT_NUMBER)
                 throw invalid_input_number(*item);
             else
                 this->push_back(static_cast<InputNumber>(*item));
@@ -474,15 +467,15 @@ public:
     }
 
     /**
-     * @brief Convert this vector to a single 64-bit bitmap
+     * @brief Convert this vector to a single input bitmap
      *
-     * @return uint64_t A bitmap
+     * @return InputBitmap A bitmap
      */
-    explicit operator uint64_t()
+    explicit operator InputBitmap()
     {
-        uint64_t bitmap = 0ULL;
+        InputBitmap bitmap = NO_INPUTS;
         for (size_t i = 0; i < this->size(); i++)
-            bitmap = bitmap | (uint64_t)this->at(i);
+            bitmap = bitmap | (InputBitmap)this->at(i);
         return bitmap;
     }
 };
@@ -853,6 +846,33 @@ typedef std::vector<InputGPIO> InputGPIOCollection;
 /// @brief Collection of output GPIOs
 typedef std::vector<OutputGPIO> OutputGPIOCollection;
 
+//-------------------------------------------------------------------
+// Input read cost
+//-------------------------------------------------------------------
+
+/**
+ * @brief Time spent reading a hardware input
+ *
+ * @note Only collected when read profiling is enabled
+ */
+struct InputReadCost
+{
+    /// @brief Lowest input number assigned to the hardware input
+    uint8_t firstInputNumber = 0xFF;
+    /// @brief Count of input numbers assigned to the hardware input
+    uint8_t inputCount = 0;
+    /// @brief True if scanned in the bus task (I2C)
+    bool busInput = false;
+    /// @brief Minimum read time in nanoseconds
+    uint32_t minNs = 0;
+    /// @brief Running average of the read time in nanoseconds
+    uint32_t avgNs = 0;
+    /// @brief Maximum read time in nanoseconds
+    uint32_t maxNs = 0;
+    /// @brief Count of profiled reads
+    uint32_t readCount = 0;
+};
+
 //-------------------------------------------------------------------
 // I2C
 //-------------------------------------------------------------------
@@ -876,6 +896,26 @@ enum class I2CBus
 };
 #endif
 
+//-------------------------------------------------------------------
+// HID
+//-------------------------------------------------------------------
+
+/**
+ * @brief Input report rates for the USB implementation
+ *
+ */
+enum class USBReportRate : uint16_t
+{
+    /// @brief 125 reports per second (8 ms)
+    HZ_125 = 125,
+    /// @brief 250 reports per second (4 ms)
+    HZ_250 = 250,
+    /// @brief 500 reports per second (2 ms)
+    HZ_500 = 500,
+    /// @brief 1000 reports per second (1 ms)
+    HZ_1000 = 1000
+};
+
 //-------------------------------------------------------------------
 // Power latch
 //-------------------------------------------------------------------